@@ -10,9 +10,9 @@ import image_decode_worker
 import server_utils
 
 class App:
-    def __init__(self, output_file, symbol_type, dim, part_num, mp, transform):
+    def __init__(self, output_file, symbol_type, dim, part_num, mp, transform, c_decoder):
         self.output_file = output_file
-        self.image_decode_worker = image_decode_worker.ImageDecodeWorker(symbol_type, dim)
+        self.image_decode_worker = image_decode_worker.ImageDecodeWorker(symbol_type, dim, c_decoder)
         self.part_num = part_num
         self.transform = transform
         self.mp = mp
@@ -106,6 +106,7 @@ if __name__ == '__main__':
     parser.add_argument('dim', help='dim as tile_x_num,tile_y_num,tile_x_size,tile_y_size')
     parser.add_argument('part_num', type=int, help='part num')
     parser.add_argument('--mp', type=int, default=1, help='multiprocessing')
+    parser.add_argument('--c_decoder', action='store_true', help='decode frames with the c++ image codec library')
     transform_utils.add_transform_arguments(parser)
     args = parser.parse_args()
 
@@ -113,7 +114,7 @@ if __name__ == '__main__':
     dim = image_codec_types.parse_dim(args.dim)
     transform = transform_utils.get_transform(args)
 
-    app = App(args.output_file, symbol_type, dim, args.part_num, args.mp, transform)
+    app = App(args.output_file, symbol_type, dim, args.part_num, args.mp, transform, args.c_decoder)
     print('start')
     app.start()
     try:
@@ -266,6 +266,10 @@ class App:
             with open(task_status_file_path, 'rb') as f:
                 task_bytes = f.read()
             if task_bytes:
+                # parts done since the last checkpoint are in the journal
+                task = image_decode_task.Task(self.target_file_path)
+                task.load()
+                task_bytes = task.to_task_bytes()
                 symbol_type, dim, part_num, done_part_num, task_status_bytes = image_decode_task.from_task_bytes(task_bytes)
                 assert symbol_type == self.symbol_type
                 assert dim == (self.tile_x_num, self.tile_y_num, self.tile_x_size, self.tile_y_size)
@@ -14,6 +14,9 @@ import image_decode_task
 import server_utils
 import image_decode_task_status_client
 
+# fec symbol types are only encoded by the native codec
+combo_box_symbol_types = [t for t in symbol_codec.SymbolType if not symbol_codec.is_fec_symbol_type(t)]
+
 class Parameters:
     def __init__(self):
         self.tile_x_num_range = (1, 10)
@@ -88,9 +91,9 @@ class CalibrationPage(QtWidgets.QWidget):
         symbol_type_label.setAlignment(QtCore.Qt.AlignRight | QtCore.Qt.AlignVCenter)
         config_frame_layout.addWidget(symbol_type_label)
         self.symbol_type_combo_box = QtWidgets.QComboBox()
-        for t in symbol_codec.SymbolType:
+        for t in combo_box_symbol_types:
             self.symbol_type_combo_box.addItem(t.name.lower())
-        self.symbol_type_combo_box.setCurrentIndex(self.context.symbol_type.value)
+        self.symbol_type_combo_box.setCurrentIndex(combo_box_symbol_types.index(self.context.symbol_type))
         config_frame_layout.addWidget(self.symbol_type_combo_box)
 
         tile_x_num_label = QtWidgets.QLabel('tile_x_num')
@@ -255,9 +258,9 @@ class TaskPage(QtWidgets.QWidget):
         symbol_type_label.setAlignment(QtCore.Qt.AlignRight | QtCore.Qt.AlignVCenter)
         config_frame_layout.addWidget(symbol_type_label)
         self.symbol_type_combo_box = QtWidgets.QComboBox()
-        for t in symbol_codec.SymbolType:
+        for t in combo_box_symbol_types:
             self.symbol_type_combo_box.addItem(t.name.lower())
-        self.symbol_type_combo_box.setCurrentIndex(self.context.symbol_type.value)
+        self.symbol_type_combo_box.setCurrentIndex(combo_box_symbol_types.index(self.context.symbol_type))
         config_frame_layout.addWidget(self.symbol_type_combo_box)
 
         tile_x_num_label = QtWidgets.QLabel('tile_x_num')
@@ -427,7 +430,7 @@ class TaskPage(QtWidgets.QWidget):
             self.task_file_line_edit.setText(task_file_path)
             task = image_decode_task.Task(task_file_path[:task_file_path.rindex('.task')])
             task.load()
-            self.symbol_type_combo_box.setCurrentIndex(task.symbol_type.value)
+            self.symbol_type_combo_box.setCurrentIndex(combo_box_symbol_types.index(task.symbol_type))
             tile_x_num, tile_y_num, tile_x_size, tile_y_size = task.dim
             self.tile_x_num_spin_box.setValue(tile_x_num)
             self.tile_y_num_spin_box.setValue(tile_y_num)
@@ -661,22 +664,8 @@ class Canvas(QtWidgets.QWidget):
                                     painter.setBrush(QtGui.QColor(0, 0, 0))
                                 else:
                                     symbol = self.data[((tile_y_id * self.context.tile_x_num + tile_x_id) * self.context.tile_y_size + (y - 1)) * self.context.tile_x_size + (x - 1)]
-                                    if symbol == image_codec_types.PixelColor.WHITE.value:
-                                        painter.setBrush(QtGui.QColor(255, 255, 255))
-                                    elif symbol == image_codec_types.PixelColor.BLACK.value:
-                                        painter.setBrush(QtGui.QColor(0, 0, 0))
-                                    elif symbol == image_codec_types.PixelColor.RED.value:
-                                        painter.setBrush(QtGui.QColor(255, 0, 0))
-                                    elif symbol == image_codec_types.PixelColor.BLUE.value:
-                                        painter.setBrush(QtGui.QColor(0, 0, 255))
-                                    elif symbol == image_codec_types.PixelColor.GREEN.value:
-                                        painter.setBrush(QtGui.QColor(0, 255, 0))
-                                    elif symbol == image_codec_types.PixelColor.CYAN.value:
-                                        painter.setBrush(QtGui.QColor(0, 255, 255))
-                                    elif symbol == image_codec_types.PixelColor.MAGENTA.value:
-                                        painter.setBrush(QtGui.QColor(255, 0, 255))
-                                    elif symbol == image_codec_types.PixelColor.YELLOW.value:
-                                        painter.setBrush(QtGui.QColor(255, 255, 0))
+                                    if symbol < image_codec_types.PixelColor.UNKNOWN.value:
+                                        painter.setBrush(QtGui.QColor(*image_codec_types.pixel_color_rgbs[symbol]))
                                     else:
                                         assert 0, 'invalid symbol \'{}\''.format(symbol)
                                 painter.drawRect(tile_x + x * self.context.pixel_size, tile_y + y * self.context.pixel_size, self.context.pixel_size, self.context.pixel_size)
@@ -699,7 +688,7 @@ class Widget(QtWidgets.QWidget):
         self.task_page = TaskPage(self.parameters, self.context)
 
         def set_symbol_type_fn(index):
-            self.context.symbol_type = symbol_codec.SymbolType(index)
+            self.context.symbol_type = combo_box_symbol_types[index]
         def set_tile_x_num_fn(tile_x_num):
             self.context.tile_x_num = tile_x_num
         def set_tile_y_num_fn(tile_y_num):
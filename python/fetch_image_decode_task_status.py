@@ -1,6 +1,7 @@
 import argparse
 
 import server_utils
+import image_decode_task
 import image_decode_task_status_client
 
 parser = argparse.ArgumentParser()
@@ -8,14 +9,17 @@ parser.add_argument('task_file', help='task file')
 parser.add_argument('server_type', help='server type')
 parser.add_argument('ip', help='ip')
 parser.add_argument('port', type=int, help='port')
+parser.add_argument('--task_bytes_version', type=int, help='task bytes version asked from the server, tcp defaults to 1 as tcp servers without version negotiation can\'t take the request')
 args = parser.parse_args()
 
 server_type = server_utils.parse_server_type(args.server_type)
-task_status_client = image_decode_task_status_client.create_task_status_client(server_type, args.ip, args.port)
+task_status_client = image_decode_task_status_client.create_task_status_client(server_type, args.ip, args.port, args.task_bytes_version)
 task_bytes = task_status_client.get_task_status()
-if task_status_bytes is None:
+if task_bytes is None:
     print('fail to get task status')
 else:
+    # task files keep the version 1 layout
+    task_bytes = image_decode_task.convert_task_bytes(task_bytes, image_decode_task.task_bytes_version1)
     with open(args.task_file, 'wb') as f:
         f.write(task_bytes)
     print('success')
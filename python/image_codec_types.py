@@ -2,16 +2,43 @@ import enum
 
 @enum.unique
 class PixelColor(enum.Enum):
-    WHITE   = 0
-    BLACK   = 1
-    RED     = 2
-    BLUE    = 3
-    GREEN   = 4
-    CYAN    = 5
-    MAGENTA = 6
-    YELLOW  = 7
-    UNKNOWN = 8
-    NUM     = 9
+    WHITE      = 0
+    BLACK      = 1
+    RED        = 2
+    BLUE       = 3
+    GREEN      = 4
+    CYAN       = 5
+    MAGENTA    = 6
+    YELLOW     = 7
+    DARK_GREEN = 8
+    MID_GREEN  = 9
+    ROYAL_BLUE = 10
+    AZURE      = 11
+    VERMILION  = 12
+    ORANGE     = 13
+    PINK       = 14
+    LIGHT_PINK = 15
+    UNKNOWN    = 16
+    NUM        = 17
+
+pixel_color_rgbs = [
+    (255, 255, 255),
+    (0, 0, 0),
+    (255, 0, 0),
+    (0, 0, 255),
+    (0, 255, 0),
+    (0, 255, 255),
+    (255, 0, 255),
+    (255, 255, 0),
+    (0, 85, 0),
+    (0, 170, 0),
+    (0, 85, 255),
+    (0, 170, 255),
+    (255, 85, 0),
+    (255, 170, 0),
+    (255, 85, 255),
+    (255, 170, 255),
+    ]
 
 class InvalidImageCodecArgument(Exception):
     pass
@@ -1,9 +1,32 @@
 import os
 import io
+import re
+import enum
 import struct
+import zlib
 
+import image_codec_types
 import symbol_codec
 
+class CompressionType(enum.Enum):
+    NONE = 0
+    ZLIB = 1
+
+fountain_part_id_flag = 0x80000000
+sparse_map_part_id_flag = 0x40000000
+
+compression_magic = 0x5a43424c
+min_compressed_part_byte_num = 24
+compression_block_byte_num = 1 << 20
+
+# task bytes version 1 is the layout of the .task file
+# version 2 starts with task_bytes_magic and the version, the version 1 fields follow with the status either as the bitmap or as the ranges of undone parts whichever is smaller
+task_bytes_version1 = 1
+task_bytes_version2 = 2
+task_bytes_magic = 0x5354424c
+task_status_bitmap = 0
+task_status_undone_ranges = 1
+
 class FinalizationProgress:
     def __init__(self):
         self.done_block_num = 0
@@ -15,6 +38,7 @@ class Task:
     def __init__(self, path):
         self.path = path
         self.task_path = path + '.task'
+        self.journal_path = path + '.task.journal'
         self.blob_path = path + '.blob'
         self.blob_buf = []
         self.finalization_start_cb = None
@@ -35,6 +59,24 @@ class Task:
         self.symbol_type = symbol_codec.SymbolType(symbol_type)
         self.dim = tuple(dim)
         self.task_status_bytes = bytearray(task_bytes[28:])
+        self.replay_journal()
+
+    # part ids done since the checkpoint in the .task file, records are the part id num and the crc32 of the part ids followed by the part ids
+    def replay_journal(self):
+        if not os.path.isfile(self.journal_path):
+            return
+        with open(self.journal_path, 'rb') as journal_file:
+            journal_bytes = journal_file.read()
+        pos = 0
+        while pos + 8 <= len(journal_bytes):
+            part_id_num, crc = struct.unpack('<II', journal_bytes[pos:pos+8])
+            part_id_bytes = journal_bytes[pos+8:pos+8+part_id_num*4]
+            if len(part_id_bytes) != part_id_num * 4 or zlib.crc32(part_id_bytes) != crc:
+                break
+            for part_id in struct.unpack('<{}I'.format(part_id_num), part_id_bytes):
+                if part_id < self.part_num and not self.is_part_done(part_id):
+                    self.mark_part_done(part_id)
+            pos += 8 + part_id_num * 4
 
     def set_finalization_cb(self, finalization_start_cb, finalization_progress_cb, finalization_complete_cb):
         self.finalization_start_cb = finalization_start_cb
@@ -55,34 +97,57 @@ class Task:
         return bool(self.task_status_bytes[byte_index] & mask)
 
     def update_part(self, part_id, part_bytes):
-        if self.is_part_done(part_id):
+        if part_id & (fountain_part_id_flag | sparse_map_part_id_flag) == sparse_map_part_id_flag:
+            self.update_sparse_map_part(part_id, part_bytes)
+            return
+        # fountain coded parts are only decoded by the native task
+        if part_id >= self.part_num or self.is_part_done(part_id):
             return
 
-        byte_index = part_id // 8
-        mask = 1 << (part_id % 8)
-        self.task_status_bytes[byte_index] |= mask
-        self.done_part_num += 1
+        self.mark_part_done(part_id)
 
         self.blob_buf.append((part_id, part_bytes))
 
         if (self.done_part_num & 0x7ff) == 0:
             self.flush()
 
-    def to_task_bytes(self):
-        task_info_bytes = struct.pack('<IIIIIII', self.symbol_type.value, *self.dim, self.part_num, self.done_part_num)
-        return task_info_bytes + self.task_status_bytes
+    def mark_part_done(self, part_id):
+        byte_index = part_id // 8
+        mask = 1 << (part_id % 8)
+        self.task_status_bytes[byte_index] |= mask
+        self.done_part_num += 1
+
+    # zero parts are left as the holes of the blob allocated by allocate_blob
+    def update_sparse_map_part(self, part_id, part_bytes):
+        first_part_id = (part_id & ~sparse_map_part_id_flag) * len(part_bytes) * 8
+        for i, b in enumerate(part_bytes):
+            for j in range(8):
+                zero_part_id = first_part_id + i * 8 + j
+                if (b >> j) & 1 and zero_part_id < self.part_num and not self.is_part_done(zero_part_id):
+                    self.mark_part_done(zero_part_id)
+
+    def to_task_bytes(self, version=task_bytes_version1):
+        return to_task_bytes(self.symbol_type, self.dim, self.part_num, self.done_part_num, self.task_status_bytes, version)
 
     def flush(self):
         with open(self.blob_path, 'r+b') as blob_file:
             for part_id, part_bytes in self.blob_buf:
                 blob_file.seek(part_id * len(part_bytes))
                 blob_file.write(part_bytes)
+            # the parts are durable before the checkpoint marks them done
+            blob_file.flush()
+            os.fsync(blob_file.fileno())
         self.blob_buf = []
 
-        with open(self.task_path, 'wb') as task_file:
-            task_info_bytes = struct.pack('<IIIIIII', self.symbol_type.value, *self.dim, self.part_num, self.done_part_num)
-            task_file.write(task_info_bytes)
-            task_file.write(self.task_status_bytes)
+        # always a full checkpoint, which replaces the journal written by the native task
+        # the journal is removed only once the checkpoint is durable
+        with open(self.task_path + '.tmp', 'wb') as task_file:
+            task_file.write(self.to_task_bytes())
+            task_file.flush()
+            os.fsync(task_file.fileno())
+        os.replace(self.task_path + '.tmp', self.task_path)
+        if os.path.isfile(self.journal_path):
+            os.remove(self.journal_path)
 
     def is_done(self):
         return self.done_part_num == self.part_num
@@ -92,14 +157,36 @@ class Task:
         with open(self.blob_path, 'r+b') as blob_file:
             part_byte_num = get_part_byte_num(self.symbol_type, self.dim)
             blob_file.seek(part_byte_num * (self.part_num - 1), io.SEEK_SET);
-            file_size_bytes = blob_file.read(8)
-            file_size = struct.unpack('<Q', file_size_bytes)[0]
+            trailer_bytes = blob_file.read(min_compressed_part_byte_num).ljust(min_compressed_part_byte_num, b'\0')
+            file_size, magic, compression_type, original_file_size = struct.unpack('<QIIQ', trailer_bytes)
             blob_file.truncate(file_size)
-        os.rename(self.blob_path, self.path)
+        if magic == compression_magic and compression_type != CompressionType.NONE.value:
+            self.decompress_blob(file_size, CompressionType(compression_type), original_file_size)
+            os.remove(self.blob_path)
+        else:
+            os.rename(self.blob_path, self.path)
         os.remove(self.task_path)
+        if os.path.isfile(self.journal_path):
+            os.remove(self.journal_path)
         if self.finalization_complete_cb:
             self.finalization_complete_cb()
 
+    def decompress_blob(self, file_size, compression_type, original_file_size):
+        finalization_progress = FinalizationProgress()
+        finalization_progress.block_num = (file_size + compression_block_byte_num - 1) // compression_block_byte_num
+        if self.finalization_start_cb:
+            self.finalization_start_cb(finalization_progress)
+        decompressor = zlib.decompressobj()
+        with open(self.blob_path, 'rb') as blob_file, open(self.path, 'wb') as f:
+            for block_id in range(finalization_progress.block_num):
+                f.write(decompressor.decompress(blob_file.read(compression_block_byte_num)))
+                finalization_progress.done_block_num = block_id + 1
+                if self.finalization_progress_cb:
+                    self.finalization_progress_cb(finalization_progress)
+            f.write(decompressor.flush())
+        if not decompressor.eof or os.path.getsize(self.path) != original_file_size:
+            raise RuntimeError('can\'t decompress \'{}\''.format(self.blob_path))
+
     def print(self, show_undone_part_num):
         print('symbol_type={}'.format(self.symbol_type.name))
         print('dim={}'.format(self.dim))
@@ -117,30 +204,122 @@ class Task:
 def get_part_byte_num(symbol_type, dim):
     tile_x_num, tile_y_num, tile_x_size, tile_y_size = dim
     codec = symbol_codec.create_symbol_codec(symbol_type)
-    return tile_x_num * tile_y_num * tile_x_size * tile_y_size * codec.bit_num_per_symbol // 8 - codec.meta_byte_num
+    return codec.get_padded_part_byte_num(tile_x_num * tile_y_num * tile_x_size * tile_y_size)
 
-def get_task_bytes(file_path, part_byte_num):
+def get_task_bytes(file_path, part_byte_num, compression_type=CompressionType.NONE):
     with open(file_path, 'rb') as f:
         raw_bytes = bytearray(f.read())
     file_size = len(raw_bytes)
+    if compression_type == CompressionType.NONE:
+        size_bytes = bytearray(struct.pack('<Q', file_size))
+    else:
+        if part_byte_num < min_compressed_part_byte_num:
+            raise image_codec_types.InvalidImageCodecArgument('invalid part_byte_num \'{}\' for compression'.format(part_byte_num))
+        original_file_size = file_size
+        raw_bytes = bytearray(zlib.compress(raw_bytes, 1))
+        file_size = len(raw_bytes)
+        size_bytes = bytearray(struct.pack('<QIIQ', file_size, compression_magic, compression_type.value, original_file_size))
     left_bytes_num1 = file_size % part_byte_num
     padding_bytes1 = bytes([0] * (part_byte_num - left_bytes_num1)) if left_bytes_num1 else b''
-    size_bytes = bytearray(struct.pack('<Q', file_size))
     padding_bytes2 = bytes([0] * (part_byte_num - len(size_bytes)))
     raw_bytes += padding_bytes1 + size_bytes + padding_bytes2
     part_num = len(raw_bytes) // part_byte_num
     return raw_bytes, part_num
 
+# runs of undone parts as [first_part_id, end_part_id), None if there are more than max_range_num runs
+def get_undone_ranges(task_status_bytes, part_num, max_range_num):
+    undone_ranges = []
+    def add_undone_range(first_part_id, end_part_id):
+        if undone_ranges and undone_ranges[-1][1] == first_part_id:
+            undone_ranges[-1][1] = end_part_id
+            return True
+        if len(undone_ranges) == max_range_num:
+            return False
+        undone_ranges.append([first_part_id, end_part_id])
+        return True
+    for m in re.finditer(rb'\x00+|[^\xff]', task_status_bytes):
+        if task_status_bytes[m.start()] == 0:
+            if not add_undone_range(m.start() * 8, min(m.end() * 8, part_num)):
+                return None
+            continue
+        for part_id in range(m.start() * 8, min(m.end() * 8, part_num)):
+            if not is_part_done(task_status_bytes, part_id) and not add_undone_range(part_id, part_id + 1):
+                return None
+    return undone_ranges
+
+def to_task_bytes(symbol_type, dim, part_num, done_part_num, task_status_bytes, version=task_bytes_version1):
+    if version not in (task_bytes_version1, task_bytes_version2):
+        raise image_codec_types.InvalidImageCodecArgument('invalid task bytes version \'{}\''.format(version))
+    task_info_bytes = struct.pack('<IIIIIII', symbol_type.value, *dim, part_num, done_part_num)
+    if version == task_bytes_version1:
+        return task_info_bytes + task_status_bytes
+    task_info_bytes = struct.pack('<II', task_bytes_magic, version) + task_info_bytes
+    # the ranges are sent when they are smaller than the bitmap
+    undone_ranges = get_undone_ranges(task_status_bytes, part_num, (len(task_status_bytes) - min(len(task_status_bytes), 4)) // 8)
+    if undone_ranges is None:
+        return task_info_bytes + struct.pack('<I', task_status_bitmap) + task_status_bytes
+    range_bytes = b''.join(struct.pack('<II', first_part_id, end_part_id) for first_part_id, end_part_id in undone_ranges)
+    return task_info_bytes + struct.pack('<II', task_status_undone_ranges, len(undone_ranges)) + range_bytes
+
 def from_task_bytes(task_bytes):
-    symbol_type, *dim, part_num, done_part_num = struct.unpack('<IIIIIII', task_bytes[:28])
+    version = get_task_bytes_version(task_bytes)
+    if version not in (task_bytes_version1, task_bytes_version2):
+        raise image_codec_types.InvalidImageCodecArgument('invalid task bytes version \'{}\''.format(version))
+    header_byte_num = 4 * 7 if version == task_bytes_version1 else 4 * 10
+    if len(task_bytes) < header_byte_num:
+        raise image_codec_types.InvalidImageCodecArgument('invalid task bytes of size \'{}\''.format(len(task_bytes)))
+    pos = 0 if version == task_bytes_version1 else 8
+    symbol_type, *dim, part_num, done_part_num = struct.unpack('<IIIIIII', task_bytes[pos:pos+28])
     dim = tuple(dim)
     symbol_type = symbol_codec.SymbolType(symbol_type)
-    task_status_bytes = task_bytes[28:]
-    expected_task_byte_num = 4 * 7 + (part_num + 7) // 8
+    task_status_encoding = task_status_bitmap
+    if version == task_bytes_version2:
+        task_status_encoding = struct.unpack('<I', task_bytes[pos+28:pos+32])[0]
+    if task_status_encoding == task_status_bitmap:
+        task_status_bytes = task_bytes[header_byte_num:]
+        expected_task_byte_num = header_byte_num + (part_num + 7) // 8
+        if len(task_bytes) != expected_task_byte_num:
+            raise image_codec_types.InvalidImageCodecArgument('invalid task bytes of size \'{}\', \'{}\' expected'.format(len(task_bytes), expected_task_byte_num))
+        return symbol_type, dim, part_num, done_part_num, task_status_bytes
+    if task_status_encoding != task_status_undone_ranges:
+        raise image_codec_types.InvalidImageCodecArgument('invalid task status encoding \'{}\''.format(task_status_encoding))
+    if len(task_bytes) < header_byte_num + 4:
+        raise image_codec_types.InvalidImageCodecArgument('invalid task bytes of size \'{}\''.format(len(task_bytes)))
+    range_num = struct.unpack('<I', task_bytes[header_byte_num:header_byte_num+4])[0]
+    expected_task_byte_num = header_byte_num + 4 + range_num * 8
     if len(task_bytes) != expected_task_byte_num:
         raise image_codec_types.InvalidImageCodecArgument('invalid task bytes of size \'{}\', \'{}\' expected'.format(len(task_bytes), expected_task_byte_num))
+    undone_ranges = struct.unpack('<{}I'.format(range_num * 2), task_bytes[header_byte_num+4:])
+    task_status_bytes = bytearray(b'\xff' * ((part_num + 7) // 8))
+    if part_num % 8:
+        task_status_bytes[-1] = (1 << (part_num % 8)) - 1
+    for i in range(0, len(undone_ranges), 2):
+        first_part_id, end_part_id = undone_ranges[i], undone_ranges[i+1]
+        if first_part_id >= end_part_id or end_part_id > part_num:
+            raise image_codec_types.InvalidImageCodecArgument('invalid undone part range \'{}-{}\''.format(first_part_id, end_part_id))
+        while first_part_id < end_part_id and first_part_id % 8:
+            task_status_bytes[first_part_id // 8] &= ~(1 << (first_part_id % 8))
+            first_part_id += 1
+        byte_num = (end_part_id - first_part_id) // 8
+        task_status_bytes[first_part_id // 8:first_part_id // 8 + byte_num] = bytes(byte_num)
+        first_part_id += byte_num * 8
+        while first_part_id < end_part_id:
+            task_status_bytes[first_part_id // 8] &= ~(1 << (first_part_id % 8))
+            first_part_id += 1
     return symbol_type, dim, part_num, done_part_num, task_status_bytes
 
+def get_task_bytes_version(task_bytes):
+    if len(task_bytes) < 8:
+        return task_bytes_version1
+    magic, version = struct.unpack('<II', task_bytes[:8])
+    return version if magic == task_bytes_magic else task_bytes_version1
+
+def convert_task_bytes(task_bytes, version):
+    if get_task_bytes_version(task_bytes) == version:
+        return task_bytes
+    symbol_type, dim, part_num, done_part_num, task_status_bytes = from_task_bytes(task_bytes)
+    return to_task_bytes(symbol_type, dim, part_num, done_part_num, task_status_bytes, version)
+
 def is_part_done(task_status_bytes, part_id):
     byte_index = part_id // 8
     mask = 1 << (part_id % 8)
@@ -2,25 +2,33 @@ import struct
 import socket
 import http.client
 
+import image_decode_task
+import image_decode_task_status_server
 import server_utils
 
 class TaskStatusClient:
-    def __init__(self, ip, port):
+    # servers without version negotiation always send version 1 task bytes
+    def __init__(self, ip, port, task_bytes_version):
         self.ip = ip
         self.port = port
+        self.task_bytes_version = task_bytes_version
 
     def get_task_status(self):
         raise NotImplementedError()
 
+# tcp servers without version negotiation never read a version request and may reset the connection before the task bytes are read,
+# so only clients asking for version 2 send one
 class TaskStatusTcpClient(TaskStatusClient):
-    def __init__(self, ip, port):
-        super().__init__(ip, port)
+    def __init__(self, ip, port, task_bytes_version=image_decode_task.task_bytes_version1):
+        super().__init__(ip, port, task_bytes_version)
 
     def get_task_status(self):
         try:
             with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as s:
                 s.settimeout(5)
                 s.connect((self.ip, self.port))
+                if self.task_bytes_version != image_decode_task.task_bytes_version1:
+                    s.sendall(struct.pack('<I', self.task_bytes_version))
                 len_bytes = bytearray()
                 while len(len_bytes) < 8:
                     len_bytes += s.recv(8 - len(len_bytes))
@@ -33,14 +41,15 @@ class TaskStatusTcpClient(TaskStatusClient):
         except Exception as e:
             return None
 
+# http servers ignore the version header field if they don't know it
 class TaskStatusHttpClient(TaskStatusClient):
-    def __init__(self, ip, port):
-        super().__init__(ip, port)
+    def __init__(self, ip, port, task_bytes_version=image_decode_task.task_bytes_version2):
+        super().__init__(ip, port, task_bytes_version)
 
     def get_task_status(self):
         try:
             conn = http.client.HTTPConnection(self.ip, self.port)
-            conn.request('GET', '/')
+            conn.request('GET', '/', headers={image_decode_task_status_server.task_bytes_version_field: str(self.task_bytes_version)})
             resp = conn.getresponse()
             task_bytes = resp.read(int(resp.getheader('Content-Length')))
             return task_bytes
@@ -52,5 +61,8 @@ server_type_to_client_mapping = {
     server_utils.ServerType.HTTP: TaskStatusHttpClient,
     }
 
-def create_task_status_client(server_type, ip, port):
-    return server_type_to_client_mapping[server_type](ip, port)
+# without task_bytes_version tcp clients ask for version 1 and http clients for version 2
+def create_task_status_client(server_type, ip, port, task_bytes_version=None):
+    if task_bytes_version is None:
+        return server_type_to_client_mapping[server_type](ip, port)
+    return server_type_to_client_mapping[server_type](ip, port, task_bytes_version)
@@ -6,8 +6,14 @@ import wsgiref.simple_server
 import http.client
 
 import image_codec_types
+import image_decode_task
 import server_utils
 
+# tcp clients ask for a task bytes version right after connecting, clients which don't ask get version 1
+task_bytes_version_request_timeout = 0.1
+# http clients ask for a task bytes version with this header field
+task_bytes_version_field = 'Task-Bytes-Version'
+
 class TaskStatusServer:
     def __init__(self):
         self.port = None
@@ -38,9 +44,12 @@ class TaskStatusServer:
                     break
             self.handle_request()
 
-    def get_task_bytes(self):
+    def get_task_bytes(self, version):
         with self.lock:
-            return bytes(self.task_bytes)
+            task_bytes = self.task_bytes
+        if not task_bytes:
+            return task_bytes
+        return bytes(image_decode_task.convert_task_bytes(task_bytes, version))
 
     def handle_request(self):
         raise NotImplementedError()
@@ -48,21 +57,52 @@ class TaskStatusServer:
     def request_self(self):
         raise NotImplementedError()
 
+    # task bytes of either version, each client gets the version it asks for
     def update_task_status(self, task_bytes):
         with self.lock:
             self.task_bytes = bytes(task_bytes)
 
+# each accepted connection waits for the version request of its client on a thread of its own, so clients which don't send one don't hold up the accept loop
 class TaskStatusTcpServer(TaskStatusServer):
+    def __init__(self):
+        super().__init__()
+        self.response_threads = []
+
     def handle_request(self):
+        self.response_threads = [t for t in self.response_threads if t.is_alive()]
         try:
             with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as s:
+                # the previous connection may still be in TIME_WAIT
+                s.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
                 s.bind(('', self.port))
                 s.listen(1)
                 conn, addr = s.accept()
-                task_bytes = self.get_task_bytes()
-                with conn:
-                    conn.sendall(struct.pack('<Q', len(task_bytes)))
-                    conn.sendall(task_bytes)
+                response_thread = threading.Thread(target=self.respond, args=(conn,))
+                response_thread.start()
+                self.response_threads.append(response_thread)
+        except Exception as e:
+            pass
+
+    def respond(self, conn):
+        try:
+            with conn:
+                version = image_decode_task.task_bytes_version1
+                conn.settimeout(task_bytes_version_request_timeout)
+                try:
+                    version_bytes = bytearray()
+                    while len(version_bytes) < 4:
+                        data = conn.recv(4 - len(version_bytes))
+                        if not data:
+                            break
+                        version_bytes += data
+                    if len(version_bytes) == 4:
+                        version = min(max(struct.unpack('<I', version_bytes)[0], image_decode_task.task_bytes_version1), image_decode_task.task_bytes_version2)
+                except socket.timeout:
+                    pass
+                conn.settimeout(None)
+                task_bytes = self.get_task_bytes(version)
+                conn.sendall(struct.pack('<Q', len(task_bytes)))
+                conn.sendall(task_bytes)
         except Exception as e:
             pass
 
@@ -70,6 +110,8 @@ class TaskStatusTcpServer(TaskStatusServer):
         try:
             with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as s:
                 s.connect(('127.0.0.1', self.port))
+                # asking for a version spares the wait for a request
+                s.sendall(struct.pack('<I', image_decode_task.task_bytes_version1))
                 len_bytes = bytearray()
                 while len(len_bytes) < 8:
                     len_bytes += s.recv(8 - len(len_bytes))
@@ -82,21 +124,23 @@ class TaskStatusTcpServer(TaskStatusServer):
             pass
 
 class WsgiApp:
-    def __init__(self, task_bytes):
-        self.task_bytes = task_bytes
+    def __init__(self, get_task_bytes):
+        self.get_task_bytes = get_task_bytes
 
     def __call__(self, environ, start_response):
+        version = int(environ.get('HTTP_' + task_bytes_version_field.upper().replace('-', '_'), image_decode_task.task_bytes_version1))
+        task_bytes = self.get_task_bytes(min(max(version, image_decode_task.task_bytes_version1), image_decode_task.task_bytes_version2))
         headers = [
                 ('Content-type', 'text/plain'),
-                ('Content-Length', str(len(self.task_bytes))),
+                ('Content-Length', str(len(task_bytes))),
                 ]
         start_response('200 OK', headers)
-        return [self.task_bytes]
+        return [task_bytes]
 
 class TaskStatusHttpServer(TaskStatusServer):
     def handle_request(self):
         try:
-            httpd = wsgiref.simple_server.make_server('', self.port, WsgiApp(self.get_task_bytes()))
+            httpd = wsgiref.simple_server.make_server('', self.port, WsgiApp(self.get_task_bytes))
             httpd.handle_request()
             httpd.server_close()
         except Exception as e:
@@ -27,8 +27,13 @@ class SavePartProgress:
         self.left_seconds = 0
 
 class ImageDecodeWorker:
-    def __init__(self, symbol_type, dim):
+    def __init__(self, symbol_type, dim, c_decoder=False):
         self.image_decoder = image_decoder.ImageDecoder(symbol_type, dim)
+        # decode_image_worker hands frames to the c++ decoder if set, the other workers keep the python decoder for its result images
+        self.image_decoder_c = None
+        if c_decoder:
+            import image_decoder_c
+            self.image_decoder_c = image_decoder_c.ImageDecoder(symbol_type, dim)
 
     def fetch_image_worker(self, running, running_lock, frame_q, interval):
         frame_id = 0
@@ -86,8 +91,12 @@ class ImageDecodeWorker:
             if data is None:
                 break
             frame_id, frame = data
-            success, part_id, part_bytes, part_symbols, frame1, result_imgs = self.image_decoder.decode(frame, transform, calibration, False)
-            part_q.put((success, part_id, part_bytes))
+            if self.image_decoder_c:
+                for success, part_id, part_bytes in self.image_decoder_c.decode(frame, transform, calibration):
+                    part_q.put((success, part_id, part_bytes))
+            else:
+                success, part_id, part_bytes, part_symbols, frame1, result_imgs = self.image_decoder.decode(frame, transform, calibration, False)
+                part_q.put((success, part_id, part_bytes))
             frame_num += 1
             if frame_num & 0x7 == 0:
                 transform = get_transform_cb()
@@ -1,5 +1,5 @@
+import math
 import struct
-import collections
 
 import numpy as np
 import cv2 as cv
@@ -18,70 +18,103 @@ class Calibration:
         self.dim = None
         self.tiles = None
 
+    file_magic = 0x4143424c
+    file_version = 2
+
     def load(self, path):
         with open(path, 'rb') as f:
-            self.valid = bool(struct.unpack('<i', f.read(4))[0])
-            if valid:
-                self.dim = struct.unpack('<IIII', f.read(16))
-                tile_x_num, tile_y_num, tile_x_size, tile_y_size = self.dim
-                tiles = [[TileCalibration() for j in range(tile_x_num)] for i in range(tile_y_num)]
-                for tile_y_id in range(tile_y_num):
-                    for tile_x_id in range(tile_x_num):
-                        centers = [[(None, None) for j in range(tile_x_size)] for i in range(tile_y_size)]
-                        tiles[tile_y_id][tile_x_id].centers = centers
-                        for y in range(tile_y_size):
-                            for x in range(tile_x_size):
-                                cx = struct.unpack('<f', f.read(4))[0]
-                                cy = struct.unpack('<f', f.read(4))[0]
-                                centers[y][x] = (cx, cy)
+            calibration_bytes = f.read()
+        self.valid = False
+        if len(calibration_bytes) < 4:
+            return
+        magic = struct.unpack('<I', calibration_bytes[:4])[0]
+        if magic == Calibration.file_magic:
+            version, valid, *dim, center_num = struct.unpack('<IiiiiiI', calibration_bytes[4:32])
+            if version != Calibration.file_version:
+                return
+            if valid and center_num != dim[0] * dim[1] * dim[2] * dim[3]:
+                return
+            xys = np.frombuffer(calibration_bytes, dtype='<f4', count=center_num * 2, offset=32)
+            xs = xys[:center_num]
+            ys = xys[center_num:]
+        else:
+            valid = struct.unpack('<i', calibration_bytes[:4])[0]
+            if not valid:
+                return
+            dim = struct.unpack('<iiii', calibration_bytes[4:20])
+            center_num = dim[0] * dim[1] * dim[2] * dim[3]
+            xys = np.frombuffer(calibration_bytes, dtype='<f4', count=center_num * 2, offset=20)
+            xs = xys[0::2]
+            ys = xys[1::2]
+        self.valid = bool(valid)
+        if not self.valid:
+            return
+        self.dim = tuple(dim)
+        tile_x_num, tile_y_num, tile_x_size, tile_y_size = self.dim
+        self.tiles = [[TileCalibration() for j in range(tile_x_num)] for i in range(tile_y_num)]
+        index = 0
+        for tile_y_id in range(tile_y_num):
+            for tile_x_id in range(tile_x_num):
+                centers = [[(None, None) for j in range(tile_x_size)] for i in range(tile_y_size)]
+                self.tiles[tile_y_id][tile_x_id].centers = centers
+                for y in range(tile_y_size):
+                    for x in range(tile_x_size):
+                        centers[y][x] = (float(xs[index]), float(ys[index]))
+                        index += 1
 
     def save(self, path):
+        xs = []
+        ys = []
+        if self.valid:
+            tile_x_num, tile_y_num, tile_x_size, tile_y_size = self.dim
+            for tile_y_id in range(tile_y_num):
+                for tile_x_id in range(tile_x_num):
+                    centers = self.tiles[tile_y_id][tile_x_id].centers
+                    for y in range(tile_y_size):
+                        for x in range(tile_x_size):
+                            cx, cy = centers[y][x]
+                            xs.append(cx)
+                            ys.append(cy)
+        dim = self.dim if self.valid else (0, 0, 0, 0)
         with open(path, 'wb') as f:
-            f.write(struct.pack('<i', int(self.valid)))
-            if self.valid:
-                f.write(struct.pack('<IIII', *self.dim))
-                tile_x_num, tile_y_num, tile_x_size, tile_y_size = self.dim
-                for tile_y_id in range(tile_y_num):
-                    for tile_x_id in range(tile_x_num):
-                        centers = tiles[tile_y_id][tile_x_id].centers
-                        for y in range(tile_y_size):
-                            for x in range(tile_x_size):
-                                cx, cy = centers[y][x]
-                                f.write(struct.pack('<ff', cx, cy))
+            f.write(struct.pack('<IIiiiiiI', Calibration.file_magic, Calibration.file_version, int(self.valid), *dim, len(xs)))
+            f.write(np.array(xs + ys, dtype='<f4').tobytes())
 
-def find_non_white_boundary_n(img):
-    for i in range(img.shape[0]):
-        for j in range(img.shape[1]):
-            if transform_utils.is_non_white(img, j, i):
-                return i
-    return img.shape[0]
+def get_white_projections(img):
+    img_w = img if len(img.shape) == 2 else np.min(img, axis=2)
+    col_projection = np.min(img_w, axis=0, initial=255)
+    row_projection = np.min(img_w, axis=1, initial=255)
+    return col_projection, row_projection
 
-def find_non_white_boundary_s(img):
-    for i in range(img.shape[0] - 1, -1, -1):
-        for j in range(img.shape[1]):
-            if transform_utils.is_non_white(img, j, i):
-                return i
-    return -1
+def find_non_white_first(projection):
+    indices = np.flatnonzero(projection != 255)
+    return int(indices[0]) if indices.size > 0 else projection.size
 
-def find_non_white_boundary_w(img):
-    for j in range(img.shape[1]):
-        for i in range(img.shape[0]):
-            if transform_utils.is_non_white(img, j, i):
-                return j
-    return img.shape[1]
+def find_non_white_last(projection):
+    indices = np.flatnonzero(projection != 255)
+    return int(indices[-1]) if indices.size > 0 else -1
 
-def find_non_white_boundary_e(img):
-    for j in range(img.shape[1] - 1, -1, -1):
-        for i in range(img.shape[0]):
-            if transform_utils.is_non_white(img, j, i):
-                return j
-    return -1
+def find_spaces(projection):
+    spaces = []
+    space_start = -1
+    for i, is_space in enumerate((projection == 255).tolist()):
+        if space_start >= 0:
+            if not is_space:
+                spaces.append((space_start + i) // 2)
+                space_start = -1
+        else:
+            if is_space:
+                space_start = i
+    if space_start >= 0:
+        spaces.append((space_start + projection.size) // 2)
+    return spaces
 
 def find_tile_bbox1(img):
-    y0 = find_non_white_boundary_n(img)
-    y1 = find_non_white_boundary_s(img)
-    x0 = find_non_white_boundary_w(img)
-    x1 = find_non_white_boundary_e(img)
+    col_projection, row_projection = get_white_projections(img)
+    y0 = find_non_white_first(row_projection)
+    y1 = find_non_white_last(row_projection)
+    x0 = find_non_white_first(col_projection)
+    x1 = find_non_white_last(col_projection)
     return [x0, y0, x1, y1]
 
 def get_tile_bbox2(bbox1, tile_x_size, tile_y_size):
@@ -98,41 +131,8 @@ def get_tile_bbox2(bbox1, tile_x_size, tile_y_size):
     return [x0, y0, x1, y1]
 
 def get_spaces(img):
-    space_xs = []
-    x_space_start_x = -1
-    for j in range(img.shape[1]):
-        is_space = True
-        for i in range(img.shape[0]):
-            if transform_utils.is_non_white(img, j, i):
-                is_space = False
-                break
-        if x_space_start_x >= 0:
-            if not is_space:
-                space_xs.append((x_space_start_x + j) // 2)
-                x_space_start_x = -1
-        else:
-            if is_space:
-                x_space_start_x = j
-    if x_space_start_x >= 0:
-        space_xs.append((x_space_start_x + img.shape[1]) // 2)
-    space_ys = []
-    y_space_start_y = -1
-    for i in range(img.shape[0]):
-        is_space = True
-        for j in range(img.shape[1]):
-            if transform_utils.is_non_white(img, j, i):
-                is_space = False
-                break
-        if y_space_start_y >= 0:
-            if not is_space:
-                space_ys.append((y_space_start_y + i) // 2)
-                y_space_start_y = -1
-        else:
-            if is_space:
-                y_space_start_y = i
-    if y_space_start_y >= 0:
-        space_ys.append((y_space_start_y + img.shape[0]) // 2)
-    return space_xs, space_ys
+    col_projection, row_projection = get_white_projections(img)
+    return find_spaces(col_projection), find_spaces(row_projection)
 
 def get_tile_bboxes(img, tile_x_num, tile_y_num):
     space_xs, space_ys = get_spaces(img)
@@ -148,33 +148,52 @@ def get_tile_bboxes(img, tile_x_num, tile_y_num):
             tile_bboxs[tile_y_id][tile_x_id] = (x0, y0, x1, y1)
     return True, tile_bboxs
 
-def get_non_white_region_bbox(img, x, y):
-    x0 = x
-    y0 = y
-    x1 = x
-    y1 = y
-    visited = set()
-    q = collections.deque()
-    q.append((x, y))
-    while q:
-        px, py = q.popleft()
-        if px - 1 >= 0 and (px - 1, py) not in visited and transform_utils.is_non_white(img, px - 1, py):
-            x0 = min(x0, px - 1)
-            q.append((px - 1, py))
-            visited.add((px - 1, py))
-        if px + 1 < img.shape[1] and (px + 1, py) not in visited and transform_utils.is_non_white(img, px + 1, py):
-            x1 = max(x1, px + 1)
-            q.append((px + 1, py))
-            visited.add((px + 1, py))
-        if py - 1 >= 0 and (px, py - 1) not in visited and transform_utils.is_non_white(img, px, py - 1):
-            y0 = min(y0, py - 1)
-            q.append((px, py - 1))
-            visited.add((px, py - 1))
-        if py + 1 < img.shape[0] and (px, py + 1) not in visited and transform_utils.is_non_white(img, px, py + 1):
-            y1 = max(y1, py + 1)
-            q.append((px, py + 1))
-            visited.add((px, py + 1))
-    return x0, y0, x1 + 1, y1 + 1
+def get_calibration_centers(img_b, row_num, col_num):
+    _, mask = cv.threshold(img_b, 254, 255, cv.THRESH_BINARY_INV)
+    label_num, labels, stats, centroids = cv.connectedComponentsWithStats(mask, connectivity=4, ltype=cv.CV_32S)
+    if label_num <= 1:
+        return False, []
+    areas = stats[1:, cv.CC_STAT_AREA]
+    min_area = int(np.partition(areas, len(areas) // 2)[len(areas) // 2]) // 4
+    centers = []
+    for label in range(1, label_num):
+        if stats[label, cv.CC_STAT_AREA] < min_area:
+            continue
+        x0 = int(stats[label, cv.CC_STAT_LEFT])
+        y0 = int(stats[label, cv.CC_STAT_TOP])
+        x1 = x0 + int(stats[label, cv.CC_STAT_WIDTH])
+        y1 = y0 + int(stats[label, cv.CC_STAT_HEIGHT])
+        centers.append(((x0 + x1) / 2, (y0 + y1) / 2))
+    if len(centers) != row_num * col_num:
+        return False, centers
+    # rows are found in the frame of the grid, the tilt is taken from the edge of its min area rect closest to horizontal
+    rect_points = cv.boxPoints(cv.minAreaRect(np.array(centers, dtype=np.float32)))
+    angle = 0
+    for i in range(2):
+        dx, dy = rect_points[i + 1] - rect_points[i]
+        edge_angle = math.atan2(dy, dx)
+        edge_angle = (edge_angle + math.pi / 2) % math.pi - math.pi / 2
+        if abs(edge_angle) <= math.pi / 4:
+            angle = edge_angle
+    cos_a = math.cos(angle)
+    sin_a = math.sin(angle)
+    def grid_x(c):
+        return c[0] * cos_a + c[1] * sin_a
+    def grid_y(c):
+        return c[1] * cos_a - c[0] * sin_a
+    centers.sort(key=grid_y)
+    row_ys = []
+    for y in range(row_num):
+        centers[y * col_num:(y + 1) * col_num] = sorted(centers[y * col_num:(y + 1) * col_num], key=grid_x)
+        ys = [grid_y(c) for c in centers[y * col_num:(y + 1) * col_num]]
+        row_ys.append((min(ys), max(ys)))
+    # a row mixing centers of two rows would give wrong centers, which is worse than none
+    if row_num > 1:
+        row_pitches = sorted((row_ys[y + 1][0] + row_ys[y + 1][1] - row_ys[y][0] - row_ys[y][1]) / 2 for y in range(row_num - 1))
+        row_pitch = row_pitches[len(row_pitches) // 2]
+        if any(y1 - y0 >= row_pitch / 2 for y0, y1 in row_ys):
+            return False, centers
+    return True, centers
 
 def get_symbol(img, cx, cy):
     RADIUS = 1
@@ -182,7 +201,7 @@ def get_symbol(img, cx, cy):
     y0 = max(round(cy - RADIUS), 0)
     x1 = min(round(cx + RADIUS + 1), img.shape[1])
     y1 = min(round(cy + RADIUS + 1), img.shape[0])
-    symbol_cnt = [0, 0, 0, 0, 0, 0, 0, 0, 0]
+    symbol_cnt = [0] * image_codec_types.PixelColor.NUM.value
     for y in range(y0, y1):
         for x in range(x0, x1):
             if transform_utils.is_white(img, x, y):
@@ -322,24 +341,11 @@ class ImageDecoder:
         img1_b = transform_utils.do_binarize(img1, transform.binarization_threshold)
         calibration = Calibration()
         result_imgs = [[None for j in range(tile_x_num)] for i in range(tile_y_num)]
-        centers = []
-        start_x = 0
-        start_y = [0 for i in range(tile_x_num * tile_x_size)]
-        for y in range(tile_y_num * tile_y_size):
-            for x in range(tile_x_num * tile_x_size):
-                if start_x >= img1_b.shape[1] or start_y[x] >= img1_b.shape[0]:
-                    if result_image:
-                        result_imgs[0][0] = cv.cvtColor(img1_b, cv.COLOR_GRAY2BGR)
-                    return img1, calibration, result_imgs
-                img2_b = transform_utils.do_crop(img1_b, (start_x, start_y[x], img1.shape[1], img1.shape[0]))
-                corner_x, corner_y = transform_utils.detect_non_white_corner_nw(img2_b)
-                x0, y0, x1, y1 = get_non_white_region_bbox(img2_b, corner_x, corner_y)
-                cx = (x0 + x1) / 2 + start_x
-                cy = (y0 + y1) / 2 + start_y[x]
-                centers.append((cx, cy))
-                start_x += x1
-                start_y[x] += y1
-            start_x = 0
+        calibration_success, centers = get_calibration_centers(img1_b, tile_y_num * tile_y_size, tile_x_num * tile_x_size)
+        if not calibration_success:
+            if result_image:
+                result_imgs[0][0] = cv.cvtColor(img1_b, cv.COLOR_GRAY2BGR)
+            return img1, calibration, result_imgs
         calibration.valid = True
         calibration.dim = self.dim
         calibration.tiles = [[TileCalibration() for j in range(tile_x_num)] for i in range(tile_y_num)]
@@ -0,0 +1,93 @@
+import ctypes
+import threading
+
+import numpy as np
+
+import clib_utils
+
+clib = clib_utils.load_library('image_codec')
+clib.create_image_decoder_c.argtypes = [ctypes.c_char_p, ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_int]
+clib.create_image_decoder_c.restype = ctypes.c_void_p
+clib.destroy_image_decoder_c.argtypes = [ctypes.c_void_p]
+clib.image_decoder_frame_part_num_c.argtypes = [ctypes.c_void_p]
+clib.image_decoder_frame_part_num_c.restype = ctypes.c_int
+clib.image_decoder_padded_part_byte_num_c.argtypes = [ctypes.c_void_p]
+clib.image_decoder_padded_part_byte_num_c.restype = ctypes.c_int
+clib.create_calibration_c.argtypes = [ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.POINTER(ctypes.c_float), ctypes.POINTER(ctypes.c_float), ctypes.c_size_t]
+clib.create_calibration_c.restype = ctypes.c_void_p
+clib.destroy_calibration_c.argtypes = [ctypes.c_void_p]
+clib.image_decoder_decode_c.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_bool), ctypes.POINTER(ctypes.c_uint32), ctypes.c_void_p, ctypes.c_void_p, ctypes.c_int, ctypes.c_int, ctypes.c_size_t, ctypes.POINTER(ctypes.c_float), ctypes.POINTER(ctypes.c_float), ctypes.c_int, ctypes.c_int, ctypes.POINTER(ctypes.c_int), ctypes.c_void_p]
+clib.image_decoder_decode_c.restype = ctypes.c_int
+
+class ImageDecoder:
+    def __init__(self, symbol_type, dim, frame_part_num=1):
+        self.dim = dim
+        self.handle = clib.create_image_decoder_c(symbol_type.name.lower().encode(), *dim, frame_part_num)
+        if not self.handle:
+            raise ValueError(f'can\'t create image decoder for {symbol_type.name} {dim}')
+        self.frame_part_num = clib.image_decoder_frame_part_num_c(self.handle)
+        self.padded_part_byte_num = clib.image_decoder_padded_part_byte_num_c(self.handle)
+        # entries are [calibration, handle, decode num], decode threads may still use an older calibration
+        # while a newer one is created, so older handles are released once no decode uses them
+        self.calibrations = []
+        self.calibration_lock = threading.Lock()
+
+    def destroy(self):
+        with self.calibration_lock:
+            for calibration, calibration_handle, decode_num in self.calibrations:
+                clib.destroy_calibration_c(calibration_handle)
+            self.calibrations.clear()
+        clib.destroy_image_decoder_c(self.handle)
+
+    def acquire_calibration(self, calibration):
+        if not calibration.valid:
+            return None
+        with self.calibration_lock:
+            if not self.calibrations or self.calibrations[-1][0] is not calibration:
+                tile_x_num, tile_y_num, tile_x_size, tile_y_size = calibration.dim
+                centers = [center for tiles in calibration.tiles for tile in tiles for row in tile.centers for center in row]
+                center_xs = (ctypes.c_float * len(centers))(*[center[0] for center in centers])
+                center_ys = (ctypes.c_float * len(centers))(*[center[1] for center in centers])
+                calibration_handle = clib.create_calibration_c(tile_x_num, tile_y_num, tile_x_size, tile_y_size, center_xs, center_ys, len(centers))
+                if not calibration_handle:
+                    raise ValueError(f'calibration has {len(centers)} centers, which doesn\'t match its dim {calibration.dim}')
+                self.calibrations.append([calibration, calibration_handle, 0])
+                self.release_unused_calibrations()
+            entry = self.calibrations[-1]
+            entry[2] += 1
+            return entry
+
+    def release_calibration(self, entry):
+        if entry is None:
+            return
+        with self.calibration_lock:
+            entry[2] -= 1
+            self.release_unused_calibrations()
+
+    # called with calibration_lock held, the latest calibration is kept for the next frames
+    def release_unused_calibrations(self):
+        kept = []
+        for entry in self.calibrations[:-1]:
+            if entry[2] == 0:
+                clib.destroy_calibration_c(entry[1])
+            else:
+                kept.append(entry)
+        self.calibrations[:-1] = kept
+
+    # img is a bgr frame as returned by opencv, it is handed to the c++ decoder without a copy
+    def decode(self, img, transform, calibration):
+        if img.dtype != np.uint8 or img.ndim != 3 or img.shape[2] != 3 or img.strides[1] != 3 or img.strides[2] != 1:
+            img = np.ascontiguousarray(img, dtype=np.uint8)
+        success_array = (ctypes.c_bool * self.frame_part_num)()
+        part_id_array = (ctypes.c_uint32 * self.frame_part_num)()
+        padded_part_bytes = bytearray(self.padded_part_byte_num * self.frame_part_num)
+        bbox = (ctypes.c_float * 4)(*transform.bbox)
+        sphere = (ctypes.c_float * 4)(*transform.sphere)
+        pixelization_threshold = (ctypes.c_int * 3)(*transform.pixelization_threshold)
+        entry = self.acquire_calibration(calibration)
+        try:
+            # a failed decode marks every part as failed, the frame is then dropped like an undecodable one
+            clib.image_decoder_decode_c(self.handle, success_array, part_id_array, ctypes.addressof(ctypes.c_uint8.from_buffer(padded_part_bytes)), img.ctypes.data, img.shape[1], img.shape[0], img.strides[0], bbox, sphere, transform.filter_level, transform.binarization_threshold, pixelization_threshold, entry[1] if entry else None)
+        finally:
+            self.release_calibration(entry)
+        return [(success_array[i], part_id_array[i], padded_part_bytes[i*self.padded_part_byte_num:(i+1)*self.padded_part_byte_num]) for i in range(self.frame_part_num)]
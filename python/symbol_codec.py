@@ -2,15 +2,25 @@ import enum
 import struct
 import zlib
 
+import image_codec_types
+
 @enum.unique
 class SymbolType(enum.Enum):
     SYMBOL1 = 0
     SYMBOL2 = 1
     SYMBOL3 = 2
+    SYMBOL1_RS = 3
+    SYMBOL2_RS = 4
+    SYMBOL3_RS = 5
+    SYMBOL4 = 6
+    SYMBOL4_RS = 7
 
 def parse_symbol_type(symbol_type_str):
     return SymbolType[symbol_type_str.upper()]
 
+def is_fec_symbol_type(symbol_type):
+    return symbol_type in (SymbolType.SYMBOL1_RS, SymbolType.SYMBOL2_RS, SymbolType.SYMBOL3_RS, SymbolType.SYMBOL4_RS)
+
 def encrypt_bytes(bytes1):
     bytes1 = bytearray(reversed(bytes1))
     for i in range(len(bytes1)):
@@ -25,12 +35,25 @@ class SymbolCodec:
     part_id_byte_num = 4
     meta_byte_num = crc_byte_num + part_id_byte_num
 
+    fec_parity_byte_num = 32
+    fec_max_codeword_byte_num = 255
+
     symbol_type = None
     bit_num_per_symbol = None
+    has_fec = False
 
     def get_symbol_value_num(self):
         return 2 ** self.bit_num_per_symbol
 
+    def get_fec_parity_byte_num(self, frame_size):
+        if not self.has_fec:
+            return 0
+        byte_num = frame_size * self.bit_num_per_symbol // 8
+        return (byte_num + self.fec_max_codeword_byte_num - 1) // self.fec_max_codeword_byte_num * self.fec_parity_byte_num
+
+    def get_padded_part_byte_num(self, frame_size):
+        return frame_size * self.bit_num_per_symbol // 8 - self.meta_byte_num - self.get_fec_parity_byte_num(frame_size)
+
     def bytes_to_symbols(self, b):
         raise NotImplementedError()
 
@@ -100,10 +123,64 @@ class Symbol3Codec(SymbolCodec):
         s = s[:len(s) // 8 * 8]
         return bytes([int(s[i:i+8], 2) for i in range(0, len(s), 8)])
 
+# red and blue carry one bit each and the four green levels carry two gray coded bits
+def get_symbol4_colors():
+    PixelColor = image_codec_types.PixelColor
+    green_level_colors = [
+        [PixelColor.BLACK,   PixelColor.DARK_GREEN, PixelColor.MID_GREEN,  PixelColor.GREEN],
+        [PixelColor.BLUE,    PixelColor.ROYAL_BLUE, PixelColor.AZURE,      PixelColor.CYAN],
+        [PixelColor.RED,     PixelColor.VERMILION,  PixelColor.ORANGE,     PixelColor.YELLOW],
+        [PixelColor.MAGENTA, PixelColor.PINK,       PixelColor.LIGHT_PINK, PixelColor.WHITE],
+        ]
+    colors = [None] * 16
+    for red_blue in range(4):
+        for level in range(4):
+            colors[(red_blue << 2) | (level ^ (level >> 1))] = green_level_colors[red_blue][level].value
+    return colors
+
+class Symbol4Codec(SymbolCodec):
+    symbol_type = SymbolType.SYMBOL4
+    bit_num_per_symbol = 4
+    colors = get_symbol4_colors()
+    color_bits = {color: bits for bits, color in enumerate(colors)}
+
+    def bytes_to_symbols(self, b):
+        return [self.colors[(e >> k) & 0xf] for e in b for k in (4, 0)]
+
+    def symbols_to_bytes(self, symbols):
+        return bytes([(self.color_bits.get(symbols[i], 0) << 4) | self.color_bits.get(symbols[i+1], 0) for i in range(0, len(symbols) - 1, 2)])
+
+# reed-solomon coded frames are only encoded and decoded by the native codec
+class SymbolRsCodecMixin:
+    has_fec = True
+
+    def encode(self, part_id, part_bytes, frame_size):
+        raise NotImplementedError('{} is only supported by symbol_codec_c'.format(self.symbol_type.name.lower()))
+
+    def decode(self, symbols):
+        raise NotImplementedError('{} is only supported by symbol_codec_c'.format(self.symbol_type.name.lower()))
+
+class Symbol1RsCodec(SymbolRsCodecMixin, Symbol1Codec):
+    symbol_type = SymbolType.SYMBOL1_RS
+
+class Symbol2RsCodec(SymbolRsCodecMixin, Symbol2Codec):
+    symbol_type = SymbolType.SYMBOL2_RS
+
+class Symbol3RsCodec(SymbolRsCodecMixin, Symbol3Codec):
+    symbol_type = SymbolType.SYMBOL3_RS
+
+class Symbol4RsCodec(SymbolRsCodecMixin, Symbol4Codec):
+    symbol_type = SymbolType.SYMBOL4_RS
+
 symbol_type_to_symbol_codec_mapping = {
     SymbolType.SYMBOL1: Symbol1Codec,
     SymbolType.SYMBOL2: Symbol2Codec,
     SymbolType.SYMBOL3: Symbol3Codec,
+    SymbolType.SYMBOL1_RS: Symbol1RsCodec,
+    SymbolType.SYMBOL2_RS: Symbol2RsCodec,
+    SymbolType.SYMBOL3_RS: Symbol3RsCodec,
+    SymbolType.SYMBOL4: Symbol4Codec,
+    SymbolType.SYMBOL4_RS: Symbol4RsCodec,
     }
 
 def create_symbol_codec(symbol_type):
@@ -10,6 +10,15 @@ clib.symbol_codec_meta_byte_num_c.argtypes = []
 clib.symbol_codec_meta_byte_num_c.restype = ctypes.c_int
 clib.symbol_codec_bit_num_per_symbol_c.argtypes = [ctypes.c_void_p]
 clib.symbol_codec_bit_num_per_symbol_c.restype = ctypes.c_int
+clib.symbol_codec_padded_part_byte_num_c.argtypes = [ctypes.c_void_p, ctypes.c_size_t]
+clib.symbol_codec_padded_part_byte_num_c.restype = ctypes.c_int
+clib.symbol_codec_encode_c.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_uint32, ctypes.c_char_p, ctypes.c_int, ctypes.c_int]
+clib.symbol_codec_decode_c.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_bool), ctypes.POINTER(ctypes.c_uint32), ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t]
+clib.symbol_codec_encode_batch_c.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.POINTER(ctypes.c_uint32), ctypes.c_char_p, ctypes.c_int, ctypes.c_int, ctypes.c_size_t]
+clib.symbol_codec_decode_batch_c.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_bool), ctypes.POINTER(ctypes.c_uint32), ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t, ctypes.c_size_t]
+
+def get_buffer_address(buf):
+    return ctypes.addressof(ctypes.c_uint8.from_buffer(buf)) if len(buf) else None
 
 class SymbolCodec:
     def __init__(self, symbol_type):
@@ -22,16 +31,32 @@ class SymbolCodec:
 
     def encode(self, part_id, part_bytes, frame_size):
         symbol_bytes = bytearray(frame_size)
-        clib.symbol_codec_encode_c.argtypes = [ctypes.c_void_p, ctypes.c_uint8 * frame_size, ctypes.c_uint32, ctypes.c_char_p, ctypes.c_int, ctypes.c_int]
-        clib.symbol_codec_encode_c(self.handle, (ctypes.c_uint8 * frame_size).from_buffer(symbol_bytes), part_id, part_bytes, len(part_bytes), frame_size)
+        clib.symbol_codec_encode_c(self.handle, get_buffer_address(symbol_bytes), part_id, bytes(part_bytes), len(part_bytes), frame_size)
         return list(symbol_bytes)
 
     def decode(self, symbols):
-        symbol_ctypes_bytes = bytes(symbols)
+        symbol_ctypes_bytes = symbols if isinstance(symbols, bytes) else bytes(symbols)
         success = ctypes.c_bool(False)
         part_id = ctypes.c_uint32(0)
-        padded_part_byte_num = len(symbols) * self.bit_num_per_symbol // 8 - self.meta_byte_num
+        padded_part_byte_num = clib.symbol_codec_padded_part_byte_num_c(self.handle, len(symbols))
         padded_part_bytes = bytearray(padded_part_byte_num)
-        clib.symbol_codec_decode_c.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_bool), ctypes.POINTER(ctypes.c_uint32), ctypes.c_uint8 * padded_part_byte_num, ctypes.c_char_p, ctypes.c_int]
-        clib.symbol_codec_decode_c(self.handle, ctypes.pointer(success), ctypes.pointer(part_id), (ctypes.c_uint8 * padded_part_byte_num).from_buffer(padded_part_bytes), symbol_ctypes_bytes, len(symbols))
+        clib.symbol_codec_decode_c(self.handle, ctypes.byref(success), ctypes.byref(part_id), get_buffer_address(padded_part_bytes), symbol_ctypes_bytes, len(symbols))
         return success.value, part_id.value, padded_part_bytes
+
+    # part_bytes holds len(part_ids) parts of part_byte_num bytes each, the returned buffer holds one frame of frame_size symbols per part
+    def encode_batch(self, part_ids, part_bytes, part_byte_num, frame_size):
+        part_num = len(part_ids)
+        symbol_bytes = bytearray(frame_size * part_num)
+        part_id_array = (ctypes.c_uint32 * part_num)(*part_ids)
+        clib.symbol_codec_encode_batch_c(self.handle, get_buffer_address(symbol_bytes), part_id_array, part_bytes if isinstance(part_bytes, bytes) else bytes(part_bytes), part_byte_num, frame_size, part_num)
+        return symbol_bytes
+
+    # symbol_bytes holds frames of frame_size symbols each, the returned buffer holds one padded part per frame
+    def decode_batch(self, symbol_bytes, frame_size):
+        part_num = len(symbol_bytes) // frame_size if frame_size else 0
+        success_array = (ctypes.c_bool * part_num)()
+        part_id_array = (ctypes.c_uint32 * part_num)()
+        padded_part_byte_num = clib.symbol_codec_padded_part_byte_num_c(self.handle, frame_size)
+        padded_part_bytes = bytearray(padded_part_byte_num * part_num)
+        clib.symbol_codec_decode_batch_c(self.handle, success_array, part_id_array, get_buffer_address(padded_part_bytes), symbol_bytes if isinstance(symbol_bytes, bytes) else bytes(symbol_bytes), frame_size, part_num)
+        return list(success_array), list(part_id_array), padded_part_bytes
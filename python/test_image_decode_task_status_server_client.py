@@ -3,6 +3,8 @@ import sys
 import time
 
 import server_utils
+import symbol_codec
+import image_decode_task
 import image_decode_task_status_server
 import image_decode_task_status_client
 
@@ -14,21 +16,36 @@ args = parser.parse_args()
 
 server_type = server_utils.parse_server_type(args.server_type)
 
-task_bytes1 = bytes([i % 256 for i in range(args.task_byte_num)])
+# task_byte_num status bytes of a task with every other byte done, and of a task nearly done
+part_num = args.task_byte_num * 8
+task_status_bytes = bytes([0xff if i % 2 else 0 for i in range(args.task_byte_num)])
+task_status_bytes1 = bytes([0xfe if i % 125 == 0 else 0xff for i in range(args.task_byte_num)])
+dim = (1, 1, 10, 10)
+task_bytes_list = [
+    image_decode_task.to_task_bytes(symbol_codec.SymbolType.SYMBOL1, dim, part_num, part_num // 2, task_status_bytes),
+    image_decode_task.to_task_bytes(symbol_codec.SymbolType.SYMBOL1, dim, part_num, part_num - (args.task_byte_num + 124) // 125, task_status_bytes1),
+    ]
 
 task_status_server = image_decode_task_status_server.create_task_status_server(server_type)
-task_status_server.update_task_status(task_bytes1)
 task_status_server.start(args.port)
 
-task_status_client = image_decode_task_status_client.create_task_status_client(server_type, '127.0.0.1', args.port)
-success = False
-for i in range(3):
-    task_bytes2 = task_status_client.get_task_status()
-    if task_bytes1 == task_bytes2:
-        success = True
-        break
-    else:
-        time.sleep(1)
+success = True
+for task_bytes1 in task_bytes_list:
+    for server_version in (image_decode_task.task_bytes_version1, image_decode_task.task_bytes_version2):
+        task_status_server.update_task_status(image_decode_task.convert_task_bytes(task_bytes1, server_version))
+        for client_version in (image_decode_task.task_bytes_version1, image_decode_task.task_bytes_version2):
+            task_status_client = image_decode_task_status_client.create_task_status_client(server_type, '127.0.0.1', args.port, client_version)
+            success1 = False
+            for i in range(3):
+                task_bytes2 = task_status_client.get_task_status()
+                if task_bytes2 and image_decode_task.get_task_bytes_version(task_bytes2) == client_version and image_decode_task.convert_task_bytes(task_bytes2, image_decode_task.task_bytes_version1) == task_bytes1:
+                    success1 = True
+                    break
+                else:
+                    time.sleep(1)
+            success = success and success1
+# only the undone parts of the nearly done task are sent
+success = success and len(image_decode_task.convert_task_bytes(task_bytes_list[1], image_decode_task.task_bytes_version2)) * 10 < len(task_bytes_list[1])
 
 task_status_server.stop()
 
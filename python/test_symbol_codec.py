@@ -32,6 +32,7 @@ is_pass = True
 is_pass = is_pass and test_symbol_codec('symbol1')
 is_pass = is_pass and test_symbol_codec('symbol2')
 is_pass = is_pass and test_symbol_codec('symbol3')
+is_pass = is_pass and test_symbol_codec('symbol4')
 if is_pass:
     print('pass')
     sys.exit(0)
@@ -53,10 +53,59 @@ def test_symbol_codec(symbol_type_str):
     codec_c.destroy()
     return True
 
+def test_fec_symbol_codec(symbol_type_str):
+    symbol_type = symbol_codec.parse_symbol_type(symbol_type_str)
+    codec_c = symbol_codec_c.SymbolCodec(symbol_type)
+
+    part_id = 0
+    for frame_size in range(0, 4096, 29):
+        part_byte_num = image_decode_task.get_part_byte_num(symbol_type, (1, 1, frame_size, 1))
+        if part_byte_num >= image_decode_task.Task.min_part_byte_num:
+            part_bytes = bytes([i % 256 for i in range(part_byte_num)])
+            symbols_c = codec_c.encode(part_id, part_bytes, frame_size)
+            symbols_c[frame_size // 2] ^= 1
+            success_c, part_id_c, part_bytes_c = codec_c.decode(symbols_c)
+            if not success_c or part_id != part_id_c or part_bytes != part_bytes_c:
+                print('{} codec {} fail'.format(symbol_type_str, frame_size))
+                return False
+            part_id += 1
+    print('{} codec {} tests pass'.format(symbol_type_str, part_id))
+    codec_c.destroy()
+    return True
+
+def test_symbol_codec_batch(symbol_type_str):
+    symbol_type = symbol_codec.parse_symbol_type(symbol_type_str)
+    codec_c = symbol_codec_c.SymbolCodec(symbol_type)
+
+    frame_size = 1000
+    part_num = 17
+    part_byte_num = image_decode_task.get_part_byte_num(symbol_type, (1, 1, frame_size, 1))
+    part_ids = [i * 3 for i in range(part_num)]
+    part_bytes = bytes([(i * 7) % 256 for i in range(part_byte_num * part_num)])
+    symbol_bytes = codec_c.encode_batch(part_ids, part_bytes, part_byte_num, frame_size)
+    successes, part_ids_c, part_bytes_c = codec_c.decode_batch(symbol_bytes, frame_size)
+    for i in range(part_num):
+        if bytes(symbol_bytes[i*frame_size:(i+1)*frame_size]) != bytes(codec_c.encode(part_ids[i], part_bytes[i*part_byte_num:(i+1)*part_byte_num], frame_size)):
+            print('{} codec batch encode {} fail'.format(symbol_type_str, i))
+            return False
+    if not all(successes) or part_ids_c != part_ids or part_bytes_c != part_bytes:
+        print('{} codec batch decode fail'.format(symbol_type_str))
+        return False
+    print('{} codec batch pass'.format(symbol_type_str))
+    codec_c.destroy()
+    return True
+
 is_pass = True
 is_pass = is_pass and test_symbol_codec('symbol1')
 is_pass = is_pass and test_symbol_codec('symbol2')
 is_pass = is_pass and test_symbol_codec('symbol3')
+is_pass = is_pass and test_symbol_codec('symbol4')
+is_pass = is_pass and test_symbol_codec_batch('symbol2')
+is_pass = is_pass and test_symbol_codec_batch('symbol4_rs')
+is_pass = is_pass and test_fec_symbol_codec('symbol1_rs')
+is_pass = is_pass and test_fec_symbol_codec('symbol2_rs')
+is_pass = is_pass and test_fec_symbol_codec('symbol3_rs')
+is_pass = is_pass and test_fec_symbol_codec('symbol4_rs')
 if is_pass:
     print('pass')
     sys.exit(0)
@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+
+#include <boost/program_options.hpp>
+
+#include "image_codec.h"
+
+void remove_task_files(const std::string& output_file) {
+    std::filesystem::remove(output_file + ".task");
+    std::filesystem::remove(output_file + ".task.journal");
+    std::filesystem::remove(output_file + ".blob");
+}
+
+// saves part_num parts of part_byte_num bytes through a task, returns parts per second or 0 if the storage is not supported
+double benchmark(BlobStorageType blob_storage_type, const std::string& output_file, int part_byte_num, uint32_t part_num, int shuffle_window, size_t write_behind_byte_budget) {
+    remove_task_files(output_file);
+    // symbol1 frames with dim {1, 1, (part_byte_num + 8) * 8, 1} carry part_byte_num bytes
+    Dim dim = {1, 1, (part_byte_num + SymbolCodec::META_BYTE_NUM) * 8, 1};
+    auto task = std::make_unique<Task>(output_file, blob_storage_type);
+    task->SetWriteBehind(write_behind_byte_budget);
+    task->Init(SymbolType::SYMBOL1, dim, part_num);
+    if (!task->AllocateBlob()) throw std::runtime_error("can't allocate blob of " + std::to_string(static_cast<uint64_t>(part_byte_num) * part_num) + " bytes");
+
+    // parts arrive mostly in order, lost parts come back in later rounds
+    std::vector<uint32_t> part_ids(part_num);
+    for (uint32_t part_id = 0; part_id < part_num; ++part_id) part_ids[part_id] = part_id;
+    std::mt19937 rng(0);
+    if (shuffle_window > 1) {
+        for (size_t i = 0; i < part_ids.size(); i += shuffle_window) {
+            std::shuffle(part_ids.begin() + i, part_ids.begin() + std::min(i + shuffle_window, part_ids.size()), rng);
+        }
+    }
+    Bytes part_bytes(part_byte_num);
+    for (auto& b : part_bytes) b = static_cast<Byte>(rng() | 1);
+
+    auto start_time = std::chrono::steady_clock::now();
+    try {
+        for (auto part_id : part_ids) {
+            task->UpdatePart(part_id, part_bytes);
+        }
+    }
+    catch (const std::exception& e) {
+        std::cout << get_blob_storage_type_str(blob_storage_type) << " skipped, " << e.what() << "\n";
+        task.reset();
+        remove_task_files(output_file);
+        return 0;
+    }
+    task->Flush();
+    // with write behind the flush only queues the parts, destroying the task waits for the io thread to write them
+    auto write_behind_stats = task->GetWriteBehindStats();
+    task.reset();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    if (write_behind_stats.flush_num) {
+        std::cout << get_blob_storage_type_str(blob_storage_type) << " " << write_behind_stats.flush_num << " write behind flushes before the final one, max flush time " << std::fixed << std::setprecision(3) << write_behind_stats.max_flush_seconds << "s\n";
+    }
+    remove_task_files(output_file);
+    return part_num / seconds;
+}
+
+int main(int argc, char** argv) {
+    try {
+        std::string output_dir = std::filesystem::temp_directory_path().string();
+        std::string blob_storage_types_str = "stream,mmap,pwritev,io_uring";
+        int part_byte_num = 1024;
+        uint32_t part_num = 1 << 18;
+        int shuffle_window = 64;
+        size_t write_behind_mb = 0;
+        boost::program_options::options_description desc("usage");
+        auto desc_handler = desc.add_options();
+        desc_handler("help", "help message");
+        desc_handler("output_dir", boost::program_options::value<std::string>(&output_dir), "dir of the blob files");
+        desc_handler("blob_storage", boost::program_options::value<std::string>(&blob_storage_types_str), "comma separated blob storage backends");
+        desc_handler("part_byte_num", boost::program_options::value<int>(&part_byte_num), "part byte num");
+        desc_handler("part_num", boost::program_options::value<uint32_t>(&part_num), "part num");
+        desc_handler("shuffle_window", boost::program_options::value<int>(&shuffle_window), "parts are saved in random order within windows of this many parts");
+        desc_handler("write_behind_mb", boost::program_options::value<size_t>(&write_behind_mb), "MiB of parts buffered for the io thread, 0 saves parts inline");
+        boost::program_options::variables_map vm;
+        boost::program_options::store(boost::program_options::command_line_parser(argc, argv).options(desc).run(), vm);
+        boost::program_options::notify(vm);
+
+        if (vm.count("help")) {
+            std::cout << desc << "\n";
+            return 1;
+        }
+
+        check_is_dir(output_dir);
+        if (part_byte_num < Task::MIN_PART_BYTE_NUM) throw invalid_image_codec_argument("part_byte_num should be at least " + std::to_string(Task::MIN_PART_BYTE_NUM));
+        std::vector<BlobStorageType> blob_storage_types;
+        std::istringstream iss(blob_storage_types_str);
+        std::string blob_storage_type_str;
+        while (std::getline(iss, blob_storage_type_str, ',')) {
+            blob_storage_types.push_back(parse_blob_storage_type(blob_storage_type_str));
+        }
+
+        auto output_file = (std::filesystem::path(output_dir) / "benchmark_blob_storage").string();
+        for (auto blob_storage_type : blob_storage_types) {
+            double parts_per_second = benchmark(blob_storage_type, output_file, part_byte_num, part_num, shuffle_window, write_behind_mb << 20);
+            if (parts_per_second == 0) continue;
+            std::cout << std::setw(8) << get_blob_storage_type_str(blob_storage_type) << " " << std::fixed << std::setprecision(0) << parts_per_second << " parts/s, " << std::setprecision(1) << parts_per_second * part_byte_num / (1 << 20) << " MiB/s\n";
+        }
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << "\n";
+    }
+
+    return 0;
+}
@@ -1,5 +1,6 @@
 #include <iostream>
 #include <map>
+#include <bitset>
 #include <exception>
 #include <thread>
 #include <filesystem>
@@ -31,13 +32,15 @@ void decode(ImageDecoder* image_decoder, const cv::Mat& img, const Transform tra
     if (part_symbols.empty()) {
         std::cout << "symbols decode fail\n";
     } else {
+        const auto& constellation = get_constellation(image_decoder->GetSymbolCodec().GetSymbolType());
         int mismatch_count = 0;
+        int bit_mismatch_count = 0;
         std::map<Symbol, std::map<Symbol, int>> mismatch_counts;
         for (int tile_y_id = 0; tile_y_id < dim.tile_y_num; ++tile_y_id) {
             for (int tile_x_id = 0; tile_x_id < dim.tile_x_num; ++tile_x_id) {
                 for (int y = 0; y < dim.tile_y_size; ++y) {
                     for (int x = 0; x < dim.tile_x_size; ++x) {
-                        Symbol golden_symbol = (x + y + tile_x_id + tile_y_id) % image_decoder->GetSymbolCodec().SymbolValueNum();
+                        Symbol golden_symbol = get_color_calibration_symbol(image_decoder->GetSymbolCodec().GetSymbolType(), tile_x_id, tile_y_id, x, y);
                         int index = ((tile_y_id * dim.tile_x_num + tile_x_id) * dim.tile_y_size + y) * dim.tile_x_size + x;
                         auto actual_symbol = part_symbols[index];
                         if (actual_symbol != golden_symbol) {
@@ -45,6 +48,7 @@ void decode(ImageDecoder* image_decoder, const cv::Mat& img, const Transform tra
                                 std::cout << "symbol_" << tile_x_id << "_" << tile_y_id << "_" << x << "_" << y << ": " << get_pixel_color(golden_symbol) << " -> " << get_pixel_color(actual_symbol) << "\n";
                             }
                             ++mismatch_count;
+                            bit_mismatch_count += static_cast<int>(std::bitset<8>(constellation.SymbolToBits(golden_symbol) ^ constellation.SymbolToBits(actual_symbol)).count());
                             ++mismatch_counts[golden_symbol][actual_symbol];
                         }
                     }
@@ -59,6 +63,7 @@ void decode(ImageDecoder* image_decoder, const cv::Mat& img, const Transform tra
             }
         }
         std::cout << "mismatch count " << mismatch_count << "\n";
+        std::cout << "bit mismatch count " << bit_mismatch_count << "\n";
         if (mismatch_counts.empty()) {
             std::cout << "color calibration pass\n";
         } else {
@@ -73,7 +78,7 @@ bool is_mismatch(const Symbols& part_symbols, ImageDecoder* image_decoder, const
         for (int tile_x_id = 0; tile_x_id < dim.tile_x_num; ++tile_x_id) {
             for (int y = 0; y < dim.tile_y_size; ++y) {
                 for (int x = 0; x < dim.tile_x_size; ++x) {
-                    Symbol golden_symbol = (x + y + tile_x_id + tile_y_id) % image_decoder->GetSymbolCodec().SymbolValueNum();
+                    Symbol golden_symbol = get_color_calibration_symbol(image_decoder->GetSymbolCodec().GetSymbolType(), tile_x_id, tile_y_id, x, y);
                     int index = ((tile_y_id * dim.tile_x_num + tile_x_id) * dim.tile_y_size + y) * dim.tile_x_size + x;
                     auto actual_symbol = part_symbols[index];
                     if (actual_symbol != golden_symbol) {
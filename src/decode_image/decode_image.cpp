@@ -26,10 +26,14 @@ void decode(ImageDecoder* image_decoder, const cv::Mat& img, const Transform tra
             }
         }
     }
-    if (success) {
-        std::cout << "pass part_id=" << part_id << "\n";
-    } else {
-        std::cout << "fail\n";
+    DecodeResults results;
+    image_decoder->DecodeParts(part_symbols, results);
+    for (const auto& [success1, part_id1, part_bytes1] : results) {
+        if (success1) {
+            std::cout << "pass part_id=" << part_id1 << "\n";
+        } else {
+            std::cout << "fail\n";
+        }
     }
 }
 
@@ -38,6 +42,7 @@ using ResultQueue = ThreadSafeQueue<std::tuple<bool, int, int, int>>;
 
 void scan1_worker(ResultQueue& q_result, InputQueue& q_in, ImageDecoder* image_decoder, const cv::Mat& img, const Transform transform, const Calibration& calibration) {
     Transform transform1 = transform;
+    SampleMap sample_map;
     while (true) {
         auto data = q_in.Pop();
         if (!data) break;
@@ -45,7 +50,7 @@ void scan1_worker(ResultQueue& q_result, InputQueue& q_in, ImageDecoder* image_d
         transform1.pixelization_threshold[0] = b;
         transform1.pixelization_threshold[1] = g;
         transform1.pixelization_threshold[2] = r;
-        auto [success, part_id, part_bytes, part_symbols, img1, result_imgs] = image_decoder->Decode(img, transform1, calibration, true);
+        auto [success, part_id, part_bytes, part_symbols, img1, result_imgs] = image_decoder->Decode(img, transform1, calibration, sample_map);
         if (success) {
             q_result.Emplace(true, b, g, r);
         } else {
@@ -104,12 +109,13 @@ void scan1(ImageDecoder* image_decoder, const cv::Mat& img, const Transform tran
 }
 
 void scan2(ImageDecoder* image_decoder, const cv::Mat& img, const Transform transform, const Calibration& calibration) {
+    SampleMap sample_map;
     for (int c = 0; c < 256; ++c) {
         Transform transform1 = transform;
         transform1.pixelization_threshold[0] = c;
         transform1.pixelization_threshold[1] = c;
         transform1.pixelization_threshold[2] = c;
-        auto [success, part_id, part_bytes, part_symbols, img1, result_imgs] = image_decoder->Decode(img, transform1, calibration, true);
+        auto [success, part_id, part_bytes, part_symbols, img1, result_imgs] = image_decoder->Decode(img, transform1, calibration, sample_map);
         std::cout << "bgr: " << c << "," << c << "," << c << " ";
         if (success) {
             std::cout << "pass";
@@ -126,6 +132,7 @@ int main(int argc, char** argv) {
         std::string symbol_type_str;
         std::string dim_str;
         std::string calibration_file;
+        int frame_part_num = 1;
         bool save_result_image = false;
         int scan_mode = 0;
         int scan_bgr_radius = 0;
@@ -135,6 +142,7 @@ int main(int argc, char** argv) {
         desc_handler("image_file", boost::program_options::value<std::string>(&image_file), "image file");
         desc_handler("symbol_type", boost::program_options::value<std::string>(&symbol_type_str), "symbol type");
         desc_handler("dim", boost::program_options::value<std::string>(&dim_str), "dim as tile_x_num,tile_y_num,tile_x_size,tile_y_size");
+        desc_handler("frame_part_num", boost::program_options::value<int>(&frame_part_num), "independently coded parts per frame");
         desc_handler("calibration_file", boost::program_options::value<std::string>(&calibration_file), "calibration file");
         desc_handler("save_result_image", boost::program_options::value<bool>(&save_result_image), "dump result image");
         desc_handler("scan_mode", boost::program_options::value<int>(&scan_mode), "scan mode, 1: bgr; 2: gray");
@@ -161,7 +169,7 @@ int main(int argc, char** argv) {
         }
 
         auto dim = parse_dim(dim_str);
-        ImageDecoder image_decoder(parse_symbol_type(symbol_type_str), dim);
+        ImageDecoder image_decoder(parse_symbol_type(symbol_type_str), dim, frame_part_num);
         Transform transform = get_transform(vm);
         Calibration calibration;
         if (vm.count("calibration_file")) {
@@ -11,7 +11,10 @@
 
 class App {
 public:
-    App(const std::string& output_file, SymbolType symbol_type, const Dim& dim, uint32_t part_num, int mp, const Transform& transform) : m_output_file(output_file), m_image_decode_worker(symbol_type, dim), m_part_num(part_num), m_mp(mp), m_transform(transform) {
+    App(const std::string& output_file, SymbolType symbol_type, const Dim& dim, int frame_part_num, uint32_t part_num, int mp, const Transform& transform, const ChaseConfig& chase_config, BlobStorageType blob_storage_type, size_t write_behind_byte_budget) : m_output_file(output_file), m_image_decode_worker(symbol_type, dim, frame_part_num), m_part_num(part_num), m_mp(mp), m_transform(transform) {
+        m_image_decode_worker.GetImageDecoder().SetChaseConfig(chase_config);
+        m_image_decode_worker.SetBlobStorageType(blob_storage_type);
+        m_image_decode_worker.SetWriteBehindByteBudget(write_behind_byte_budget);
     }
 
     bool IsRunning() { return m_running; }
@@ -42,7 +45,11 @@ public:
         m_auto_transform_thread = std::make_unique<std::thread>(&ImageDecodeWorker::AutoTransformWorker, &m_image_decode_worker, std::ref(m_part_q), std::ref(m_frame_q), get_transform_fn, m_calibration, send_auto_trasform_cb);
 
         auto save_part_progress_cb = [](const ImageDecodeWorker::SavePartProgress& save_part_progress){
-            std::cout << save_part_progress.frame_num << " frames processed, " << save_part_progress.done_part_num << "/" << save_part_progress.part_num << " parts transferred, fps=" << std::fixed << std::setprecision(2) << save_part_progress.fps << ", done_fps=" << std::fixed << std::setprecision(2) << save_part_progress.done_fps << ", bps=" << std::fixed << std::setprecision(0) << save_part_progress.bps << ", left_time=" << std::setfill('0') << std::setw(2) << save_part_progress.left_days << "d" << std::setw(2) << save_part_progress.left_hours << "h" << std::setw(2) << save_part_progress.left_minutes << "m" << std::setw(2) << save_part_progress.left_seconds << "s" << std::setfill(' ') << "\n";
+            std::cout << save_part_progress.frame_num << " frames processed, " << save_part_progress.done_part_num << "/" << save_part_progress.part_num << " parts transferred, fps=" << std::fixed << std::setprecision(2) << save_part_progress.fps << ", done_fps=" << std::fixed << std::setprecision(2) << save_part_progress.done_fps << ", bps=" << std::fixed << std::setprecision(0) << save_part_progress.bps << ", left_time=" << std::setfill('0') << std::setw(2) << save_part_progress.left_days << "d" << std::setw(2) << save_part_progress.left_hours << "h" << std::setw(2) << save_part_progress.left_minutes << "m" << std::setw(2) << save_part_progress.left_seconds << "s" << std::setfill(' ');
+            if (save_part_progress.write_behind_byte_num || save_part_progress.flush_seconds) {
+                std::cout << ", write_behind=" << save_part_progress.write_behind_byte_num / 1024 << "KiB, flush_time=" << std::fixed << std::setprecision(3) << save_part_progress.flush_seconds << "s";
+            }
+            std::cout << "\n";
         };
         auto save_part_complete_cb = []() {
             std::cout << "transfer done\n";
@@ -72,6 +79,10 @@ public:
         m_part_q.PushNull();
         m_save_part_thread->join();
         m_save_part_thread.reset();
+        auto chase_stats = m_image_decode_worker.GetImageDecoder().GetChaseStats();
+        if (chase_stats.retry_frame_num) {
+            std::cout << chase_stats.rescued_frame_num << "/" << chase_stats.retry_frame_num << " failed parts rescued by chase decoding\n";
+        }
     }
 
 private:
@@ -82,7 +93,7 @@ private:
     Transform m_transform;
     Calibration m_calibration;
     ThreadSafeQueue<std::pair<uint64_t, cv::Mat>> m_frame_q{128};
-    ThreadSafeQueue<DecodeResult> m_part_q{128};
+    ThreadSafeQueue<DecodeResults> m_part_q{128};
     std::unique_ptr<std::thread> m_fetch_image_thread;
     std::vector<std::thread> m_decode_image_threads;
     std::unique_ptr<std::thread> m_decode_image_result_thread;
@@ -98,7 +109,11 @@ int main(int argc, char** argv) {
         std::string symbol_type_str;
         std::string dim_str;
         uint32_t part_num = 0;
+        int frame_part_num = 1;
         int mp = 1;
+        ChaseConfig chase_config;
+        std::string blob_storage_type_str = "stream";
+        size_t write_behind_mb = 64;
         boost::program_options::options_description desc("usage");
         auto desc_handler = desc.add_options();
         desc_handler("help", "help message");
@@ -106,7 +121,12 @@ int main(int argc, char** argv) {
         desc_handler("symbol_type", boost::program_options::value<std::string>(&symbol_type_str), "symbol type");
         desc_handler("dim", boost::program_options::value<std::string>(&dim_str), "dim as tile_x_num,tile_y_num,tile_x_size,tile_y_size");
         desc_handler("part_num", boost::program_options::value<uint32_t>(&part_num), "part num");
+        desc_handler("frame_part_num", boost::program_options::value<int>(&frame_part_num), "independently coded parts per frame, each taking an equal rectangular group of tiles");
         desc_handler("mp", boost::program_options::value<int>(&mp), "multiprocessing");
+        desc_handler("chase_symbol_num", boost::program_options::value<int>(&chase_config.candidate_symbol_num), "least confident symbols retried on crc failure, at most 16");
+        desc_handler("chase_flip_num", boost::program_options::value<int>(&chase_config.max_flip_symbol_num), "max symbols flipped at once by chase decoding, at most 3");
+        desc_handler("blob_storage", boost::program_options::value<std::string>(&blob_storage_type_str), "blob storage backend, stream, mmap, pwritev or io_uring");
+        desc_handler("write_behind_mb", boost::program_options::value<size_t>(&write_behind_mb), "MiB of decoded parts buffered for the io thread, 0 saves parts inline");
         add_transform_options(desc_handler);
         boost::program_options::positional_options_description p_desc;
         p_desc.add("output_file", 1);
@@ -126,8 +146,9 @@ int main(int argc, char** argv) {
 
         auto symbol_type = parse_symbol_type(symbol_type_str);
         auto dim = parse_dim(dim_str);
+        auto blob_storage_type = parse_blob_storage_type(blob_storage_type_str);
         Transform transform = get_transform(vm);
-        App app(output_file, symbol_type, dim, part_num, mp, transform);
+        App app(output_file, symbol_type, dim, frame_part_num, part_num, mp, transform, chase_config, blob_storage_type, write_behind_mb << 20);
         std::cout << "start\n";
         app.Start();
         while (app.IsRunning()) {
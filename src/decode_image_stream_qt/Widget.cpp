@@ -66,7 +66,7 @@ void SavePartThread::run() {
     m_worker_fn(save_part_progress_cb, save_part_complete_cb, save_part_error_cb, finalization_start_cb, finalization_progress_cb);
 }
 
-Widget::Widget(QWidget* parent, const std::string& output_file, SymbolType symbol_type, const Dim& dim, uint32_t part_num, int mp) : QWidget(parent), m_output_file(output_file), m_image_decode_worker(symbol_type, dim), m_dim(dim), m_part_num(part_num), m_mp(mp) {
+Widget::Widget(QWidget* parent, const std::string& output_file, SymbolType symbol_type, const Dim& dim, int frame_part_num, uint32_t part_num, int mp) : QWidget(parent), m_output_file(output_file), m_image_decode_worker(symbol_type, dim, frame_part_num), m_dim(dim), m_part_num(part_num), m_mp(mp) {
     m_result_images.resize(m_dim.tile_y_num);
     for (int tile_y_id = 0; tile_y_id < m_dim.tile_y_num; ++tile_y_id) {
         m_result_images[tile_y_id].resize(m_dim.tile_x_num);
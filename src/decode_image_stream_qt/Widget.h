@@ -87,7 +87,7 @@ class Widget : public QWidget {
     Q_OBJECT
 
 public:
-    Widget(QWidget* parent, const std::string& output_file, SymbolType symbol_type, const Dim& dim, uint32_t part_num, int mp);
+    Widget(QWidget* parent, const std::string& output_file, SymbolType symbol_type, const Dim& dim, int frame_part_num, uint32_t part_num, int mp);
 
 private slots:
     void ToggleCalibrationStartStop();
@@ -132,7 +132,7 @@ private:
     cv::Mat m_image;
     std::vector<std::vector<cv::Mat>> m_result_images;
     ThreadSafeQueue<std::pair<uint64_t, cv::Mat>> m_frame_q{128};
-    ThreadSafeQueue<DecodeResult> m_part_q{128};
+    ThreadSafeQueue<DecodeResults> m_part_q{128};
 
     std::unique_ptr<std::thread> m_fetch_image_thread;
     std::unique_ptr<CalibrateThread> m_calibrate_thread;
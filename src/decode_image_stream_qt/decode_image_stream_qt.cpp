@@ -18,6 +18,7 @@ int run(int argc, char *argv[]) {
         parser.addPositionalArgument("part_num", "part num");
         parser.addOptions({
             {"mp", "multiprocessing", "number"},
+            {"frame_part_num", "independently coded parts per frame", "number"},
         });
         parser.process(app);
         QStringList args = parser.positionalArguments();
@@ -32,7 +33,11 @@ int run(int argc, char *argv[]) {
         if (parser.isSet("mp")) {
             mp = std::stoi(parser.value("mp").toStdString());
         }
-        Widget widget(nullptr, output_file, symbol_type, dim, part_num, mp);
+        int frame_part_num = 1;
+        if (parser.isSet("frame_part_num")) {
+            frame_part_num = std::stoi(parser.value("frame_part_num").toStdString());
+        }
+        Widget widget(nullptr, output_file, symbol_type, dim, frame_part_num, part_num, mp);
         widget.show();
         return app.exec();
     }
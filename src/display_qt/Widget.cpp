@@ -1,7 +1,9 @@
 #include <cassert>
+#include <algorithm>
 #include <sstream>
 #include <fstream>
 #include <filesystem>
+#include <random>
 
 #include <boost/program_options.hpp>
 
@@ -45,7 +47,7 @@ CalibrationPage::CalibrationPage(QWidget* parent, const Parameters& parameters,
     symbol_type_label->setAlignment(Qt::AlignRight | Qt::AlignVCenter);
     config_frame_layout->addWidget(symbol_type_label);
     m_symbol_type_combo_box = new QComboBox();
-    for (int i = static_cast<int>(SymbolType::SYMBOL1); i <= static_cast<int>(SymbolType::SYMBOL3); ++i) {
+    for (int i = static_cast<int>(SymbolType::SYMBOL1); i <= static_cast<int>(SymbolType::SYMBOL4_RS); ++i) {
         m_symbol_type_combo_box->addItem(get_symbol_type_str(static_cast<SymbolType>(i)).c_str());
     }
     m_symbol_type_combo_box->setCurrentIndex(static_cast<int>(m_context.symbol_type));
@@ -116,13 +118,12 @@ void CalibrationPage::ToggleCalibrationStartStop() {
         if (m_calibration_mode_combo_box->currentIndex() == static_cast<int>(CalibrationMode::POSITION)) {
             emit CalibrationStarted(CalibrationMode::POSITION, std::vector<uint8_t>());
         } else if (m_calibration_mode_combo_box->currentIndex() == static_cast<int>(CalibrationMode::COLOR)) {
-            auto symbol_codec = create_symbol_codec(m_context.symbol_type);
             std::vector<uint8_t> data;
             for (int tile_y_id = 0; tile_y_id < m_context.tile_y_num; ++tile_y_id) {
                 for (int tile_x_id = 0; tile_x_id < m_context.tile_x_num; ++tile_x_id) {
                     for (int y = 0; y < m_context.tile_y_size; ++y) {
                         for (int x = 0; x < m_context.tile_x_size; ++x) {
-                            data.push_back((x + y + tile_x_id + tile_y_id) % symbol_codec->SymbolValueNum());
+                            data.push_back(get_color_calibration_symbol(m_context.symbol_type, tile_x_id, tile_y_id, x, y));
                         }
                     }
                 }
@@ -190,7 +191,7 @@ TaskPage::TaskPage(QWidget* parent, const Parameters& parameters, Context& conte
     symbol_type_label->setAlignment(Qt::AlignRight | Qt::AlignVCenter);
     config_frame_layout->addWidget(symbol_type_label);
     m_symbol_type_combo_box = new QComboBox();
-    for (int i = static_cast<int>(SymbolType::SYMBOL1); i <= static_cast<int>(SymbolType::SYMBOL3); ++i) {
+    for (int i = static_cast<int>(SymbolType::SYMBOL1); i <= static_cast<int>(SymbolType::SYMBOL4_RS); ++i) {
         m_symbol_type_combo_box->addItem(get_symbol_type_str(static_cast<SymbolType>(i)).c_str());
     }
     m_symbol_type_combo_box->setCurrentIndex(static_cast<int>(m_context.symbol_type));
@@ -244,6 +245,27 @@ TaskPage::TaskPage(QWidget* parent, const Parameters& parameters, Context& conte
     m_space_size_spin_box->setValue(m_context.space_size);
     config_frame_layout->addWidget(m_space_size_spin_box);
 
+    auto frame_part_num_label = new QLabel("frame_part_num");
+    frame_part_num_label->setAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    config_frame_layout->addWidget(frame_part_num_label);
+    m_frame_part_num_spin_box = new QSpinBox();
+    m_frame_part_num_spin_box->setRange(m_parameters.frame_part_num_range[0], m_parameters.frame_part_num_range[1]);
+    m_frame_part_num_spin_box->setValue(m_context.frame_part_num);
+    m_frame_part_num_spin_box->setToolTip("each part takes an equal rectangular group of tiles with its own crc, so a damaged tile only loses its own part");
+    connect(m_frame_part_num_spin_box, &QSpinBox::valueChanged, this, [this](int frame_part_num){ m_context.frame_part_num = frame_part_num; });
+    config_frame_layout->addWidget(m_frame_part_num_spin_box);
+
+    auto compression_type_label = new QLabel("compression_type");
+    compression_type_label->setAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    config_frame_layout->addWidget(compression_type_label);
+    m_compression_type_combo_box = new QComboBox();
+    for (int i = static_cast<int>(CompressionType::NONE); i <= static_cast<int>(CompressionType::ZLIB); ++i) {
+        m_compression_type_combo_box->addItem(get_compression_type_str(static_cast<CompressionType>(i)).c_str());
+    }
+    m_compression_type_combo_box->setCurrentIndex(static_cast<int>(m_context.compression_type));
+    connect(m_compression_type_combo_box, &QComboBox::currentIndexChanged, this, [this](int index){ m_context.compression_type = static_cast<CompressionType>(index); });
+    config_frame_layout->addWidget(m_compression_type_combo_box);
+
     m_task_file_frame = new QFrame();
     m_task_file_frame->setFrameStyle(QFrame::Box | QFrame::Sunken);
     m_task_file_frame->setEnabled(false);
@@ -291,6 +313,14 @@ TaskPage::TaskPage(QWidget* parent, const Parameters& parameters, Context& conte
     m_task_status_auto_update_checkbox->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Preferred);
     task_status_server_frame_layout->addWidget(m_task_status_auto_update_checkbox);
 
+    m_fountain_checkbox = new QCheckBox("fountain");
+    m_fountain_checkbox->setToolTip("auto navigate shows fountain coded parts, the receiver completes after slightly more than part_num of them");
+    task_status_server_layout->addWidget(m_fountain_checkbox);
+
+    m_sparse_checkbox = new QCheckBox("sparse");
+    m_sparse_checkbox->setToolTip("all-zero parts are not shown, each navigation cycle starts with sparse map parts listing them");
+    task_status_server_layout->addWidget(m_sparse_checkbox);
+
     task_status_server_layout->addStretch(1);
 
     m_display_config_frame = new QFrame();
@@ -364,42 +394,56 @@ void TaskPage::OpenTaskFile() {
         auto task_file_path = file_path.toStdString();
         m_task_file_line_edit->setText(file_path);
         Task task(task_file_path.substr(0, task_file_path.rfind(".task")));
-        task.Load();
+        try {
+            task.Load();
+        }
+        catch (std::exception& e) {
+            QMessageBox::warning(this, "Warning", e.what());
+            return;
+        }
         m_symbol_type_combo_box->setCurrentIndex(static_cast<int>(task.GetSymbolType()));
         auto [tile_x_num, tile_y_num, tile_x_size, tile_y_size] = task.GetDim();
         m_tile_x_num_spin_box->setValue(tile_x_num);
         m_tile_y_num_spin_box->setValue(tile_y_num);
         m_tile_x_size_spin_box->setValue(tile_x_size);
         m_tile_y_size_spin_box->setValue(tile_y_size);
+        // tasks keep the dim of a single part, which is a valid frame by itself
+        m_frame_part_num_spin_box->setValue(1);
         m_part_num = task.GetPartNum();
-        m_undone_part_ids.clear();
-        for (uint32_t part_id = 0; part_id < m_part_num; ++part_id) {
-            if (!task.IsPartDone(part_id)) {
-                m_undone_part_ids.push_back(part_id);
-            }
-        }
-        assert(!m_undone_part_ids.empty());
+        m_part_bitmap = std::make_unique<PartBitmap>(task.GetPartBitmap());
+        assert(m_part_bitmap->UndonePartNum() > 0);
     }
 }
 
 void TaskPage::ToggleTaskStartStop() {
     if (m_context.state == State::CONFIG) {
         m_symbol_codec = create_symbol_codec(m_context.symbol_type);
-        m_part_byte_num = get_part_byte_num(m_context.symbol_type, {m_context.tile_x_num, m_context.tile_y_num, m_context.tile_x_size, m_context.tile_y_size});
         if (ValidateConfig()) {
             m_context.state = State::DISPLAY;
-            auto [raw_bytes, part_num] = get_task_bytes(m_target_file_path, m_part_byte_num);
+            auto [raw_bytes, part_num] = get_task_bytes(m_target_file_path, m_part_byte_num, m_context.compression_type);
             m_raw_bytes = std::move(raw_bytes);
-            if (!m_undone_part_ids.empty()) {
+            if (m_part_bitmap) {
                 assert(part_num == m_part_num);
                 m_cur_undone_part_id_index = 0;
-                m_cur_part_id = m_undone_part_ids[m_cur_undone_part_id_index];
-                m_undone_part_id_num_label->setText(std::to_string(m_undone_part_ids.size()).c_str());
+                m_cur_part_id = m_part_bitmap->NextUndone(0);
+                m_undone_part_id_num_label->setText(std::to_string(m_part_bitmap->UndonePartNum()).c_str());
             } else {
                 m_part_num = part_num;
                 m_cur_part_id = 0;
                 m_undone_part_id_num_label->setText(std::to_string(m_part_num).c_str());
             }
+            if (m_sparse_checkbox->checkState() == Qt::Checked) {
+                m_sparse_map = std::make_unique<SparseMap>(m_raw_bytes, m_part_byte_num, m_part_num);
+                m_sparse_map_part_index = 0;
+                auto part_bitmap = m_part_bitmap ? std::make_unique<PartBitmap>(*m_part_bitmap) : std::make_unique<PartBitmap>(m_part_num);
+                SetZeroPartsDone(*part_bitmap);
+                if (part_bitmap->UndonePartNum() > 0) {
+                    m_part_bitmap = std::move(part_bitmap);
+                    m_cur_undone_part_id_index = 0;
+                    m_cur_part_id = m_part_bitmap->NextUndone(0);
+                    m_undone_part_id_num_label->setText(std::to_string(m_part_bitmap->UndonePartNum()).c_str());
+                }
+            }
             if (IsTaskStatusServerOn()) {
                 auto [ip, port] = parse_server_addr(m_task_status_server_line_edit->text().toStdString());
                 m_task_status_client = create_task_status_client(static_cast<ServerType>(m_task_status_server_type_combo_box->currentIndex()), ip, port);
@@ -412,6 +456,11 @@ void TaskPage::ToggleTaskStartStop() {
             m_cur_part_id_spin_box->setRange(0, m_part_num - 1);
             m_cur_part_id_spin_box->setValue(m_cur_part_id);
             m_max_part_id_label->setText(std::to_string(m_part_num - 1).c_str());
+            if (m_fountain_checkbox->checkState() == Qt::Checked) {
+                m_fountain_code = std::make_unique<FountainCode>(m_part_num);
+                // a random start keeps a restarted display from repeating coded parts the receiver already has
+                m_fountain_seq = std::random_device()() & ~FOUNTAIN_PART_ID_FLAG;
+            }
             emit TaskStarted();
             Draw(m_cur_part_id);
         } else {
@@ -420,6 +469,8 @@ void TaskPage::ToggleTaskStartStop() {
     } else if (m_context.state == State::DISPLAY) {
         m_context.state = State::CONFIG;
         m_symbol_codec.reset();
+        m_fountain_code.reset();
+        m_sparse_map.reset();
         if (m_display_mode == DisplayMode::AUTO) {
             ToggleDisplayMode();
         }
@@ -443,10 +494,23 @@ bool TaskPage::ValidateConfig() {
             QMessageBox::warning(this, "Warning", std::string("can't find target file '" + m_target_file_path + "'").c_str());
         }
     }
+    if (valid) {
+        try {
+            m_part_byte_num = get_part_byte_num(m_context.symbol_type, get_part_dim(GetDim(), m_context.frame_part_num));
+        }
+        catch (const invalid_image_codec_argument& e) {
+            valid = false;
+            m_part_byte_num = 0;
+            QMessageBox::warning(this, "Warning", e.what());
+        }
+    }
     if (valid) {
         if (m_part_byte_num < Task::MIN_PART_BYTE_NUM) {
             valid = false;
             QMessageBox::warning(this, "Warning", std::string("invalid part_byte_num '" + std::to_string(m_part_byte_num) + "'").c_str());
+        } else if (m_context.compression_type != CompressionType::NONE && m_part_byte_num < Task::MIN_COMPRESSED_PART_BYTE_NUM) {
+            valid = false;
+            QMessageBox::warning(this, "Warning", std::string("invalid part_byte_num '" + std::to_string(m_part_byte_num) + "' for compression").c_str());
         }
     }
     if (valid) {
@@ -463,6 +527,10 @@ bool TaskPage::ValidateConfig() {
     return valid;
 }
 
+Dim TaskPage::GetDim() const {
+    return {m_context.tile_x_num, m_context.tile_y_num, m_context.tile_x_size, m_context.tile_y_size};
+}
+
 void TaskPage::ToggleDisplayMode() {
     if (m_display_mode == DisplayMode::MANUAL) {
         m_display_mode = DisplayMode::AUTO;
@@ -491,29 +559,76 @@ void TaskPage::NavigatePart(uint32_t part_id) {
 }
 
 void TaskPage::Draw(uint32_t part_id) {
-    Bytes part_bytes(m_raw_bytes.begin()+part_id*static_cast<size_t>(m_part_byte_num), m_raw_bytes.begin()+(part_id+1)*static_cast<size_t>(m_part_byte_num));
-    auto symbols = m_symbol_codec->Encode(part_id, part_bytes, m_context.tile_x_num * m_context.tile_y_num * m_context.tile_x_size * m_context.tile_y_size);
+    // the remaining parts of the frame are the ones navigation would visit next
+    std::vector<std::pair<uint32_t, Bytes>> parts;
+    for (int i = 0; i < m_context.frame_part_num; ++i) {
+        uint32_t part_id1 = part_id;
+        if (i > 0) {
+            if (m_part_bitmap) {
+                part_id1 = m_part_bitmap->NextUndone(parts.back().first + 1);
+                if (part_id1 == m_part_num) part_id1 = m_part_bitmap->NextUndone(0);
+            } else {
+                part_id1 = (part_id + i) % m_part_num;
+            }
+        }
+        parts.emplace_back(part_id1, Bytes(m_raw_bytes.begin()+part_id1*static_cast<size_t>(m_part_byte_num), m_raw_bytes.begin()+(part_id1+1)*static_cast<size_t>(m_part_byte_num)));
+    }
+    auto symbols = encode_frame(m_symbol_codec.get(), GetDim(), parts);
+    emit PartNavigated(symbols);
+}
+
+void TaskPage::DrawFountainPart(uint32_t seq) {
+    std::vector<std::pair<uint32_t, Bytes>> parts;
+    for (int i = 0; i < m_context.frame_part_num; ++i) {
+        uint32_t seq1 = (seq + i) & ~FOUNTAIN_PART_ID_FLAG;
+        Bytes part_bytes(m_part_byte_num);
+        m_fountain_code->Encode(seq1, m_raw_bytes.data(), m_part_byte_num, part_bytes.data());
+        parts.emplace_back(FOUNTAIN_PART_ID_FLAG | seq1, std::move(part_bytes));
+    }
+    auto symbols = encode_frame(m_symbol_codec.get(), GetDim(), parts);
+    emit PartNavigated(symbols);
+}
+
+void TaskPage::DrawSparseMapParts(size_t index) {
+    const auto& map_parts = m_sparse_map->MapParts();
+    std::vector<std::pair<uint32_t, Bytes>> parts;
+    for (int i = 0; i < m_context.frame_part_num; ++i) {
+        parts.push_back(map_parts[(index + i) % map_parts.size()]);
+    }
+    auto symbols = encode_frame(m_symbol_codec.get(), GetDim(), parts);
     emit PartNavigated(symbols);
 }
 
 void TaskPage::NavigateNextPart() {
-    if (!m_undone_part_ids.empty()) {
+    if (m_fountain_code) {
+        DrawFountainPart(m_fountain_seq);
+        m_fountain_seq = (m_fountain_seq + m_context.frame_part_num) & ~FOUNTAIN_PART_ID_FLAG;
+    } else if (m_sparse_map && m_sparse_map_part_index < m_sparse_map->MapParts().size()) {
+        DrawSparseMapParts(m_sparse_map_part_index);
+        m_sparse_map_part_index += m_context.frame_part_num;
+    } else if (m_part_bitmap) {
+        uint32_t step = m_context.frame_part_num;
+        uint32_t undone_part_num = m_part_bitmap->UndonePartNum();
         bool need_normal_navigate = true;
-        if (IsTaskStatusAutoUpdate() && m_undone_part_ids.size() > m_task_status_auto_update_threshold && m_cur_undone_part_id_index == m_undone_part_ids.size() - 1) {
+        if (IsTaskStatusAutoUpdate() && undone_part_num > m_task_status_auto_update_threshold && m_cur_undone_part_id_index + step >= undone_part_num) {
             need_normal_navigate = !UpdateTaskStatus();
         }
         if (need_normal_navigate) {
-            m_cur_undone_part_id_index = m_cur_undone_part_id_index < m_undone_part_ids.size() - 1 ? m_cur_undone_part_id_index + 1 : 0;
-            uint32_t cur_part_id = m_undone_part_ids[m_cur_undone_part_id_index];
+            m_cur_undone_part_id_index = m_cur_undone_part_id_index + step < undone_part_num ? m_cur_undone_part_id_index + step : 0;
+            // the map parts are shown again at the start of every cycle
+            if (m_cur_undone_part_id_index == 0) m_sparse_map_part_index = 0;
+            uint32_t cur_part_id = m_part_bitmap->SelectUndone(m_cur_undone_part_id_index);
             m_cur_part_id_spin_box->setValue(cur_part_id);
         }
     } else {
+        uint32_t step = m_context.frame_part_num;
         bool need_normal_navigate = true;
-        if (IsTaskStatusAutoUpdate() && m_part_num > m_task_status_auto_update_threshold && m_cur_part_id == m_part_num - 1) {
+        if (IsTaskStatusAutoUpdate() && m_part_num > m_task_status_auto_update_threshold && m_cur_part_id + step >= m_part_num) {
             need_normal_navigate = !UpdateTaskStatus();
         }
         if (need_normal_navigate) {
-            uint32_t cur_part_id = m_cur_part_id < m_part_num - 1 ? m_cur_part_id + 1 : 0;
+            uint32_t cur_part_id = m_cur_part_id + step < m_part_num ? m_cur_part_id + step : 0;
+            if (cur_part_id == 0) m_sparse_map_part_index = 0;
             m_cur_part_id_spin_box->setValue(cur_part_id);
         }
     }
@@ -535,15 +650,26 @@ void TaskPage::NavigateNextPart() {
 
 void TaskPage::NavigatePrevPart() {
     uint32_t cur_part_id = 0;
-    if (!m_undone_part_ids.empty()) {
-        m_cur_undone_part_id_index = m_cur_undone_part_id_index > 0 ? m_cur_undone_part_id_index - 1 : m_undone_part_ids.size() - 1;
-        cur_part_id = m_undone_part_ids[m_cur_undone_part_id_index];
+    uint32_t step = m_context.frame_part_num;
+    if (m_part_bitmap) {
+        m_cur_undone_part_id_index = m_cur_undone_part_id_index >= step ? m_cur_undone_part_id_index - step : m_part_bitmap->UndonePartNum() - 1;
+        cur_part_id = m_part_bitmap->SelectUndone(m_cur_undone_part_id_index);
     } else {
-        cur_part_id = m_cur_part_id > 0 ? m_cur_part_id - 1 : m_part_num - 1;
+        cur_part_id = m_cur_part_id >= step ? m_cur_part_id - step : m_part_num - 1;
     }
     m_cur_part_id_spin_box->setValue(cur_part_id);
 }
 
+// zero parts are covered by the map parts, they lie between the ids of the parts which are not all zero
+void TaskPage::SetZeroPartsDone(PartBitmap& part_bitmap) const {
+    uint32_t zero_part_id = 0;
+    for (auto part_id : m_sparse_map->PartIds()) {
+        for (; zero_part_id < part_id; ++zero_part_id) part_bitmap.SetDone(zero_part_id);
+        zero_part_id = part_id + 1;
+    }
+    for (; zero_part_id < m_part_num; ++zero_part_id) part_bitmap.SetDone(zero_part_id);
+}
+
 bool TaskPage::IsTaskStatusServerOn() {
     return m_task_status_server_type_combo_box->currentIndex() != static_cast<int>(ServerType::NONE);
 }
@@ -557,22 +683,19 @@ bool TaskPage::FetchTaskStatus() {
     if (!task_bytes.empty()) {
         auto [symbol_type, dim, part_num, done_part_num, task_status_bytes] = from_task_bytes(task_bytes);
         assert(symbol_type == m_context.symbol_type);
-        assert(dim.tile_x_num == m_context.tile_x_num &&
-               dim.tile_y_num == m_context.tile_y_num &&
-               dim.tile_x_size == m_context.tile_x_size &&
-               dim.tile_y_size == m_context.tile_y_size);
+        assert(dim == get_part_dim(GetDim(), m_context.frame_part_num));
         assert(part_num == m_part_num);
         assert(task_status_bytes.size() == (m_part_num + 7) / 8);
-        m_undone_part_ids.clear();
-        for (uint32_t part_id = 0; part_id < m_part_num; ++part_id) {
-            if (!is_part_done(task_status_bytes, part_id)) {
-                m_undone_part_ids.push_back(part_id);
-            }
-        }
+        auto part_bitmap = std::make_unique<PartBitmap>(task_status_bytes, m_part_num);
+        // the receiver only learns the zero parts from the map parts, they stay masked so they are never displayed
+        if (m_sparse_map) SetZeroPartsDone(*part_bitmap);
+        // the receiver may be done with the parts while the display keeps going
+        if (part_bitmap->UndonePartNum() == 0) return true;
+        m_part_bitmap = std::move(part_bitmap);
         m_cur_undone_part_id_index = 0;
-        m_cur_part_id = m_undone_part_ids[m_cur_undone_part_id_index];
+        m_cur_part_id = m_part_bitmap->NextUndone(0);
         m_cur_part_id_spin_box->setValue(m_cur_part_id);
-        m_undone_part_id_num_label->setText(std::to_string(m_undone_part_ids.size()).c_str());
+        m_undone_part_id_num_label->setText(std::to_string(m_part_bitmap->UndonePartNum()).c_str());
         return true;
     } else {
         return false;
@@ -651,22 +774,9 @@ void Canvas::paintEvent(QPaintEvent*) {
                                 painter.setBrush(QColor(0, 0, 0));
                             } else {
                                 Symbol symbol = m_data[((tile_y_id * m_context.tile_x_num + tile_x_id) * m_context.tile_y_size + (y - 1)) * m_context.tile_x_size + (x - 1)];
-                                if (symbol == static_cast<int>(PixelColor::WHITE)) {
-                                    painter.setBrush(QColor(255, 255, 255));
-                                } else if (symbol == static_cast<int>(PixelColor::BLACK)) {
-                                    painter.setBrush(QColor(0, 0, 0));
-                                } else if (symbol == static_cast<int>(PixelColor::RED)) {
-                                    painter.setBrush(QColor(255, 0, 0));
-                                } else if (symbol == static_cast<int>(PixelColor::BLUE)) {
-                                    painter.setBrush(QColor(0, 0, 255));
-                                } else if (symbol == static_cast<int>(PixelColor::GREEN)) {
-                                    painter.setBrush(QColor(0, 255, 0));
-                                } else if (symbol == static_cast<int>(PixelColor::CYAN)) {
-                                    painter.setBrush(QColor(0, 255, 255));
-                                } else if (symbol == static_cast<int>(PixelColor::MAGENTA)) {
-                                    painter.setBrush(QColor(255, 0, 255));
-                                } else if (symbol == static_cast<int>(PixelColor::YELLOW)) {
-                                    painter.setBrush(QColor(255, 255, 0));
+                                if (symbol < static_cast<int>(PixelColor::UNKNOWN)) {
+                                    const auto& bgr = get_pixel_color_bgr(static_cast<PixelColor>(symbol));
+                                    painter.setBrush(QColor(bgr[2], bgr[1], bgr[0]));
                                 } else {
                                     std::cerr << "invalid symbol '" << symbol << "'\n";
                                     assert(false);
@@ -752,6 +862,7 @@ Widget::Widget(QWidget* parent) : QWidget(parent) {
 void Widget::LoadConfig() {
     std::ifstream cfg_file("display_qt.ini");
     std::string symbol_type_str;
+    std::string compression_type_str = "none";
     boost::program_options::options_description desc;
     auto desc_handler = desc.add_options();
     desc_handler("DEFAULT.symbol_type", boost::program_options::value<std::string>(&symbol_type_str));
@@ -761,6 +872,8 @@ void Widget::LoadConfig() {
     desc_handler("DEFAULT.tile_y_size", boost::program_options::value<int>(&m_context.tile_y_size));
     desc_handler("DEFAULT.pixel_size", boost::program_options::value<int>(&m_context.pixel_size));
     desc_handler("DEFAULT.space_size", boost::program_options::value<int>(&m_context.space_size));
+    desc_handler("DEFAULT.frame_part_num", boost::program_options::value<int>(&m_context.frame_part_num));
+    desc_handler("DEFAULT.compression_type", boost::program_options::value<std::string>(&compression_type_str));
     desc_handler("DEFAULT.calibration_pixel_size", boost::program_options::value<int>(&m_context.calibration_pixel_size));
     desc_handler("DEFAULT.task_status_server", boost::program_options::value<std::string>(&m_context.task_status_server));
     desc_handler("DEFAULT.interval", boost::program_options::value<int>(&m_context.interval));
@@ -778,6 +891,7 @@ void Widget::LoadConfig() {
     if (!vm.count("DEFAULT.task_status_server")) throw std::invalid_argument("DEFAULT.task_status_server not found");
     if (!vm.count("DEFAULT.interval")) throw std::invalid_argument("DEFAULT.interval not found");
     m_context.symbol_type = parse_symbol_type(symbol_type_str);
+    m_context.compression_type = parse_compression_type(compression_type_str);
 }
 
 void Widget::StartCalibration(CalibrationMode calibration_mode, std::vector<uint8_t> data) {
@@ -22,6 +22,7 @@ struct Parameters {
     std::array<int, 2> tile_y_size_range{1, 500};
     std::array<int, 2> pixel_size_range{1, 100};
     std::array<int, 2> space_size_range{1, 10};
+    std::array<int, 2> frame_part_num_range{1, 100};
     std::array<int, 2> calibration_pixel_size_range{1, 10};
     std::array<int, 2> interval_range{1, 1000};
 };
@@ -41,6 +42,8 @@ struct Context {
     int tile_y_size = 0;
     int pixel_size = 0;
     int space_size = 0;
+    int frame_part_num = 1;
+    CompressionType compression_type = CompressionType::NONE;
     int calibration_pixel_size = 0;
     std::string task_status_server;
     int interval = 0;
@@ -99,6 +102,8 @@ public:
     QSpinBox* m_tile_y_size_spin_box = nullptr;
     QSpinBox* m_pixel_size_spin_box = nullptr;
     QSpinBox* m_space_size_spin_box = nullptr;
+    QSpinBox* m_frame_part_num_spin_box = nullptr;
+    QComboBox* m_compression_type_combo_box = nullptr;
 
 public slots:
     void ToggleDisplayMode();
@@ -117,7 +122,11 @@ private slots:
 
 private:
     bool ValidateConfig();
+    Dim GetDim() const;
     void Draw(uint32_t part_id);
+    void DrawFountainPart(uint32_t seq);
+    void DrawSparseMapParts(size_t index);
+    void SetZeroPartsDone(PartBitmap& part_bitmap) const;
     bool IsTaskStatusServerOn();
     bool IsTaskStatusAutoUpdate();
     bool FetchTaskStatus();
@@ -131,9 +140,14 @@ private:
     uint32_t m_part_num = 0;
     std::unique_ptr<TaskStatusClient> m_task_status_client;
     size_t m_task_status_auto_update_threshold = 200;
-    std::vector<uint32_t> m_undone_part_ids;
-    size_t m_cur_undone_part_id_index = 0;
+    // parts left to display, null when all parts are displayed
+    std::unique_ptr<PartBitmap> m_part_bitmap;
+    uint32_t m_cur_undone_part_id_index = 0;
     uint32_t m_cur_part_id = 0;
+    std::unique_ptr<FountainCode> m_fountain_code;
+    uint32_t m_fountain_seq = 0;
+    std::unique_ptr<SparseMap> m_sparse_map;
+    size_t m_sparse_map_part_index = 0;
     DisplayMode m_display_mode = DisplayMode::MANUAL;
 
     std::unique_ptr<SymbolCodec> m_symbol_codec;
@@ -155,6 +169,8 @@ private:
     QFrame* m_task_status_server_frame = nullptr;
     QLineEdit* m_task_status_server_line_edit = nullptr;
     QCheckBox* m_task_status_auto_update_checkbox = nullptr;
+    QCheckBox* m_fountain_checkbox = nullptr;
+    QCheckBox* m_sparse_checkbox = nullptr;
     QFrame* m_display_config_frame = nullptr;
     QPushButton* m_display_mode_button = nullptr;
     QSpinBox* m_interval_spin_box = nullptr;
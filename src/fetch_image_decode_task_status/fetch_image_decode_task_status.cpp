@@ -12,6 +12,7 @@ int main(int argc, char** argv) {
         std::string server_type_str;
         std::string ip;
         int port = 0;
+        uint32_t task_bytes_version = 0;
         boost::program_options::options_description desc("usage");
         auto desc_handler = desc.add_options();
         desc_handler("help", "help message");
@@ -19,6 +20,7 @@ int main(int argc, char** argv) {
         desc_handler("server_type", boost::program_options::value<std::string>(&server_type_str), "server type");
         desc_handler("ip", boost::program_options::value<std::string>(&ip), "ip");
         desc_handler("port", boost::program_options::value<int>(&port), "port");
+        desc_handler("task_bytes_version", boost::program_options::value<uint32_t>(&task_bytes_version), "task bytes version asked from the server, tcp defaults to 1 as tcp servers without version negotiation can't take the request");
         boost::program_options::positional_options_description p_desc;
         p_desc.add("task_file", 1);
         p_desc.add("server_type", 1);
@@ -35,11 +37,13 @@ int main(int argc, char** argv) {
 
         check_positional_options(p_desc, vm);
 
-        auto task_status_client = create_task_status_client(parse_server_type(server_type_str), ip, port);
+        auto task_status_client = create_task_status_client(parse_server_type(server_type_str), ip, port, vm.count("task_bytes_version") ? std::optional<uint32_t>(task_bytes_version) : std::nullopt);
         Bytes task_bytes = task_status_client->GetTaskStatus();
         if (task_bytes.empty()) {
             std::cout << "fail to get task status\n";
         } else {
+            // task files keep the version 1 layout
+            task_bytes = convert_task_bytes(task_bytes, TASK_BYTES_VERSION1);
             std::ofstream f(task_file, std::ios_base::binary);
             f.write(reinterpret_cast<char*>(task_bytes.data()), task_bytes.size());
             std::cout << "success\n";
@@ -0,0 +1,644 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#endif
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#define IMAGE_CODEC_IO_URING 1
+#endif
+
+#include "blob_storage.h"
+
+namespace {
+
+std::map<std::string, BlobStorageType> blob_storage_type_str_to_blob_storage_type_mapping({
+    {"stream", BlobStorageType::STREAM},
+    {"mmap", BlobStorageType::MMAP},
+    {"pwritev", BlobStorageType::PWRITEV},
+    {"io_uring", BlobStorageType::IO_URING},
+});
+
+std::map<BlobStorageType, std::string> blob_storage_type_to_blob_storage_type_str_mapping({
+    {BlobStorageType::STREAM, "stream"},
+    {BlobStorageType::MMAP, "mmap"},
+    {BlobStorageType::PWRITEV, "pwritev"},
+    {BlobStorageType::IO_URING, "io_uring"},
+});
+
+class StreamBlobStorage : public BlobStorage {
+public:
+    StreamBlobStorage(const std::string& blob_path, int part_byte_num) : m_blob_path(blob_path), m_part_byte_num(part_byte_num), m_file(blob_path, std::ios_base::in | std::ios_base::out | std::ios_base::binary) {
+        if (!m_file) throw std::runtime_error("can't open blob file '" + blob_path + "'");
+    }
+
+    void WritePart(uint32_t part_id, const Bytes& part_bytes) override {
+        m_buf.emplace_back(part_id, part_bytes);
+    }
+
+    void ReadPart(uint32_t part_id, Byte* part_bytes) override {
+        if (!m_buf.empty()) Flush();
+        m_file.clear();
+        m_file.seekg(static_cast<uint64_t>(part_id) * m_part_byte_num);
+        m_file.read(reinterpret_cast<char*>(part_bytes), m_part_byte_num);
+    }
+
+    void Flush() override {
+        for (const auto& [part_id, part_bytes] : m_buf) {
+            m_file.seekp(static_cast<uint64_t>(part_id) * m_part_byte_num);
+            m_file.write(reinterpret_cast<const char*>(part_bytes.data()), part_bytes.size());
+        }
+        m_buf.clear();
+        m_file.flush();
+    }
+
+    // fstream has no fd to sync, the file is synced through a descriptor of its own
+    void Sync() override {
+        Flush();
+        if (!m_file) throw std::runtime_error("can't write blob file '" + m_blob_path + "'");
+        sync_path(m_blob_path);
+    }
+
+private:
+    std::string m_blob_path;
+    int m_part_byte_num;
+    std::fstream m_file;
+    std::vector<std::pair<uint32_t, Bytes>> m_buf;
+};
+
+#ifndef _WIN32
+
+// buffered parts are written once this many have been collected
+constexpr size_t BATCH_PART_NUM = 256;
+constexpr size_t MAX_IOV_NUM = 1024;
+
+class BlobFile {
+public:
+    explicit BlobFile(const std::string& blob_path) : m_fd(open(blob_path.c_str(), O_RDWR)) {
+        if (m_fd < 0) throw std::runtime_error("can't open blob file '" + blob_path + "', errno " + std::to_string(errno));
+    }
+
+    ~BlobFile() {
+        close(m_fd);
+    }
+
+    int Fd() const { return m_fd; }
+
+    void Sync() {
+        while (fdatasync(m_fd) < 0) {
+            if (errno != EINTR) throw std::runtime_error("blob sync fail, errno " + std::to_string(errno));
+        }
+    }
+
+    void Read(uint64_t offset, Byte* bytes, size_t byte_num) {
+        while (byte_num > 0) {
+            ssize_t n = pread(m_fd, bytes, byte_num, offset);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) throw std::runtime_error("blob read fail, errno " + std::to_string(errno));
+            bytes += n;
+            byte_num -= n;
+            offset += n;
+        }
+    }
+
+    // iovs are consumed as they get written
+    void Write(uint64_t offset, iovec* iovs, size_t iov_num) {
+        while (iov_num > 0) {
+            ssize_t n = pwritev(m_fd, iovs, static_cast<int>(std::min(iov_num, MAX_IOV_NUM)), offset);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) throw std::runtime_error("blob write fail, errno " + std::to_string(errno));
+            offset += n;
+            while (iov_num > 0 && static_cast<size_t>(n) >= iovs->iov_len) {
+                n -= iovs->iov_len;
+                ++iovs;
+                --iov_num;
+            }
+            if (n > 0) {
+                iovs->iov_base = static_cast<Byte*>(iovs->iov_base) + n;
+                iovs->iov_len -= n;
+            }
+        }
+    }
+
+private:
+    int m_fd;
+};
+
+// buffered parts, written as runs of consecutive part ids
+class PartBatch {
+public:
+    size_t Size() const { return m_parts.size(); }
+
+    void Add(uint32_t part_id, const Bytes& part_bytes) {
+        m_part_indexes[part_id] = m_parts.size();
+        m_parts.emplace_back(part_id, part_bytes);
+    }
+
+    bool Find(uint32_t part_id, Byte* part_bytes) const {
+        auto it = m_part_indexes.find(part_id);
+        if (it == m_part_indexes.end()) return false;
+        const auto& bytes = m_parts[it->second].second;
+        std::copy(bytes.begin(), bytes.end(), part_bytes);
+        return true;
+    }
+
+    // fn gets the first part id of every run and the iovs of its parts, the batch must not change afterwards
+    template <typename Fn>
+    void ForEachRun(Fn fn) {
+        std::sort(m_parts.begin(), m_parts.end(), [](const auto& a, const auto& b){ return a.first < b.first; });
+        m_part_indexes.clear();
+        std::vector<iovec> iovs;
+        for (size_t i = 0; i < m_parts.size(); ++i) {
+            auto& [part_id, part_bytes] = m_parts[i];
+            iovs.push_back({part_bytes.data(), part_bytes.size()});
+            if (i + 1 == m_parts.size() || m_parts[i + 1].first != part_id + 1 || iovs.size() == MAX_IOV_NUM) {
+                auto first_part_id = static_cast<uint32_t>(part_id + 1 - iovs.size());
+                fn(first_part_id, std::move(iovs));
+                iovs.clear();
+            }
+        }
+    }
+
+private:
+    std::vector<std::pair<uint32_t, Bytes>> m_parts;
+    std::unordered_map<uint32_t, size_t> m_part_indexes;
+};
+
+class MmapBlobStorage : public BlobStorage {
+public:
+    MmapBlobStorage(const std::string& blob_path, int part_byte_num, uint32_t part_num) : m_part_byte_num(part_byte_num), m_file(blob_path), m_byte_num(static_cast<size_t>(part_byte_num) * part_num) {
+        if (m_byte_num == 0) return;
+        void* data = mmap(nullptr, m_byte_num, PROT_READ | PROT_WRITE, MAP_SHARED, m_file.Fd(), 0);
+        if (data == MAP_FAILED) throw std::runtime_error("can't map blob file '" + blob_path + "', errno " + std::to_string(errno));
+        m_data = static_cast<Byte*>(data);
+    }
+
+    ~MmapBlobStorage() {
+        if (m_data) munmap(m_data, m_byte_num);
+    }
+
+    void WritePart(uint32_t part_id, const Bytes& part_bytes) override {
+        std::copy_n(part_bytes.begin(), std::min(part_bytes.size(), static_cast<size_t>(m_part_byte_num)), m_data + static_cast<size_t>(part_id) * m_part_byte_num);
+    }
+
+    void ReadPart(uint32_t part_id, Byte* part_bytes) override {
+        std::copy_n(m_data + static_cast<size_t>(part_id) * m_part_byte_num, m_part_byte_num, part_bytes);
+    }
+
+    void Flush() override {
+        if (m_data) msync(m_data, m_byte_num, MS_ASYNC);
+    }
+
+    void Sync() override {
+        if (m_data && msync(m_data, m_byte_num, MS_SYNC) < 0) throw std::runtime_error("blob sync fail, errno " + std::to_string(errno));
+    }
+
+private:
+    int m_part_byte_num;
+    BlobFile m_file;
+    size_t m_byte_num;
+    Byte* m_data = nullptr;
+};
+
+class PwritevBlobStorage : public BlobStorage {
+public:
+    PwritevBlobStorage(const std::string& blob_path, int part_byte_num) : m_part_byte_num(part_byte_num), m_file(blob_path) {
+    }
+
+    ~PwritevBlobStorage() {
+        try {
+            Flush();
+        }
+        catch (const std::exception&) {
+        }
+    }
+
+    void WritePart(uint32_t part_id, const Bytes& part_bytes) override {
+        m_batch.Add(part_id, part_bytes);
+        if (m_batch.Size() >= BATCH_PART_NUM) Flush();
+    }
+
+    void ReadPart(uint32_t part_id, Byte* part_bytes) override {
+        if (m_batch.Find(part_id, part_bytes)) return;
+        m_file.Read(static_cast<uint64_t>(part_id) * m_part_byte_num, part_bytes, m_part_byte_num);
+    }
+
+    void Flush() override {
+        m_batch.ForEachRun([this](uint32_t part_id, std::vector<iovec> iovs) {
+            m_file.Write(static_cast<uint64_t>(part_id) * m_part_byte_num, iovs.data(), iovs.size());
+        });
+        m_batch = PartBatch();
+    }
+
+    void Sync() override {
+        Flush();
+        m_file.Sync();
+    }
+
+private:
+    int m_part_byte_num;
+    BlobFile m_file;
+    PartBatch m_batch;
+};
+
+#ifdef IMAGE_CODEC_IO_URING
+
+// submission and completion rings set up with the raw syscalls, liburing is not required
+class IoUring {
+public:
+    explicit IoUring(unsigned entry_num) {
+        io_uring_params params{};
+        m_fd = static_cast<int>(syscall(__NR_io_uring_setup, entry_num, &params));
+        if (m_fd < 0) throw std::runtime_error("io_uring setup fail, errno " + std::to_string(errno));
+        m_entry_num = params.sq_entries;
+        m_sq_ring_byte_num = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        m_cq_ring_byte_num = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap) m_sq_ring_byte_num = m_cq_ring_byte_num = std::max(m_sq_ring_byte_num, m_cq_ring_byte_num);
+        m_sq_ring = Map(m_sq_ring_byte_num, IORING_OFF_SQ_RING);
+        m_cq_ring = single_mmap ? m_sq_ring : Map(m_cq_ring_byte_num, IORING_OFF_CQ_RING);
+        m_sqe_byte_num = params.sq_entries * sizeof(io_uring_sqe);
+        m_sqes = static_cast<io_uring_sqe*>(Map(m_sqe_byte_num, IORING_OFF_SQES));
+        auto sq_ring = static_cast<Byte*>(m_sq_ring);
+        auto cq_ring = static_cast<Byte*>(m_cq_ring);
+        m_sq_tail = reinterpret_cast<unsigned*>(sq_ring + params.sq_off.tail);
+        m_sq_mask = *reinterpret_cast<unsigned*>(sq_ring + params.sq_off.ring_mask);
+        m_sq_array = reinterpret_cast<unsigned*>(sq_ring + params.sq_off.array);
+        m_cq_head = reinterpret_cast<unsigned*>(cq_ring + params.cq_off.head);
+        m_cq_tail = reinterpret_cast<unsigned*>(cq_ring + params.cq_off.tail);
+        m_cq_mask = *reinterpret_cast<unsigned*>(cq_ring + params.cq_off.ring_mask);
+        m_cqes = reinterpret_cast<io_uring_cqe*>(cq_ring + params.cq_off.cqes);
+    }
+
+    ~IoUring() {
+        if (m_sqes) munmap(m_sqes, m_sqe_byte_num);
+        if (m_cq_ring && m_cq_ring != m_sq_ring) munmap(m_cq_ring, m_cq_ring_byte_num);
+        if (m_sq_ring) munmap(m_sq_ring, m_sq_ring_byte_num);
+        close(m_fd);
+    }
+
+    unsigned EntryNum() const { return m_entry_num; }
+
+    void PushWritev(int fd, const iovec* iovs, unsigned iov_num, uint64_t offset, uint64_t user_data) {
+        unsigned tail = *m_sq_tail;
+        unsigned index = tail & m_sq_mask;
+        io_uring_sqe& sqe = m_sqes[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_WRITEV;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<uint64_t>(iovs);
+        sqe.len = iov_num;
+        sqe.off = offset;
+        sqe.user_data = user_data;
+        m_sq_array[index] = index;
+        __atomic_store_n(m_sq_tail, tail + 1, __ATOMIC_RELEASE);
+        ++m_queued_num;
+    }
+
+    // submits the queued entries and waits for min_complete completions
+    void Submit(unsigned min_complete) {
+        while (true) {
+            int ret = static_cast<int>(syscall(__NR_io_uring_enter, m_fd, m_queued_num, min_complete, min_complete ? IORING_ENTER_GETEVENTS : 0, nullptr, 0));
+            if (ret < 0 && errno == EINTR) continue;
+            if (ret < 0) throw std::runtime_error("io_uring enter fail, errno " + std::to_string(errno));
+            m_queued_num -= ret;
+            return;
+        }
+    }
+
+    // fn gets the user data and the result of every completion
+    template <typename Fn>
+    void Reap(Fn fn) {
+        unsigned head = *m_cq_head;
+        while (head != __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE)) {
+            const io_uring_cqe& cqe = m_cqes[head & m_cq_mask];
+            fn(cqe.user_data, cqe.res);
+            ++head;
+            __atomic_store_n(m_cq_head, head, __ATOMIC_RELEASE);
+        }
+    }
+
+private:
+    void* Map(size_t byte_num, off_t offset) {
+        void* ptr = mmap(nullptr, byte_num, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, offset);
+        if (ptr == MAP_FAILED) throw std::runtime_error("io_uring mmap fail, errno " + std::to_string(errno));
+        return ptr;
+    }
+
+    int m_fd = -1;
+    unsigned m_entry_num = 0;
+    unsigned m_queued_num = 0;
+    size_t m_sq_ring_byte_num = 0;
+    size_t m_cq_ring_byte_num = 0;
+    size_t m_sqe_byte_num = 0;
+    void* m_sq_ring = nullptr;
+    void* m_cq_ring = nullptr;
+    io_uring_sqe* m_sqes = nullptr;
+    unsigned* m_sq_tail = nullptr;
+    unsigned m_sq_mask = 0;
+    unsigned* m_sq_array = nullptr;
+    unsigned* m_cq_head = nullptr;
+    unsigned* m_cq_tail = nullptr;
+    unsigned m_cq_mask = 0;
+    io_uring_cqe* m_cqes = nullptr;
+};
+
+constexpr unsigned IO_URING_ENTRY_NUM = 32;
+
+// full batches are written in the background, up to IO_URING_ENTRY_NUM vectored writes are in flight
+class IoUringBlobStorage : public BlobStorage {
+public:
+    IoUringBlobStorage(const std::string& blob_path, int part_byte_num) : m_part_byte_num(part_byte_num), m_file(blob_path), m_ring(IO_URING_ENTRY_NUM) {
+    }
+
+    ~IoUringBlobStorage() {
+        try {
+            Flush();
+        }
+        catch (const std::exception&) {
+        }
+    }
+
+    void WritePart(uint32_t part_id, const Bytes& part_bytes) override {
+        m_batch->Add(part_id, part_bytes);
+        if (m_batch->Size() >= BATCH_PART_NUM) SubmitBatch();
+    }
+
+    void ReadPart(uint32_t part_id, Byte* part_bytes) override {
+        if (m_batch->Find(part_id, part_bytes)) return;
+        WaitWrites(0);
+        m_file.Read(static_cast<uint64_t>(part_id) * m_part_byte_num, part_bytes, m_part_byte_num);
+    }
+
+    void Flush() override {
+        SubmitBatch();
+        WaitWrites(0);
+    }
+
+    void Sync() override {
+        Flush();
+        m_file.Sync();
+    }
+
+private:
+    struct Write {
+        std::shared_ptr<PartBatch> batch;
+        std::vector<iovec> iovs;
+        uint64_t offset = 0;
+        size_t byte_num = 0;
+    };
+
+    void SubmitBatch() {
+        if (m_batch->Size() == 0) return;
+        std::shared_ptr<PartBatch> batch = std::move(m_batch);
+        m_batch = std::make_unique<PartBatch>();
+        batch->ForEachRun([this, &batch](uint32_t part_id, std::vector<iovec> iovs) {
+            WaitWrites(m_ring.EntryNum() - 1);
+            uint64_t write_id = m_next_write_id++;
+            Write& write = m_writes[write_id];
+            write.batch = batch;
+            write.iovs = std::move(iovs);
+            write.offset = static_cast<uint64_t>(part_id) * m_part_byte_num;
+            for (const auto& iov : write.iovs) write.byte_num += iov.iov_len;
+            m_ring.PushWritev(m_file.Fd(), write.iovs.data(), static_cast<unsigned>(write.iovs.size()), write.offset, write_id);
+        });
+        m_ring.Submit(0);
+    }
+
+    // waits until at most write_num writes are in flight
+    void WaitWrites(size_t write_num) {
+        while (m_writes.size() > write_num) {
+            m_ring.Submit(1);
+            m_ring.Reap([this](uint64_t write_id, int res) {
+                auto it = m_writes.find(write_id);
+                if (res < 0) throw std::runtime_error("blob write fail, errno " + std::to_string(-res));
+                auto& write = it->second;
+                // short writes are completed synchronously
+                if (static_cast<size_t>(res) < write.byte_num) {
+                    size_t n = res;
+                    size_t i = 0;
+                    while (n >= write.iovs[i].iov_len) n -= write.iovs[i++].iov_len;
+                    write.iovs[i].iov_base = static_cast<Byte*>(write.iovs[i].iov_base) + n;
+                    write.iovs[i].iov_len -= n;
+                    m_file.Write(write.offset + res, write.iovs.data() + i, write.iovs.size() - i);
+                }
+                m_writes.erase(it);
+            });
+        }
+    }
+
+    int m_part_byte_num;
+    BlobFile m_file;
+    IoUring m_ring;
+    std::unique_ptr<PartBatch> m_batch = std::make_unique<PartBatch>();
+    std::unordered_map<uint64_t, Write> m_writes;
+    uint64_t m_next_write_id = 0;
+};
+
+#endif
+
+#endif
+
+}
+
+WriteBehindBlobStorage::WriteBehindBlobStorage(std::unique_ptr<BlobStorage> blob_storage, size_t byte_budget, std::chrono::milliseconds flush_interval) : m_blob_storage(std::move(blob_storage)), m_byte_budget(byte_budget), m_flush_interval(flush_interval) {
+    m_thread = std::thread(&WriteBehindBlobStorage::Worker, this);
+}
+
+WriteBehindBlobStorage::~WriteBehindBlobStorage() {
+    Stop();
+    // the destructor can't throw, an error nobody saw is at least reported
+    if (m_error && !m_error_reported) {
+        try {
+            std::rethrow_exception(m_error);
+        }
+        catch (std::exception& e) {
+            std::cerr << "write behind error, " << e.what() << "\n";
+        }
+        catch (...) {
+            std::cerr << "write behind error\n";
+        }
+    }
+}
+
+void WriteBehindBlobStorage::Close() {
+    Flush();
+    Stop();
+    std::lock_guard<std::mutex> lock(m_mtx);
+    CheckError();
+}
+
+void WriteBehindBlobStorage::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        m_running = false;
+    }
+    m_write_cv.notify_one();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void WriteBehindBlobStorage::WritePart(uint32_t part_id, const Bytes& part_bytes) {
+    std::unique_lock<std::mutex> lock(m_mtx);
+    m_done_cv.wait(lock, [this] { return m_error || m_queue.byte_num + m_writing_queue.byte_num < m_byte_budget; });
+    CheckError();
+    m_queue.part_indexes[part_id] = m_queue.parts.size();
+    m_queue.parts.push_back({part_id, part_bytes});
+    m_queue.byte_num += part_bytes.size();
+    if (m_queue.byte_num >= m_byte_budget / 2) m_write_cv.notify_one();
+}
+
+void WriteBehindBlobStorage::ReadPart(uint32_t part_id, Byte* part_bytes) {
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        for (const Queue* queue : {&m_queue, &m_writing_queue}) {
+            auto it = queue->part_indexes.find(part_id);
+            if (it != queue->part_indexes.end()) {
+                const auto& bytes = queue->parts[it->second].part_bytes;
+                std::copy(bytes.begin(), bytes.end(), part_bytes);
+                return;
+            }
+        }
+    }
+    // parts leave the writing queue only after they are written
+    std::lock_guard<std::mutex> blob_storage_lock(m_blob_storage_mtx);
+    m_blob_storage->ReadPart(part_id, part_bytes);
+}
+
+void WriteBehindBlobStorage::Flush() {
+    std::unique_lock<std::mutex> lock(m_mtx);
+    CheckError();
+    uint64_t flush_seq = ++m_queued_flush_seq;
+    m_queue.flush_seq = flush_seq;
+    m_write_cv.notify_one();
+    m_done_cv.wait(lock, [this, flush_seq] { return m_error || m_done_flush_seq >= flush_seq; });
+    CheckError();
+}
+
+void WriteBehindBlobStorage::Sync() {
+    Flush();
+}
+
+void WriteBehindBlobStorage::FlushAsync(std::function<void()> flush_cb) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    CheckError();
+    m_queue.flush_cbs.push_back(std::move(flush_cb));
+    m_queue.flush_seq = ++m_queued_flush_seq;
+    m_write_cv.notify_one();
+}
+
+WriteBehindBlobStorage::Stats WriteBehindBlobStorage::GetStats() const {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    Stats stats = m_stats;
+    stats.pending_part_num = m_queue.parts.size() + m_writing_queue.parts.size();
+    stats.pending_byte_num = m_queue.byte_num + m_writing_queue.byte_num;
+    return stats;
+}
+
+void WriteBehindBlobStorage::Worker() {
+    std::unique_lock<std::mutex> lock(m_mtx);
+    while (true) {
+        m_write_cv.wait_for(lock, m_flush_interval, [this] { return !m_running || m_queue.flush_seq || m_queue.byte_num >= m_byte_budget / 2; });
+        if (m_queue.parts.empty() && !m_queue.flush_seq) {
+            if (!m_running) break;
+            continue;
+        }
+        std::swap(m_queue, m_writing_queue);
+        lock.unlock();
+        auto t0 = std::chrono::steady_clock::now();
+        std::exception_ptr error;
+        try {
+            std::lock_guard<std::mutex> blob_storage_lock(m_blob_storage_mtx);
+            for (const auto& part : m_writing_queue.parts) {
+                m_blob_storage->WritePart(part.part_id, part.part_bytes);
+            }
+            // parts are synced before the flush callbacks write a task status marking them done
+            if (m_writing_queue.flush_seq) {
+                m_blob_storage->Sync();
+            } else {
+                m_blob_storage->Flush();
+            }
+            for (const auto& flush_cb : m_writing_queue.flush_cbs) {
+                if (flush_cb) flush_cb();
+            }
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+        float flush_seconds = std::chrono::duration_cast<std::chrono::duration<float>>(std::chrono::steady_clock::now() - t0).count();
+        lock.lock();
+        m_stats.flush_num += 1;
+        m_stats.last_flush_seconds = flush_seconds;
+        m_stats.max_flush_seconds = std::max(m_stats.max_flush_seconds, flush_seconds);
+        if (!error) m_done_flush_seq = std::max(m_done_flush_seq, m_writing_queue.flush_seq);
+        m_error = error;
+        m_writing_queue = Queue();
+        m_done_cv.notify_all();
+        if (m_error) break;
+    }
+}
+
+void WriteBehindBlobStorage::CheckError() {
+    if (m_error) {
+        m_error_reported = true;
+        std::rethrow_exception(m_error);
+    }
+}
+
+void sync_path(const std::string& path, bool is_dir) {
+#ifdef _WIN32
+    // windows can't sync a dir, renames are committed with the file system journal
+    if (is_dir) return;
+    int fd = _open(path.c_str(), _O_RDWR | _O_BINARY);
+    bool success = fd >= 0 && _commit(fd) == 0;
+    if (fd >= 0) _close(fd);
+#else
+    int fd = open(path.c_str(), is_dir ? O_RDONLY | O_DIRECTORY : O_RDONLY);
+    bool success = fd >= 0 && fsync(fd) == 0;
+    if (fd >= 0) close(fd);
+#endif
+    if (!success) throw std::runtime_error("can't sync '" + path + "'");
+}
+
+BlobStorageType parse_blob_storage_type(const std::string& blob_storage_type_str) {
+    if (blob_storage_type_str_to_blob_storage_type_mapping.find(blob_storage_type_str) == blob_storage_type_str_to_blob_storage_type_mapping.end()) {
+        throw invalid_image_codec_argument("invalid blob storage type '" + blob_storage_type_str + "'");
+    }
+    return blob_storage_type_str_to_blob_storage_type_mapping[blob_storage_type_str];
+}
+
+std::string get_blob_storage_type_str(BlobStorageType blob_storage_type) {
+    if (blob_storage_type_to_blob_storage_type_str_mapping.find(blob_storage_type) == blob_storage_type_to_blob_storage_type_str_mapping.end()) {
+        throw std::invalid_argument("invalid blob storage type " + std::to_string(static_cast<int>(blob_storage_type)));
+    }
+    return blob_storage_type_to_blob_storage_type_str_mapping[blob_storage_type];
+}
+
+std::unique_ptr<BlobStorage> create_blob_storage(BlobStorageType blob_storage_type, const std::string& blob_path, int part_byte_num, uint32_t part_num) {
+    switch (blob_storage_type) {
+        case BlobStorageType::STREAM: return std::make_unique<StreamBlobStorage>(blob_path, part_byte_num);
+#ifndef _WIN32
+        case BlobStorageType::MMAP: return std::make_unique<MmapBlobStorage>(blob_path, part_byte_num, part_num);
+        case BlobStorageType::PWRITEV: return std::make_unique<PwritevBlobStorage>(blob_path, part_byte_num);
+#ifdef IMAGE_CODEC_IO_URING
+        case BlobStorageType::IO_URING: return std::make_unique<IoUringBlobStorage>(blob_path, part_byte_num);
+#endif
+#endif
+        default: throw invalid_image_codec_argument("blob storage type '" + get_blob_storage_type_str(blob_storage_type) + "' is not supported on this platform");
+    }
+}
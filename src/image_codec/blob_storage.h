@@ -0,0 +1,103 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+#include "image_codec_api.h"
+#include "image_codec_types.h"
+
+enum class BlobStorageType {
+    STREAM = 0,
+    MMAP = 1,
+    PWRITEV = 2,
+    IO_URING = 3,
+};
+
+// writes the parts of a task into its blob file, which is already allocated to part_num parts
+class BlobStorage {
+public:
+    virtual ~BlobStorage() {}
+    // part_bytes may be buffered until Flush
+    virtual void WritePart(uint32_t part_id, const Bytes& part_bytes) = 0;
+    // sees the parts written so far, buffered or not
+    virtual void ReadPart(uint32_t part_id, Byte* part_bytes) = 0;
+    virtual void Flush() = 0;
+    // flushes and makes the parts written so far durable, a task status marking them done may only be written after it
+    virtual void Sync() = 0;
+};
+
+// parts are written to blob_storage by an io thread, which flushes once half of byte_budget is pending or flush_interval has passed,
+// WritePart only blocks while byte_budget bytes are pending
+class WriteBehindBlobStorage : public BlobStorage {
+public:
+    struct Stats {
+        size_t pending_part_num = 0;
+        size_t pending_byte_num = 0;
+        uint64_t flush_num = 0;
+        float last_flush_seconds = 0;
+        float max_flush_seconds = 0;
+    };
+
+    IMAGE_CODEC_API WriteBehindBlobStorage(std::unique_ptr<BlobStorage> blob_storage, size_t byte_budget, std::chrono::milliseconds flush_interval);
+    IMAGE_CODEC_API ~WriteBehindBlobStorage();
+    IMAGE_CODEC_API void WritePart(uint32_t part_id, const Bytes& part_bytes) override;
+    IMAGE_CODEC_API void ReadPart(uint32_t part_id, Byte* part_bytes) override;
+    // waits until every part written so far is flushed, explicit flushes are synced by the io thread
+    IMAGE_CODEC_API void Flush() override;
+    IMAGE_CODEC_API void Sync() override;
+    // flush_cb runs on the io thread once every part written so far is synced
+    IMAGE_CODEC_API void FlushAsync(std::function<void()> flush_cb);
+    // flushes and stops the io thread, errors of the io thread are rethrown here rather than lost in the destructor
+    IMAGE_CODEC_API void Close();
+    IMAGE_CODEC_API Stats GetStats() const;
+
+private:
+    struct Part {
+        uint32_t part_id = 0;
+        Bytes part_bytes;
+    };
+
+    struct Queue {
+        std::vector<Part> parts;
+        std::unordered_map<uint32_t, size_t> part_indexes;
+        std::vector<std::function<void()>> flush_cbs;
+        size_t byte_num = 0;
+        uint64_t flush_seq = 0;
+    };
+
+    void Worker();
+    void Stop();
+    void CheckError();
+
+    std::unique_ptr<BlobStorage> m_blob_storage;
+    size_t m_byte_budget;
+    std::chrono::milliseconds m_flush_interval;
+    Queue m_queue;
+    // parts taken by the io thread, still visible to ReadPart until written
+    Queue m_writing_queue;
+    uint64_t m_queued_flush_seq = 0;
+    uint64_t m_done_flush_seq = 0;
+    Stats m_stats;
+    std::exception_ptr m_error;
+    bool m_error_reported = false;
+    bool m_running = true;
+    std::thread m_thread;
+    mutable std::mutex m_mtx;
+    std::mutex m_blob_storage_mtx;
+    std::condition_variable m_write_cv;
+    std::condition_variable m_done_cv;
+};
+
+// makes the content of path durable, for a dir this covers the entries renamed into it
+IMAGE_CODEC_API void sync_path(const std::string& path, bool is_dir = false);
+IMAGE_CODEC_API BlobStorageType parse_blob_storage_type(const std::string& blob_storage_type_str);
+IMAGE_CODEC_API std::string get_blob_storage_type_str(BlobStorageType blob_storage_type);
+IMAGE_CODEC_API std::unique_ptr<BlobStorage> create_blob_storage(BlobStorageType blob_storage_type, const std::string& blob_path, int part_byte_num, uint32_t part_num);
@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+
+#include <zlib.h>
+
+#include "compression.h"
+
+namespace {
+
+constexpr size_t COMPRESSION_BLOCK_BYTE_NUM = 1 << 20;
+
+std::map<std::string, CompressionType> compression_type_str_to_compression_type_mapping({
+    {"none", CompressionType::NONE},
+    {"zlib", CompressionType::ZLIB},
+});
+
+std::map<CompressionType, std::string> compression_type_to_compression_type_str_mapping({
+    {CompressionType::NONE, "none"},
+    {CompressionType::ZLIB, "zlib"},
+});
+
+class ZlibStream {
+public:
+    explicit ZlibStream(bool deflate) : m_deflate(deflate) {
+        int ret = m_deflate ? deflateInit(&m_stream, Z_BEST_SPEED) : inflateInit(&m_stream);
+        if (ret != Z_OK) throw std::runtime_error("zlib init fail " + std::to_string(ret));
+    }
+
+    ~ZlibStream() {
+        if (m_deflate) {
+            deflateEnd(&m_stream);
+        } else {
+            inflateEnd(&m_stream);
+        }
+    }
+
+    // returns false once the end of the stream is reached
+    template <typename WriteFn>
+    bool Process(const Byte* input, size_t input_byte_num, bool finish, Bytes& buf, WriteFn write_fn) {
+        m_stream.next_in = const_cast<Byte*>(input);
+        m_stream.avail_in = static_cast<uInt>(input_byte_num);
+        buf.resize(COMPRESSION_BLOCK_BYTE_NUM);
+        int ret = Z_OK;
+        do {
+            m_stream.next_out = buf.data();
+            m_stream.avail_out = static_cast<uInt>(buf.size());
+            ret = m_deflate ? deflate(&m_stream, finish ? Z_FINISH : Z_NO_FLUSH) : inflate(&m_stream, Z_NO_FLUSH);
+            if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) throw std::runtime_error("zlib stream fail " + std::to_string(ret));
+            write_fn(buf.data(), buf.size() - m_stream.avail_out);
+        } while (ret != Z_STREAM_END && (m_stream.avail_in > 0 || m_stream.avail_out == 0));
+        return ret != Z_STREAM_END;
+    }
+
+private:
+    bool m_deflate;
+    z_stream m_stream{};
+};
+
+}
+
+CompressionType parse_compression_type(const std::string& compression_type_str) {
+    if (compression_type_str_to_compression_type_mapping.find(compression_type_str) == compression_type_str_to_compression_type_mapping.end()) {
+        throw std::invalid_argument("invalid compression type '" + compression_type_str + "'");
+    }
+    return compression_type_str_to_compression_type_mapping[compression_type_str];
+}
+
+std::string get_compression_type_str(CompressionType compression_type) {
+    if (compression_type_to_compression_type_str_mapping.find(compression_type) == compression_type_to_compression_type_str_mapping.end()) {
+        throw std::invalid_argument("invalid compression type " + std::to_string(static_cast<int>(compression_type)));
+    }
+    return compression_type_to_compression_type_str_mapping[compression_type];
+}
+
+void compress_file(const std::string& file_path, CompressionType compression_type, Bytes& bytes) {
+    if (compression_type != CompressionType::ZLIB) throw std::invalid_argument("invalid compression type " + std::to_string(static_cast<int>(compression_type)));
+    std::ifstream f(file_path, std::ios_base::binary);
+    if (!f) throw std::runtime_error("can't open file '" + file_path + "'");
+    ZlibStream stream(true);
+    Bytes block(COMPRESSION_BLOCK_BYTE_NUM);
+    Bytes buf;
+    auto write_fn = [&bytes](const Byte* data, size_t byte_num) { bytes.insert(bytes.end(), data, data + byte_num); };
+    bool finish = false;
+    while (!finish) {
+        f.read(reinterpret_cast<char*>(block.data()), block.size());
+        finish = !f;
+        stream.Process(block.data(), f.gcount(), finish, buf, write_fn);
+    }
+}
+
+void decompress_file(const std::string& src_path, uint64_t byte_num, const std::string& dst_path, CompressionType compression_type, DecompressionProgressCb progress_cb) {
+    if (compression_type != CompressionType::ZLIB) throw std::invalid_argument("invalid compression type " + std::to_string(static_cast<int>(compression_type)));
+    std::ifstream src_file(src_path, std::ios_base::binary);
+    std::ofstream dst_file(dst_path, std::ios_base::binary);
+    if (!src_file || !dst_file) throw std::runtime_error("can't decompress '" + src_path + "' into '" + dst_path + "'");
+    ZlibStream stream(false);
+    Bytes block(COMPRESSION_BLOCK_BYTE_NUM);
+    Bytes buf;
+    auto write_fn = [&dst_file](const Byte* data, size_t byte_num) { dst_file.write(reinterpret_cast<const char*>(data), byte_num); };
+    uint64_t block_num = (byte_num + COMPRESSION_BLOCK_BYTE_NUM - 1) / COMPRESSION_BLOCK_BYTE_NUM;
+    if (progress_cb) progress_cb(0, block_num);
+    bool running = true;
+    for (uint64_t block_id = 0; block_id < block_num && running; ++block_id) {
+        size_t block_byte_num = static_cast<size_t>(std::min<uint64_t>(COMPRESSION_BLOCK_BYTE_NUM, byte_num - block_id * COMPRESSION_BLOCK_BYTE_NUM));
+        src_file.read(reinterpret_cast<char*>(block.data()), block_byte_num);
+        if (static_cast<size_t>(src_file.gcount()) != block_byte_num) throw std::runtime_error("can't read '" + src_path + "'");
+        running = stream.Process(block.data(), block_byte_num, false, buf, write_fn);
+        if (progress_cb) progress_cb(block_id + 1, block_num);
+    }
+    if (running) throw std::runtime_error("truncated compressed stream in '" + src_path + "'");
+    if (!dst_file) throw std::runtime_error("can't write '" + dst_path + "'");
+}
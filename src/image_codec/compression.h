@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <functional>
+
+#include "image_codec_api.h"
+#include "image_codec_types.h"
+
+enum class CompressionType {
+    NONE = 0,
+    ZLIB = 1,
+};
+
+// called with the number of done blocks and the total block num, first with 0 done blocks before any block is processed
+using DecompressionProgressCb = std::function<void(uint64_t, uint64_t)>;
+
+IMAGE_CODEC_API CompressionType parse_compression_type(const std::string& compression_type_str);
+IMAGE_CODEC_API std::string get_compression_type_str(CompressionType compression_type);
+// the file is streamed through the compressor and the compressed bytes are appended to bytes
+IMAGE_CODEC_API void compress_file(const std::string& file_path, CompressionType compression_type, Bytes& bytes);
+// the first byte_num bytes of src_path are streamed through the decompressor into dst_path
+IMAGE_CODEC_API void decompress_file(const std::string& src_path, uint64_t byte_num, const std::string& dst_path, CompressionType compression_type, DecompressionProgressCb progress_cb);
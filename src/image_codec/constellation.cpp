@@ -0,0 +1,30 @@
+#include <stdexcept>
+#include <string>
+
+#include "constellation.h"
+
+Constellation::Constellation(int bit_num, const std::vector<PixelColor>& colors) : m_bit_num(bit_num) {
+    if (colors.size() != static_cast<size_t>(1) << bit_num) throw std::invalid_argument("invalid constellation color num " + std::to_string(colors.size()));
+    std::array<bool, static_cast<int>(PixelColor::UNKNOWN)> used{};
+    for (size_t bits = 0; bits < colors.size(); ++bits) {
+        Symbol symbol = static_cast<Symbol>(colors[bits]);
+        if (symbol >= static_cast<int>(PixelColor::UNKNOWN) || used[symbol]) {
+            throw std::invalid_argument("invalid constellation color " + std::to_string(symbol));
+        }
+        used[symbol] = true;
+        m_symbols[bits] = symbol;
+        m_bits[symbol] = static_cast<Symbol>(bits);
+    }
+}
+
+void Constellation::BitsToSymbols(Symbol* symbols, size_t symbol_num) const {
+    for (size_t i = 0; i < symbol_num; ++i) {
+        symbols[i] = m_symbols[symbols[i]];
+    }
+}
+
+void Constellation::SymbolsToBits(const Symbol* symbols, size_t symbol_num, Symbol* bits) const {
+    for (size_t i = 0; i < symbol_num; ++i) {
+        bits[i] = m_bits[symbols[i]];
+    }
+}
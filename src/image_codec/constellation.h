@@ -0,0 +1,31 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "image_codec_api.h"
+#include "image_codec_types.h"
+
+// symbols are the pixel colors they are drawn with, a constellation assigns the bit patterns carried by a symbol to those colors
+class Constellation {
+public:
+    IMAGE_CODEC_API Constellation(int bit_num, const std::vector<PixelColor>& colors);
+    IMAGE_CODEC_API int BitNum() const { return m_bit_num; }
+    IMAGE_CODEC_API int ColorNum() const { return 1 << m_bit_num; }
+    IMAGE_CODEC_API bool HasSymbol(Symbol symbol) const { return m_symbols[m_bits[symbol]] == symbol; }
+    IMAGE_CODEC_API Symbol BitsToSymbol(int bits) const { return m_symbols[bits]; }
+    // colors outside of the constellation carry zero bits
+    IMAGE_CODEC_API int SymbolToBits(Symbol symbol) const { return m_bits[symbol]; }
+    IMAGE_CODEC_API void BitsToSymbols(Symbol* symbols, size_t symbol_num) const;
+    IMAGE_CODEC_API void SymbolsToBits(const Symbol* symbols, size_t symbol_num, Symbol* bits) const;
+
+private:
+    int m_bit_num;
+    std::array<Symbol, 256> m_symbols{};
+    std::array<Symbol, 256> m_bits{};
+};
+
+// gray code of a level index, neighboring levels differ in one bit
+constexpr int get_gray_code(int level) {
+    return level ^ (level >> 1);
+}
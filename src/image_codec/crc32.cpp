@@ -0,0 +1,232 @@
+#include <array>
+#include <cstring>
+
+#include "crc32.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define CRC32_PCLMUL 1
+#define CRC32_PCLMUL_TARGET __attribute__((target("pclmul,sse4.1")))
+#include <immintrin.h>
+#elif defined(_M_X64) && defined(_MSC_VER)
+#define CRC32_PCLMUL 1
+#define CRC32_PCLMUL_TARGET
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+namespace {
+
+constexpr uint32_t CRC32_POLY = 0xedb88320;
+
+using Crc32Tables = std::array<std::array<uint32_t, 256>, 8>;
+
+constexpr Crc32Tables get_crc32_tables() {
+    Crc32Tables tables{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t v = i;
+        for (int k = 0; k < 8; ++k) {
+            v = (v & 1) ? (v >> 1) ^ CRC32_POLY : v >> 1;
+        }
+        tables[0][i] = v;
+    }
+    for (uint32_t i = 0; i < 256; ++i) {
+        for (int t = 1; t < 8; ++t) {
+            uint32_t v = tables[t-1][i];
+            tables[t][i] = (v >> 8) ^ tables[0][v & 0xff];
+        }
+    }
+    return tables;
+}
+
+constexpr Crc32Tables CRC32_TABLES = get_crc32_tables();
+
+uint32_t read_uint32_le(const Byte* bytes) {
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+// state is the raw crc register, i.e. the inverted crc value
+uint32_t update_state_slicing8(uint32_t state, const Byte* bytes, size_t byte_num) {
+    const auto& t = CRC32_TABLES;
+    while (byte_num >= 8) {
+        uint32_t one = read_uint32_le(bytes) ^ state;
+        uint32_t two = read_uint32_le(bytes + 4);
+        state = t[7][one & 0xff] ^ t[6][(one >> 8) & 0xff] ^ t[5][(one >> 16) & 0xff] ^ t[4][one >> 24] ^
+                t[3][two & 0xff] ^ t[2][(two >> 8) & 0xff] ^ t[1][(two >> 16) & 0xff] ^ t[0][two >> 24];
+        bytes += 8;
+        byte_num -= 8;
+    }
+    while (byte_num--) {
+        state = (state >> 8) ^ t[0][(state ^ *bytes++) & 0xff];
+    }
+    return state;
+}
+
+// polynomial product modulo the crc polynomial, bit 31 is x^0
+constexpr uint32_t multiply_mod_poly(uint32_t a, uint32_t b) {
+    uint32_t m = 1u << 31;
+    uint32_t p = 0;
+    while (a) {
+        if (a & m) {
+            p ^= b;
+            a ^= m;
+        }
+        m >>= 1;
+        b = (b & 1) ? (b >> 1) ^ CRC32_POLY : b >> 1;
+    }
+    return p;
+}
+
+constexpr std::array<uint32_t, 64> get_x_pow2n_table() {
+    std::array<uint32_t, 64> table{};
+    uint32_t p = 1u << 30;
+    for (auto& e : table) {
+        e = p;
+        p = multiply_mod_poly(p, p);
+    }
+    return table;
+}
+
+constexpr std::array<uint32_t, 64> X_POW2N_TABLE = get_x_pow2n_table();
+
+// x^(8*byte_num) modulo the crc polynomial
+uint32_t get_zero_bytes_operator(size_t byte_num) {
+    uint32_t p = 1u << 31;
+    int k = 3;
+    while (byte_num) {
+        if (byte_num & 1) {
+            p = multiply_mod_poly(X_POW2N_TABLE[k & 63], p);
+        }
+        byte_num >>= 1;
+        ++k;
+    }
+    return p;
+}
+
+#if CRC32_PCLMUL
+
+constexpr size_t PCLMUL_MIN_BYTE_NUM = 64;
+
+bool has_pclmul() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 1)) != 0 && (info[2] & (1 << 19)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+#endif
+}
+
+// folds 64 byte blocks with carry-less multiplication and reduces with barrett, byte_num must be a multiple of 16 and at least 64
+CRC32_PCLMUL_TARGET uint32_t update_state_pclmul(uint32_t state, const Byte* bytes, size_t byte_num) {
+    alignas(16) static const uint64_t k1k2[] = {0x0154442bd4, 0x01c6e41596};
+    alignas(16) static const uint64_t k3k4[] = {0x01751997d0, 0x00ccaa009e};
+    alignas(16) static const uint64_t k5k0[] = {0x0163cd6124, 0x0000000000};
+    alignas(16) static const uint64_t poly[] = {0x01db710641, 0x01f7011641};
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+    x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + 0x00));
+    x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + 0x10));
+    x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + 0x20));
+    x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(state)));
+    x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+    bytes += 64;
+    byte_num -= 64;
+    while (byte_num >= 64) {
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+        y5 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + 0x00));
+        y6 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + 0x10));
+        y7 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + 0x20));
+        y8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + 0x30));
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+        bytes += 64;
+        byte_num -= 64;
+    }
+    x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+    while (byte_num >= 16) {
+        x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+        bytes += 16;
+        byte_num -= 16;
+    }
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x1 = _mm_srli_si128(x1, 8);
+    x1 = _mm_xor_si128(x1, x2);
+    x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5k0));
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, x3);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+    x2 = _mm_and_si128(x1, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+}
+
+const bool g_pclmul = has_pclmul();
+
+#else
+
+const bool g_pclmul = false;
+
+#endif
+
+}
+
+uint32_t crc32_update(uint32_t crc, const Byte* bytes, size_t byte_num) {
+    uint32_t state = ~crc;
+#if CRC32_PCLMUL
+    if (g_pclmul && byte_num >= PCLMUL_MIN_BYTE_NUM) {
+        size_t folded_byte_num = byte_num & ~static_cast<size_t>(15);
+        state = update_state_pclmul(state, bytes, folded_byte_num);
+        bytes += folded_byte_num;
+        byte_num -= folded_byte_num;
+    }
+#endif
+    return ~update_state_slicing8(state, bytes, byte_num);
+}
+
+uint32_t crc32_update_slicing8(uint32_t crc, const Byte* bytes, size_t byte_num) {
+    return ~update_state_slicing8(~crc, bytes, byte_num);
+}
+
+uint32_t crc32_update_zeros(uint32_t crc, size_t byte_num) {
+    return ~multiply_mod_poly(get_zero_bytes_operator(byte_num), ~crc);
+}
+
+uint32_t crc32_combine(uint32_t crc1, uint32_t crc2, size_t byte_num2) {
+    return multiply_mod_poly(get_zero_bytes_operator(byte_num2), crc1) ^ crc2;
+}
+
+uint32_t crc32_byte_delta(Byte xor_byte, size_t byte_pos, size_t byte_num) {
+    return multiply_mod_poly(get_zero_bytes_operator(byte_num - 1 - byte_pos), CRC32_TABLES[0][xor_byte]);
+}
+
+bool is_crc32_accelerated() {
+    return g_pclmul;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "image_codec_api.h"
+#include "image_codec_types.h"
+
+// crc values follow the zlib convention: start from 0 and pass the previous result back in to continue
+IMAGE_CODEC_API uint32_t crc32_update(uint32_t crc, const Byte* bytes, size_t byte_num);
+IMAGE_CODEC_API uint32_t crc32_update_slicing8(uint32_t crc, const Byte* bytes, size_t byte_num);
+IMAGE_CODEC_API uint32_t crc32_update_zeros(uint32_t crc, size_t byte_num);
+IMAGE_CODEC_API uint32_t crc32_combine(uint32_t crc1, uint32_t crc2, size_t byte_num2);
+// crc change caused by xoring one byte of a byte_num byte message with xor_byte
+IMAGE_CODEC_API uint32_t crc32_byte_delta(Byte xor_byte, size_t byte_pos, size_t byte_num);
+IMAGE_CODEC_API bool is_crc32_accelerated();
+
+inline uint32_t crc32(const Byte* bytes, size_t byte_num) {
+    return crc32_update(0, bytes, byte_num);
+}
@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+#include "fountain_code.h"
+
+namespace {
+
+constexpr double ROBUST_SOLITON_C = 0.03;
+constexpr double ROBUST_SOLITON_DELTA = 0.5;
+
+class SplitMix64 {
+public:
+    explicit SplitMix64(uint64_t seed) : m_state(seed) {}
+
+    uint32_t Next() {
+        uint64_t z = (m_state += 0x9e3779b97f4a7c15);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        return static_cast<uint32_t>((z ^ (z >> 31)) >> 32);
+    }
+
+    // uniform in [0, n)
+    uint32_t Next(uint32_t n) {
+        return static_cast<uint32_t>((static_cast<uint64_t>(Next()) * n) >> 32);
+    }
+
+private:
+    uint64_t m_state;
+};
+
+}
+
+FountainCode::FountainCode(uint32_t part_num) : m_part_num(part_num) {
+    if (part_num == 0 || part_num >= FOUNTAIN_PART_ID_FLAG) throw std::invalid_argument("invalid fountain code part num " + std::to_string(part_num));
+    // robust soliton distribution, the cdf is quantized so that encoder and decoder hosts agree on sampled degrees
+    double k = part_num;
+    double r = ROBUST_SOLITON_C * std::log(k / ROBUST_SOLITON_DELTA) * std::sqrt(k);
+    uint32_t spike = r > 1 ? static_cast<uint32_t>(std::clamp(std::floor(k / r), 1.0, k)) : part_num;
+    std::vector<double> weights(part_num);
+    for (uint32_t d = 1; d <= part_num; ++d) {
+        double w = d == 1 ? 1 / k : 1 / (static_cast<double>(d) * (d - 1));
+        if (d < spike) {
+            w += r / (d * k);
+        } else if (d == spike) {
+            w += r * std::log(std::max(r / ROBUST_SOLITON_DELTA, 1.0)) / k;
+        }
+        weights[d - 1] = w;
+    }
+    double total = 0;
+    for (auto w : weights) total += w;
+    m_degree_cdf.resize(part_num);
+    double cum = 0;
+    for (uint32_t d = 1; d <= part_num; ++d) {
+        cum += weights[d - 1];
+        m_degree_cdf[d - 1] = static_cast<uint32_t>(std::min(std::round(cum / total * 4294967296.0), 4294967295.0));
+    }
+    m_degree_cdf.back() = 0xffffffff;
+}
+
+void FountainCode::GetNeighbors(uint32_t seq, std::vector<uint32_t>& neighbors) const {
+    SplitMix64 rng((static_cast<uint64_t>(m_part_num) << 32) | seq);
+    uint32_t degree = static_cast<uint32_t>(std::upper_bound(m_degree_cdf.begin(), m_degree_cdf.end(), rng.Next()) - m_degree_cdf.begin()) + 1;
+    degree = std::min(degree, m_part_num);
+    // floyd's sampling of distinct part ids
+    neighbors.clear();
+    for (uint32_t j = m_part_num - degree; j < m_part_num; ++j) {
+        uint32_t t = rng.Next(j + 1);
+        auto it = std::lower_bound(neighbors.begin(), neighbors.end(), t);
+        if (it != neighbors.end() && *it == t) {
+            t = j;
+            it = neighbors.end();
+        }
+        neighbors.insert(it, t);
+    }
+}
+
+void FountainCode::Encode(uint32_t seq, const Byte* raw_bytes, int part_byte_num, Byte* part_bytes) const {
+    thread_local std::vector<uint32_t> neighbors;
+    GetNeighbors(seq, neighbors);
+    std::fill(part_bytes, part_bytes + part_byte_num, 0);
+    for (auto part_id : neighbors) {
+        const Byte* src = raw_bytes + static_cast<size_t>(part_id) * part_byte_num;
+        for (int i = 0; i < part_byte_num; ++i) {
+            part_bytes[i] ^= src[i];
+        }
+    }
+}
+
+namespace {
+
+void xor_part_bytes(Byte* dst, const Byte* src, size_t byte_num) {
+    for (size_t i = 0; i < byte_num; ++i) {
+        dst[i] ^= src[i];
+    }
+}
+
+}
+
+FountainDecoder::FountainDecoder(const std::string& pending_path, uint32_t part_num, int part_byte_num, IsPartDoneCb is_part_done_cb, ReadPartCb read_part_cb, RecoverPartCb recover_part_cb) :
+    m_pending_path(pending_path),
+    m_fountain_code(part_num),
+    m_part_byte_num(part_byte_num),
+    m_is_part_done_cb(is_part_done_cb),
+    m_read_part_cb(read_part_cb),
+    m_recover_part_cb(recover_part_cb),
+    m_pending_file(pending_path, std::ios_base::in | std::ios_base::out | std::ios_base::binary | std::ios_base::trunc) {
+    if (!m_pending_file) throw std::runtime_error("can't open fountain pending file '" + pending_path + "'");
+}
+
+FountainDecoder::~FountainDecoder() {
+    m_pending_file.close();
+    std::remove(m_pending_path.c_str());
+}
+
+void FountainDecoder::UpdateFountainPart(uint32_t seq, const Bytes& part_bytes) {
+    if (part_bytes.size() != static_cast<size_t>(m_part_byte_num)) return;
+    m_fountain_code.GetNeighbors(seq, m_neighbors);
+    Bytes coded_bytes = part_bytes;
+    std::vector<uint32_t> unknown_neighbors;
+    m_buf.resize(m_part_byte_num);
+    for (auto part_id : m_neighbors) {
+        if (m_is_part_done_cb(part_id)) {
+            m_read_part_cb(part_id, m_buf.data());
+            xor_part_bytes(coded_bytes.data(), m_buf.data(), m_part_byte_num);
+        } else {
+            unknown_neighbors.push_back(part_id);
+        }
+    }
+    if (unknown_neighbors.empty()) return;
+    if (unknown_neighbors.size() == 1) {
+        Peel(unknown_neighbors[0], std::move(coded_bytes));
+        return;
+    }
+    uint32_t slot = AllocateSlot();
+    WriteSlot(slot, coded_bytes.data());
+    for (auto part_id : unknown_neighbors) {
+        m_part_to_slots[part_id].push_back(slot);
+    }
+    m_pending_parts[slot].unknown_neighbors = std::move(unknown_neighbors);
+    m_pending_parts[slot].alive = true;
+    ++m_pending_part_num;
+}
+
+void FountainDecoder::UpdatePart(uint32_t part_id, const Bytes& part_bytes) {
+    Peel(part_id, part_bytes);
+}
+
+uint32_t FountainDecoder::AllocateSlot() {
+    if (!m_free_slots.empty()) {
+        uint32_t slot = m_free_slots.back();
+        m_free_slots.pop_back();
+        return slot;
+    }
+    m_pending_parts.emplace_back();
+    return static_cast<uint32_t>(m_pending_parts.size() - 1);
+}
+
+void FountainDecoder::ReadSlot(uint32_t slot, Byte* part_bytes) {
+    m_pending_file.seekg(static_cast<uint64_t>(slot) * m_part_byte_num);
+    m_pending_file.read(reinterpret_cast<char*>(part_bytes), m_part_byte_num);
+}
+
+void FountainDecoder::WriteSlot(uint32_t slot, const Byte* part_bytes) {
+    m_pending_file.seekp(static_cast<uint64_t>(slot) * m_part_byte_num);
+    m_pending_file.write(reinterpret_cast<const char*>(part_bytes), m_part_byte_num);
+}
+
+void FountainDecoder::Peel(uint32_t part_id, Bytes part_bytes) {
+    std::vector<std::pair<uint32_t, Bytes>> ripple;
+    ripple.emplace_back(part_id, std::move(part_bytes));
+    Bytes coded_bytes(m_part_byte_num);
+    while (!ripple.empty()) {
+        auto [cur_part_id, cur_part_bytes] = std::move(ripple.back());
+        ripple.pop_back();
+        if (m_is_part_done_cb(cur_part_id)) continue;
+        m_recover_part_cb(cur_part_id, cur_part_bytes);
+        auto it = m_part_to_slots.find(cur_part_id);
+        if (it == m_part_to_slots.end()) continue;
+        auto slots = std::move(it->second);
+        m_part_to_slots.erase(it);
+        for (auto slot : slots) {
+            auto& pending_part = m_pending_parts[slot];
+            if (!pending_part.alive) continue;
+            auto& unknown_neighbors = pending_part.unknown_neighbors;
+            unknown_neighbors.erase(std::find(unknown_neighbors.begin(), unknown_neighbors.end(), cur_part_id));
+            ReadSlot(slot, coded_bytes.data());
+            xor_part_bytes(coded_bytes.data(), cur_part_bytes.data(), m_part_byte_num);
+            if (unknown_neighbors.size() == 1) {
+                ripple.emplace_back(unknown_neighbors[0], coded_bytes);
+                unknown_neighbors.clear();
+                pending_part.alive = false;
+                m_free_slots.push_back(slot);
+                --m_pending_part_num;
+            } else {
+                WriteSlot(slot, coded_bytes.data());
+            }
+        }
+    }
+}
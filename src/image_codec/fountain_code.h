@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <functional>
+#include <unordered_map>
+
+#include "image_codec_api.h"
+#include "image_codec_types.h"
+
+// fountain coded parts carry this flag in their part id, the remaining bits are the sequence number of the coded part
+constexpr uint32_t FOUNTAIN_PART_ID_FLAG = 0x80000000;
+
+inline bool is_fountain_part_id(uint32_t part_id) {
+    return (part_id & FOUNTAIN_PART_ID_FLAG) != 0;
+}
+
+// LT code with a robust soliton degree distribution over the parts of a task
+class FountainCode {
+public:
+    IMAGE_CODEC_API explicit FountainCode(uint32_t part_num);
+    IMAGE_CODEC_API uint32_t PartNum() const { return m_part_num; }
+    // neighbors are the distinct source part ids xored into coded part seq
+    IMAGE_CODEC_API void GetNeighbors(uint32_t seq, std::vector<uint32_t>& neighbors) const;
+    IMAGE_CODEC_API void Encode(uint32_t seq, const Byte* raw_bytes, int part_byte_num, Byte* part_bytes) const;
+
+private:
+    uint32_t m_part_num;
+    std::vector<uint32_t> m_degree_cdf;
+};
+
+// peeling decoder, coded parts which still have more than one unknown neighbor are kept in a pending file
+class FountainDecoder {
+public:
+    using IsPartDoneCb = std::function<bool(uint32_t)>;
+    using ReadPartCb = std::function<void(uint32_t, Byte*)>;
+    using RecoverPartCb = std::function<void(uint32_t, const Bytes&)>;
+
+    IMAGE_CODEC_API FountainDecoder(const std::string& pending_path, uint32_t part_num, int part_byte_num, IsPartDoneCb is_part_done_cb, ReadPartCb read_part_cb, RecoverPartCb recover_part_cb);
+    IMAGE_CODEC_API ~FountainDecoder();
+    IMAGE_CODEC_API void UpdateFountainPart(uint32_t seq, const Bytes& part_bytes);
+    // feeds a source part which became known outside the decoder
+    IMAGE_CODEC_API void UpdatePart(uint32_t part_id, const Bytes& part_bytes);
+    IMAGE_CODEC_API size_t PendingPartNum() const { return m_pending_part_num; }
+
+private:
+    struct PendingPart {
+        std::vector<uint32_t> unknown_neighbors;
+        bool alive = false;
+    };
+
+    uint32_t AllocateSlot();
+    void ReadSlot(uint32_t slot, Byte* part_bytes);
+    void WriteSlot(uint32_t slot, const Byte* part_bytes);
+    void Peel(uint32_t part_id, Bytes part_bytes);
+
+    std::string m_pending_path;
+    FountainCode m_fountain_code;
+    int m_part_byte_num;
+    IsPartDoneCb m_is_part_done_cb;
+    ReadPartCb m_read_part_cb;
+    RecoverPartCb m_recover_part_cb;
+
+    std::fstream m_pending_file;
+    std::vector<PendingPart> m_pending_parts;
+    std::vector<uint32_t> m_free_slots;
+    size_t m_pending_part_num = 0;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> m_part_to_slots;
+    std::vector<uint32_t> m_neighbors;
+    Bytes m_buf;
+};
@@ -1,7 +1,16 @@
 #pragma once
 
+#include "blob_storage.h"
+#include "compression.h"
+#include "crc32.h"
+#include "fountain_code.h"
+#include "part_bitmap.h"
+#include "reed_solomon.h"
+#include "sparse_map.h"
 #include "symbol_codec.h"
+#include "symbol_packing.h"
 #include "transform_utils.h"
+#include "pixel_classifier.h"
 #include "image_decoder.h"
 #include "thread_safe_queue.h"
 #include "image_stream.h"
@@ -16,17 +16,25 @@ std::ostream& operator<<(std::ostream& os, const std::vector<uint8_t>& v) {
 
 std::string get_pixel_color(Symbol symbol) {
     switch (symbol) {
-        case static_cast<int>(PixelColor::WHITE):   return "white";
-        case static_cast<int>(PixelColor::BLACK):   return "black";
-        case static_cast<int>(PixelColor::RED):     return "red";
-        case static_cast<int>(PixelColor::BLUE):    return "blue";
-        case static_cast<int>(PixelColor::GREEN):   return "green";
-        case static_cast<int>(PixelColor::CYAN):    return "cyan";
-        case static_cast<int>(PixelColor::MAGENTA): return "magenta";
-        case static_cast<int>(PixelColor::YELLOW):  return "yellow";
-        case static_cast<int>(PixelColor::UNKNOWN): return "unknown";
-        case static_cast<int>(PixelColor::NUM):     return "num";
-        default:                                    return "default";
+        case static_cast<int>(PixelColor::WHITE):      return "white";
+        case static_cast<int>(PixelColor::BLACK):      return "black";
+        case static_cast<int>(PixelColor::RED):        return "red";
+        case static_cast<int>(PixelColor::BLUE):       return "blue";
+        case static_cast<int>(PixelColor::GREEN):      return "green";
+        case static_cast<int>(PixelColor::CYAN):       return "cyan";
+        case static_cast<int>(PixelColor::MAGENTA):    return "magenta";
+        case static_cast<int>(PixelColor::YELLOW):     return "yellow";
+        case static_cast<int>(PixelColor::DARK_GREEN): return "dark_green";
+        case static_cast<int>(PixelColor::MID_GREEN):  return "mid_green";
+        case static_cast<int>(PixelColor::ROYAL_BLUE): return "royal_blue";
+        case static_cast<int>(PixelColor::AZURE):      return "azure";
+        case static_cast<int>(PixelColor::VERMILION):  return "vermilion";
+        case static_cast<int>(PixelColor::ORANGE):     return "orange";
+        case static_cast<int>(PixelColor::PINK):       return "pink";
+        case static_cast<int>(PixelColor::LIGHT_PINK): return "light_pink";
+        case static_cast<int>(PixelColor::UNKNOWN):    return "unknown";
+        case static_cast<int>(PixelColor::NUM):        return "num";
+        default:                                       return "default";
     }
 }
 
@@ -48,3 +56,17 @@ Dim parse_dim(const std::string& dim_str) {
     if (dims.size() != 4) throw std::invalid_argument("invalid dim");
     return {dims[0], dims[1], dims[2], dims[3]};
 }
+
+Dim get_part_dim(const Dim& dim, int frame_part_num) {
+    int tile_num = dim.tile_x_num * dim.tile_y_num;
+    if (frame_part_num < 1 || tile_num % frame_part_num != 0) throw invalid_image_codec_argument("invalid frame_part_num '" + std::to_string(frame_part_num) + "' for " + std::to_string(tile_num) + " tiles");
+    // parts take consecutive tiles in row-major order, so a part must be whole rows of tiles or a whole fraction of one row
+    int part_tile_num = tile_num / frame_part_num;
+    if (part_tile_num % dim.tile_x_num == 0) {
+        return {dim.tile_x_num, part_tile_num / dim.tile_x_num, dim.tile_x_size, dim.tile_y_size};
+    } else if (dim.tile_x_num % part_tile_num == 0) {
+        return {part_tile_num, 1, dim.tile_x_size, dim.tile_y_size};
+    } else {
+        throw invalid_image_codec_argument("invalid frame_part_num '" + std::to_string(frame_part_num) + "', parts of " + std::to_string(part_tile_num) + " tiles aren't rectangular");
+    }
+}
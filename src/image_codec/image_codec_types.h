@@ -16,16 +16,24 @@ using Symbols = std::vector<Symbol>;
 IMAGE_CODEC_API std::ostream& operator<<(std::ostream& os, const std::vector<uint8_t>& v);
 
 enum class PixelColor {
-    WHITE   = 0,
-    BLACK   = 1,
-    RED     = 2,
-    BLUE    = 3,
-    GREEN   = 4,
-    CYAN    = 5,
-    MAGENTA = 6,
-    YELLOW  = 7,
-    UNKNOWN = 8,
-    NUM     = 9,
+    WHITE      = 0,
+    BLACK      = 1,
+    RED        = 2,
+    BLUE       = 3,
+    GREEN      = 4,
+    CYAN       = 5,
+    MAGENTA    = 6,
+    YELLOW     = 7,
+    DARK_GREEN = 8,
+    MID_GREEN  = 9,
+    ROYAL_BLUE = 10,
+    AZURE      = 11,
+    VERMILION  = 12,
+    ORANGE     = 13,
+    PINK       = 14,
+    LIGHT_PINK = 15,
+    UNKNOWN    = 16,
+    NUM        = 17,
 };
 
 IMAGE_CODEC_API std::string get_pixel_color(Symbol symbol);
@@ -105,3 +113,5 @@ IMAGE_CODEC_API bool operator!=(const Dim& dim1, const Dim& dim2);
 IMAGE_CODEC_API std::ostream& operator<<(std::ostream& os, const Dim& dim);
 
 IMAGE_CODEC_API Dim parse_dim(const std::string& dim_str);
+// dim of each of the frame_part_num independently coded parts of a frame
+IMAGE_CODEC_API Dim get_part_dim(const Dim& dim, int frame_part_num);
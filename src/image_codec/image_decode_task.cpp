@@ -1,32 +1,145 @@
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#include <stdexcept>
 #include <system_error>
 
+#include "crc32.h"
 #include "symbol_codec.h"
 #include "image_decode_task.h"
 
-Task::Task(const std::string& path) : m_path(path), m_task_path(path + ".task"), m_blob_path(path + ".blob") {
+namespace {
+
+constexpr uint32_t COMPRESSION_MAGIC = 0x5a43424c;
+constexpr std::chrono::milliseconds WRITE_BEHIND_FLUSH_INTERVAL(1000);
+
+// layout of the last part, uncompressed tasks only carry byte_num followed by zero padding
+struct TaskTrailer {
+    uint64_t byte_num = 0;
+    uint32_t compression_magic = 0;
+    uint32_t compression_type = 0;
+    uint64_t original_byte_num = 0;
+};
+
+// a journal record is the part id num and the crc32 of the part ids followed by the part ids
+constexpr size_t JOURNAL_RECORD_HEADER_BYTE_NUM = 8;
+constexpr size_t MIN_CHECKPOINT_JOURNAL_BYTE_NUM = 1 << 16;
+
+// status encodings of version 2 task bytes
+constexpr uint32_t TASK_STATUS_BITMAP = 0;
+constexpr uint32_t TASK_STATUS_UNDONE_RANGES = 1;
+
+// clears the status bits of parts [first_part_id, end_part_id)
+void clear_part_bits(Bytes& task_status_bytes, uint32_t first_part_id, uint32_t end_part_id) {
+    for (; first_part_id < end_part_id && first_part_id % 8; ++first_part_id) {
+        task_status_bytes[first_part_id / 8] &= ~(0x1 << (first_part_id % 8));
+    }
+    uint32_t byte_num = (end_part_id - first_part_id) / 8;
+    std::fill_n(task_status_bytes.begin() + first_part_id / 8, byte_num, 0);
+    for (first_part_id += byte_num * 8; first_part_id < end_part_id; ++first_part_id) {
+        task_status_bytes[first_part_id / 8] &= ~(0x1 << (first_part_id % 8));
+    }
+}
+
+// the journal is dropped only once the checkpoint replacing it is durable, a failed write leaves the old checkpoint and the journal in place
+void write_task_checkpoint(const std::string& task_path, const std::string& journal_path, const Bytes& task_bytes) {
+    std::string tmp_task_path = task_path + ".tmp";
+    {
+        std::ofstream f(tmp_task_path, std::ios_base::binary);
+        f.write(reinterpret_cast<const char*>(task_bytes.data()), task_bytes.size());
+        f.close();
+        if (!f) throw std::runtime_error("can't write '" + tmp_task_path + "'");
+    }
+    sync_path(tmp_task_path);
+    std::filesystem::rename(tmp_task_path, task_path);
+    auto dir = std::filesystem::absolute(task_path).parent_path().string();
+    sync_path(dir, true);
+    std::filesystem::remove(journal_path);
+}
+
+void append_task_journal(const std::string& journal_path, const std::vector<uint32_t>& part_ids) {
+    uint32_t part_id_num = static_cast<uint32_t>(part_ids.size());
+    uint32_t crc = crc32(reinterpret_cast<const Byte*>(part_ids.data()), part_ids.size() * sizeof(uint32_t));
+    std::ofstream f(journal_path, std::ios_base::binary | std::ios_base::app);
+    f.write(reinterpret_cast<const char*>(&part_id_num), sizeof(part_id_num));
+    f.write(reinterpret_cast<const char*>(&crc), sizeof(crc));
+    f.write(reinterpret_cast<const char*>(part_ids.data()), part_ids.size() * sizeof(uint32_t));
+    f.close();
+    if (!f) throw std::runtime_error("can't write '" + journal_path + "'");
+}
+
+}
+
+Task::Task(const std::string& path, BlobStorageType blob_storage_type) : m_path(path), m_task_path(path + ".task"), m_journal_path(path + ".task.journal"), m_blob_path(path + ".blob"), m_blob_storage_type(blob_storage_type) {
 }
 
 void Task::Init(SymbolType symbol_type, const Dim& dim, uint32_t part_num) {
     m_symbol_type = symbol_type;
     m_dim = dim;
     m_part_num = part_num;
-    m_done_part_num = 0;
-    m_task_status_bytes.resize((static_cast<size_t>(m_part_num) + 7) / 8, 0);
+    m_part_bitmap = PartBitmap(m_part_num);
+    m_journal_part_ids.clear();
+    m_journal_byte_num = 0;
+    m_checkpointed = false;
 }
 
+// a truncated task file is rejected rather than loaded as a status with parts missing
 void Task::Load() {
+    std::error_code ec;
+    auto task_byte_num = std::filesystem::file_size(m_task_path, ec);
+    if (ec) throw std::runtime_error("can't read '" + m_task_path + "'");
+    Bytes task_bytes(task_byte_num);
     std::ifstream f(m_task_path, std::ios_base::binary);
-    int symbol_type = 0;
-    f.read(reinterpret_cast<char*>(&symbol_type), sizeof(symbol_type));
-    m_symbol_type = static_cast<SymbolType>(symbol_type);
-    f.read(reinterpret_cast<char*>(&m_dim), sizeof(m_dim));
-    f.read(reinterpret_cast<char*>(&m_part_num), sizeof(m_part_num));
-    f.read(reinterpret_cast<char*>(&m_done_part_num), sizeof(m_done_part_num));
-    m_task_status_bytes.resize((static_cast<size_t>(m_part_num) + 7) / 8, 0);
-    f.read(reinterpret_cast<char*>(m_task_status_bytes.data()), m_task_status_bytes.size());
+    f.read(reinterpret_cast<char*>(task_bytes.data()), task_bytes.size());
+    if (!f) throw std::runtime_error("can't read '" + m_task_path + "'");
+    if (get_task_bytes_version(task_bytes) != TASK_BYTES_VERSION1) throw std::runtime_error("invalid task file '" + m_task_path + "'");
+    try {
+        // the done part num is recounted from the status bits
+        auto [symbol_type, dim, part_num, done_part_num, task_status_bytes] = from_task_bytes(task_bytes);
+        m_symbol_type = symbol_type;
+        m_dim = dim;
+        m_part_num = part_num;
+        m_part_bitmap = PartBitmap(task_status_bytes, m_part_num);
+    }
+    catch (const std::invalid_argument& e) {
+        throw std::runtime_error("invalid task file '" + m_task_path + "', " + e.what());
+    }
+    ReplayJournal();
+}
+
+// replay stops at the first torn record, the next flush then compacts into a checkpoint so nothing gets appended after it
+void Task::ReplayJournal() {
+    m_journal_part_ids.clear();
+    m_journal_byte_num = 0;
+    m_checkpointed = true;
+    std::ifstream f(m_journal_path, std::ios_base::binary);
+    if (!f) return;
+    std::vector<uint32_t> part_ids;
+    while (true) {
+        uint32_t part_id_num = 0;
+        uint32_t crc = 0;
+        if (!f.read(reinterpret_cast<char*>(&part_id_num), sizeof(part_id_num))) break;
+        if (!f.read(reinterpret_cast<char*>(&crc), sizeof(crc))) {
+            m_checkpointed = false;
+            break;
+        }
+        part_ids.resize(part_id_num);
+        if (!f.read(reinterpret_cast<char*>(part_ids.data()), part_ids.size() * sizeof(uint32_t)) || crc32(reinterpret_cast<const Byte*>(part_ids.data()), part_ids.size() * sizeof(uint32_t)) != crc) {
+            m_checkpointed = false;
+            break;
+        }
+        for (auto part_id : part_ids) {
+            if (part_id < m_part_num) m_part_bitmap.SetDone(part_id);
+        }
+        m_journal_byte_num += JOURNAL_RECORD_HEADER_BYTE_NUM + part_ids.size() * sizeof(uint32_t);
+    }
+    m_journal_part_ids.clear();
+}
+
+void Task::SetWriteBehind(size_t byte_budget) {
+    m_write_behind_byte_budget = byte_budget;
 }
 
 void Task::SetFinalizationCb(FinalizationStartCb finalization_start_cb, FinalizationProgressCb finalization_progress_cb, FinalizationCompleteCb finalization_complete_cb) {
@@ -44,73 +157,155 @@ bool Task::AllocateBlob() {
 }
 
 bool Task::IsPartDone(uint32_t part_id) const {
-    auto byte_index = part_id / 8;
-    char mask = 0x1 << (part_id % 8);
-    return m_task_status_bytes[byte_index] & mask;
+    return m_part_bitmap.IsDone(part_id);
 }
 
 void Task::UpdatePart(uint32_t part_id, const Bytes& part_bytes) {
-    if (IsPartDone(part_id)) return;
+    if (is_fountain_part_id(part_id)) {
+        GetFountainDecoder().UpdateFountainPart(part_id & ~FOUNTAIN_PART_ID_FLAG, part_bytes);
+        return;
+    }
+    if (is_sparse_map_part_id(part_id)) {
+        UpdateSparseMapPart(part_id, part_bytes);
+        return;
+    }
+    if (part_id >= m_part_num || IsPartDone(part_id)) return;
+    if (m_fountain_decoder) {
+        m_fountain_decoder->UpdatePart(part_id, part_bytes);
+    } else {
+        SavePart(part_id, part_bytes);
+    }
+}
 
-    auto byte_index = part_id / 8;
-    char mask = 0x1 << (part_id % 8);
-    m_task_status_bytes[byte_index] |= mask;
-    m_done_part_num += 1;
+void Task::MarkPartDone(uint32_t part_id) {
+    m_part_bitmap.SetDone(part_id);
+    m_journal_part_ids.push_back(part_id);
+}
 
-    m_blob_buf.emplace_back(part_id, part_bytes);
+void Task::SavePart(uint32_t part_id, const Bytes& part_bytes) {
+    MarkPartDone(part_id);
 
-    if ((m_done_part_num & 0x1fff) == 0) {
+    GetBlobStorage().WritePart(part_id, part_bytes);
+
+    if ((DonePartNum() & 0x1fff) == 0) {
         Flush();
     }
 }
 
-Bytes Task::ToTaskBytes() const {
-    Bytes bytes;
-    const uint8_t* ptr = nullptr;
-    int symbol_type = static_cast<int>(m_symbol_type);
-    ptr = reinterpret_cast<const uint8_t*>(&symbol_type);
-    bytes.insert(bytes.end(), ptr, ptr+sizeof(symbol_type));
-    ptr = reinterpret_cast<const uint8_t*>(&m_dim);
-    bytes.insert(bytes.end(), ptr, ptr+sizeof(m_dim));
-    ptr = reinterpret_cast<const uint8_t*>(&m_part_num);
-    bytes.insert(bytes.end(), ptr, ptr+sizeof(m_part_num));
-    ptr = reinterpret_cast<const uint8_t*>(&m_done_part_num);
-    bytes.insert(bytes.end(), ptr, ptr+sizeof(m_done_part_num));
-    bytes.insert(bytes.end(), m_task_status_bytes.begin(), m_task_status_bytes.end());
-    return bytes;
+// zero parts are left as the holes of the blob allocated by AllocateBlob, only the fountain decoder needs their bytes
+void Task::UpdateSparseMapPart(uint32_t part_id, const Bytes& part_bytes) {
+    m_zero_part_ids.clear();
+    get_sparse_map_zero_part_ids(part_id, part_bytes, m_part_num, m_zero_part_ids);
+    for (auto zero_part_id : m_zero_part_ids) {
+        if (IsPartDone(zero_part_id)) continue;
+        if (m_fountain_decoder) {
+            m_fountain_decoder->UpdatePart(zero_part_id, Bytes(part_bytes.size(), 0));
+        } else {
+            MarkPartDone(zero_part_id);
+        }
+    }
 }
 
-void Task::Flush() {
-    std::fstream blob_file(m_blob_path, std::ios_base::in | std::ios_base::out | std::ios_base::binary);
-    for (const auto& [part_id, part_bytes] : m_blob_buf) {
-        blob_file.seekp(part_id * part_bytes.size());
-        blob_file.write(reinterpret_cast<const char*>(part_bytes.data()), part_bytes.size());
+Bytes Task::ToTaskBytes(uint32_t version) const {
+    return to_task_bytes(m_symbol_type, m_dim, m_part_bitmap, version);
+}
+
+void Task::ReadPart(uint32_t part_id, Byte* part_bytes) {
+    GetBlobStorage().ReadPart(part_id, part_bytes);
+}
+
+FountainDecoder& Task::GetFountainDecoder() {
+    if (!m_fountain_decoder) {
+        m_fountain_decoder = std::make_unique<FountainDecoder>(m_path + ".fountain", m_part_num, get_part_byte_num(m_symbol_type, m_dim),
+            [this](uint32_t part_id){ return IsPartDone(part_id); },
+            [this](uint32_t part_id, Byte* part_bytes){ ReadPart(part_id, part_bytes); },
+            [this](uint32_t part_id, const Bytes& part_bytes){ SavePart(part_id, part_bytes); });
     }
-    m_blob_buf.clear();
+    return *m_fountain_decoder;
+}
+
+// the blob file must be allocated before the first part is saved
+BlobStorage& Task::GetBlobStorage() {
+    if (!m_blob_storage) {
+        m_blob_storage = create_blob_storage(m_blob_storage_type, m_blob_path, get_part_byte_num(m_symbol_type, m_dim), m_part_num);
+        if (m_write_behind_byte_budget) {
+            auto write_behind_blob_storage = std::make_unique<WriteBehindBlobStorage>(std::move(m_blob_storage), m_write_behind_byte_budget, WRITE_BEHIND_FLUSH_INTERVAL);
+            m_write_behind_blob_storage = write_behind_blob_storage.get();
+            m_blob_storage = std::move(write_behind_blob_storage);
+        }
+    }
+    return *m_blob_storage;
+}
 
-    std::ofstream f(m_task_path, std::ios_base::binary);
-    int symbol_type = static_cast<int>(m_symbol_type);
-    f.write(reinterpret_cast<char*>(&symbol_type), sizeof(symbol_type));
-    f.write(reinterpret_cast<char*>(&m_dim), sizeof(m_dim));
-    f.write(reinterpret_cast<char*>(&m_part_num), sizeof(m_part_num));
-    f.write(reinterpret_cast<char*>(&m_done_part_num), sizeof(m_done_part_num));
-    f.write(reinterpret_cast<char*>(m_task_status_bytes.data()), m_task_status_bytes.size());
+void Task::SyncBlob() {
+    if (m_blob_storage) m_blob_storage->Sync();
+}
+
+// new part ids are appended to the journal, the whole status is only rewritten once the journal grows as large as it
+void Task::Flush() {
+    size_t journal_byte_num = JOURNAL_RECORD_HEADER_BYTE_NUM + m_journal_part_ids.size() * sizeof(uint32_t);
+    Bytes task_bytes;
+    std::vector<uint32_t> journal_part_ids;
+    if (!m_checkpointed || m_journal_byte_num + journal_byte_num >= std::max((static_cast<size_t>(m_part_num) + 7) / 8, MIN_CHECKPOINT_JOURNAL_BYTE_NUM)) {
+        task_bytes = ToTaskBytes();
+        m_journal_byte_num = 0;
+        m_checkpointed = true;
+    } else if (!m_journal_part_ids.empty()) {
+        journal_part_ids = std::move(m_journal_part_ids);
+        m_journal_byte_num += journal_byte_num;
+    }
+    m_journal_part_ids.clear();
+    auto write_task_status_fn = [task_path = m_task_path, journal_path = m_journal_path, task_bytes = std::move(task_bytes), journal_part_ids = std::move(journal_part_ids)] {
+        if (!task_bytes.empty()) {
+            write_task_checkpoint(task_path, journal_path, task_bytes);
+        } else if (!journal_part_ids.empty()) {
+            append_task_journal(journal_path, journal_part_ids);
+        }
+    };
+    if (m_write_behind_blob_storage) {
+        // the status is written by the io thread once the parts it records are in the blob
+        m_write_behind_blob_storage->FlushAsync(std::move(write_task_status_fn));
+        return;
+    }
+    SyncBlob();
+    write_task_status_fn();
 }
 
 bool Task::IsDone() const {
-    return m_done_part_num == m_part_num;
+    return DonePartNum() == m_part_num;
 }
 
 void Task::Finalize() {
     Flush();
+    m_fountain_decoder.reset();
+    // waits for the io thread of write behind to finish, a failed write must not leave a partial blob to be renamed as the output
+    if (m_write_behind_blob_storage) m_write_behind_blob_storage->Close();
+    m_blob_storage.reset();
+    m_write_behind_blob_storage = nullptr;
+    auto part_byte_num = get_part_byte_num(m_symbol_type, m_dim);
     std::ifstream blob_file(m_blob_path, std::ios_base::binary);
-    blob_file.seekg(static_cast<uint64_t>(get_part_byte_num(m_symbol_type, m_dim)) * (m_part_num - 1));
-    uint64_t file_size = 0;
-    blob_file.read(reinterpret_cast<char*>(&file_size), sizeof(file_size));
+    blob_file.seekg(static_cast<uint64_t>(part_byte_num) * (m_part_num - 1));
+    TaskTrailer trailer;
+    blob_file.read(reinterpret_cast<char*>(&trailer), std::min(sizeof(trailer), static_cast<size_t>(part_byte_num)));
     blob_file.close();
-    std::filesystem::resize_file(m_blob_path, file_size);
-    std::filesystem::rename(m_blob_path, m_path);
+    std::filesystem::resize_file(m_blob_path, trailer.byte_num);
+    auto compression_type = static_cast<CompressionType>(trailer.compression_type);
+    if (trailer.compression_magic == COMPRESSION_MAGIC && compression_type != CompressionType::NONE) {
+        decompress_file(m_blob_path, trailer.byte_num, m_path, compression_type, [this](uint64_t done_block_num, uint64_t block_num) {
+            FinalizationProgress finalization_progress{done_block_num, block_num};
+            if (done_block_num == 0) {
+                if (m_finalization_start_cb) m_finalization_start_cb(finalization_progress);
+            } else {
+                if (m_finalization_progress_cb) m_finalization_progress_cb(finalization_progress);
+            }
+        });
+        if (std::filesystem::file_size(m_path) != trailer.original_byte_num) throw std::runtime_error("decompressed size mismatch for '" + m_path + "'");
+        std::filesystem::remove(m_blob_path);
+    } else {
+        std::filesystem::rename(m_blob_path, m_path);
+    }
     std::filesystem::remove(m_task_path);
+    std::filesystem::remove(m_journal_path);
     if (m_finalization_complete_cb) m_finalization_complete_cb();
 }
 
@@ -118,35 +313,45 @@ void Task::Print(uint32_t show_undone_part_num) const {
     std::cout << "symbol_type=" << get_symbol_type_str(m_symbol_type) << "\n";
     std::cout << "dim=" << m_dim << "\n";
     std::cout << "part_num=" << m_part_num << "\n";
-    std::cout << "done_part_num=" << m_done_part_num << "\n";
+    std::cout << "done_part_num=" << DonePartNum() << "\n";
     if (show_undone_part_num > 0) {
         std::cout << "undone parts:\n";
-        for (uint32_t part_id = 0; part_id < m_part_num; ++part_id) {
-            if (!IsPartDone(part_id)) {
-                std::cout << part_id << "\n";
-                --show_undone_part_num;
-                if (show_undone_part_num == 0) break;
-            }
+        for (uint32_t part_id = m_part_bitmap.NextUndone(0); part_id < m_part_num && show_undone_part_num > 0; part_id = m_part_bitmap.NextUndone(part_id + 1)) {
+            std::cout << part_id << "\n";
+            --show_undone_part_num;
         }
     }
 }
 
 int get_part_byte_num(SymbolType symbol_type, const Dim& dim) {
     auto codec = create_symbol_codec(symbol_type);
-    return dim.tile_x_num * dim.tile_y_num * dim.tile_x_size * dim.tile_y_size * codec->BitNumPerSymbol() / 8 - SymbolCodec::META_BYTE_NUM;
+    return codec->PaddedPartByteNum(static_cast<size_t>(dim.tile_x_num) * dim.tile_y_num * dim.tile_x_size * dim.tile_y_size);
 }
 
-std::tuple<Bytes, uint32_t> get_task_bytes(const std::string& file_path, int part_byte_num) {
-    std::ifstream f(file_path, std::ios_base::binary);
-    f.seekg(0, std::ios_base::end);
-    uint64_t file_size = f.tellg();
-    Bytes raw_bytes(file_size);
-    f.seekg(0, std::ios_base::beg);
-    f.read(reinterpret_cast<char*>(raw_bytes.data()), file_size);
-    int left_bytes_num1 = file_size % part_byte_num;
+std::tuple<Bytes, uint32_t> get_task_bytes(const std::string& file_path, int part_byte_num, CompressionType compression_type) {
+    TaskTrailer trailer;
+    Bytes raw_bytes;
+    if (compression_type == CompressionType::NONE) {
+        std::ifstream f(file_path, std::ios_base::binary);
+        f.seekg(0, std::ios_base::end);
+        uint64_t file_size = f.tellg();
+        raw_bytes.resize(file_size);
+        f.seekg(0, std::ios_base::beg);
+        f.read(reinterpret_cast<char*>(raw_bytes.data()), file_size);
+        trailer.byte_num = file_size;
+    } else {
+        if (part_byte_num < Task::MIN_COMPRESSED_PART_BYTE_NUM) throw invalid_image_codec_argument("invalid part_byte_num '" + std::to_string(part_byte_num) + "' for compression");
+        compress_file(file_path, compression_type, raw_bytes);
+        trailer.byte_num = raw_bytes.size();
+        trailer.compression_magic = COMPRESSION_MAGIC;
+        trailer.compression_type = static_cast<uint32_t>(compression_type);
+        trailer.original_byte_num = std::filesystem::file_size(file_path);
+    }
+    int left_bytes_num1 = trailer.byte_num % part_byte_num;
     Bytes padding_bytes1;
     if (left_bytes_num1) padding_bytes1.resize(part_byte_num - left_bytes_num1, 0);
-    Bytes size_bytes(reinterpret_cast<Byte*>(&file_size), reinterpret_cast<Byte*>(&file_size)+sizeof(file_size));
+    size_t trailer_byte_num = compression_type == CompressionType::NONE ? sizeof(trailer.byte_num) : sizeof(trailer);
+    Bytes size_bytes(reinterpret_cast<Byte*>(&trailer), reinterpret_cast<Byte*>(&trailer)+trailer_byte_num);
     Bytes padding_bytes2(part_byte_num - size_bytes.size(), 0);
     raw_bytes.insert(raw_bytes.end(), padding_bytes1.begin(), padding_bytes1.end());
     raw_bytes.insert(raw_bytes.end(), size_bytes.begin(), size_bytes.end());
@@ -155,9 +360,65 @@ std::tuple<Bytes, uint32_t> get_task_bytes(const std::string& file_path, int par
     return std::make_tuple(std::move(raw_bytes), part_num);
 }
 
+Bytes to_task_bytes(SymbolType symbol_type, const Dim& dim, const PartBitmap& part_bitmap, uint32_t version) {
+    if (version != TASK_BYTES_VERSION1 && version != TASK_BYTES_VERSION2) throw invalid_image_codec_argument("invalid task bytes version '" + std::to_string(version) + "'");
+    Bytes bytes;
+    const uint8_t* ptr = nullptr;
+    if (version == TASK_BYTES_VERSION2) {
+        ptr = reinterpret_cast<const uint8_t*>(&TASK_BYTES_MAGIC);
+        bytes.insert(bytes.end(), ptr, ptr+sizeof(TASK_BYTES_MAGIC));
+        ptr = reinterpret_cast<const uint8_t*>(&version);
+        bytes.insert(bytes.end(), ptr, ptr+sizeof(version));
+    }
+    int symbol_type_v = static_cast<int>(symbol_type);
+    ptr = reinterpret_cast<const uint8_t*>(&symbol_type_v);
+    bytes.insert(bytes.end(), ptr, ptr+sizeof(symbol_type_v));
+    ptr = reinterpret_cast<const uint8_t*>(&dim);
+    bytes.insert(bytes.end(), ptr, ptr+sizeof(dim));
+    uint32_t part_num = part_bitmap.PartNum();
+    ptr = reinterpret_cast<const uint8_t*>(&part_num);
+    bytes.insert(bytes.end(), ptr, ptr+sizeof(part_num));
+    uint32_t done_part_num = part_bitmap.DonePartNum();
+    ptr = reinterpret_cast<const uint8_t*>(&done_part_num);
+    bytes.insert(bytes.end(), ptr, ptr+sizeof(done_part_num));
+    if (version == TASK_BYTES_VERSION2) {
+        // ranges are collected until they would outgrow the bitmap
+        size_t max_range_num = ((static_cast<size_t>(part_num) + 7) / 8 - std::min<size_t>((static_cast<size_t>(part_num) + 7) / 8, sizeof(uint32_t))) / (2 * sizeof(uint32_t));
+        std::vector<uint32_t> undone_ranges;
+        uint32_t part_id = part_bitmap.NextUndone(0);
+        while (part_id < part_num && undone_ranges.size() < 2 * max_range_num) {
+            uint32_t end_part_id = part_bitmap.NextDone(part_id);
+            undone_ranges.push_back(part_id);
+            undone_ranges.push_back(end_part_id);
+            part_id = part_bitmap.NextUndone(end_part_id);
+        }
+        uint32_t task_status_encoding = part_id < part_num ? TASK_STATUS_BITMAP : TASK_STATUS_UNDONE_RANGES;
+        ptr = reinterpret_cast<const uint8_t*>(&task_status_encoding);
+        bytes.insert(bytes.end(), ptr, ptr+sizeof(task_status_encoding));
+        if (task_status_encoding == TASK_STATUS_UNDONE_RANGES) {
+            uint32_t range_num = static_cast<uint32_t>(undone_ranges.size() / 2);
+            ptr = reinterpret_cast<const uint8_t*>(&range_num);
+            bytes.insert(bytes.end(), ptr, ptr+sizeof(range_num));
+            ptr = reinterpret_cast<const uint8_t*>(undone_ranges.data());
+            bytes.insert(bytes.end(), ptr, ptr+undone_ranges.size()*sizeof(uint32_t));
+            return bytes;
+        }
+    }
+    auto task_status_bytes = part_bitmap.ToBytes();
+    bytes.insert(bytes.end(), task_status_bytes.begin(), task_status_bytes.end());
+    return bytes;
+}
+
 std::tuple<SymbolType, Dim, uint32_t, uint32_t, Bytes> from_task_bytes(const Bytes& task_bytes) {
+    uint32_t version = get_task_bytes_version(task_bytes);
+    if (version != TASK_BYTES_VERSION1 && version != TASK_BYTES_VERSION2) throw invalid_image_codec_argument("invalid task bytes version '" + std::to_string(version) + "'");
+    size_t header_byte_num = version == TASK_BYTES_VERSION1 ? 4 * 7 : 4 * 10;
+    if (task_bytes.size() < header_byte_num) {
+        throw invalid_image_codec_argument("invalid task bytes of size '" + std::to_string(task_bytes.size()) + "'");
+    }
     size_t count = 0;
     auto ptr = task_bytes.data();
+    if (version == TASK_BYTES_VERSION2) ptr += sizeof(TASK_BYTES_MAGIC) + sizeof(version);
     int symbol_type_v = 0;
     count = sizeof(symbol_type_v);
     std::copy_n(ptr, count, reinterpret_cast<Byte*>(&symbol_type_v));
@@ -175,14 +436,59 @@ std::tuple<SymbolType, Dim, uint32_t, uint32_t, Bytes> from_task_bytes(const Byt
     count = sizeof(done_part_num);
     std::copy_n(ptr, count, reinterpret_cast<Byte*>(&done_part_num));
     ptr += count;
-    Bytes task_status_bytes(ptr, task_bytes.data()+task_bytes.size());
-    size_t expected_task_byte_num = 4 * 7 + (part_num + 7) / 8;
+    uint32_t task_status_encoding = TASK_STATUS_BITMAP;
+    if (version == TASK_BYTES_VERSION2) {
+        count = sizeof(task_status_encoding);
+        std::copy_n(ptr, count, reinterpret_cast<Byte*>(&task_status_encoding));
+        ptr += count;
+    }
+    if (task_status_encoding == TASK_STATUS_BITMAP) {
+        Bytes task_status_bytes(ptr, task_bytes.data()+task_bytes.size());
+        size_t expected_task_byte_num = header_byte_num + (static_cast<size_t>(part_num) + 7) / 8;
+        if (task_bytes.size() != expected_task_byte_num) {
+            throw invalid_image_codec_argument("invalid task bytes of size '" + std::to_string(task_bytes.size()) + "', '" + std::to_string(expected_task_byte_num) + "' expected");
+        }
+        return std::make_tuple(symbol_type, dim, part_num, done_part_num, std::move(task_status_bytes));
+    }
+    if (task_status_encoding != TASK_STATUS_UNDONE_RANGES) throw invalid_image_codec_argument("invalid task status encoding '" + std::to_string(task_status_encoding) + "'");
+    if (task_bytes.size() < header_byte_num + sizeof(uint32_t)) {
+        throw invalid_image_codec_argument("invalid task bytes of size '" + std::to_string(task_bytes.size()) + "'");
+    }
+    uint32_t range_num = 0;
+    count = sizeof(range_num);
+    std::copy_n(ptr, count, reinterpret_cast<Byte*>(&range_num));
+    ptr += count;
+    size_t expected_task_byte_num = header_byte_num + sizeof(range_num) + static_cast<size_t>(range_num) * 2 * sizeof(uint32_t);
     if (task_bytes.size() != expected_task_byte_num) {
         throw invalid_image_codec_argument("invalid task bytes of size '" + std::to_string(task_bytes.size()) + "', '" + std::to_string(expected_task_byte_num) + "' expected");
     }
+    std::vector<uint32_t> undone_ranges(static_cast<size_t>(range_num) * 2);
+    std::copy_n(ptr, undone_ranges.size() * sizeof(uint32_t), reinterpret_cast<Byte*>(undone_ranges.data()));
+    Bytes task_status_bytes((static_cast<size_t>(part_num) + 7) / 8, 0xff);
+    if (part_num % 8) task_status_bytes.back() = static_cast<Byte>((0x1 << (part_num % 8)) - 1);
+    for (size_t i = 0; i < undone_ranges.size(); i += 2) {
+        if (undone_ranges[i] >= undone_ranges[i + 1] || undone_ranges[i + 1] > part_num) throw invalid_image_codec_argument("invalid undone part range '" + std::to_string(undone_ranges[i]) + "-" + std::to_string(undone_ranges[i + 1]) + "'");
+        clear_part_bits(task_status_bytes, undone_ranges[i], undone_ranges[i + 1]);
+    }
     return std::make_tuple(symbol_type, dim, part_num, done_part_num, std::move(task_status_bytes));
 }
 
+uint32_t get_task_bytes_version(const Bytes& task_bytes) {
+    uint32_t magic = 0;
+    if (task_bytes.size() < sizeof(magic) * 2) return TASK_BYTES_VERSION1;
+    std::copy_n(task_bytes.data(), sizeof(magic), reinterpret_cast<Byte*>(&magic));
+    if (magic != TASK_BYTES_MAGIC) return TASK_BYTES_VERSION1;
+    uint32_t version = 0;
+    std::copy_n(task_bytes.data() + sizeof(magic), sizeof(version), reinterpret_cast<Byte*>(&version));
+    return version;
+}
+
+Bytes convert_task_bytes(const Bytes& task_bytes, uint32_t version) {
+    if (get_task_bytes_version(task_bytes) == version) return task_bytes;
+    auto [symbol_type, dim, part_num, done_part_num, task_status_bytes] = from_task_bytes(task_bytes);
+    return to_task_bytes(symbol_type, dim, PartBitmap(task_status_bytes, part_num), version);
+}
+
 bool is_part_done(const Bytes& task_status_bytes, uint32_t part_id) {
     auto byte_index = part_id / 8;
     char mask = 0x1 << (part_id % 8);
@@ -2,10 +2,24 @@
 
 #include <string>
 #include <vector>
+#include <fstream>
 #include <functional>
+#include <memory>
 
 #include "image_codec_api.h"
 #include "image_codec_types.h"
+#include "blob_storage.h"
+#include "compression.h"
+#include "fountain_code.h"
+#include "part_bitmap.h"
+#include "sparse_map.h"
+#include "symbol_codec.h"
+
+// task bytes version 1 is the layout of the .task file
+// version 2 starts with TASK_BYTES_MAGIC and the version, the version 1 fields follow with the status either as the bitmap or as the ranges of undone parts whichever is smaller
+constexpr uint32_t TASK_BYTES_VERSION1 = 1;
+constexpr uint32_t TASK_BYTES_VERSION2 = 2;
+constexpr uint32_t TASK_BYTES_MAGIC = 0x5354424c;
 
 class Task {
 public:
@@ -19,10 +33,14 @@ public:
     using FinalizationCompleteCb = std::function<void()>;
 
     static constexpr int MIN_PART_BYTE_NUM = 8;
+    // the last part also records the compression type and the original file size
+    static constexpr int MIN_COMPRESSED_PART_BYTE_NUM = 24;
 
-    IMAGE_CODEC_API Task(const std::string& path);
+    IMAGE_CODEC_API Task(const std::string& path, BlobStorageType blob_storage_type = BlobStorageType::STREAM);
     IMAGE_CODEC_API void Init(SymbolType symbol_type, const Dim& dim, uint32_t part_num);
     IMAGE_CODEC_API void Load();
+    // blob writes and status flushes go through an io thread with byte_budget bytes of buffer, must be set before the first part is saved
+    IMAGE_CODEC_API void SetWriteBehind(size_t byte_budget);
     IMAGE_CODEC_API void SetFinalizationCb(FinalizationStartCb finalization_start_cb, FinalizationProgressCb finalization_progress_cb, FinalizationCompleteCb finalization_complete_cb);
     IMAGE_CODEC_API bool AllocateBlob();
     IMAGE_CODEC_API bool IsPartDone(uint32_t part_id) const;
@@ -32,26 +50,48 @@ public:
     IMAGE_CODEC_API void Finalize();
     IMAGE_CODEC_API void Print(uint32_t show_undone_part_num) const;
 
-    IMAGE_CODEC_API uint32_t DonePartNum() const { return m_done_part_num; }
+    IMAGE_CODEC_API uint32_t DonePartNum() const { return m_part_bitmap.DonePartNum(); }
     IMAGE_CODEC_API const std::string& TaskPath() const { return m_task_path; }
+    IMAGE_CODEC_API const std::string& JournalPath() const { return m_journal_path; }
     IMAGE_CODEC_API const std::string& BlobPath() const { return m_blob_path; }
     IMAGE_CODEC_API SymbolType GetSymbolType() const { return m_symbol_type; }
     IMAGE_CODEC_API Dim GetDim() const { return m_dim; }
     IMAGE_CODEC_API uint32_t GetPartNum() const { return m_part_num; }
-    IMAGE_CODEC_API Bytes ToTaskBytes() const;
+    IMAGE_CODEC_API const PartBitmap& GetPartBitmap() const { return m_part_bitmap; }
+    IMAGE_CODEC_API Bytes ToTaskBytes(uint32_t version = TASK_BYTES_VERSION1) const;
+    IMAGE_CODEC_API WriteBehindBlobStorage::Stats GetWriteBehindStats() const { return m_write_behind_blob_storage ? m_write_behind_blob_storage->GetStats() : WriteBehindBlobStorage::Stats(); }
+    IMAGE_CODEC_API size_t PendingFountainPartNum() const { return m_fountain_decoder ? m_fountain_decoder->PendingPartNum() : 0; }
 
 private:
+    void MarkPartDone(uint32_t part_id);
+    void ReplayJournal();
+    void SavePart(uint32_t part_id, const Bytes& part_bytes);
+    void UpdateSparseMapPart(uint32_t part_id, const Bytes& part_bytes);
+    void ReadPart(uint32_t part_id, Byte* part_bytes);
+    void SyncBlob();
+    BlobStorage& GetBlobStorage();
+    FountainDecoder& GetFountainDecoder();
+
     std::string m_path;
     std::string m_task_path;
+    std::string m_journal_path;
     std::string m_blob_path;
 
     SymbolType m_symbol_type = SymbolType::SYMBOL1;
     Dim m_dim;
     uint32_t m_part_num = 0;
-    uint32_t m_done_part_num = 0;
-    Bytes m_task_status_bytes;
+    PartBitmap m_part_bitmap;
+    // parts done since the last flush, appended to the journal until it outgrows the checkpoint in the .task file
+    std::vector<uint32_t> m_journal_part_ids;
+    size_t m_journal_byte_num = 0;
+    bool m_checkpointed = false;
 
-    std::vector<std::pair<uint32_t, Bytes>> m_blob_buf;
+    BlobStorageType m_blob_storage_type;
+    size_t m_write_behind_byte_budget = 0;
+    std::unique_ptr<BlobStorage> m_blob_storage;
+    WriteBehindBlobStorage* m_write_behind_blob_storage = nullptr;
+    std::unique_ptr<FountainDecoder> m_fountain_decoder;
+    std::vector<uint32_t> m_zero_part_ids;
 
     FinalizationStartCb m_finalization_start_cb;
     FinalizationProgressCb m_finalization_progress_cb;
@@ -59,6 +99,10 @@ private:
 };
 
 IMAGE_CODEC_API int get_part_byte_num(SymbolType symbol_type, const Dim& dim);
-IMAGE_CODEC_API std::tuple<Bytes, uint32_t> get_task_bytes(const std::string& file_path, int part_byte_num);
+IMAGE_CODEC_API std::tuple<Bytes, uint32_t> get_task_bytes(const std::string& file_path, int part_byte_num, CompressionType compression_type = CompressionType::NONE);
+IMAGE_CODEC_API Bytes to_task_bytes(SymbolType symbol_type, const Dim& dim, const PartBitmap& part_bitmap, uint32_t version = TASK_BYTES_VERSION1);
+// task bytes of either version, the status is returned as the bitmap
 IMAGE_CODEC_API std::tuple<SymbolType, Dim, uint32_t, uint32_t, Bytes> from_task_bytes(const Bytes& task_bytes);
+IMAGE_CODEC_API uint32_t get_task_bytes_version(const Bytes& task_bytes);
+IMAGE_CODEC_API Bytes convert_task_bytes(const Bytes& task_bytes, uint32_t version);
 IMAGE_CODEC_API bool is_part_done(const Bytes& task_status_bytes, uint32_t part_id);
@@ -3,7 +3,7 @@
 
 #include "image_decode_task_status_client.h"
 
-TaskStatusClient::TaskStatusClient(const std::string& ip, int port) : m_ip(ip), m_port(port) {
+TaskStatusClient::TaskStatusClient(const std::string& ip, int port, uint32_t task_bytes_version) : m_ip(ip), m_port(port), m_task_bytes_version(task_bytes_version) {
 }
 
 Bytes TaskStatusTcpClient::GetTaskStatus() {
@@ -12,6 +12,8 @@ Bytes TaskStatusTcpClient::GetTaskStatus() {
         boost::asio::ip::tcp::socket socket(io_context);
         boost::asio::ip::tcp::endpoint endpoint(boost::asio::ip::make_address(GetIp()), GetPort());
         socket.connect(endpoint);
+        uint32_t version = GetTaskBytesVersion();
+        if (version != TASK_BYTES_VERSION1) boost::asio::write(socket, boost::asio::buffer(&version, sizeof(version)));
         uint64_t task_byte_len = 0;
         uint64_t done1 = 0;
         while (done1 < sizeof(uint64_t)) {
@@ -40,6 +42,7 @@ Bytes TaskStatusHttpClient::GetTaskStatus() {
         socket.connect(endpoint);
         boost::beast::http::request<boost::beast::http::string_body> req(boost::beast::http::verb::get, "/", 10);
         req.set(boost::beast::http::field::user_agent, BOOST_BEAST_VERSION_STRING);
+        req.set(TASK_BYTES_VERSION_FIELD, std::to_string(GetTaskBytesVersion()));
         boost::beast::http::write(socket, req);
         boost::beast::flat_buffer buffer;
         boost::beast::http::response<boost::beast::http::vector_body<Byte>> res;
@@ -52,12 +55,12 @@ Bytes TaskStatusHttpClient::GetTaskStatus() {
     }
 }
 
-std::unique_ptr<TaskStatusClient> create_task_status_client(ServerType server_type, const std::string& ip, int port) {
+std::unique_ptr<TaskStatusClient> create_task_status_client(ServerType server_type, const std::string& ip, int port, std::optional<uint32_t> task_bytes_version) {
     std::unique_ptr<TaskStatusClient> task_status_client;
     if (server_type == ServerType::TCP) {
-        task_status_client = std::make_unique<TaskStatusTcpClient>(ip, port);
+        task_status_client = std::make_unique<TaskStatusTcpClient>(ip, port, task_bytes_version.value_or(TASK_BYTES_VERSION1));
     } else if (server_type == ServerType::HTTP) {
-        task_status_client = std::make_unique<TaskStatusHttpClient>(ip, port);
+        task_status_client = std::make_unique<TaskStatusHttpClient>(ip, port, task_bytes_version.value_or(TASK_BYTES_VERSION2));
     } else {
         throw std::invalid_argument("invalid server type '" + std::to_string(static_cast<int>(server_type)) + "'");
     }
@@ -1,37 +1,46 @@
 #pragma once
 
 #include <string>
+#include <optional>
 
 #include "image_codec_api.h"
 #include "image_codec_types.h"
 #include "server_utils.h"
+#include "image_decode_task.h"
 #include "image_decode_task_status_server.h"
 
 class TaskStatusClient {
 public:
-    IMAGE_CODEC_API TaskStatusClient(const std::string& ip, int port);
+    // servers without version negotiation always send version 1 task bytes
+    IMAGE_CODEC_API TaskStatusClient(const std::string& ip, int port, uint32_t task_bytes_version);
     IMAGE_CODEC_API virtual ~TaskStatusClient() {}
     IMAGE_CODEC_API virtual Bytes GetTaskStatus() = 0;
 
 protected:
     std::string GetIp() const { return m_ip; }
     int GetPort() const { return m_port; }
+    uint32_t GetTaskBytesVersion() const { return m_task_bytes_version; }
 
 private:
     std::string m_ip;
     int m_port = 0;
+    uint32_t m_task_bytes_version = TASK_BYTES_VERSION2;
 };
 
+// tcp servers without version negotiation never read a version request and may reset the connection before the task bytes are read,
+// so only clients asking for version 2 send one
 class TaskStatusTcpClient : public TaskStatusClient {
 public:
-    using TaskStatusClient::TaskStatusClient;
+    IMAGE_CODEC_API TaskStatusTcpClient(const std::string& ip, int port, uint32_t task_bytes_version = TASK_BYTES_VERSION1) : TaskStatusClient(ip, port, task_bytes_version) {}
     IMAGE_CODEC_API Bytes GetTaskStatus() override;
 };
 
+// http servers ignore the version header field if they don't know it
 class TaskStatusHttpClient : public TaskStatusClient {
 public:
-    using TaskStatusClient::TaskStatusClient;
+    IMAGE_CODEC_API TaskStatusHttpClient(const std::string& ip, int port, uint32_t task_bytes_version = TASK_BYTES_VERSION2) : TaskStatusClient(ip, port, task_bytes_version) {}
     IMAGE_CODEC_API Bytes GetTaskStatus() override;
 };
 
-IMAGE_CODEC_API std::unique_ptr<TaskStatusClient> create_task_status_client(ServerType server_type, const std::string& ip, int port);
+// without task_bytes_version tcp clients ask for version 1 and http clients for version 2
+IMAGE_CODEC_API std::unique_ptr<TaskStatusClient> create_task_status_client(ServerType server_type, const std::string& ip, int port, std::optional<uint32_t> task_bytes_version = std::nullopt);
@@ -1,10 +1,25 @@
+#include <algorithm>
 #include <regex>
+#include <chrono>
 
 #include <boost/asio.hpp>
 #include <boost/beast.hpp>
 
+#include "image_decode_task.h"
 #include "image_decode_task_status_server.h"
 
+namespace {
+
+// tcp clients ask for a task bytes version right after connecting, clients which don't ask get version 1
+constexpr std::chrono::milliseconds TASK_BYTES_VERSION_REQUEST_TIMEOUT(100);
+
+struct TcpConnection {
+    boost::asio::io_context ioc;
+    boost::asio::ip::tcp::socket socket{ioc};
+};
+
+}
+
 void TaskStatusServer::Start(int port) {
     m_port = port;
     m_running = true;
@@ -19,9 +34,9 @@ void TaskStatusServer::Stop() {
     }
 }
 
-void TaskStatusServer::UpdateTaskStatus(const Bytes& task_bytes) {
+void TaskStatusServer::UpdateTaskStatus(Bytes task_bytes) {
     std::lock_guard<std::mutex> lock(m_mtx);
-    m_task_bytes = task_bytes;
+    m_task_bytes = std::move(task_bytes);
 }
 
 void TaskStatusServer::Worker() {
@@ -30,29 +45,49 @@ void TaskStatusServer::Worker() {
     }
 }
 
-Bytes TaskStatusServer::GetTaskBytes() const {
-    std::lock_guard<std::mutex> lock(m_mtx);
-    return m_task_bytes;
+Bytes TaskStatusServer::GetTaskBytes(uint32_t version) const {
+    Bytes task_bytes;
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        task_bytes = m_task_bytes;
+    }
+    if (task_bytes.empty()) return task_bytes;
+    return convert_task_bytes(task_bytes, version);
 }
 
 void TaskStatusTcpServer::HandleRequest() {
+    m_responses.erase(std::remove_if(m_responses.begin(), m_responses.end(), [](const std::future<void>& response) { return response.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }), m_responses.end());
     try {
         boost::asio::io_context ioc;
         boost::asio::ip::tcp::acceptor acceptor(ioc, boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), GetPort()));
-        boost::asio::ip::tcp::socket socket(ioc);
-        acceptor.accept(socket);
-        Bytes task_bytes = GetTaskBytes();
-        uint64_t task_byte_len = task_bytes.size();
-        uint64_t done1 = 0;
-        while (done1 < sizeof(uint64_t)) {
-            done1 += boost::asio::write(socket, boost::asio::buffer(reinterpret_cast<char*>(&task_byte_len) + done1, sizeof(uint64_t) - done1));
-        }
-        if (task_byte_len) {
-            uint64_t done2 = 0;
-            while (done2 < task_byte_len) {
-                done2 += boost::asio::write(socket, boost::asio::buffer(task_bytes.data() + done2, task_byte_len - done2));
+        auto connection = std::make_shared<TcpConnection>();
+        acceptor.accept(connection->socket);
+        m_responses.push_back(std::async(std::launch::async, [this, connection] {
+            try {
+                auto& socket = connection->socket;
+                uint32_t version = TASK_BYTES_VERSION1;
+                uint32_t requested_version = 0;
+                boost::asio::async_read(socket, boost::asio::buffer(&requested_version, sizeof(requested_version)), [&version, &requested_version](const boost::system::error_code& ec, size_t) {
+                    if (!ec) version = std::clamp(requested_version, TASK_BYTES_VERSION1, TASK_BYTES_VERSION2);
+                });
+                connection->ioc.run_for(TASK_BYTES_VERSION_REQUEST_TIMEOUT);
+                Bytes task_bytes = GetTaskBytes(version);
+                uint64_t task_byte_len = task_bytes.size();
+                uint64_t done1 = 0;
+                while (done1 < sizeof(uint64_t)) {
+                    done1 += boost::asio::write(socket, boost::asio::buffer(reinterpret_cast<char*>(&task_byte_len) + done1, sizeof(uint64_t) - done1));
+                }
+                if (task_byte_len) {
+                    uint64_t done2 = 0;
+                    while (done2 < task_byte_len) {
+                        done2 += boost::asio::write(socket, boost::asio::buffer(task_bytes.data() + done2, task_byte_len - done2));
+                    }
+                }
             }
-        }
+            catch (std::exception& e) {
+                //std::cerr << e.what() << "\n";
+            }
+        }));
     }
     catch (std::exception& e) {
         //std::cerr << e.what() << "\n";
@@ -65,6 +100,9 @@ void TaskStatusTcpServer::RequestSelf() {
         boost::asio::ip::tcp::socket socket(ioc);
         boost::asio::ip::tcp::endpoint endpoint(boost::asio::ip::make_address("127.0.0.1"), GetPort());
         socket.connect(endpoint);
+        // asking for a version spares the wait for a request
+        uint32_t version = TASK_BYTES_VERSION1;
+        boost::asio::write(socket, boost::asio::buffer(&version, sizeof(version)));
         uint64_t task_byte_len = 0;
         uint64_t done1 = 0;
         while (done1 < sizeof(uint64_t)) {
@@ -89,10 +127,13 @@ void TaskStatusHttpServer::HandleRequest() {
         boost::asio::ip::tcp::acceptor acceptor(ioc, boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), GetPort()));
         boost::asio::ip::tcp::socket socket(ioc);
         acceptor.accept(socket);
-        Bytes task_bytes = GetTaskBytes();
         boost::beast::flat_buffer buffer;
         boost::beast::http::request<boost::beast::http::string_body> req;
         boost::beast::http::read(socket, buffer, req);
+        uint32_t version = TASK_BYTES_VERSION1;
+        auto version_it = req.find(TASK_BYTES_VERSION_FIELD);
+        if (version_it != req.end()) version = std::clamp(static_cast<uint32_t>(std::stoul(std::string(version_it->value()))), TASK_BYTES_VERSION1, TASK_BYTES_VERSION2);
+        Bytes task_bytes = GetTaskBytes(version);
         boost::beast::http::vector_body<Byte>::value_type body(task_bytes.begin(), task_bytes.end());
         boost::beast::http::response<boost::beast::http::vector_body<Byte>> res(std::piecewise_construct, std::make_tuple(std::move(body)), std::make_tuple(boost::beast::http::status::ok, req.version()));
         res.set(boost::beast::http::field::server, BOOST_BEAST_VERSION_STRING);
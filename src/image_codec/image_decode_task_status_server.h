@@ -4,21 +4,27 @@
 #include <thread>
 #include <mutex>
 #include <atomic>
+#include <future>
+#include <vector>
 
 #include "image_codec_api.h"
 #include "image_codec_types.h"
 #include "server_utils.h"
 
+// http clients ask for a task bytes version with this header field
+constexpr char TASK_BYTES_VERSION_FIELD[] = "Task-Bytes-Version";
+
 class TaskStatusServer {
 public:
     IMAGE_CODEC_API virtual ~TaskStatusServer() {}
     IMAGE_CODEC_API void Start(int port);
     IMAGE_CODEC_API void Stop();
-    IMAGE_CODEC_API void UpdateTaskStatus(const Bytes& task_bytes);
+    // task bytes of either version, each client gets the version it asks for
+    IMAGE_CODEC_API void UpdateTaskStatus(Bytes task_bytes);
 
 protected:
     int GetPort() const { return m_port; };
-    Bytes GetTaskBytes() const;
+    Bytes GetTaskBytes(uint32_t version) const;
 
 private:
     void Worker();
@@ -33,10 +39,13 @@ private:
     mutable std::mutex m_mtx;
 };
 
+// each accepted connection waits for the version request of its client on a thread of its own, so clients which don't send one don't hold up the accept loop
 class TaskStatusTcpServer : public TaskStatusServer {
 private:
     void HandleRequest() override;
     void RequestSelf() override;
+
+    std::vector<std::future<void>> m_responses;
 };
 
 class TaskStatusHttpServer : public TaskStatusServer {
@@ -4,12 +4,28 @@
 #include <filesystem>
 #include <cmath>
 #include <algorithm>
+#include <optional>
 
 #include "image_decode_worker.h"
 #include "image_stream.h"
 #include "image_decode_task_status_server.h"
 
-ImageDecodeWorker::ImageDecodeWorker(SymbolType symbol_type, const Dim& dim) : m_image_decoder(symbol_type, dim) {
+ImageDecodeWorker::ImageDecodeWorker(SymbolType symbol_type, const Dim& dim, int frame_part_num) : m_image_decoder(symbol_type, dim, frame_part_num) {
+}
+
+DecodeResults ImageDecodeWorker::TakeRecycledResults() {
+    std::lock_guard<std::mutex> lock(m_recycled_results_mtx);
+    if (m_recycled_results.empty()) return DecodeResults();
+    DecodeResults results = std::move(m_recycled_results.back());
+    m_recycled_results.pop_back();
+    return results;
+}
+
+void ImageDecodeWorker::RecycleResults(DecodeResults&& results) {
+    // bounded by the results in flight between the decode threads and the save thread
+    constexpr size_t MAX_RECYCLED_RESULTS_NUM = 64;
+    std::lock_guard<std::mutex> lock(m_recycled_results_mtx);
+    if (m_recycled_results.size() < MAX_RECYCLED_RESULTS_NUM) m_recycled_results.push_back(std::move(results));
 }
 
 void ImageDecodeWorker::FetchImageWorker(std::atomic<bool>& running, ThreadSafeQueue<std::pair<uint64_t, cv::Mat>>& frame_q, int interval) {
@@ -52,15 +68,17 @@ void ImageDecodeWorker::CalibrateWorker(ThreadSafeQueue<std::pair<uint64_t, cv::
     }
 }
 
-void ImageDecodeWorker::DecodeImageWorker(ThreadSafeQueue<DecodeResult>& part_q, ThreadSafeQueue<std::pair<uint64_t, cv::Mat>>& frame_q, GetTransformCb get_transform_cb, const Calibration& calibration) {
+void ImageDecodeWorker::DecodeImageWorker(ThreadSafeQueue<DecodeResults>& part_q, ThreadSafeQueue<std::pair<uint64_t, cv::Mat>>& frame_q, GetTransformCb get_transform_cb, const Calibration& calibration) {
     uint64_t frame_num = 0;
     Transform transform = get_transform_cb();
+    DecodeScratch scratch;
     while (true) {
         auto data = frame_q.Pop();
         if (!data) break;
         auto& [frame_id, frame] = data.value();
-        auto [success, part_id, part_bytes, part_symbols, frame1, result_imgs] = m_image_decoder.Decode(frame, transform, calibration, false);
-        part_q.Emplace(success, part_id, part_bytes);
+        DecodeResults results = TakeRecycledResults();
+        m_image_decoder.DecodeInto(frame, transform, calibration, scratch, results);
+        part_q.Push(std::move(results));
         ++frame_num;
         if ((frame_num & 0x1f) == 0) {
             transform = get_transform_cb();
@@ -68,7 +86,7 @@ void ImageDecodeWorker::DecodeImageWorker(ThreadSafeQueue<DecodeResult>& part_q,
     }
 }
 
-void ImageDecodeWorker::DecodeResultWorker(ThreadSafeQueue<DecodeResult>& part_q, ThreadSafeQueue<std::pair<uint64_t, cv::Mat>>& frame_q, GetTransformCb get_transform_cb, const Calibration& calibration, SendDecodeImageResultCb send_decode_image_result_cb) {
+void ImageDecodeWorker::DecodeResultWorker(ThreadSafeQueue<DecodeResults>& part_q, ThreadSafeQueue<std::pair<uint64_t, cv::Mat>>& frame_q, GetTransformCb get_transform_cb, const Calibration& calibration, SendDecodeImageResultCb send_decode_image_result_cb) {
     while (true) {
         auto data = frame_q.Front();
         if (!data) {
@@ -77,16 +95,18 @@ void ImageDecodeWorker::DecodeResultWorker(ThreadSafeQueue<DecodeResult>& part_q
         }
         auto& [frame_id, frame] = data.value();
         auto [success, part_id, part_bytes, part_symbols, frame1, result_imgs] = m_image_decoder.Decode(frame, get_transform_cb(), calibration, true);
-        part_q.Emplace(success, part_id, part_bytes);
+        DecodeResults results;
+        m_image_decoder.DecodeParts(part_symbols, results);
+        part_q.Push(std::move(results));
         send_decode_image_result_cb(frame1, success, result_imgs);
         std::this_thread::sleep_for(std::chrono::milliseconds(1000));
     }
 }
 
-void ImageDecodeWorker::AutoTransformWorker(ThreadSafeQueue<DecodeResult>& part_q, ThreadSafeQueue<std::pair<uint64_t, cv::Mat>>& frame_q, GetTransformCb get_transform_cb, const Calibration& calibration, SendAutoTransformCb send_auto_trasform_cb) {
+void ImageDecodeWorker::AutoTransformWorker(ThreadSafeQueue<DecodeResults>& part_q, ThreadSafeQueue<std::pair<uint64_t, cv::Mat>>& frame_q, GetTransformCb get_transform_cb, const Calibration& calibration, SendAutoTransformCb send_auto_trasform_cb) {
     constexpr std::array<int, 2> PIXELIZATION_CHANNEL_RANGE{150, 180};
     constexpr int PIXELIZATION_CHANNEL_DIFF = 3;
-    constexpr int LOOP_NUM = 8;
+    constexpr int CANDIDATE_NUM_PER_FRAME = 256;
     uint64_t frame_num = 0;
     std::vector<Transform::PixelizationThreshold> pixelization_thresholds;
     for (int t = PIXELIZATION_CHANNEL_RANGE[0]; t < PIXELIZATION_CHANNEL_RANGE[1]; ++t) {
@@ -110,6 +130,11 @@ void ImageDecodeWorker::AutoTransformWorker(ThreadSafeQueue<DecodeResult>& part_
     }
     int cur_auto_transform_index = 0;
     std::map<AutoTransform, float> auto_transform_scores;
+    SampleMap sample_map;
+    SymbolSamples samples;
+    Symbols symbols;
+    DecodeResults results;
+    std::optional<uint64_t> last_frame_id;
     while (true) {
         auto data = frame_q.Front();
         if (!data) {
@@ -117,19 +142,35 @@ void ImageDecodeWorker::AutoTransformWorker(ThreadSafeQueue<DecodeResult>& part_
             break;
         }
         auto& [frame_id, frame] = data.value();
+        if (last_frame_id == frame_id) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+        last_frame_id = frame_id;
         auto transform = get_transform_cb();
+        bool extraction_success = m_image_decoder.ExtractSamples(frame, transform, calibration, sample_map, samples);
+        int candidate_num = std::min(CANDIDATE_NUM_PER_FRAME, static_cast<int>(auto_transforms.size()));
         bool has_succeeded = false;
-        for (int loop_id = 0; loop_id < LOOP_NUM; ++loop_id) {
+        for (int candidate_id = 0; candidate_id < candidate_num; ++candidate_id) {
             const auto& auto_transform = auto_transforms[cur_auto_transform_index];
-            std::tie(transform.pixelization_threshold) = auto_transform;
-            auto [success, part_id, part_bytes, part_symbols, frame1, result_imgs] = m_image_decoder.Decode(frame, transform, calibration, false);
-            if (!has_succeeded && (success || loop_id == LOOP_NUM - 1)) {
-                part_q.Emplace(success, part_id, part_bytes);
-                has_succeeded = true;
+            float success = 0;
+            if (extraction_success) {
+                m_image_decoder.DecodeSamples(samples, std::get<0>(auto_transform), symbols, results);
+                int success_num = 0;
+                for (const auto& e : results) success_num += std::get<0>(e);
+                // a damaged tile only costs its own part, so the score counts decoded parts
+                success = static_cast<float>(success_num) / results.size();
+                if (!has_succeeded && success_num > 0) {
+                    part_q.Push(results);
+                    has_succeeded = true;
+                }
             }
-            auto_transform_scores[auto_transform] = auto_transform_scores[auto_transform] * 0.75f + static_cast<float>(success) * 0.25f;
+            auto_transform_scores[auto_transform] = auto_transform_scores[auto_transform] * 0.75f + success * 0.25f;
             cur_auto_transform_index = (cur_auto_transform_index + 1) % auto_transforms.size();
         }
+        if (!has_succeeded) {
+            part_q.Push(DecodeResults(m_image_decoder.FramePartNum(), DecodeResult(false, 0, Bytes())));
+        }
         ++frame_num;
         if ((frame_num & 0x1f) == 0) {
             float total_score = 0;
@@ -148,16 +189,24 @@ void ImageDecodeWorker::AutoTransformWorker(ThreadSafeQueue<DecodeResult>& part_
                 send_auto_trasform_cb(transform);
             }
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
     }
 }
 
-void ImageDecodeWorker::SavePartWorker(std::atomic<bool>& running, ThreadSafeQueue<DecodeResult>& part_q, std::string output_file, uint32_t part_num, SavePartProgressCb save_part_progress_cb, SavePartFinishCb save_part_finish_cb, SavePartCompleteCb save_part_complete_cb, SavePartErrorCb error_cb, Task::FinalizationStartCb finalization_start_cb, Task::FinalizationProgressCb finalization_progress_cb, Task::FinalizationCompleteCb finalization_complete_cb, ServerType task_status_server_type, int task_status_server_port) {
+void ImageDecodeWorker::SavePartWorker(std::atomic<bool>& running, ThreadSafeQueue<DecodeResults>& part_q, std::string output_file, uint32_t part_num, SavePartProgressCb save_part_progress_cb, SavePartFinishCb save_part_finish_cb, SavePartCompleteCb save_part_complete_cb, SavePartErrorCb error_cb, Task::FinalizationStartCb finalization_start_cb, Task::FinalizationProgressCb finalization_progress_cb, Task::FinalizationCompleteCb finalization_complete_cb, ServerType task_status_server_type, int task_status_server_port) {
     auto symbol_type = m_image_decoder.GetSymbolCodec().GetSymbolType();
-    auto dim = m_image_decoder.GetDim();
-    Task task(output_file);
+    // the task only sees parts, so it is kept in terms of the part dim
+    auto dim = m_image_decoder.GetPartDim();
+    Task task(output_file, m_blob_storage_type);
     if (std::filesystem::is_regular_file(task.TaskPath())) {
-        task.Load();
+        try {
+            task.Load();
+        }
+        catch (std::exception& e) {
+            if (error_cb) error_cb(std::string(e.what()) + "\n");
+            running = false;
+            while (part_q.Pop());
+            return;
+        }
         if (symbol_type != task.GetSymbolType() || dim != task.GetDim() || part_num != task.GetPartNum()) {
             if (error_cb) {
                 std::ostringstream oss;
@@ -190,6 +239,7 @@ void ImageDecodeWorker::SavePartWorker(std::atomic<bool>& running, ThreadSafeQue
             return;
         }
     }
+    task.SetWriteBehind(m_write_behind_byte_budget);
     task.SetFinalizationCb(finalization_start_cb, finalization_progress_cb, finalization_complete_cb);
     std::unique_ptr<TaskStatusServer> task_status_server;
     if (task_status_server_type != ServerType::NONE) {
@@ -208,60 +258,72 @@ void ImageDecodeWorker::SavePartWorker(std::atomic<bool>& running, ThreadSafeQue
     int left_hours = 0;
     int left_minutes = 0;
     int left_seconds = 0;
-    while (true) {
-        auto data = part_q.Pop();
-        if (!data) break;
-        auto& [success, part_id, part_bytes] = data.value();
-        if (success) task.UpdatePart(part_id, part_bytes);
-        ++frame_num;
-        if ((frame_num & 0x3f) == 0) {
-            auto t1 = std::chrono::high_resolution_clock::now();
-            auto delta_t = std::max(std::chrono::duration_cast<std::chrono::duration<float>>(t1 - t0).count(), 0.001f);
-            t0 = t1;
-            auto delta_frame_num = frame_num - frame_num0;
-            frame_num0 = frame_num;
-            auto fps1 = delta_frame_num / delta_t;
-            fps = fps * 0.5f + fps1 * 0.5f;
-            auto delta_done_part_num = task.DonePartNum() - done_part_num0;
-            done_part_num0 = task.DonePartNum();
-            auto done_fps1 = delta_done_part_num / delta_t;
-            done_fps = done_fps * 0.5f + done_fps1 * 0.5f;
-            bps = done_fps * bpf;
-            if (done_fps > 0.01f) {
-                int64_t left_total_seconds = static_cast<int64_t>((part_num - task.DonePartNum()) / done_fps);
-                left_days = left_total_seconds / (24 * 60 * 60);
-                left_total_seconds -= left_days * (24 * 60 * 60);
-                left_hours = left_total_seconds / (60 * 60);
-                left_total_seconds -= left_hours * (60 * 60);
-                left_minutes = left_total_seconds / 60;
-                left_seconds = left_total_seconds - left_minutes * 60;
-            } else {
-                left_days = 0;
-                left_hours = 0;
-                left_minutes = 0;
-                left_seconds = 0;
+    // storage errors, like a full disk, stop saving instead of escaping the thread
+    try {
+        while (true) {
+            auto data = part_q.Pop();
+            if (!data) break;
+            for (const auto& [success, part_id, part_bytes] : data.value()) {
+                if (success) task.UpdatePart(part_id, part_bytes);
+            }
+            RecycleResults(std::move(data.value()));
+            ++frame_num;
+            if ((frame_num & 0x3f) == 0) {
+                auto t1 = std::chrono::high_resolution_clock::now();
+                auto delta_t = std::max(std::chrono::duration_cast<std::chrono::duration<float>>(t1 - t0).count(), 0.001f);
+                t0 = t1;
+                auto delta_frame_num = frame_num - frame_num0;
+                frame_num0 = frame_num;
+                auto fps1 = delta_frame_num / delta_t;
+                fps = fps * 0.5f + fps1 * 0.5f;
+                auto delta_done_part_num = task.DonePartNum() - done_part_num0;
+                done_part_num0 = task.DonePartNum();
+                auto done_fps1 = delta_done_part_num / delta_t;
+                done_fps = done_fps * 0.5f + done_fps1 * 0.5f;
+                bps = done_fps * bpf;
+                if (done_fps > 0.01f) {
+                    int64_t left_total_seconds = static_cast<int64_t>((part_num - task.DonePartNum()) / done_fps);
+                    left_days = left_total_seconds / (24 * 60 * 60);
+                    left_total_seconds -= left_days * (24 * 60 * 60);
+                    left_hours = left_total_seconds / (60 * 60);
+                    left_total_seconds -= left_hours * (60 * 60);
+                    left_minutes = left_total_seconds / 60;
+                    left_seconds = left_total_seconds - left_minutes * 60;
+                } else {
+                    left_days = 0;
+                    left_hours = 0;
+                    left_minutes = 0;
+                    left_seconds = 0;
+                }
+            }
+            if ((frame_num & 0x1f) == 0) {
+                auto write_behind_stats = task.GetWriteBehindStats();
+                if (save_part_progress_cb) save_part_progress_cb({frame_num, task.DonePartNum(), part_num, fps, done_fps, bps, left_days, left_hours, left_minutes, left_seconds, write_behind_stats.pending_byte_num, write_behind_stats.last_flush_seconds});
+            }
+            if (task_status_server && (frame_num & 0xff) == 0) {
+                task_status_server->UpdateTaskStatus(task.ToTaskBytes(TASK_BYTES_VERSION2));
+            }
+            if (task.IsDone()) {
+                auto write_behind_stats = task.GetWriteBehindStats();
+                if (save_part_progress_cb) save_part_progress_cb({frame_num, task.DonePartNum(), part_num, fps, done_fps, bps, left_days, left_hours, left_minutes, left_seconds, write_behind_stats.pending_byte_num, write_behind_stats.last_flush_seconds});
+                task.Finalize();
+                if (save_part_complete_cb) save_part_complete_cb();
+                running = false;
+                while (part_q.Pop());
+                break;
             }
         }
-        if ((frame_num & 0x1f) == 0) {
-            if (save_part_progress_cb) save_part_progress_cb({frame_num, task.DonePartNum(), part_num, fps, done_fps, bps, left_days, left_hours, left_minutes, left_seconds});
-        }
-        if (task_status_server && (frame_num & 0xff) == 0) {
-            task_status_server->UpdateTaskStatus(task.ToTaskBytes());
-        }
-        if (task.IsDone()) {
-            if (save_part_progress_cb) save_part_progress_cb({frame_num, task.DonePartNum(), part_num, fps, done_fps, bps, left_days, left_hours, left_minutes, left_seconds});
-            task.Finalize();
-            if (save_part_complete_cb) save_part_complete_cb();
-            running = false;
-            while (part_q.Pop());
-            break;
+        if (!task.IsDone()) {
+            task.Flush();
         }
     }
+    catch (std::exception& e) {
+        if (error_cb) error_cb("can't save parts, " + std::string(e.what()) + "\n");
+        running = false;
+        while (part_q.Pop());
+    }
     if (task_status_server) {
         task_status_server->Stop();
     }
-    if (!task.IsDone()) {
-        task.Flush();
-    }
     if (save_part_finish_cb) save_part_finish_cb();
 }
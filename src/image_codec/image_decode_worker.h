@@ -3,6 +3,8 @@
 #include <tuple>
 #include <functional>
 #include <atomic>
+#include <mutex>
+#include <vector>
 
 #include <opencv2/opencv.hpp>
 
@@ -32,6 +34,8 @@ public:
         int left_hours = 0;
         int left_minutes = 0;
         int left_seconds = 0;
+        size_t write_behind_byte_num = 0;
+        float flush_seconds = 0;
     };
 
     using GetTransformCb = std::function<Transform()>;
@@ -45,14 +49,27 @@ public:
     using SavePartCompleteCb = std::function<void()>;
     using SavePartErrorCb = std::function<void(const std::string&)>;
 
-    IMAGE_CODEC_API ImageDecodeWorker(SymbolType symbol_type, const Dim& dim);
+    IMAGE_CODEC_API ImageDecodeWorker(SymbolType symbol_type, const Dim& dim, int frame_part_num = 1);
+    IMAGE_CODEC_API ImageDecoder& GetImageDecoder() { return m_image_decoder; }
+    // must be set before decoding starts
+    IMAGE_CODEC_API void SetBlobStorageType(BlobStorageType blob_storage_type) { m_blob_storage_type = blob_storage_type; }
+    // 0 saves parts inline, must be set before decoding starts
+    IMAGE_CODEC_API void SetWriteBehindByteBudget(size_t write_behind_byte_budget) { m_write_behind_byte_budget = write_behind_byte_budget; }
     IMAGE_CODEC_API void FetchImageWorker(std::atomic<bool>& running, ThreadSafeQueue<std::pair<uint64_t, cv::Mat>>& frame_q, int interval);
     IMAGE_CODEC_API void CalibrateWorker(ThreadSafeQueue<std::pair<uint64_t, cv::Mat>>& frame_q, GetTransformCb get_transform_cb, CalibrateCb calibrate_cb, SendCalibrationImageResultCb send_calibration_image_result_cb, CalibrationProgressCb calibration_progress_cb);
-    IMAGE_CODEC_API void DecodeImageWorker(ThreadSafeQueue<DecodeResult>& part_q, ThreadSafeQueue<std::pair<uint64_t, cv::Mat>>& frame_q, GetTransformCb get_transform_cb, const Calibration& calibration);
-    IMAGE_CODEC_API void DecodeResultWorker(ThreadSafeQueue<DecodeResult>& part_q, ThreadSafeQueue<std::pair<uint64_t, cv::Mat>>& frame_q, GetTransformCb get_transform_cb, const Calibration& calibration, SendDecodeImageResultCb send_decode_image_result_cb);
-    IMAGE_CODEC_API void AutoTransformWorker(ThreadSafeQueue<DecodeResult>& part_q, ThreadSafeQueue<std::pair<uint64_t, cv::Mat>>& frame_q, GetTransformCb get_transform_cb, const Calibration& calibration, SendAutoTransformCb send_auto_trasform_cb);
-    IMAGE_CODEC_API void SavePartWorker(std::atomic<bool>& running, ThreadSafeQueue<DecodeResult>& part_q, std::string output_file, uint32_t part_num, SavePartProgressCb save_part_progress_cb, SavePartFinishCb save_part_finish_cb, SavePartCompleteCb save_part_complete_cb, SavePartErrorCb error_cb, Task::FinalizationStartCb finalization_start_cb, Task::FinalizationProgressCb finalization_progress_cb, Task::FinalizationCompleteCb finalization_complete_cb, ServerType task_status_server_type, int task_status_server_port);
+    IMAGE_CODEC_API void DecodeImageWorker(ThreadSafeQueue<DecodeResults>& part_q, ThreadSafeQueue<std::pair<uint64_t, cv::Mat>>& frame_q, GetTransformCb get_transform_cb, const Calibration& calibration);
+    IMAGE_CODEC_API void DecodeResultWorker(ThreadSafeQueue<DecodeResults>& part_q, ThreadSafeQueue<std::pair<uint64_t, cv::Mat>>& frame_q, GetTransformCb get_transform_cb, const Calibration& calibration, SendDecodeImageResultCb send_decode_image_result_cb);
+    IMAGE_CODEC_API void AutoTransformWorker(ThreadSafeQueue<DecodeResults>& part_q, ThreadSafeQueue<std::pair<uint64_t, cv::Mat>>& frame_q, GetTransformCb get_transform_cb, const Calibration& calibration, SendAutoTransformCb send_auto_trasform_cb);
+    IMAGE_CODEC_API void SavePartWorker(std::atomic<bool>& running, ThreadSafeQueue<DecodeResults>& part_q, std::string output_file, uint32_t part_num, SavePartProgressCb save_part_progress_cb, SavePartFinishCb save_part_finish_cb, SavePartCompleteCb save_part_complete_cb, SavePartErrorCb error_cb, Task::FinalizationStartCb finalization_start_cb, Task::FinalizationProgressCb finalization_progress_cb, Task::FinalizationCompleteCb finalization_complete_cb, ServerType task_status_server_type, int task_status_server_port);
 
 private:
+    DecodeResults TakeRecycledResults();
+    void RecycleResults(DecodeResults&& results);
+
     ImageDecoder m_image_decoder;
+    BlobStorageType m_blob_storage_type = BlobStorageType::STREAM;
+    size_t m_write_behind_byte_budget = 0;
+    // results saved by SavePartWorker go back to DecodeImageWorker so their part byte buffers are reused
+    std::mutex m_recycled_results_mtx;
+    std::vector<DecodeResults> m_recycled_results;
 };
@@ -1,107 +1,203 @@
-#include <set>
-#include <queue>
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <cmath>
 
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
 #include "image_decoder.h"
+#include "pixel_classifier.h"
+
+uint64_t Calibration::NextGeneration() {
+    static std::atomic<uint64_t> generation = 0;
+    return ++generation;
+}
+
+void Calibration::Init(const Dim& dim, std::vector<float> center_xs, std::vector<float> center_ys) {
+    auto centers = std::make_shared<std::vector<float>>(std::move(center_xs));
+    centers->insert(centers->end(), center_ys.begin(), center_ys.end());
+    valid = true;
+    this->dim = dim;
+    m_center_num = center_ys.size();
+    m_center_xs = centers->data();
+    m_center_ys = centers->data() + m_center_num;
+    m_center_storage = std::move(centers);
+    m_generation = NextGeneration();
+}
 
 void Calibration::Load(const std::string& path) {
+    *this = Calibration();
+    uint32_t magic = 0;
+    {
+        std::ifstream f(path, std::ios_base::binary);
+        f.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+        if (!f) return;
+    }
+    if (magic != FILE_MAGIC) {
+        LoadV1(path);
+        return;
+    }
+    try {
+        boost::interprocess::file_mapping file(path.c_str(), boost::interprocess::read_only);
+        auto region = std::make_shared<boost::interprocess::mapped_region>(file, boost::interprocess::read_only);
+        if (region->get_size() < sizeof(FileHeader)) return;
+        const auto* header = static_cast<const FileHeader*>(region->get_address());
+        if (header->version != FILE_VERSION || region->get_size() < sizeof(FileHeader) + sizeof(float) * 2 * static_cast<size_t>(header->center_num)) return;
+        // the sample map and the decoder index the centers by the dim
+        const Dim& dim1 = header->dim;
+        if (header->valid && header->center_num != static_cast<uint64_t>(dim1.tile_x_num) * dim1.tile_y_num * dim1.tile_x_size * dim1.tile_y_size) return;
+        valid = header->valid;
+        dim = header->dim;
+        m_center_num = header->center_num;
+        m_center_xs = reinterpret_cast<const float*>(header + 1);
+        m_center_ys = m_center_xs + m_center_num;
+        m_center_storage = std::move(region);
+        m_generation = NextGeneration();
+    }
+    catch (const boost::interprocess::interprocess_exception&) {
+        *this = Calibration();
+    }
+}
+
+void Calibration::LoadV1(const std::string& path) {
     std::ifstream f(path, std::ios_base::binary);
     int vld = 0;
     f.read(reinterpret_cast<char*>(&vld), sizeof(vld));
-    valid = vld;
-    if (valid) {
-        f.read(reinterpret_cast<char*>(&dim), sizeof(Dim));
-        tiles.resize(dim.tile_y_num);
-        for (int tile_y_id = 0; tile_y_id < dim.tile_y_num; ++tile_y_id) {
-            tiles[tile_y_id].resize(dim.tile_x_num);
-            for (int tile_x_id = 0; tile_x_id < dim.tile_x_num; ++tile_x_id) {
-                auto& centers = tiles[tile_y_id][tile_x_id].centers;
-                centers.resize(dim.tile_y_size);
-                for (int y = 0; y < dim.tile_y_size; ++y) {
-                    centers[y].resize(dim.tile_x_size);
-                    for (int x = 0; x < dim.tile_x_size; ++x) {
-                        auto& center = centers[y][x];
-                        f.read(reinterpret_cast<char*>(&center[0]), sizeof(center[0]));
-                        f.read(reinterpret_cast<char*>(&center[1]), sizeof(center[1]));
-                    }
-                }
-            }
+    if (vld) {
+        Dim dim1;
+        f.read(reinterpret_cast<char*>(&dim1), sizeof(Dim));
+        size_t center_num = static_cast<size_t>(dim1.tile_x_num) * dim1.tile_y_num * dim1.tile_x_size * dim1.tile_y_size;
+        std::vector<float> center_xys(center_num * 2);
+        f.read(reinterpret_cast<char*>(center_xys.data()), sizeof(float) * center_xys.size());
+        if (!f) return;
+        std::vector<float> center_xs(center_num);
+        std::vector<float> center_ys(center_num);
+        for (size_t i = 0; i < center_num; ++i) {
+            center_xs[i] = center_xys[i * 2];
+            center_ys[i] = center_xys[i * 2 + 1];
         }
+        Init(dim1, std::move(center_xs), std::move(center_ys));
     }
 }
 
+// the centers may be mapped from path itself, so they are copied before the file is truncated
 void Calibration::Save(const std::string& path) {
+    FileHeader header;
+    header.valid = valid;
+    header.dim = dim;
+    header.center_num = valid ? static_cast<uint32_t>(m_center_num) : 0;
+    Bytes file_bytes(sizeof(header) + sizeof(float) * 2 * static_cast<size_t>(header.center_num));
+    std::copy_n(reinterpret_cast<const Byte*>(&header), sizeof(header), file_bytes.data());
+    if (header.center_num) {
+        std::copy_n(reinterpret_cast<const Byte*>(m_center_xs), sizeof(float) * header.center_num, file_bytes.data() + sizeof(header));
+        std::copy_n(reinterpret_cast<const Byte*>(m_center_ys), sizeof(float) * header.center_num, file_bytes.data() + sizeof(header) + sizeof(float) * header.center_num);
+        // a mapped file can't be truncated on windows, the centers move to owned storage first
+        Init(dim, std::vector<float>(m_center_xs, m_center_xs + m_center_num), std::vector<float>(m_center_ys, m_center_ys + m_center_num));
+    }
     std::ofstream f(path, std::ios_base::binary);
-    int vld = valid;
-    f.write(reinterpret_cast<char*>(&vld), sizeof(vld));
-    if (valid) {
-        f.write(reinterpret_cast<char*>(&dim), sizeof(Dim));
-        for (int tile_y_id = 0; tile_y_id < dim.tile_y_num; ++tile_y_id) {
-            for (int tile_x_id = 0; tile_x_id < dim.tile_x_num; ++tile_x_id) {
-                const auto& centers = tiles[tile_y_id][tile_x_id].centers;
-                for (int y = 0; y < dim.tile_y_size; ++y) {
-                    for (int x = 0; x < dim.tile_x_size; ++x) {
-                        const auto& center = centers[y][x];
-                        f.write(reinterpret_cast<const char*>(&center[0]), sizeof(center[0]));
-                        f.write(reinterpret_cast<const char*>(&center[1]), sizeof(center[1]));
-                    }
-                }
+    f.write(reinterpret_cast<const char*>(file_bytes.data()), file_bytes.size());
+}
+
+bool SampleMap::IsApplicable(const Transform& transform, const Calibration& calibration) {
+    return calibration.valid && transform.filter_level == 0;
+}
+
+bool SampleMap::IsUpToDate(const cv::Mat& img, const Transform& transform, const Calibration& calibration) const {
+    return calibration_generation == calibration.Generation() && frame_step == img.step[0] && transform_cache.IsUpToDate(img, transform);
+}
+
+void SampleMap::Update(const cv::Mat& img, const Transform& transform, const Calibration& calibration) {
+    if (IsUpToDate(img, transform, calibration)) return;
+    calibration_generation = calibration.Generation();
+    frame_step = img.step[0];
+    transform_cache.Update(img, transform);
+    const cv::Mat& map = transform_cache.map;
+    auto get_offset = [&](int x, int y) {
+        const auto& p = map.at<cv::Vec2s>(y, x);
+        if (p[0] < 0) return SAMPLE_BORDER;
+        return static_cast<int32_t>(p[1] * frame_step + p[0] * 3);
+    };
+    const float* center_xs = calibration.CenterXs();
+    const float* center_ys = calibration.CenterYs();
+    offsets.assign(calibration.CenterNum() * SAMPLE_NUM_PER_SYMBOL, SAMPLE_NONE);
+    for (size_t i = 0; i < calibration.CenterNum(); ++i) {
+        float radius = 1;
+        int x0 = std::max(static_cast<int>(std::round(center_xs[i] - radius)), 0);
+        int y0 = std::max(static_cast<int>(std::round(center_ys[i] - radius)), 0);
+        int x1 = std::min(static_cast<int>(std::round(center_xs[i] + radius + 1)), map.cols);
+        int y1 = std::min(static_cast<int>(std::round(center_ys[i] + radius + 1)), map.rows);
+        int32_t* symbol_offsets = offsets.data() + i * SAMPLE_NUM_PER_SYMBOL;
+        int sample_id = 0;
+        for (int y = y0; y < y1; ++y) {
+            for (int x = x0; x < x1; ++x) {
+                if (sample_id < SAMPLE_NUM_PER_SYMBOL) symbol_offsets[sample_id++] = get_offset(x, y);
             }
         }
     }
 }
 
-int find_non_white_boundary_n(const cv::Mat& img) {
-    for (int i = 0; i < img.rows; ++i) {
-        for (int j = 0; j < img.cols; ++j) {
-            if (is_non_white(img, j, i)) {
-                return i;
-            }
-        }
+std::array<cv::Mat, 2> get_white_projections(const cv::Mat& img) {
+    if (img.empty()) {
+        return {cv::Mat(1, img.cols, CV_8U, cv::Scalar(255)), cv::Mat(img.rows, 1, CV_8U, cv::Scalar(255))};
     }
-    return img.rows;
+    cv::Mat img_w = img;
+    if (img.channels() != 1) {
+        cv::inRange(img, cv::Scalar::all(255), cv::Scalar::all(255), img_w);
+    }
+    cv::Mat col_projection;
+    cv::Mat row_projection;
+    cv::reduce(img_w, col_projection, 0, cv::REDUCE_MIN);
+    cv::reduce(img_w, row_projection, 1, cv::REDUCE_MIN);
+    return {std::move(col_projection), std::move(row_projection)};
 }
 
-int find_non_white_boundary_s(const cv::Mat& img) {
-    for (int i = img.rows - 1; i >= 0; --i) {
-        for (int j = 0; j < img.cols; ++j) {
-            if (is_non_white(img, j, i)) {
-                return i;
-            }
-        }
+int find_non_white_first(const cv::Mat& projection) {
+    const uchar* p = projection.ptr<uchar>();
+    int n = static_cast<int>(projection.total());
+    for (int i = 0; i < n; ++i) {
+        if (p[i] != 255) return i;
     }
-    return -1;
+    return n;
 }
 
-int find_non_white_boundary_w(const cv::Mat& img) {
-    for (int j = 0; j < img.cols; ++j) {
-        for (int i = 0; i < img.rows; ++i) {
-            if (is_non_white(img, j, i)) {
-                return j;
-            }
-        }
+int find_non_white_last(const cv::Mat& projection) {
+    const uchar* p = projection.ptr<uchar>();
+    int n = static_cast<int>(projection.total());
+    for (int i = n - 1; i >= 0; --i) {
+        if (p[i] != 255) return i;
     }
-    return img.cols;
+    return -1;
 }
 
-int find_non_white_boundary_e(const cv::Mat& img) {
-    for (int j = img.cols - 1; j >= 0; --j) {
-        for (int i = 0; i < img.rows; ++i) {
-            if (is_non_white(img, j, i)) {
-                return j;
+std::vector<int> find_spaces(const cv::Mat& projection) {
+    const uchar* p = projection.ptr<uchar>();
+    int n = static_cast<int>(projection.total());
+    std::vector<int> spaces;
+    int space_start = -1;
+    for (int i = 0; i < n; ++i) {
+        bool is_space = p[i] == 255;
+        if (space_start >= 0) {
+            if (!is_space) {
+                spaces.push_back((space_start + i) / 2);
+                space_start = -1;
+            }
+        } else {
+            if (is_space) {
+                space_start = i;
             }
         }
     }
-    return -1;
+    if (space_start >= 0) spaces.push_back((space_start + n) / 2);
+    return spaces;
 }
 
 std::array<int, 4> find_tile_bbox1(const cv::Mat& img) {
-    int y0 = find_non_white_boundary_n(img);
-    int y1 = find_non_white_boundary_s(img);
-    int x0 = find_non_white_boundary_w(img);
-    int x1 = find_non_white_boundary_e(img);
+    auto [col_projection, row_projection] = get_white_projections(img);
+    int y0 = find_non_white_first(row_projection);
+    int y1 = find_non_white_last(row_projection);
+    int x0 = find_non_white_first(col_projection);
+    int x1 = find_non_white_last(col_projection);
     return {x0, y0, x1, y1};
 }
 
@@ -120,51 +216,8 @@ std::array<int, 4> get_tile_bbox2(const std::array<int, 4>& bbox1, int tile_x_si
 }
 
 std::array<std::vector<int>, 2> get_spaces(const cv::Mat& img) {
-    std::vector<int> space_xs;
-    int x_space_start_x = -1;
-    for (int j = 0; j < img.cols; ++j) {
-        bool is_space = true;
-        for (int i = 0; i < img.rows; ++i) {
-            if (is_non_white(img, j, i)) {
-                is_space = false;
-                break;
-            }
-        }
-        if (x_space_start_x >= 0) {
-            if (!is_space) {
-                space_xs.push_back((x_space_start_x + j) / 2);
-                x_space_start_x = -1;
-            }
-        } else {
-            if (is_space) {
-                x_space_start_x = j;
-            }
-        }
-    }
-    if (x_space_start_x >= 0) space_xs.push_back((x_space_start_x + img.cols) / 2);
-    std::vector<int> space_ys;
-    int y_space_start_y = -1;
-    for (int i = 0; i < img.rows; ++i) {
-        bool is_space = true;
-        for (int j = 0; j < img.cols; ++j) {
-            if (is_non_white(img, j, i)) {
-                is_space = false;
-                break;
-            }
-        }
-        if (y_space_start_y >= 0) {
-            if (!is_space) {
-                space_ys.push_back((y_space_start_y + i) / 2);
-                y_space_start_y = -1;
-            }
-        } else {
-            if (is_space) {
-                y_space_start_y = i;
-            }
-        }
-    }
-    if (y_space_start_y >= 0) space_ys.push_back((y_space_start_y + img.rows) / 2);
-    return {std::move(space_xs), std::move(space_ys)};
+    auto [col_projection, row_projection] = get_white_projections(img);
+    return {find_spaces(col_projection), find_spaces(row_projection)};
 }
 
 std::pair<bool, std::vector<std::vector<std::array<int, 4>>>> get_tile_bboxes(const cv::Mat& img, int tile_x_num, int tile_y_num) {
@@ -187,79 +240,114 @@ std::pair<bool, std::vector<std::vector<std::array<int, 4>>>> get_tile_bboxes(co
     return std::make_pair(true, std::move(tile_bboxs));
 }
 
-std::tuple<int, int, int, int> get_non_white_region_bbox(const cv::Mat& img, int x, int y) {
-    int x0 = x;
-    int y0 = y;
-    int x1 = x;
-    int y1 = y;
-    std::set<std::array<int, 2>> visited;
-    std::queue<std::array<int, 2>> q;
-    q.push({x, y});
-    while (!q.empty()) {
-        auto [px, py] = q.front();
-        q.pop();
-        if (px - 1 >= 0 && visited.insert({px - 1, py}).second && is_non_white(img, px - 1, py)) {
-            x0 = std::min(x0, px - 1);
-            q.push({px - 1, py});
+std::pair<bool, std::vector<std::tuple<cv::Mat, std::array<int, 4>, cv::Mat>>> get_tile_images(const cv::Mat& img, const Dim& dim, int binarization_threshold) {
+    auto [tile_x_num, tile_y_num, tile_x_size, tile_y_size] = dim;
+    cv::Mat img_b = do_binarize(img, binarization_threshold);
+    auto [tiling_success, tile_bboxes] = get_tile_bboxes(img_b, tile_x_num, tile_y_num);
+    std::vector<std::tuple<cv::Mat, std::array<int, 4>, cv::Mat>> tile_imgs;
+    if (!tiling_success) return std::make_pair(false, std::move(tile_imgs));
+    for (int tile_y_id = 0; tile_y_id < tile_y_num; ++tile_y_id) {
+        for (int tile_x_id = 0; tile_x_id < tile_x_num; ++tile_x_id) {
+            cv::Mat tile_img = do_crop(img, tile_bboxes[tile_y_id][tile_x_id]);
+            cv::Mat tile_img1 = do_auto_quad(tile_img, binarization_threshold);
+            std::array<int, 4> bbox1 = {0, 0, tile_img1.cols, tile_img1.rows};
+            std::array<int, 4> bbox2 = get_tile_bbox2(bbox1, tile_x_size, tile_y_size);
+            cv::Mat tile_img2 = do_crop(tile_img1, bbox2);
+            tile_imgs.emplace_back(std::move(tile_img1), bbox2, std::move(tile_img2));
         }
-        if (px + 1 < img.cols && visited.insert({px + 1, py}).second && is_non_white(img, px + 1, py)) {
-            x1 = std::max(x1, px + 1);
-            q.push({px + 1, py});
+    }
+    return std::make_pair(true, std::move(tile_imgs));
+}
+
+std::pair<bool, std::vector<std::array<float, 2>>> get_calibration_centers(const cv::Mat& img_b, int row_num, int col_num) {
+    cv::Mat mask;
+    cv::threshold(img_b, mask, 254, 255, cv::THRESH_BINARY_INV);
+    cv::Mat labels, stats, centroids;
+    int label_num = cv::connectedComponentsWithStats(mask, labels, stats, centroids, 4, CV_32S);
+    std::vector<int> areas;
+    for (int label = 1; label < label_num; ++label) {
+        areas.push_back(stats.at<int>(label, cv::CC_STAT_AREA));
+    }
+    std::vector<std::array<float, 2>> centers;
+    if (areas.empty()) return std::make_pair(false, std::move(centers));
+    std::nth_element(areas.begin(), areas.begin() + areas.size() / 2, areas.end());
+    int min_area = areas[areas.size() / 2] / 4;
+    for (int label = 1; label < label_num; ++label) {
+        if (stats.at<int>(label, cv::CC_STAT_AREA) < min_area) continue;
+        int x0 = stats.at<int>(label, cv::CC_STAT_LEFT);
+        int y0 = stats.at<int>(label, cv::CC_STAT_TOP);
+        int x1 = x0 + stats.at<int>(label, cv::CC_STAT_WIDTH);
+        int y1 = y0 + stats.at<int>(label, cv::CC_STAT_HEIGHT);
+        centers.push_back({static_cast<float>(x0 + x1) / 2, static_cast<float>(y0 + y1) / 2});
+    }
+    if (centers.size() != static_cast<size_t>(row_num) * col_num) return std::make_pair(false, std::move(centers));
+    // rows are found in the frame of the grid, the tilt is taken from the edge of its min area rect closest to horizontal
+    std::vector<cv::Point2f> points;
+    for (const auto& center : centers) points.emplace_back(center[0], center[1]);
+    cv::Point2f rect_points[4];
+    cv::minAreaRect(points).points(rect_points);
+    float angle = 0;
+    for (int i = 0; i < 2; ++i) {
+        cv::Point2f edge = rect_points[i + 1] - rect_points[i];
+        float edge_angle = std::atan2(edge.y, edge.x);
+        edge_angle = edge_angle - static_cast<float>(CV_PI) * std::round(edge_angle / static_cast<float>(CV_PI));
+        if (std::abs(edge_angle) <= static_cast<float>(CV_PI) / 4) angle = edge_angle;
+    }
+    float cos_a = std::cos(angle);
+    float sin_a = std::sin(angle);
+    auto grid_x = [cos_a, sin_a](const std::array<float, 2>& c) { return c[0] * cos_a + c[1] * sin_a; };
+    auto grid_y = [cos_a, sin_a](const std::array<float, 2>& c) { return c[1] * cos_a - c[0] * sin_a; };
+    std::sort(centers.begin(), centers.end(), [&grid_y](const auto& c1, const auto& c2) { return grid_y(c1) < grid_y(c2); });
+    std::vector<std::array<float, 2>> row_ys(row_num);
+    for (int y = 0; y < row_num; ++y) {
+        std::sort(centers.begin() + y * col_num, centers.begin() + (y + 1) * col_num, [&grid_x](const auto& c1, const auto& c2) { return grid_x(c1) < grid_x(c2); });
+        auto [min_it, max_it] = std::minmax_element(centers.begin() + y * col_num, centers.begin() + (y + 1) * col_num, [&grid_y](const auto& c1, const auto& c2) { return grid_y(c1) < grid_y(c2); });
+        row_ys[y] = {grid_y(*min_it), grid_y(*max_it)};
+    }
+    // a row mixing centers of two rows would give wrong centers, which is worse than none
+    if (row_num > 1) {
+        std::vector<float> row_pitches;
+        for (int y = 0; y + 1 < row_num; ++y) {
+            row_pitches.push_back((row_ys[y + 1][0] + row_ys[y + 1][1] - row_ys[y][0] - row_ys[y][1]) / 2);
         }
-        if (py - 1 >= 0 && visited.insert({px, py - 1}).second && is_non_white(img, px, py - 1)) {
-            y0 = std::min(y0, py - 1);
-            q.push({px, py - 1});
+        std::nth_element(row_pitches.begin(), row_pitches.begin() + row_pitches.size() / 2, row_pitches.end());
+        float row_pitch = row_pitches[row_pitches.size() / 2];
+        for (const auto& [y0, y1] : row_ys) {
+            if (y1 - y0 >= row_pitch / 2) return std::make_pair(false, std::move(centers));
         }
-        if (py + 1 < img.rows && visited.insert({px, py + 1}).second && is_non_white(img, px, py + 1)) {
-            y1 = std::max(y1, py + 1);
-            q.push({px, py + 1});
+    }
+    return std::make_pair(true, std::move(centers));
+}
+
+Symbol vote_symbol(const int* color_num) {
+    Symbol symbol = static_cast<int>(PixelColor::UNKNOWN);
+    int max_num = 0;
+    for (int i = 0; i < static_cast<int>(PixelColor::NUM); ++i) {
+        if (color_num[i] > max_num) {
+            symbol = i;
+            max_num = color_num[i];
         }
     }
-    return {x0, y0, x1 + 1, y1 + 1};
+    return symbol;
 }
 
-Symbol get_symbol(const cv::Mat& img, float cx, float cy) {
+Symbol get_symbol(const cv::Mat& img, const PixelClassifier& pixel_classifier, float cx, float cy) {
     float radius = 1;
     int x0 = std::max(static_cast<int>(std::round(cx - radius)), 0);
     int y0 = std::max(static_cast<int>(std::round(cy - radius)), 0);
     int x1 = std::min(static_cast<int>(std::round(cx + radius + 1)), img.cols);
     int y1 = std::min(static_cast<int>(std::round(cy + radius + 1)), img.rows);
-    int color_num[static_cast<int>(PixelColor::NUM)] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+    int color_num[static_cast<int>(PixelColor::NUM)] = {};
     for (int y = y0; y < y1; ++y) {
+        const uchar* row = img.ptr<uchar>(y);
         for (int x = x0; x < x1; ++x) {
-            if (is_white(img, x, y)) {
-                ++color_num[static_cast<int>(PixelColor::WHITE)];
-            } else if (is_black(img, x, y)) {
-                ++color_num[static_cast<int>(PixelColor::BLACK)];
-            } else if (is_red(img, x, y)) {
-                ++color_num[static_cast<int>(PixelColor::RED)];
-            } else if (is_blue(img, x, y)) {
-                ++color_num[static_cast<int>(PixelColor::BLUE)];
-            } else if (is_green(img, x, y)) {
-                ++color_num[static_cast<int>(PixelColor::GREEN)];
-            } else if (is_cyan(img, x, y)) {
-                ++color_num[static_cast<int>(PixelColor::CYAN)];
-            } else if (is_magenta(img, x, y)) {
-                ++color_num[static_cast<int>(PixelColor::MAGENTA)];
-            } else if (is_yellow(img, x, y)) {
-                ++color_num[static_cast<int>(PixelColor::YELLOW)];
-            } else {
-                ++color_num[static_cast<int>(PixelColor::UNKNOWN)];
-            }
-        }
-    }
-    Symbol symbol = static_cast<int>(PixelColor::UNKNOWN);
-    int max_num = 0;
-    for (int i = 0; i < static_cast<int>(PixelColor::NUM); ++i) {
-        if (color_num[i] > max_num) {
-            symbol = i;
-            max_num = color_num[i];
+            ++color_num[static_cast<int>(pixel_classifier.Classify(row + x * 3))];
         }
     }
-    return symbol;
+    return vote_symbol(color_num);
 }
 
-Symbols get_tile_symbols(const cv::Mat& img, int tile_x_size, int tile_y_size) {
+Symbols get_tile_symbols(const cv::Mat& img, const PixelClassifier& pixel_classifier, int tile_x_size, int tile_y_size) {
     float unit_w = static_cast<float>(img.cols) / tile_x_size;
     float unit_h = static_cast<float>(img.rows) / tile_y_size;
     Symbols symbols;
@@ -269,7 +357,7 @@ Symbols get_tile_symbols(const cv::Mat& img, int tile_x_size, int tile_y_size) {
             if (img.cols && img.rows) {
                 float cx = (x + 0.5f) * unit_w;
                 float cy = (y + 0.5f) * unit_h;
-                symbol = get_symbol(img, cx, cy);
+                symbol = get_symbol(img, pixel_classifier, cx, cy);
             }
             symbols.push_back(symbol);
         }
@@ -277,18 +365,216 @@ Symbols get_tile_symbols(const cv::Mat& img, int tile_x_size, int tile_y_size) {
     return symbols;
 }
 
-Symbols get_tile_symbols(const cv::Mat& img, const std::vector<std::vector<std::array<float, 2>>>& centers) {
-    Symbols symbols;
-    for (size_t y = 0; y < centers.size(); ++y) {
-        for (size_t x = 0; x < centers[y].size(); ++x) {
-            const auto& center = centers[y][x];
-            Symbol symbol = get_symbol(img, center[0], center[1]);
-            symbols.push_back(symbol);
-        }
+Symbols get_tile_symbols(const cv::Mat& img, const PixelClassifier& pixel_classifier, const Calibration& calibration) {
+    const float* center_xs = calibration.CenterXs();
+    const float* center_ys = calibration.CenterYs();
+    Symbols symbols(calibration.CenterNum());
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        symbols[i] = get_symbol(img, pixel_classifier, center_xs[i], center_ys[i]);
     }
     return symbols;
 }
 
+void get_sampled_symbols(const cv::Mat& img, const PixelClassifier& pixel_classifier, const SampleMap& sample_map, Symbols& symbols) {
+    const uchar* data = img.data;
+    PixelColor border_color = pixel_classifier.Classify(cv::Vec3b(255, 255, 255));
+    size_t symbol_num = sample_map.offsets.size() / SampleMap::SAMPLE_NUM_PER_SYMBOL;
+    symbols.resize(symbol_num);
+    const int32_t* offset = sample_map.offsets.data();
+    for (size_t i = 0; i < symbol_num; ++i) {
+        int color_num[static_cast<int>(PixelColor::NUM)] = {};
+        for (int j = 0; j < SampleMap::SAMPLE_NUM_PER_SYMBOL; ++j) {
+            if (offset[j] >= 0) {
+                ++color_num[static_cast<int>(pixel_classifier.Classify(data + offset[j]))];
+            } else if (offset[j] == SampleMap::SAMPLE_BORDER) {
+                ++color_num[static_cast<int>(border_color)];
+            }
+        }
+        symbols[i] = vote_symbol(color_num);
+        offset += SampleMap::SAMPLE_NUM_PER_SYMBOL;
+    }
+}
+
+void append_samples(const cv::Mat& img, float cx, float cy, SymbolSamples& samples) {
+    float radius = 1;
+    int x0 = std::max(static_cast<int>(std::round(cx - radius)), 0);
+    int y0 = std::max(static_cast<int>(std::round(cy - radius)), 0);
+    int x1 = std::min(static_cast<int>(std::round(cx + radius + 1)), img.cols);
+    int y1 = std::min(static_cast<int>(std::round(cy + radius + 1)), img.rows);
+    size_t symbol_id = samples.sample_nums.size();
+    samples.bgrs.resize((symbol_id + 1) * SampleMap::SAMPLE_NUM_PER_SYMBOL);
+    cv::Vec3b* bgrs = samples.bgrs.data() + symbol_id * SampleMap::SAMPLE_NUM_PER_SYMBOL;
+    int sample_num = 0;
+    for (int y = y0; y < y1; ++y) {
+        for (int x = x0; x < x1; ++x) {
+            if (sample_num < SampleMap::SAMPLE_NUM_PER_SYMBOL) bgrs[sample_num++] = img.at<cv::Vec3b>(y, x);
+        }
+    }
+    samples.sample_nums.push_back(static_cast<uint8_t>(sample_num));
+}
+
+void append_tile_samples(const cv::Mat& img, int tile_x_size, int tile_y_size, SymbolSamples& samples) {
+    float unit_w = static_cast<float>(img.cols) / tile_x_size;
+    float unit_h = static_cast<float>(img.rows) / tile_y_size;
+    for (int y = 0; y < tile_y_size; ++y) {
+        for (int x = 0; x < tile_x_size; ++x) {
+            if (img.cols && img.rows) {
+                append_samples(img, (x + 0.5f) * unit_w, (y + 0.5f) * unit_h, samples);
+            } else {
+                samples.bgrs.resize(samples.bgrs.size() + SampleMap::SAMPLE_NUM_PER_SYMBOL);
+                samples.sample_nums.push_back(0);
+            }
+        }
+    }
+}
+
+void append_mapped_samples(const cv::Mat& img, const SampleMap& sample_map, SymbolSamples& samples) {
+    const uchar* data = img.data;
+    size_t symbol_num = sample_map.offsets.size() / SampleMap::SAMPLE_NUM_PER_SYMBOL;
+    samples.bgrs.resize(samples.bgrs.size() + symbol_num * SampleMap::SAMPLE_NUM_PER_SYMBOL);
+    cv::Vec3b* bgrs = samples.bgrs.data() + samples.sample_nums.size() * SampleMap::SAMPLE_NUM_PER_SYMBOL;
+    const int32_t* offset = sample_map.offsets.data();
+    for (size_t i = 0; i < symbol_num; ++i) {
+        int sample_num = 0;
+        for (int j = 0; j < SampleMap::SAMPLE_NUM_PER_SYMBOL; ++j) {
+            if (offset[j] >= 0) {
+                const uchar* p = data + offset[j];
+                bgrs[sample_num++] = cv::Vec3b(p[0], p[1], p[2]);
+            } else if (offset[j] == SampleMap::SAMPLE_BORDER) {
+                bgrs[sample_num++] = cv::Vec3b(255, 255, 255);
+            }
+        }
+        samples.sample_nums.push_back(static_cast<uint8_t>(sample_num));
+        bgrs += SampleMap::SAMPLE_NUM_PER_SYMBOL;
+        offset += SampleMap::SAMPLE_NUM_PER_SYMBOL;
+    }
+}
+
+bool append_filtered_samples(const cv::Mat& img, const Transform& transform, const Calibration& calibration, TransformCache& transform_cache, SymbolSamples& samples) {
+    transform_cache.Update(img, transform);
+    const cv::Mat& map = transform_cache.map;
+    int margin = get_filter_radius(transform.filter_level);
+    size_t patch_size = 3 + 2 * margin;
+    if (patch_size * patch_size * calibration.CenterNum() > map.total()) return false;
+    const float* center_xs = calibration.CenterXs();
+    const float* center_ys = calibration.CenterYs();
+    cv::Mat patch;
+    for (size_t i = 0; i < calibration.CenterNum(); ++i) {
+        float radius = 1;
+        int x0 = std::max(static_cast<int>(std::round(center_xs[i] - radius)), 0);
+        int y0 = std::max(static_cast<int>(std::round(center_ys[i] - radius)), 0);
+        int x1 = std::min(static_cast<int>(std::round(center_xs[i] + radius + 1)), map.cols);
+        int y1 = std::min(static_cast<int>(std::round(center_ys[i] + radius + 1)), map.rows);
+        size_t symbol_id = samples.sample_nums.size();
+        samples.bgrs.resize((symbol_id + 1) * SampleMap::SAMPLE_NUM_PER_SYMBOL);
+        cv::Vec3b* bgrs = samples.bgrs.data() + symbol_id * SampleMap::SAMPLE_NUM_PER_SYMBOL;
+        int sample_num = 0;
+        if (x0 < x1 && y0 < y1) {
+            int px0 = std::max(x0 - margin, 0);
+            int py0 = std::max(y0 - margin, 0);
+            int px1 = std::min(x1 + margin, map.cols);
+            int py1 = std::min(y1 + margin, map.rows);
+            cv::remap(img, patch, map(cv::Rect(px0, py0, px1 - px0, py1 - py0)), cv::Mat(), cv::INTER_NEAREST, cv::BORDER_CONSTANT, cv::Scalar(255, 255, 255));
+            patch = do_filter(patch, transform.filter_level);
+            for (int y = y0; y < y1; ++y) {
+                for (int x = x0; x < x1; ++x) {
+                    if (sample_num < SampleMap::SAMPLE_NUM_PER_SYMBOL) bgrs[sample_num++] = patch.at<cv::Vec3b>(y - py0, x - px0);
+                }
+            }
+        }
+        samples.sample_nums.push_back(static_cast<uint8_t>(sample_num));
+    }
+    return true;
+}
+
+void get_sample_symbols(const SymbolSamples& samples, const PixelClassifier& pixel_classifier, Symbols& symbols) {
+    symbols.resize(samples.sample_nums.size());
+    const cv::Vec3b* bgrs = samples.bgrs.data();
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        int color_num[static_cast<int>(PixelColor::NUM)] = {};
+        for (int j = 0; j < samples.sample_nums[i]; ++j) {
+            ++color_num[static_cast<int>(pixel_classifier.Classify(bgrs[j]))];
+        }
+        symbols[i] = vote_symbol(color_num);
+        bgrs += SampleMap::SAMPLE_NUM_PER_SYMBOL;
+    }
+}
+
+struct SoftVote {
+    int color_num[static_cast<int>(PixelColor::NUM)] = {};
+    int min_distance[static_cast<int>(PixelColor::NUM)];
+    PixelColor alternative[static_cast<int>(PixelColor::NUM)];
+
+    SoftVote() {
+        std::fill(std::begin(min_distance), std::end(min_distance), 255);
+    }
+
+    void Add(PixelColor color, int distance, PixelColor alternative1) {
+        int i = static_cast<int>(color);
+        ++color_num[i];
+        if (distance < min_distance[i]) {
+            min_distance[i] = distance;
+            alternative[i] = alternative1;
+        }
+    }
+
+    SymbolSoftInfo Get(Symbol symbol) const {
+        SymbolSoftInfo soft_info;
+        if (symbol >= static_cast<int>(PixelColor::UNKNOWN)) {
+            soft_info.confidence = 0;
+            soft_info.runner_up = symbol;
+            return soft_info;
+        }
+        int second = -1;
+        for (int i = 0; i < static_cast<int>(PixelColor::UNKNOWN); ++i) {
+            if (i != symbol && color_num[i] > 0 && (second < 0 || color_num[i] > color_num[second])) second = i;
+        }
+        int margin = color_num[symbol] - (second >= 0 ? color_num[second] : 0);
+        // a unanimous vote falls back to the color across the nearest threshold of its most marginal sample
+        soft_info.runner_up = static_cast<Symbol>(second >= 0 ? second : static_cast<int>(min_distance[symbol] < 255 ? alternative[symbol] : PixelColor::UNKNOWN));
+        soft_info.confidence = static_cast<uint16_t>((margin << 8) | min_distance[symbol]);
+        return soft_info;
+    }
+};
+
+void get_sampled_soft_infos(const cv::Mat& img, const PixelClassifier& pixel_classifier, const SampleMap& sample_map, const Symbols& symbols, SymbolSoftInfos& soft_infos) {
+    const uchar* data = img.data;
+    size_t symbol_num = sample_map.offsets.size() / SampleMap::SAMPLE_NUM_PER_SYMBOL;
+    soft_infos.resize(symbol_num);
+    const int32_t* offset = sample_map.offsets.data();
+    for (size_t i = 0; i < symbol_num; ++i) {
+        SoftVote vote;
+        for (int j = 0; j < SampleMap::SAMPLE_NUM_PER_SYMBOL; ++j) {
+            if (offset[j] >= 0) {
+                int distance = 0;
+                PixelColor alternative;
+                PixelColor color = pixel_classifier.ClassifySoft(data + offset[j], distance, alternative);
+                vote.Add(color, distance, alternative);
+            } else if (offset[j] == SampleMap::SAMPLE_BORDER) {
+                vote.Add(pixel_classifier.Classify(cv::Vec3b(255, 255, 255)), 255, PixelColor::UNKNOWN);
+            }
+        }
+        soft_infos[i] = vote.Get(symbols[i]);
+        offset += SampleMap::SAMPLE_NUM_PER_SYMBOL;
+    }
+}
+
+void get_sample_soft_infos(const SymbolSamples& samples, const PixelClassifier& pixel_classifier, const Symbols& symbols, SymbolSoftInfos& soft_infos) {
+    soft_infos.resize(samples.sample_nums.size());
+    const cv::Vec3b* bgrs = samples.bgrs.data();
+    for (size_t i = 0; i < soft_infos.size(); ++i) {
+        SoftVote vote;
+        for (int j = 0; j < samples.sample_nums[i]; ++j) {
+            int distance = 0;
+            PixelColor alternative;
+            PixelColor color = pixel_classifier.ClassifySoft(bgrs[j], distance, alternative);
+            vote.Add(color, distance, alternative);
+        }
+        soft_infos[i] = vote.Get(symbols[i]);
+        bgrs += SampleMap::SAMPLE_NUM_PER_SYMBOL;
+    }
+}
+
 cv::Mat get_result_image(const cv::Mat& img, int tile_x_size, int tile_y_size, const std::array<int, 4>& bbox1, const std::array<int, 4>& bbox2, const Symbols& symbols) {
     cv::Mat img1 = img.clone();
     float unit_h = static_cast<float>(bbox2[3] - bbox2[1]) / tile_y_size;
@@ -302,15 +588,8 @@ cv::Mat get_result_image(const cv::Mat& img, int tile_x_size, int tile_y_size, c
                 int x = static_cast<int>(std::round(bbox2[0] + (j + 0.5) * unit_w));
                 auto color = cv::Scalar(0, 0, 0);
                 auto marker = cv::MARKER_TILTED_CROSS;
-                if (symbols[index] == static_cast<int>(PixelColor::WHITE))        color = cv::Scalar(255, 255, 255);
-                else if (symbols[index] == static_cast<int>(PixelColor::BLACK))   color = cv::Scalar(0, 0, 0);
-                else if (symbols[index] == static_cast<int>(PixelColor::RED))     color = cv::Scalar(0, 0, 255);
-                else if (symbols[index] == static_cast<int>(PixelColor::BLUE))    color = cv::Scalar(255, 0, 0);
-                else if (symbols[index] == static_cast<int>(PixelColor::GREEN))   color = cv::Scalar(0, 255, 0);
-                else if (symbols[index] == static_cast<int>(PixelColor::CYAN))    color = cv::Scalar(255, 255, 0);
-                else if (symbols[index] == static_cast<int>(PixelColor::MAGENTA)) color = cv::Scalar(255, 0, 255);
-                else if (symbols[index] == static_cast<int>(PixelColor::YELLOW))  color = cv::Scalar(0, 255, 255);
-                else                                                              { std::cout << static_cast<int>(symbols[index]) << "\n"; marker = cv::MARKER_CROSS; }
+                if (symbols[index] < static_cast<int>(PixelColor::UNKNOWN)) color = get_pixel_color_bgr(static_cast<PixelColor>(symbols[index]));
+                else                                                        { std::cout << static_cast<int>(symbols[index]) << "\n"; marker = cv::MARKER_CROSS; }
                 cv::drawMarker(img1, cv::Point(x, y), color, marker, radius * 2);
             }
         }
@@ -331,36 +610,22 @@ cv::Mat get_result_image(const cv::Mat& img, int tile_x_size, int tile_y_size, c
     return img1;
 }
 
-cv::Mat get_result_image(const cv::Mat& img, const Dim& dim, const Calibration& calibration, const Symbols& symbols) {
+cv::Mat get_result_image(const cv::Mat& img, const Calibration& calibration, const Symbols& symbols) {
     cv::Mat img1 = img.clone();
-    auto [tile_x_num, tile_y_num, tile_x_size, tile_y_size] = dim;
     const int radius = 2;
-    for (int tile_y_id = 0; tile_y_id < tile_y_num; ++tile_y_id) {
-        for (int tile_x_id = 0; tile_x_id < tile_x_num; ++tile_x_id) {
-            for (int y = 0; y < tile_y_size; ++y) {
-                for (int x = 0; x < tile_x_size; ++x) {
-                    int index = ((tile_y_id * tile_x_num + tile_x_id) * tile_y_size + y) * tile_x_size + x;
-                    auto [cx, cy] = calibration.tiles[tile_y_id][tile_x_id].centers[y][x];
-                    auto color = cv::Scalar(0, 0, 0);
-                    auto marker = cv::MARKER_TILTED_CROSS;
-                    if (symbols[index] == static_cast<int>(PixelColor::WHITE))        color = cv::Scalar(255, 255, 255);
-                    else if (symbols[index] == static_cast<int>(PixelColor::BLACK))   color = cv::Scalar(0, 0, 0);
-                    else if (symbols[index] == static_cast<int>(PixelColor::RED))     color = cv::Scalar(0, 0, 255);
-                    else if (symbols[index] == static_cast<int>(PixelColor::BLUE))    color = cv::Scalar(255, 0, 0);
-                    else if (symbols[index] == static_cast<int>(PixelColor::GREEN))   color = cv::Scalar(0, 255, 0);
-                    else if (symbols[index] == static_cast<int>(PixelColor::CYAN))    color = cv::Scalar(255, 255, 0);
-                    else if (symbols[index] == static_cast<int>(PixelColor::MAGENTA)) color = cv::Scalar(255, 0, 255);
-                    else if (symbols[index] == static_cast<int>(PixelColor::YELLOW))  color = cv::Scalar(0, 255, 255);
-                    else                                                              marker = cv::MARKER_CROSS;
-                    cv::drawMarker(img1, cv::Point2f(cx, cy), color, marker, radius * 2);
-                }
-            }
-        }
+    const float* center_xs = calibration.CenterXs();
+    const float* center_ys = calibration.CenterYs();
+    for (size_t index = 0; index < calibration.CenterNum(); ++index) {
+        auto color = cv::Scalar(0, 0, 0);
+        auto marker = cv::MARKER_TILTED_CROSS;
+        if (symbols[index] < static_cast<int>(PixelColor::UNKNOWN)) color = get_pixel_color_bgr(static_cast<PixelColor>(symbols[index]));
+        else                                                        marker = cv::MARKER_CROSS;
+        cv::drawMarker(img1, cv::Point2f(center_xs[index], center_ys[index]), color, marker, radius * 2);
     }
     return img1;
 }
 
-ImageDecoder::ImageDecoder(SymbolType symbol_type, const Dim& dim) : m_symbol_codec(create_symbol_codec(symbol_type)), m_dim(dim) {
+ImageDecoder::ImageDecoder(SymbolType symbol_type, const Dim& dim, int frame_part_num) : m_symbol_codec(create_symbol_codec(symbol_type)), m_dim(dim), m_frame_part_num(frame_part_num), m_part_dim(get_part_dim(dim, frame_part_num)) {
 }
 
 CalibrateResult ImageDecoder::Calibrate(const cv::Mat& img, const Transform& transform, bool result_image) {
@@ -370,42 +635,25 @@ CalibrateResult ImageDecoder::Calibrate(const cv::Mat& img, const Transform& tra
     Calibration calibration;
     std::vector<std::vector<cv::Mat>> result_imgs(tile_y_num);
     for (auto& e : result_imgs) e.resize(tile_x_num);
-    std::vector<std::array<float, 2>> centers;
-    int start_x = 0;
-    std::vector<int> start_y(tile_x_num * tile_x_size, 0);
-    for (int y = 0; y < tile_y_num * tile_y_size; ++y) {
-        for (int x = 0; x < tile_x_num * tile_x_size; ++x) {
-            if (start_x >= img1_b.cols || start_y[x] >= img1_b.rows) {
-                if (result_image) {
-                    cv::cvtColor(img1_b, result_imgs[0][0], cv::COLOR_GRAY2BGR);
-                }
-                return std::make_tuple(std::move(img1), std::move(calibration), std::move(result_imgs));
-            }
-            cv::Mat img2_b = do_crop(img1_b, {start_x, start_y[x], img1.cols, img1.rows});
-            auto [corner_x, corner_y] = detect_non_white_corner_nw(img2_b);
-            auto [x0, y0, x1, y1] = get_non_white_region_bbox(img2_b, corner_x, corner_y);
-            float cx = static_cast<float>(x0 + x1) / 2 + start_x;
-            float cy = static_cast<float>(y0 + y1) / 2 + start_y[x];
-            centers.push_back({cx, cy});
-            start_x += x1;
-            start_y[x] += y1;
+    auto [calibration_success, centers] = get_calibration_centers(img1_b, tile_y_num * tile_y_size, tile_x_num * tile_x_size);
+    if (!calibration_success) {
+        if (result_image) {
+            cv::cvtColor(img1_b, result_imgs[0][0], cv::COLOR_GRAY2BGR);
         }
-        start_x = 0;
+        return std::make_tuple(std::move(img1), std::move(calibration), std::move(result_imgs));
     }
-    calibration.valid = true;
-    calibration.dim = m_dim;
-    calibration.tiles.resize(tile_y_num);
+    std::vector<float> center_xs(centers.size());
+    std::vector<float> center_ys(centers.size());
     cv::Mat result_img = img1.clone();
     const int radius = 2;
     for (int tile_y_id = 0; tile_y_id < tile_y_num; ++tile_y_id) {
-        calibration.tiles[tile_y_id].resize(tile_x_num);
         for (int tile_x_id = 0; tile_x_id < tile_x_num; ++tile_x_id) {
-            calibration.tiles[tile_y_id][tile_x_id].centers.resize(tile_y_size);
             for (int y = 0; y < tile_y_size; ++y) {
-                calibration.tiles[tile_y_id][tile_x_id].centers[y].resize(tile_x_size);
                 for (int x = 0; x < tile_x_size; ++x) {
                     int index = ((tile_y_id * tile_y_size + y) * tile_x_num + tile_x_id) * tile_x_size + x;
-                    calibration.tiles[tile_y_id][tile_x_id].centers[y][x] = centers[index];
+                    int decode_index = ((tile_y_id * tile_x_num + tile_x_id) * tile_y_size + y) * tile_x_size + x;
+                    center_xs[decode_index] = centers[index][0];
+                    center_ys[decode_index] = centers[index][1];
                     if (result_image) {
                         cv::circle(result_img, cv::Point2f(centers[index][0], centers[index][1]), radius, cv::Scalar(0, 0, 255), cv::FILLED);
                     }
@@ -413,6 +661,7 @@ CalibrateResult ImageDecoder::Calibrate(const cv::Mat& img, const Transform& tra
             }
         }
     }
+    calibration.Init(m_dim, std::move(center_xs), std::move(center_ys));
     if (result_image) {
         result_imgs[0][0] = result_img;
     }
@@ -420,36 +669,131 @@ CalibrateResult ImageDecoder::Calibrate(const cv::Mat& img, const Transform& tra
 }
 
 ImageDecodeResult ImageDecoder::Decode(const cv::Mat& img, const Transform& transform, const Calibration& calibration, bool result_image) {
-    auto [tile_x_num, tile_y_num, tile_x_size, tile_y_size] = m_dim;
-    cv::Mat img1 = transform_image(img, transform);
+    return DecodeTransformed(transform_image(img, transform), transform, calibration, result_image);
+}
+
+ImageDecodeResult ImageDecoder::Decode(const cv::Mat& img, const Transform& transform, const Calibration& calibration, SampleMap& sample_map) {
+    PixelClassifier pixel_classifier(m_symbol_codec->GetSymbolType(), transform.pixelization_threshold);
     Symbols symbols;
-    std::vector<std::vector<cv::Mat>> result_imgs(tile_y_num);
-    for (auto& e : result_imgs) e.resize(tile_x_num);
-    if (calibration.valid) {
-        cv::Mat img1_p = do_pixelize(img1, m_symbol_codec->GetSymbolType(), transform.pixelization_threshold);
-        for (int tile_y_id = 0; tile_y_id < tile_y_num; ++tile_y_id) {
-            for (int tile_x_id = 0; tile_x_id < tile_x_num; ++tile_x_id) {
-                auto tile_symbols = get_tile_symbols(img1_p, calibration.tiles[tile_y_id][tile_x_id].centers);
-                symbols.insert(symbols.end(), tile_symbols.begin(), tile_symbols.end());
+    if (SampleMap::IsApplicable(transform, calibration)) {
+        sample_map.Update(img, transform, calibration);
+        get_sampled_symbols(img, pixel_classifier, sample_map, symbols);
+    } else {
+        SymbolSamples samples;
+        if (!calibration.valid || !append_filtered_samples(img, transform, calibration, sample_map.transform_cache, samples)) {
+            return DecodeTransformed(transform_image(img, transform, sample_map.transform_cache), transform, calibration, false);
+        }
+        get_sample_symbols(samples, pixel_classifier, symbols);
+    }
+    auto [success, part_id, part_bytes] = DecodeFrame(symbols);
+    return std::make_tuple(success, part_id, std::move(part_bytes), std::move(symbols), cv::Mat(), std::vector<std::vector<cv::Mat>>());
+}
+
+void ImageDecoder::DecodeInto(const cv::Mat& img, const Transform& transform, const Calibration& calibration, DecodeScratch& scratch, DecodeResults& results) {
+    PixelClassifier pixel_classifier(m_symbol_codec->GetSymbolType(), transform.pixelization_threshold);
+    bool sampled = SampleMap::IsApplicable(transform, calibration);
+    if (sampled) {
+        scratch.sample_map.Update(img, transform, calibration);
+        get_sampled_symbols(img, pixel_classifier, scratch.sample_map, scratch.symbols);
+    } else {
+        scratch.samples.bgrs.clear();
+        scratch.samples.sample_nums.clear();
+        if (!calibration.valid || !append_filtered_samples(img, transform, calibration, scratch.sample_map.transform_cache, scratch.samples)) {
+            cv::Mat img1 = transform_image(img, transform, scratch.sample_map.transform_cache);
+            std::vector<std::vector<cv::Mat>> result_imgs;
+            scratch.symbols.clear();
+            GetTransformedSymbols(img1, transform, calibration, false, scratch.symbols, result_imgs);
+            DecodeParts(scratch.symbols, results);
+            return;
+        }
+        get_sample_symbols(scratch.samples, pixel_classifier, scratch.symbols);
+    }
+    DecodeParts(scratch.symbols, results);
+    if (m_chase_config.candidate_symbol_num <= 0) return;
+    bool has_soft_infos = false;
+    size_t part_frame_size = scratch.symbols.size() / m_frame_part_num;
+    for (int i = 0; i < m_frame_part_num; ++i) {
+        auto& [success, part_id, part_bytes] = results[i];
+        if (success) continue;
+        // soft information is only gathered for frames failing the crc
+        if (!has_soft_infos) {
+            if (sampled) {
+                get_sampled_soft_infos(img, pixel_classifier, scratch.sample_map, scratch.symbols, scratch.soft_infos);
+            } else {
+                get_sample_soft_infos(scratch.samples, pixel_classifier, scratch.symbols, scratch.soft_infos);
             }
+            has_soft_infos = true;
         }
+        ++m_chase_retry_frame_num;
+        size_t offset = i * part_frame_size;
+        success = m_symbol_codec->DecodeWithRetry(scratch.symbols.data() + offset, scratch.soft_infos.data() + offset, part_frame_size, m_chase_config, part_id, part_bytes.data());
+        if (success) ++m_chase_rescued_frame_num;
+    }
+}
+
+void ImageDecoder::DecodeBatch(const std::vector<cv::Mat>& imgs, const Transform& transform, const Calibration& calibration, DecodeScratch& scratch, std::vector<DecodeResults>& results) {
+    results.resize(imgs.size());
+    for (size_t i = 0; i < imgs.size(); ++i) {
+        DecodeInto(imgs[i], transform, calibration, scratch, results[i]);
+    }
+}
+
+void ImageDecoder::DecodeParts(const Symbols& symbols, DecodeResults& results) {
+    results.resize(m_frame_part_num);
+    // parts occupy consecutive tiles, so their symbols are consecutive as well
+    size_t part_frame_size = symbols.size() / m_frame_part_num;
+    int padded_part_byte_num = part_frame_size > 0 ? m_symbol_codec->PaddedPartByteNum(part_frame_size) : 0;
+    for (int i = 0; i < m_frame_part_num; ++i) {
+        auto& [success, part_id, part_bytes] = results[i];
+        if (padded_part_byte_num <= 0) {
+            success = false;
+            part_id = 0;
+            part_bytes.clear();
+            continue;
+        }
+        part_bytes.resize(padded_part_byte_num);
+        success = m_symbol_codec->Decode(symbols.data() + i * part_frame_size, part_frame_size, part_id, part_bytes.data());
+    }
+}
+
+DecodeResult ImageDecoder::DecodeFrame(const Symbols& symbols) {
+    if (m_frame_part_num == 1) return m_symbol_codec->Decode(symbols);
+    DecodeResults results;
+    DecodeParts(symbols, results);
+    auto result = std::move(results[0]);
+    for (const auto& e : results) {
+        std::get<0>(result) = std::get<0>(result) && std::get<0>(e);
+    }
+    return result;
+}
+
+ImageDecodeResult ImageDecoder::DecodeTransformed(cv::Mat img1, const Transform& transform, const Calibration& calibration, bool result_image) {
+    Symbols symbols;
+    std::vector<std::vector<cv::Mat>> result_imgs;
+    if (!GetTransformedSymbols(img1, transform, calibration, result_image, symbols, result_imgs)) return std::make_tuple(false, 0, Bytes(), std::move(symbols), std::move(img1), std::move(result_imgs));
+    auto [success, part_id, part_bytes] = DecodeFrame(symbols);
+    return std::make_tuple(success, part_id, std::move(part_bytes), std::move(symbols), std::move(img1), std::move(result_imgs));
+}
+
+bool ImageDecoder::GetTransformedSymbols(cv::Mat& img1, const Transform& transform, const Calibration& calibration, bool result_image, Symbols& symbols, std::vector<std::vector<cv::Mat>>& result_imgs) {
+    auto [tile_x_num, tile_y_num, tile_x_size, tile_y_size] = m_dim;
+    result_imgs.resize(tile_y_num);
+    for (auto& e : result_imgs) e.resize(tile_x_num);
+    PixelClassifier pixel_classifier(m_symbol_codec->GetSymbolType(), transform.pixelization_threshold);
+    if (calibration.valid) {
+        symbols = get_tile_symbols(img1, pixel_classifier, calibration);
         if (result_image) {
-            result_imgs[0][0] = get_result_image(img1, m_dim, calibration, symbols);
+            result_imgs[0][0] = get_result_image(img1, calibration, symbols);
         }
     } else {
         img1 = do_auto_quad(img1, transform.binarization_threshold);
-        cv::Mat img1_b = do_binarize(img1, transform.binarization_threshold);
-        auto [tiling_success, tile_bboxes] = get_tile_bboxes(img1_b, tile_x_num, tile_y_num);
-        if (!tiling_success) return std::make_tuple(false, 0, Bytes(), std::move(symbols), std::move(img1), std::move(result_imgs));
+        auto [tiling_success, tile_imgs] = get_tile_images(img1, m_dim, transform.binarization_threshold);
+        if (!tiling_success) return false;
         for (int tile_y_id = 0; tile_y_id < tile_y_num; ++tile_y_id) {
             for (int tile_x_id = 0; tile_x_id < tile_x_num; ++tile_x_id) {
-                cv::Mat tile_img = do_crop(img1, tile_bboxes[tile_y_id][tile_x_id]);
-                cv::Mat tile_img1 = do_auto_quad(tile_img, transform.binarization_threshold);
+                const auto& [tile_img1, bbox2, tile_img2] = tile_imgs[tile_y_id * tile_x_num + tile_x_id];
                 std::array<int, 4> bbox1 = {0, 0, tile_img1.cols, tile_img1.rows};
-                std::array<int, 4> bbox2 = get_tile_bbox2(bbox1, tile_x_size, tile_y_size);
-                cv::Mat tile_img2 = do_crop(tile_img1, bbox2);
-                tile_img2 = do_pixelize(tile_img2, m_symbol_codec->GetSymbolType(), transform.pixelization_threshold);
-                Symbols tile_symbols = get_tile_symbols(tile_img2, tile_x_size, tile_y_size);
+                Symbols tile_symbols = get_tile_symbols(tile_img2, pixel_classifier, tile_x_size, tile_y_size);
                 symbols.insert(symbols.end(), tile_symbols.begin(), tile_symbols.end());
                 if (result_image) {
                     result_imgs[tile_y_id][tile_x_id] = get_result_image(tile_img1, tile_x_size, tile_y_size, bbox1, bbox2, tile_symbols);
@@ -457,6 +801,49 @@ ImageDecodeResult ImageDecoder::Decode(const cv::Mat& img, const Transform& tran
             }
         }
     }
-    auto [success, part_id, part_bytes] = m_symbol_codec->Decode(symbols);
-    return std::make_tuple(success, part_id, std::move(part_bytes), std::move(symbols), std::move(img1), std::move(result_imgs));
+    return true;
+}
+
+bool ImageDecoder::ExtractSamples(const cv::Mat& img, const Transform& transform, const Calibration& calibration, SampleMap& sample_map, SymbolSamples& samples) {
+    auto [tile_x_num, tile_y_num, tile_x_size, tile_y_size] = m_dim;
+    samples.bgrs.clear();
+    samples.sample_nums.clear();
+    if (SampleMap::IsApplicable(transform, calibration)) {
+        sample_map.Update(img, transform, calibration);
+        append_mapped_samples(img, sample_map, samples);
+        return true;
+    }
+    if (calibration.valid && append_filtered_samples(img, transform, calibration, sample_map.transform_cache, samples)) {
+        return true;
+    }
+    cv::Mat img1 = transform_image(img, transform, sample_map.transform_cache);
+    if (calibration.valid) {
+        const float* center_xs = calibration.CenterXs();
+        const float* center_ys = calibration.CenterYs();
+        for (size_t i = 0; i < calibration.CenterNum(); ++i) {
+            append_samples(img1, center_xs[i], center_ys[i], samples);
+        }
+        return true;
+    }
+    img1 = do_auto_quad(img1, transform.binarization_threshold);
+    auto [tiling_success, tile_imgs] = get_tile_images(img1, m_dim, transform.binarization_threshold);
+    if (!tiling_success) return false;
+    for (const auto& [tile_img1, bbox2, tile_img2] : tile_imgs) {
+        append_tile_samples(tile_img2, tile_x_size, tile_y_size, samples);
+    }
+    return true;
+}
+
+ImageDecodeResult ImageDecoder::DecodeSamples(const SymbolSamples& samples, const Transform::PixelizationThreshold& pixelization_threshold) {
+    PixelClassifier pixel_classifier(m_symbol_codec->GetSymbolType(), pixelization_threshold);
+    Symbols symbols;
+    get_sample_symbols(samples, pixel_classifier, symbols);
+    auto [success, part_id, part_bytes] = DecodeFrame(symbols);
+    return std::make_tuple(success, part_id, std::move(part_bytes), std::move(symbols), cv::Mat(), std::vector<std::vector<cv::Mat>>());
+}
+
+void ImageDecoder::DecodeSamples(const SymbolSamples& samples, const Transform::PixelizationThreshold& pixelization_threshold, Symbols& symbols, DecodeResults& results) {
+    PixelClassifier pixel_classifier(m_symbol_codec->GetSymbolType(), pixelization_threshold);
+    get_sample_symbols(samples, pixel_classifier, symbols);
+    DecodeParts(symbols, results);
 }
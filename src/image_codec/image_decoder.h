@@ -1,35 +1,115 @@
 #pragma once
 
+#include <atomic>
+
 #include "image_codec_api.h"
 #include "image_codec_types.h"
 #include "transform_utils.h"
 #include "symbol_codec.h"
 
-struct TileCalibration {
-    std::vector<std::vector<std::array<float, 2>>> centers;
-};
-
 struct Calibration {
+    static constexpr uint32_t FILE_MAGIC = 0x4143424c;
+    static constexpr uint32_t FILE_VERSION = 2;
+
+    struct FileHeader {
+        uint32_t magic = FILE_MAGIC;
+        uint32_t version = FILE_VERSION;
+        int32_t valid = 0;
+        Dim dim;
+        uint32_t center_num = 0;
+    };
+
     bool valid = false;
     Dim dim;
-    std::vector<std::vector<TileCalibration>> tiles;
 
+    IMAGE_CODEC_API void Init(const Dim& dim, std::vector<float> center_xs, std::vector<float> center_ys);
     IMAGE_CODEC_API void Load(const std::string& path);
     IMAGE_CODEC_API void Save(const std::string& path);
+
+    // changes whenever the centers change, copies share it as they share the centers
+    uint64_t Generation() const { return m_generation; }
+    size_t CenterNum() const { return m_center_num; }
+    const float* CenterXs() const { return m_center_xs; }
+    const float* CenterYs() const { return m_center_ys; }
+
+private:
+    static uint64_t NextGeneration();
+    void LoadV1(const std::string& path);
+
+    uint64_t m_generation = NextGeneration();
+    size_t m_center_num = 0;
+    const float* m_center_xs = nullptr;
+    const float* m_center_ys = nullptr;
+    std::shared_ptr<const void> m_center_storage;
+};
+
+struct SampleMap {
+    static constexpr int SAMPLE_NUM_PER_SYMBOL = 9;
+    static constexpr int32_t SAMPLE_NONE = -1;
+    static constexpr int32_t SAMPLE_BORDER = -2;
+
+    uint64_t calibration_generation = 0;
+    size_t frame_step = 0;
+    TransformCache transform_cache;
+    std::vector<int32_t> offsets;
+
+    IMAGE_CODEC_API static bool IsApplicable(const Transform& transform, const Calibration& calibration);
+    IMAGE_CODEC_API bool IsUpToDate(const cv::Mat& img, const Transform& transform, const Calibration& calibration) const;
+    IMAGE_CODEC_API void Update(const cv::Mat& img, const Transform& transform, const Calibration& calibration);
+};
+
+struct SymbolSamples {
+    std::vector<cv::Vec3b> bgrs;
+    std::vector<uint8_t> sample_nums;
+};
+
+struct DecodeScratch {
+    SampleMap sample_map;
+    SymbolSamples samples;
+    Symbols symbols;
+    SymbolSoftInfos soft_infos;
+};
+
+struct ChaseStats {
+    uint64_t retry_frame_num = 0;
+    uint64_t rescued_frame_num = 0;
 };
 
 using CalibrateResult = std::tuple<cv::Mat, Calibration, std::vector<std::vector<cv::Mat>>>;
+// for frames carrying several parts, success means every part decodes and part_id and part bytes are those of the first part
 using ImageDecodeResult = std::tuple<bool, uint32_t, Bytes, Symbols, cv::Mat, std::vector<std::vector<cv::Mat>>>;
 
 class ImageDecoder {
 public:
-    IMAGE_CODEC_API ImageDecoder(SymbolType symbol_type, const Dim& dim);
+    IMAGE_CODEC_API ImageDecoder(SymbolType symbol_type, const Dim& dim, int frame_part_num = 1);
     IMAGE_CODEC_API SymbolCodec& GetSymbolCodec() { return *m_symbol_codec; }
     IMAGE_CODEC_API const Dim& GetDim() { return m_dim; }
+    IMAGE_CODEC_API int FramePartNum() const { return m_frame_part_num; }
+    IMAGE_CODEC_API const Dim& GetPartDim() { return m_part_dim; }
+    // must be set before decoding starts
+    IMAGE_CODEC_API void SetChaseConfig(const ChaseConfig& chase_config) { m_chase_config = chase_config; }
+    IMAGE_CODEC_API ChaseStats GetChaseStats() const { return {m_chase_retry_frame_num.load(), m_chase_rescued_frame_num.load()}; }
     IMAGE_CODEC_API CalibrateResult Calibrate(const cv::Mat& img, const Transform& transform, bool result_image = false);
     IMAGE_CODEC_API ImageDecodeResult Decode(const cv::Mat& img, const Transform& transform, const Calibration& calibration, bool result_image = false);
+    IMAGE_CODEC_API ImageDecodeResult Decode(const cv::Mat& img, const Transform& transform, const Calibration& calibration, SampleMap& sample_map);
+    // results get one entry per part of the frame
+    IMAGE_CODEC_API void DecodeInto(const cv::Mat& img, const Transform& transform, const Calibration& calibration, DecodeScratch& scratch, DecodeResults& results);
+    IMAGE_CODEC_API void DecodeBatch(const std::vector<cv::Mat>& imgs, const Transform& transform, const Calibration& calibration, DecodeScratch& scratch, std::vector<DecodeResults>& results);
+    IMAGE_CODEC_API void DecodeParts(const Symbols& symbols, DecodeResults& results);
+    IMAGE_CODEC_API bool ExtractSamples(const cv::Mat& img, const Transform& transform, const Calibration& calibration, SampleMap& sample_map, SymbolSamples& samples);
+    IMAGE_CODEC_API ImageDecodeResult DecodeSamples(const SymbolSamples& samples, const Transform::PixelizationThreshold& pixelization_threshold);
+    IMAGE_CODEC_API void DecodeSamples(const SymbolSamples& samples, const Transform::PixelizationThreshold& pixelization_threshold, Symbols& symbols, DecodeResults& results);
 
 private:
+    ImageDecodeResult DecodeTransformed(cv::Mat img1, const Transform& transform, const Calibration& calibration, bool result_image);
+    bool GetTransformedSymbols(cv::Mat& img1, const Transform& transform, const Calibration& calibration, bool result_image, Symbols& symbols, std::vector<std::vector<cv::Mat>>& result_imgs);
+    DecodeResult DecodeFrame(const Symbols& symbols);
+
     std::unique_ptr<SymbolCodec> m_symbol_codec;
     Dim m_dim;
+    int m_frame_part_num;
+    Dim m_part_dim;
+    ChaseConfig m_chase_config;
+    std::atomic<uint64_t> m_chase_retry_frame_num = 0;
+    std::atomic<uint64_t> m_chase_rescued_frame_num = 0;
 };
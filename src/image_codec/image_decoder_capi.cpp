@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <exception>
+
+#include "image_codec_api.h"
+#include "image_codec_types.h"
+#include "image_decoder.h"
+
+namespace {
+
+Transform get_transform(const float* bbox, const float* sphere, int filter_level, int binarization_threshold, const int* pixelization_threshold) {
+    Transform transform;
+    std::copy_n(bbox, transform.bbox.size(), transform.bbox.begin());
+    std::copy_n(sphere, transform.sphere.size(), transform.sphere.begin());
+    transform.filter_level = filter_level;
+    transform.binarization_threshold = binarization_threshold;
+    std::copy_n(pixelization_threshold, transform.pixelization_threshold.size(), transform.pixelization_threshold.begin());
+    return transform;
+}
+
+}
+
+extern "C" {
+
+// returns null if the symbol type or the dim is rejected, exceptions must not cross into the caller
+IMAGE_CODEC_API void* create_image_decoder_c(const char* symbol_type_str, int tile_x_num, int tile_y_num, int tile_x_size, int tile_y_size, int frame_part_num) {
+    try {
+        return new ImageDecoder(parse_symbol_type(symbol_type_str), {tile_x_num, tile_y_num, tile_x_size, tile_y_size}, frame_part_num);
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+}
+
+IMAGE_CODEC_API int image_decoder_frame_part_num_c(void* image_decoder) {
+    return reinterpret_cast<ImageDecoder*>(image_decoder)->FramePartNum();
+}
+
+IMAGE_CODEC_API int image_decoder_padded_part_byte_num_c(void* image_decoder) {
+    auto decoder = reinterpret_cast<ImageDecoder*>(image_decoder);
+    const Dim& part_dim = decoder->GetPartDim();
+    return decoder->GetSymbolCodec().PaddedPartByteNum(static_cast<size_t>(part_dim.tile_x_num) * part_dim.tile_y_num * part_dim.tile_x_size * part_dim.tile_y_size);
+}
+
+IMAGE_CODEC_API void destroy_image_decoder_c(void* image_decoder) {
+    delete reinterpret_cast<ImageDecoder*>(image_decoder);
+}
+
+// centers are in tile_y, tile_x, y, x order, decoding caches samples by calibration generation so a calibration created at the address of a destroyed one isn't mistaken for it,
+// returns null unless there is exactly one center per symbol of the dim
+IMAGE_CODEC_API void* create_calibration_c(int tile_x_num, int tile_y_num, int tile_x_size, int tile_y_size, const float* center_xs, const float* center_ys, size_t center_num) {
+    if (tile_x_num <= 0 || tile_y_num <= 0 || tile_x_size <= 0 || tile_y_size <= 0) return nullptr;
+    if (center_num != static_cast<size_t>(tile_x_num) * tile_y_num * tile_x_size * tile_y_size) return nullptr;
+    auto calibration = new Calibration;
+    calibration->Init({tile_x_num, tile_y_num, tile_x_size, tile_y_size}, std::vector<float>(center_xs, center_xs + center_num), std::vector<float>(center_ys, center_ys + center_num));
+    return calibration;
+}
+
+IMAGE_CODEC_API void destroy_calibration_c(void* calibration) {
+    delete reinterpret_cast<Calibration*>(calibration);
+}
+
+// bgr_p points to height rows of width bgr pixels spaced stride bytes apart and is not copied,
+// calibration may be null to locate tiles by their borders,
+// success_p and part_id_p get one entry per part of the frame and part_byte_p gets the parts at a stride of the padded part byte num,
+// returns 0 on success and -1 if decoding threw, in which case every part is marked as failed
+IMAGE_CODEC_API int image_decoder_decode_c(void* image_decoder, bool* success_p, uint32_t* part_id_p, Byte* part_byte_p, const Byte* bgr_p, int width, int height, size_t stride, const float* bbox, const float* sphere, int filter_level, int binarization_threshold, const int* pixelization_threshold, const void* calibration) {
+    thread_local DecodeScratch scratch;
+    thread_local DecodeResults results;
+    thread_local Calibration no_calibration;
+    auto decoder = reinterpret_cast<ImageDecoder*>(image_decoder);
+    try {
+        cv::Mat img(height, width, CV_8UC3, const_cast<Byte*>(bgr_p), stride);
+        Transform transform = get_transform(bbox, sphere, filter_level, binarization_threshold, pixelization_threshold);
+        decoder->DecodeInto(img, transform, calibration ? *reinterpret_cast<const Calibration*>(calibration) : no_calibration, scratch, results);
+    } catch (const std::exception&) {
+        std::fill_n(success_p, decoder->FramePartNum(), false);
+        return -1;
+    }
+    size_t padded_part_byte_num = image_decoder_padded_part_byte_num_c(image_decoder);
+    for (int i = 0; i < decoder->FramePartNum(); ++i) {
+        const auto& [success, part_id, part_bytes] = results[i];
+        success_p[i] = success;
+        part_id_p[i] = part_id;
+        if (success) std::copy_n(part_bytes.begin(), std::min(part_bytes.size(), padded_part_byte_num), part_byte_p + i * padded_part_byte_num);
+    }
+    return 0;
+}
+
+}
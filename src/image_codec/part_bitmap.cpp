@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <string>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "part_bitmap.h"
+
+namespace {
+
+int popcount64(uint64_t v) {
+#if defined(_MSC_VER)
+    return static_cast<int>(__popcnt64(v));
+#else
+    return __builtin_popcountll(v);
+#endif
+}
+
+// v should not be 0
+int ctz64(uint64_t v) {
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward64(&index, v);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(v);
+#endif
+}
+
+// position of the set bit with rank index, v should have more than index set bits
+int select64(uint64_t v, int index) {
+    for (int i = 0; i < index; ++i) v &= v - 1;
+    return ctz64(v);
+}
+
+}
+
+PartBitmap::PartBitmap(uint32_t part_num) : m_part_num(part_num) {
+    m_words.resize((static_cast<size_t>(part_num) + BLOCK_PART_NUM - 1) / BLOCK_PART_NUM * BLOCK_WORD_NUM, 0);
+    InitSummary();
+}
+
+PartBitmap::PartBitmap(const Bytes& task_status_bytes, uint32_t part_num) : m_part_num(part_num) {
+    size_t byte_num = (static_cast<size_t>(part_num) + 7) / 8;
+    if (task_status_bytes.size() < byte_num) throw invalid_image_codec_argument("invalid task status bytes of size '" + std::to_string(task_status_bytes.size()) + "' for part_num '" + std::to_string(part_num) + "'");
+    m_words.resize((static_cast<size_t>(part_num) + BLOCK_PART_NUM - 1) / BLOCK_PART_NUM * BLOCK_WORD_NUM, 0);
+    for (size_t i = 0; i < byte_num; ++i) {
+        m_words[i / 8] |= static_cast<uint64_t>(task_status_bytes[i]) << (i % 8 * 8);
+    }
+    InitSummary();
+}
+
+void PartBitmap::InitSummary() {
+    size_t padded_part_num = m_words.size() * WORD_PART_NUM;
+    if (m_part_num % WORD_PART_NUM) m_words[m_part_num / WORD_PART_NUM] |= ~0ull << (m_part_num % WORD_PART_NUM);
+    std::fill(m_words.begin() + (static_cast<size_t>(m_part_num) + WORD_PART_NUM - 1) / WORD_PART_NUM, m_words.end(), ~0ull);
+    size_t block_num = m_words.size() / BLOCK_WORD_NUM;
+    m_block_done_nums.assign(block_num, 0);
+    m_full_blocks.assign((block_num + 63) / 64, 0);
+    if (block_num % 64) m_full_blocks.back() = ~0ull << (block_num % 64);
+    size_t done_part_num = 0;
+    for (size_t block = 0; block < block_num; ++block) {
+        int block_done_num = 0;
+        for (size_t i = block * BLOCK_WORD_NUM; i < (block + 1) * BLOCK_WORD_NUM; ++i) {
+            block_done_num += popcount64(m_words[i]);
+        }
+        m_block_done_nums[block] = static_cast<uint16_t>(block_done_num);
+        if (block_done_num == BLOCK_PART_NUM) m_full_blocks[block / 64] |= 0x1ull << (block % 64);
+        done_part_num += block_done_num;
+    }
+    m_done_part_num = static_cast<uint32_t>(done_part_num - (padded_part_num - m_part_num));
+    m_block_undone_ranks_dirty = true;
+}
+
+bool PartBitmap::SetDone(uint32_t part_id) {
+    uint64_t& word = m_words[part_id / WORD_PART_NUM];
+    uint64_t mask = 0x1ull << (part_id % WORD_PART_NUM);
+    if (word & mask) return false;
+    word |= mask;
+    size_t block = part_id / BLOCK_PART_NUM;
+    if (++m_block_done_nums[block] == BLOCK_PART_NUM) m_full_blocks[block / 64] |= 0x1ull << (block % 64);
+    m_done_part_num += 1;
+    m_block_undone_ranks_dirty = true;
+    return true;
+}
+
+// full blocks are skipped 64 at a time through m_full_blocks
+uint32_t PartBitmap::NextUndone(uint32_t part_id) const {
+    if (part_id >= m_part_num) return m_part_num;
+    size_t word_index = part_id / WORD_PART_NUM;
+    uint64_t word = ~m_words[word_index] & (~0ull << (part_id % WORD_PART_NUM));
+    size_t block = word_index / BLOCK_WORD_NUM;
+    while (!word) {
+        if (++word_index == (block + 1) * BLOCK_WORD_NUM) {
+            ++block;
+            size_t full_blocks_index = block / 64;
+            if (full_blocks_index >= m_full_blocks.size()) return m_part_num;
+            uint64_t undone_blocks = ~m_full_blocks[full_blocks_index] & (~0ull << (block % 64));
+            while (!undone_blocks) {
+                if (++full_blocks_index == m_full_blocks.size()) return m_part_num;
+                undone_blocks = ~m_full_blocks[full_blocks_index];
+            }
+            block = full_blocks_index * 64 + ctz64(undone_blocks);
+            word_index = block * BLOCK_WORD_NUM;
+        }
+        word = ~m_words[word_index];
+    }
+    return static_cast<uint32_t>(word_index * WORD_PART_NUM + ctz64(word));
+}
+
+// blocks without done parts are skipped by their done count
+uint32_t PartBitmap::NextDone(uint32_t part_id) const {
+    if (part_id >= m_part_num) return m_part_num;
+    size_t word_index = part_id / WORD_PART_NUM;
+    uint64_t word = m_words[word_index] & (~0ull << (part_id % WORD_PART_NUM));
+    size_t block = word_index / BLOCK_WORD_NUM;
+    while (!word) {
+        if (++word_index == (block + 1) * BLOCK_WORD_NUM) {
+            ++block;
+            while (block < m_block_done_nums.size() && m_block_done_nums[block] == 0) ++block;
+            if (block == m_block_done_nums.size()) return m_part_num;
+            word_index = block * BLOCK_WORD_NUM;
+        }
+        word = m_words[word_index];
+    }
+    return static_cast<uint32_t>(std::min<size_t>(word_index * WORD_PART_NUM + ctz64(word), m_part_num));
+}
+
+void PartBitmap::UpdateUndoneRanks() const {
+    if (!m_block_undone_ranks_dirty) return;
+    m_block_undone_ranks.resize(m_block_done_nums.size());
+    uint32_t undone_rank = 0;
+    for (size_t block = 0; block < m_block_done_nums.size(); ++block) {
+        m_block_undone_ranks[block] = undone_rank;
+        undone_rank += BLOCK_PART_NUM - m_block_done_nums[block];
+    }
+    m_block_undone_ranks_dirty = false;
+}
+
+uint32_t PartBitmap::UndoneRank(uint32_t part_id) const {
+    if (part_id >= m_part_num) return UndonePartNum();
+    UpdateUndoneRanks();
+    size_t word_index = part_id / WORD_PART_NUM;
+    size_t block = part_id / BLOCK_PART_NUM;
+    uint32_t undone_rank = m_block_undone_ranks[block];
+    for (size_t i = block * BLOCK_WORD_NUM; i < word_index; ++i) {
+        undone_rank += popcount64(~m_words[i]);
+    }
+    return undone_rank + popcount64(~m_words[word_index] & ((0x1ull << (part_id % WORD_PART_NUM)) - 1));
+}
+
+uint32_t PartBitmap::SelectUndone(uint32_t index) const {
+    UpdateUndoneRanks();
+    size_t block = std::upper_bound(m_block_undone_ranks.begin(), m_block_undone_ranks.end(), index) - m_block_undone_ranks.begin() - 1;
+    int left_num = static_cast<int>(index - m_block_undone_ranks[block]);
+    size_t word_index = block * BLOCK_WORD_NUM;
+    while (true) {
+        int word_undone_num = popcount64(~m_words[word_index]);
+        if (left_num < word_undone_num) break;
+        left_num -= word_undone_num;
+        ++word_index;
+    }
+    return static_cast<uint32_t>(word_index * WORD_PART_NUM + select64(~m_words[word_index], left_num));
+}
+
+Bytes PartBitmap::ToBytes() const {
+    Bytes bytes((static_cast<size_t>(m_part_num) + 7) / 8);
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        bytes[i] = static_cast<Byte>(m_words[i / 8] >> (i % 8 * 8));
+    }
+    // padding bits of the last byte stay clear as in the task status
+    if (m_part_num % 8) bytes.back() &= static_cast<Byte>((0x1 << (m_part_num % 8)) - 1);
+    return bytes;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+
+#include "image_codec_api.h"
+#include "image_codec_types.h"
+
+// done bits of the parts, one bit per part with a small summary for skipping done parts and ranking undone parts
+// the words are grouped in blocks of BLOCK_PART_NUM parts, each block keeps its done count and a second level bitmap marks full blocks
+class PartBitmap {
+public:
+    static constexpr uint32_t WORD_PART_NUM = 64;
+    static constexpr uint32_t BLOCK_WORD_NUM = 64;
+    static constexpr uint32_t BLOCK_PART_NUM = WORD_PART_NUM * BLOCK_WORD_NUM;
+
+    IMAGE_CODEC_API explicit PartBitmap(uint32_t part_num = 0);
+    // task_status_bytes has the layout of the task status, bit i of byte j marks part j * 8 + i as done
+    IMAGE_CODEC_API PartBitmap(const Bytes& task_status_bytes, uint32_t part_num);
+    IMAGE_CODEC_API uint32_t PartNum() const { return m_part_num; }
+    IMAGE_CODEC_API uint32_t DonePartNum() const { return m_done_part_num; }
+    IMAGE_CODEC_API uint32_t UndonePartNum() const { return m_part_num - m_done_part_num; }
+    IMAGE_CODEC_API bool IsDone(uint32_t part_id) const { return m_words[part_id / WORD_PART_NUM] >> (part_id % WORD_PART_NUM) & 0x1; }
+    // returns false if the part was done already
+    IMAGE_CODEC_API bool SetDone(uint32_t part_id);
+    // first undone part id not less than part_id, PartNum() if there is none
+    IMAGE_CODEC_API uint32_t NextUndone(uint32_t part_id) const;
+    // first done part id not less than part_id, PartNum() if there is none
+    IMAGE_CODEC_API uint32_t NextDone(uint32_t part_id) const;
+    // number of undone parts before part_id
+    IMAGE_CODEC_API uint32_t UndoneRank(uint32_t part_id) const;
+    // part id of the undone part with rank index, index should be less than UndonePartNum()
+    IMAGE_CODEC_API uint32_t SelectUndone(uint32_t index) const;
+    IMAGE_CODEC_API Bytes ToBytes() const;
+
+    // calls fn(first_part_id, end_part_id) for every run of undone parts in order
+    template <typename Fn>
+    void ForEachUndoneRange(Fn fn) const {
+        uint32_t part_id = NextUndone(0);
+        while (part_id < m_part_num) {
+            uint32_t end_part_id = NextDone(part_id);
+            fn(part_id, end_part_id);
+            if (end_part_id == m_part_num) break;
+            part_id = NextUndone(end_part_id);
+        }
+    }
+
+private:
+    void InitSummary();
+    void UpdateUndoneRanks() const;
+
+    uint32_t m_part_num = 0;
+    uint32_t m_done_part_num = 0;
+    // bits past m_part_num are set so they are never reported as undone
+    std::vector<uint64_t> m_words;
+    std::vector<uint16_t> m_block_done_nums;
+    std::vector<uint64_t> m_full_blocks;
+    // undone parts before each block, rebuilt on the first rank query after a change
+    mutable std::vector<uint32_t> m_block_undone_ranks;
+    mutable bool m_block_undone_ranks_dirty = true;
+};
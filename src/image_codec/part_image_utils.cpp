@@ -3,6 +3,7 @@
 #include "part_image_utils.h"
 #include "base64.h"
 #include "image_decode_task.h"
+#include "pixel_classifier.h"
 
 namespace {
 
@@ -10,9 +11,9 @@ bool is_tile_border(int tile_x_size, int tile_y_size, int x, int y) {
     return y == 0 || y == tile_y_size + 1 || x == 0 || x == tile_x_size + 1;
 }
 
-cv::Mat generate_part_image(const Dim& dim, int pixel_size, int space_size, SymbolCodec* symbol_codec, uint32_t part_id, const Bytes& part_bytes) {
+cv::Mat generate_part_image(const Dim& dim, int pixel_size, int space_size, SymbolCodec* symbol_codec, const std::vector<std::pair<uint32_t, Bytes>>& parts) {
     auto [tile_x_num, tile_y_num, tile_x_size, tile_y_size] = dim;
-    auto symbols = symbol_codec->Encode(part_id, part_bytes, tile_x_num * tile_y_num * tile_x_size * tile_y_size);
+    auto symbols = encode_frame(symbol_codec, dim, parts);
     int img_h = (tile_y_num * (tile_y_size + 2) + (tile_y_num - 1) * space_size + 2) * pixel_size;
     int img_w = (tile_x_num * (tile_x_size + 2) + (tile_x_num - 1) * space_size + 2) * pixel_size;
     cv::Mat img(img_h, img_w, CV_8UC3);
@@ -31,22 +32,8 @@ cv::Mat generate_part_image(const Dim& dim, int pixel_size, int space_size, Symb
                         color = cv::Scalar(0, 0, 0);
                     } else {
                         auto symbol = symbols[((tile_y_id * tile_x_num + tile_x_id) * tile_y_size + (y - 1)) * tile_x_size + (x - 1)];
-                        if (symbol == static_cast<int>(PixelColor::WHITE)) {
-                            color = cv::Scalar(255, 255, 255);
-                        } else if (symbol == static_cast<int>(PixelColor::BLACK)) {
-                            color = cv::Scalar(0, 0, 0);
-                        } else if (symbol == static_cast<int>(PixelColor::RED)) {
-                            color = cv::Scalar(0, 0, 255);
-                        } else if (symbol == static_cast<int>(PixelColor::BLUE)) {
-                            color = cv::Scalar(255, 0, 0);
-                        } else if (symbol == static_cast<int>(PixelColor::GREEN)) {
-                            color = cv::Scalar(0, 255, 0);
-                        } else if (symbol == static_cast<int>(PixelColor::CYAN)) {
-                            color = cv::Scalar(255, 255, 0);
-                        } else if (symbol == static_cast<int>(PixelColor::MAGENTA)) {
-                            color = cv::Scalar(255, 0, 255);
-                        } else if (symbol == static_cast<int>(PixelColor::YELLOW)) {
-                            color = cv::Scalar(0, 255, 255);
+                        if (symbol < static_cast<int>(PixelColor::UNKNOWN)) {
+                            color = get_pixel_color_bgr(static_cast<PixelColor>(symbol));
                         }
                     }
                     cv::rectangle(img, cv::Rect(tile_x + x * pixel_size, tile_y + y * pixel_size, pixel_size, pixel_size), color, cv::FILLED);
@@ -70,23 +57,48 @@ Bytes img_to_msg_bytes(const cv::Mat& img) {
 
 }
 
-std::tuple<std::unique_ptr<SymbolCodec>, int, Bytes, uint32_t> prepare_part_images(const std::string& target_file, SymbolType symbol_type, const Dim& dim) {
+Symbols encode_frame(SymbolCodec* symbol_codec, const Dim& dim, const std::vector<std::pair<uint32_t, Bytes>>& parts) {
+    size_t frame_size = static_cast<size_t>(dim.tile_x_num) * dim.tile_y_num * dim.tile_x_size * dim.tile_y_size;
+    size_t part_frame_size = frame_size / parts.size();
+    Symbols symbols(frame_size);
+    for (size_t i = 0; i < parts.size(); ++i) {
+        const auto& [part_id, part_bytes] = parts[i];
+        symbol_codec->Encode(part_id, part_bytes.data(), part_bytes.size(), symbols.data() + i * part_frame_size, part_frame_size);
+    }
+    return symbols;
+}
+
+std::tuple<std::unique_ptr<SymbolCodec>, int, Bytes, uint32_t> prepare_part_images(const std::string& target_file, SymbolType symbol_type, const Dim& dim, int frame_part_num, CompressionType compression_type) {
     auto symbol_codec = create_symbol_codec(symbol_type);
-    auto part_byte_num = get_part_byte_num(symbol_type, dim);
+    auto part_byte_num = get_part_byte_num(symbol_type, get_part_dim(dim, frame_part_num));
     if (part_byte_num < Task::MIN_PART_BYTE_NUM) throw invalid_image_codec_argument("invalid part_byte_num '" + std::to_string(part_byte_num) + "'");
-    auto [raw_bytes, part_num] = get_task_bytes(target_file, part_byte_num);
+    auto [raw_bytes, part_num] = get_task_bytes(target_file, part_byte_num, compression_type);
     std::cout << part_num << " parts\n";
     return std::make_tuple(std::move(symbol_codec), part_byte_num, std::move(raw_bytes), part_num);
 }
 
-GenPartImageFn1 generate_part_images(const Dim& dim, int pixel_size, int space_size, SymbolCodec* symbol_codec, int part_byte_num, const Bytes& raw_bytes, uint32_t part_num) {
+GenPartImageFn1 generate_part_images(const Dim& dim, int pixel_size, int space_size, SymbolCodec* symbol_codec, int part_byte_num, const Bytes& raw_bytes, uint32_t part_num, int frame_part_num, const SparseMap* sparse_map) {
     uint32_t cur_part_id = 0;
-    return [dim, pixel_size, space_size, symbol_codec, part_byte_num, &raw_bytes, part_num, cur_part_id]() mutable {
-        if (cur_part_id < part_num) {
+    uint32_t displayed_part_num = sparse_map ? sparse_map->DisplayedPartNum() : part_num;
+    return [dim, pixel_size, space_size, symbol_codec, part_byte_num, &raw_bytes, displayed_part_num, frame_part_num, sparse_map, cur_part_id]() mutable {
+        if (cur_part_id < displayed_part_num) {
             auto part_id = cur_part_id;
-            Bytes part_bytes(raw_bytes.begin()+part_id*static_cast<size_t>(part_byte_num), raw_bytes.begin()+(part_id+1)*static_cast<size_t>(part_byte_num));
-            auto img = generate_part_image(dim, pixel_size, space_size, symbol_codec, part_id, part_bytes);
-            ++cur_part_id;
+            // the last frame is filled up with parts from the beginning
+            std::vector<std::pair<uint32_t, Bytes>> parts;
+            for (int i = 0; i < frame_part_num; ++i) {
+                uint32_t part_id1 = (part_id + i) % displayed_part_num;
+                if (sparse_map) {
+                    const auto& map_parts = sparse_map->MapParts();
+                    if (part_id1 < map_parts.size()) {
+                        parts.push_back(map_parts[part_id1]);
+                        continue;
+                    }
+                    part_id1 = sparse_map->PartIds()[part_id1 - map_parts.size()];
+                }
+                parts.emplace_back(part_id1, Bytes(raw_bytes.begin()+part_id1*static_cast<size_t>(part_byte_num), raw_bytes.begin()+(part_id1+1)*static_cast<size_t>(part_byte_num)));
+            }
+            auto img = generate_part_image(dim, pixel_size, space_size, symbol_codec, parts);
+            cur_part_id += frame_part_num;
             return std::make_optional<std::pair<uint32_t, cv::Mat>>({part_id, std::move(img)});
         } else {
             return std::optional<std::pair<uint32_t, cv::Mat>>();
@@ -94,6 +106,27 @@ GenPartImageFn1 generate_part_images(const Dim& dim, int pixel_size, int space_s
     };
 }
 
+Calibration get_part_image_calibration(const Dim& dim, int pixel_size, int space_size) {
+    auto [tile_x_num, tile_y_num, tile_x_size, tile_y_size] = dim;
+    std::vector<float> center_xs;
+    std::vector<float> center_ys;
+    for (int tile_y_id = 0; tile_y_id < tile_y_num; ++tile_y_id) {
+        int tile_y = (tile_y_id * (tile_y_size + 2 + space_size) + 1) * pixel_size;
+        for (int tile_x_id = 0; tile_x_id < tile_x_num; ++tile_x_id) {
+            int tile_x = (tile_x_id * (tile_x_size + 2 + space_size) + 1) * pixel_size;
+            for (int y = 0; y < tile_y_size; ++y) {
+                for (int x = 0; x < tile_x_size; ++x) {
+                    center_xs.push_back(tile_x + (x + 1) * pixel_size + static_cast<float>(pixel_size) / 2);
+                    center_ys.push_back(tile_y + (y + 1) * pixel_size + static_cast<float>(pixel_size) / 2);
+                }
+            }
+        }
+    }
+    Calibration calibration;
+    calibration.Init(dim, std::move(center_xs), std::move(center_ys));
+    return calibration;
+}
+
 std::string get_part_image_file_name(uint32_t part_num, uint32_t part_id) {
     int part_id_width = 1;
     while (true) {
@@ -8,12 +8,21 @@
 
 #include "image_codec_api.h"
 #include "image_codec_types.h"
+#include "compression.h"
+#include "sparse_map.h"
 #include "symbol_codec.h"
+#include "image_decoder.h"
 
 using GenPartImageFn1 = std::function<std::optional<std::pair<uint32_t, cv::Mat>>()>;
 using GenPartImageFn2 = std::function<std::optional<std::pair<std::string, cv::Mat>>()>;
 
-IMAGE_CODEC_API std::tuple<std::unique_ptr<SymbolCodec>, int, Bytes, uint32_t> prepare_part_images(const std::string& target_file, SymbolType symbol_type, const Dim& dim);
-IMAGE_CODEC_API GenPartImageFn1 generate_part_images(const Dim& dim, int pixel_size, int space_size, SymbolCodec* symbol_codec, int part_byte_num, const Bytes& raw_bytes, uint32_t part_num);
+// each part is encoded into its own group of tiles, see get_part_dim
+IMAGE_CODEC_API Symbols encode_frame(SymbolCodec* symbol_codec, const Dim& dim, const std::vector<std::pair<uint32_t, Bytes>>& parts);
+IMAGE_CODEC_API std::tuple<std::unique_ptr<SymbolCodec>, int, Bytes, uint32_t> prepare_part_images(const std::string& target_file, SymbolType symbol_type, const Dim& dim, int frame_part_num = 1, CompressionType compression_type = CompressionType::NONE);
+// generated images carry frame_part_num consecutive parts and are keyed by the first of them,
+// with a sparse map the map parts and the parts which are not all zero are generated instead and images are keyed by their position in that sequence
+IMAGE_CODEC_API GenPartImageFn1 generate_part_images(const Dim& dim, int pixel_size, int space_size, SymbolCodec* symbol_codec, int part_byte_num, const Bytes& raw_bytes, uint32_t part_num, int frame_part_num = 1, const SparseMap* sparse_map = nullptr);
+// pixel centers of the images of generate_part_images, for decoding them without calibrating first
+IMAGE_CODEC_API Calibration get_part_image_calibration(const Dim& dim, int pixel_size, int space_size);
 IMAGE_CODEC_API std::string get_part_image_file_name(uint32_t part_num, uint32_t part_id);
 IMAGE_CODEC_API void start_image_stream_server(GenPartImageFn2 gen_image_fn, int port);
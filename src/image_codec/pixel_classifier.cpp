@@ -0,0 +1,103 @@
+#include <vector>
+
+#include "pixel_classifier.h"
+
+namespace {
+
+constexpr int CHANNEL_B_BIT = 0x1;
+constexpr int CHANNEL_G_BIT = 0x2;
+constexpr int CHANNEL_R_BIT = 0x4;
+// the two intermediate green levels of symbol4
+constexpr int CHANNEL_G1_BIT = 0x8;
+constexpr int CHANNEL_G2_BIT = 0x10;
+
+const std::array<cv::Vec3b, static_cast<int>(PixelColor::NUM)> pixel_color_bgrs{
+    cv::Vec3b(255, 255, 255),
+    cv::Vec3b(0, 0, 0),
+    cv::Vec3b(0, 0, 255),
+    cv::Vec3b(255, 0, 0),
+    cv::Vec3b(0, 255, 0),
+    cv::Vec3b(255, 255, 0),
+    cv::Vec3b(255, 0, 255),
+    cv::Vec3b(0, 255, 255),
+    cv::Vec3b(0, 85, 0),
+    cv::Vec3b(0, 170, 0),
+    cv::Vec3b(255, 85, 0),
+    cv::Vec3b(255, 170, 0),
+    cv::Vec3b(0, 85, 255),
+    cv::Vec3b(0, 170, 255),
+    cv::Vec3b(255, 85, 255),
+    cv::Vec3b(255, 170, 255),
+    cv::Vec3b(128, 128, 128),
+};
+
+// value v of a channel falls in level l when thresholds[l-1] < v <= thresholds[l]
+void init_channel_luts(const std::vector<int>& thresholds, const std::vector<int>& level_codes, std::array<uint8_t, 256>& lut, std::array<uint8_t, 256>& alternative_lut, std::array<uint8_t, 256>& distance_lut) {
+    int threshold_num = static_cast<int>(thresholds.size());
+    for (int v = 0; v < 256; ++v) {
+        int level = 0;
+        while (level < threshold_num && v > thresholds[level]) ++level;
+        int distance = 255;
+        int alternative_level = level;
+        if (level > 0 && v - thresholds[level - 1] < distance) {
+            distance = v - thresholds[level - 1];
+            alternative_level = level - 1;
+        }
+        if (level < threshold_num && thresholds[level] - v < distance) {
+            distance = thresholds[level] - v;
+            alternative_level = level + 1;
+        }
+        lut[v] = static_cast<uint8_t>(level_codes[level]);
+        alternative_lut[v] = static_cast<uint8_t>(level_codes[alternative_level]);
+        distance_lut[v] = static_cast<uint8_t>(distance);
+    }
+}
+
+}
+
+PixelClassifier::PixelClassifier(SymbolType symbol_type, const Transform::PixelizationThreshold& pixelization_threshold) {
+    symbol_type = get_base_symbol_type(symbol_type);
+    const int channel_bits[3] = {CHANNEL_B_BIT, CHANNEL_G_BIT, CHANNEL_R_BIT};
+    for (int c = 0; c < 3; ++c) {
+        if (c == 1 && symbol_type == SymbolType::SYMBOL4) {
+            auto thresholds = get_green_level_thresholds(pixelization_threshold[c]);
+            init_channel_luts({thresholds.begin(), thresholds.end()}, {0, CHANNEL_G1_BIT, CHANNEL_G2_BIT, CHANNEL_G_BIT}, m_channel_luts[c], m_channel_alternative_luts[c], m_channel_distance_luts[c]);
+        } else {
+            init_channel_luts({pixelization_threshold[c]}, {0, channel_bits[c]}, m_channel_luts[c], m_channel_alternative_luts[c], m_channel_distance_luts[c]);
+        }
+    }
+    m_color_lut.fill(PixelColor::UNKNOWN);
+    m_color_lut[0]                                             = PixelColor::BLACK;
+    m_color_lut[CHANNEL_B_BIT]                                 = PixelColor::BLUE;
+    m_color_lut[CHANNEL_G_BIT]                                 = PixelColor::GREEN;
+    m_color_lut[CHANNEL_B_BIT | CHANNEL_G_BIT]                 = PixelColor::CYAN;
+    m_color_lut[CHANNEL_R_BIT]                                 = PixelColor::RED;
+    m_color_lut[CHANNEL_B_BIT | CHANNEL_R_BIT]                 = PixelColor::MAGENTA;
+    m_color_lut[CHANNEL_G_BIT | CHANNEL_R_BIT]                 = PixelColor::YELLOW;
+    m_color_lut[CHANNEL_B_BIT | CHANNEL_G_BIT | CHANNEL_R_BIT] = PixelColor::WHITE;
+    if (symbol_type == SymbolType::SYMBOL1) {
+        for (int code = 0; code < 8; ++code) {
+            bool multi_channel = (code & (code - 1)) != 0;
+            m_color_lut[code] = multi_channel ? PixelColor::WHITE : PixelColor::BLACK;
+        }
+    } else if (symbol_type == SymbolType::SYMBOL2) {
+        m_split_code = CHANNEL_B_BIT | CHANNEL_R_BIT;
+    } else if (symbol_type == SymbolType::SYMBOL4) {
+        m_color_lut[CHANNEL_G1_BIT]                                 = PixelColor::DARK_GREEN;
+        m_color_lut[CHANNEL_G2_BIT]                                 = PixelColor::MID_GREEN;
+        m_color_lut[CHANNEL_B_BIT | CHANNEL_G1_BIT]                 = PixelColor::ROYAL_BLUE;
+        m_color_lut[CHANNEL_B_BIT | CHANNEL_G2_BIT]                 = PixelColor::AZURE;
+        m_color_lut[CHANNEL_R_BIT | CHANNEL_G1_BIT]                 = PixelColor::VERMILION;
+        m_color_lut[CHANNEL_R_BIT | CHANNEL_G2_BIT]                 = PixelColor::ORANGE;
+        m_color_lut[CHANNEL_B_BIT | CHANNEL_R_BIT | CHANNEL_G1_BIT] = PixelColor::PINK;
+        m_color_lut[CHANNEL_B_BIT | CHANNEL_R_BIT | CHANNEL_G2_BIT] = PixelColor::LIGHT_PINK;
+    }
+}
+
+const cv::Vec3b& get_pixel_color_bgr(PixelColor pixel_color) {
+    return pixel_color_bgrs[static_cast<int>(pixel_color)];
+}
+
+std::array<int, 3> get_green_level_thresholds(int threshold) {
+    return {threshold / 3, threshold, threshold + (255 - threshold) * 2 / 3};
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <cstdlib>
+
+#include <opencv2/opencv.hpp>
+
+#include "image_codec_api.h"
+#include "image_codec_types.h"
+#include "symbol_codec.h"
+#include "transform_utils.h"
+
+class PixelClassifier {
+public:
+    IMAGE_CODEC_API PixelClassifier(SymbolType symbol_type, const Transform::PixelizationThreshold& pixelization_threshold);
+
+    PixelColor Classify(const uchar* bgr) const {
+        int code = m_channel_luts[0][bgr[0]] | m_channel_luts[1][bgr[1]] | m_channel_luts[2][bgr[2]];
+        if (code == m_split_code) {
+            return bgr[0] > bgr[2] ? PixelColor::BLUE : PixelColor::RED;
+        }
+        return m_color_lut[code];
+    }
+
+    PixelColor Classify(const cv::Vec3b& bgr) const {
+        return Classify(&bgr[0]);
+    }
+
+    // also reports the distance to the nearest decision boundary and the color on its other side
+    PixelColor ClassifySoft(const uchar* bgr, int& distance, PixelColor& alternative) const {
+        int code = m_channel_luts[0][bgr[0]] | m_channel_luts[1][bgr[1]] | m_channel_luts[2][bgr[2]];
+        PixelColor color = Resolve(code, bgr);
+        distance = 255;
+        alternative = color;
+        for (int c = 0; c < 3; ++c) {
+            int d = m_channel_distance_luts[c][bgr[c]];
+            if (d < distance) {
+                PixelColor alternative1 = Resolve(code ^ m_channel_luts[c][bgr[c]] ^ m_channel_alternative_luts[c][bgr[c]], bgr);
+                if (alternative1 != color) {
+                    distance = d;
+                    alternative = alternative1;
+                }
+            }
+        }
+        if (code == m_split_code) {
+            int d = std::abs(bgr[0] - bgr[2]);
+            if (d < distance) {
+                distance = d;
+                alternative = color == PixelColor::BLUE ? PixelColor::RED : PixelColor::BLUE;
+            }
+        }
+        return color;
+    }
+
+    PixelColor ClassifySoft(const cv::Vec3b& bgr, int& distance, PixelColor& alternative) const {
+        return ClassifySoft(&bgr[0], distance, alternative);
+    }
+
+private:
+    PixelColor Resolve(int code, const uchar* bgr) const {
+        if (code == m_split_code) {
+            return bgr[0] > bgr[2] ? PixelColor::BLUE : PixelColor::RED;
+        }
+        return m_color_lut[code];
+    }
+
+    // code bits of the level a channel value falls in, of the level across its nearest boundary and the distance to that boundary
+    std::array<std::array<uint8_t, 256>, 3> m_channel_luts;
+    std::array<std::array<uint8_t, 256>, 3> m_channel_alternative_luts;
+    std::array<std::array<uint8_t, 256>, 3> m_channel_distance_luts;
+    std::array<PixelColor, 32> m_color_lut;
+    int m_split_code = -1;
+};
+
+IMAGE_CODEC_API const cv::Vec3b& get_pixel_color_bgr(PixelColor pixel_color);
+// boundaries between the four green levels of symbol4, derived from the black and white threshold
+IMAGE_CODEC_API std::array<int, 3> get_green_level_thresholds(int threshold);
@@ -0,0 +1,231 @@
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+#include "reed_solomon.h"
+
+namespace {
+
+constexpr int GF_POLY = 0x11d;
+
+struct GfTables {
+    std::array<Byte, 512> exp{};
+    std::array<int, 256> log{};
+};
+
+constexpr GfTables get_gf_tables() {
+    GfTables tables;
+    int v = 1;
+    for (int i = 0; i < 255; ++i) {
+        tables.exp[i] = static_cast<Byte>(v);
+        tables.log[v] = i;
+        v <<= 1;
+        if (v & 0x100) v ^= GF_POLY;
+    }
+    for (int i = 255; i < 512; ++i) {
+        tables.exp[i] = tables.exp[i - 255];
+    }
+    return tables;
+}
+
+constexpr GfTables GF = get_gf_tables();
+
+using GfMulTable = std::array<std::array<Byte, 256>, 256>;
+
+GfMulTable get_gf_mul_table() {
+    GfMulTable table{};
+    for (int a = 1; a < 256; ++a) {
+        for (int b = 1; b < 256; ++b) {
+            table[a][b] = GF.exp[GF.log[a] + GF.log[b]];
+        }
+    }
+    return table;
+}
+
+const GfMulTable GF_MUL = get_gf_mul_table();
+
+Byte gf_mul(Byte a, Byte b) {
+    return GF_MUL[a][b];
+}
+
+Byte gf_div(Byte a, Byte b) {
+    if (a == 0) return 0;
+    return GF.exp[GF.log[a] + 255 - GF.log[b]];
+}
+
+Byte gf_pow_alpha(int e) {
+    e %= 255;
+    if (e < 0) e += 255;
+    return GF.exp[e];
+}
+
+// polynomials below are stored lowest degree first
+Byte evaluate_poly(const Byte* poly, int poly_size, Byte x) {
+    Byte y = 0;
+    for (int i = poly_size - 1; i >= 0; --i) {
+        y = gf_mul(y, x) ^ poly[i];
+    }
+    return y;
+}
+
+}
+
+ReedSolomon::ReedSolomon(int parity_byte_num) : m_parity_byte_num(parity_byte_num) {
+    if (parity_byte_num <= 0 || parity_byte_num >= MAX_CODEWORD_BYTE_NUM) throw std::invalid_argument("invalid reed-solomon parity byte num " + std::to_string(parity_byte_num));
+    // highest degree first, g(x) = (x - a^0)(x - a^1)...(x - a^(parity_byte_num-1))
+    m_generator.assign(1, 1);
+    for (int i = 0; i < parity_byte_num; ++i) {
+        Bytes g(m_generator.size() + 1, 0);
+        Byte root = gf_pow_alpha(i);
+        for (size_t j = 0; j < m_generator.size(); ++j) {
+            g[j] ^= m_generator[j];
+            g[j + 1] ^= gf_mul(m_generator[j], root);
+        }
+        m_generator = std::move(g);
+    }
+}
+
+void ReedSolomon::Encode(const Byte* data, int data_byte_num, Byte* parity) const {
+    std::fill(parity, parity + m_parity_byte_num, 0);
+    for (int i = 0; i < data_byte_num; ++i) {
+        Byte coef = data[i] ^ parity[0];
+        std::copy(parity + 1, parity + m_parity_byte_num, parity);
+        parity[m_parity_byte_num - 1] = 0;
+        if (coef) {
+            const auto& mul_coef = GF_MUL[coef];
+            for (int j = 0; j < m_parity_byte_num; ++j) {
+                parity[j] ^= mul_coef[m_generator[j + 1]];
+            }
+        }
+    }
+}
+
+int ReedSolomon::Decode(Byte* codeword, int codeword_byte_num) const {
+    const int n = codeword_byte_num;
+    const int nsym = m_parity_byte_num;
+    std::array<Byte, MAX_CODEWORD_BYTE_NUM> syndromes{};
+    bool has_error = false;
+    for (int i = 0; i < nsym; ++i) {
+        const auto& mul_x = GF_MUL[gf_pow_alpha(i)];
+        Byte y = 0;
+        for (int p = 0; p < n; ++p) {
+            y = mul_x[y] ^ codeword[p];
+        }
+        syndromes[i] = y;
+        has_error = has_error || y;
+    }
+    if (!has_error) return 0;
+
+    // berlekamp-massey
+    std::array<Byte, MAX_CODEWORD_BYTE_NUM + 1> locator{};
+    std::array<Byte, MAX_CODEWORD_BYTE_NUM + 1> prev_locator{};
+    std::array<Byte, MAX_CODEWORD_BYTE_NUM + 1> tmp{};
+    locator[0] = 1;
+    prev_locator[0] = 1;
+    int error_num = 0;
+    int shift = 1;
+    Byte prev_discrepancy = 1;
+    for (int k = 0; k < nsym; ++k) {
+        Byte discrepancy = syndromes[k];
+        for (int i = 1; i <= error_num; ++i) {
+            discrepancy ^= gf_mul(locator[i], syndromes[k - i]);
+        }
+        if (discrepancy == 0) {
+            ++shift;
+            continue;
+        }
+        Byte scale = gf_div(discrepancy, prev_discrepancy);
+        if (2 * error_num <= k) {
+            tmp = locator;
+            for (int i = 0; i + shift <= nsym; ++i) {
+                locator[i + shift] ^= gf_mul(scale, prev_locator[i]);
+            }
+            error_num = k + 1 - error_num;
+            prev_locator = tmp;
+            prev_discrepancy = discrepancy;
+            shift = 1;
+        } else {
+            for (int i = 0; i + shift <= nsym; ++i) {
+                locator[i + shift] ^= gf_mul(scale, prev_locator[i]);
+            }
+            ++shift;
+        }
+    }
+    if (2 * error_num > nsym) return -1;
+
+    // error evaluator omega(x) = s(x) * locator(x) mod x^nsym
+    std::array<Byte, MAX_CODEWORD_BYTE_NUM> evaluator{};
+    for (int i = 0; i < nsym; ++i) {
+        Byte v = 0;
+        for (int j = 0; j <= std::min(i, error_num); ++j) {
+            v ^= gf_mul(locator[j], syndromes[i - j]);
+        }
+        evaluator[i] = v;
+    }
+    // chien search and forney, byte p has power n-1-p
+    std::array<Byte, MAX_CODEWORD_BYTE_NUM + 1> locator_derivative{};
+    for (int i = 1; i <= error_num; i += 2) {
+        locator_derivative[i - 1] = locator[i];
+    }
+    int found_num = 0;
+    std::array<int, MAX_CODEWORD_BYTE_NUM> error_positions{};
+    std::array<Byte, MAX_CODEWORD_BYTE_NUM> error_values{};
+    for (int p = 0; p < n && found_num <= error_num; ++p) {
+        int power = n - 1 - p;
+        Byte x_inv = gf_pow_alpha(-power);
+        if (evaluate_poly(locator.data(), error_num + 1, x_inv) != 0) continue;
+        Byte denominator = evaluate_poly(locator_derivative.data(), error_num, x_inv);
+        if (denominator == 0) return -1;
+        Byte numerator = gf_mul(gf_pow_alpha(power), evaluate_poly(evaluator.data(), nsym, x_inv));
+        error_positions[found_num] = p;
+        error_values[found_num] = gf_div(numerator, denominator);
+        ++found_num;
+    }
+    if (found_num != error_num) return -1;
+    for (int i = 0; i < found_num; ++i) {
+        codeword[error_positions[i]] ^= error_values[i];
+    }
+    return found_num;
+}
+
+int get_interleaved_codeword_num(size_t byte_num) {
+    return static_cast<int>((byte_num + ReedSolomon::MAX_CODEWORD_BYTE_NUM - 1) / ReedSolomon::MAX_CODEWORD_BYTE_NUM);
+}
+
+void encode_interleaved(const ReedSolomon& rs, Byte* bytes, size_t byte_num) {
+    int codeword_num = get_interleaved_codeword_num(byte_num);
+    Byte data[ReedSolomon::MAX_CODEWORD_BYTE_NUM];
+    Byte parity[ReedSolomon::MAX_CODEWORD_BYTE_NUM];
+    for (int i = 0; i < codeword_num; ++i) {
+        int codeword_byte_num = static_cast<int>((byte_num - i + codeword_num - 1) / codeword_num);
+        int data_byte_num = codeword_byte_num - rs.ParityByteNum();
+        for (int t = 0; t < data_byte_num; ++t) {
+            data[t] = bytes[i + static_cast<size_t>(t) * codeword_num];
+        }
+        rs.Encode(data, data_byte_num, parity);
+        for (int t = 0; t < rs.ParityByteNum(); ++t) {
+            bytes[i + static_cast<size_t>(data_byte_num + t) * codeword_num] = parity[t];
+        }
+    }
+}
+
+int decode_interleaved(const ReedSolomon& rs, Byte* bytes, size_t byte_num) {
+    int codeword_num = get_interleaved_codeword_num(byte_num);
+    Byte codeword[ReedSolomon::MAX_CODEWORD_BYTE_NUM];
+    int corrected_num = 0;
+    for (int i = 0; i < codeword_num; ++i) {
+        int codeword_byte_num = static_cast<int>((byte_num - i + codeword_num - 1) / codeword_num);
+        for (int t = 0; t < codeword_byte_num; ++t) {
+            codeword[t] = bytes[i + static_cast<size_t>(t) * codeword_num];
+        }
+        int n = rs.Decode(codeword, codeword_byte_num);
+        if (n < 0) return -1;
+        if (n > 0) {
+            for (int t = 0; t < codeword_byte_num; ++t) {
+                bytes[i + static_cast<size_t>(t) * codeword_num] = codeword[t];
+            }
+        }
+        corrected_num += n;
+    }
+    return corrected_num;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "image_codec_api.h"
+#include "image_codec_types.h"
+
+// systematic reed-solomon code over GF(256), codewords may be shortened below 255 bytes
+class ReedSolomon {
+public:
+    static constexpr int MAX_CODEWORD_BYTE_NUM = 255;
+
+    IMAGE_CODEC_API explicit ReedSolomon(int parity_byte_num);
+    IMAGE_CODEC_API int ParityByteNum() const { return m_parity_byte_num; }
+    IMAGE_CODEC_API void Encode(const Byte* data, int data_byte_num, Byte* parity) const;
+    // corrects codeword in place, returns the number of corrected bytes or -1 if uncorrectable
+    IMAGE_CODEC_API int Decode(Byte* codeword, int codeword_byte_num) const;
+
+private:
+    int m_parity_byte_num;
+    Bytes m_generator;
+};
+
+// bytes of a frame are interleaved over ceil(byte_num / 255) codewords whose parity occupies the end of the frame
+IMAGE_CODEC_API int get_interleaved_codeword_num(size_t byte_num);
+IMAGE_CODEC_API void encode_interleaved(const ReedSolomon& rs, Byte* bytes, size_t byte_num);
+IMAGE_CODEC_API int decode_interleaved(const ReedSolomon& rs, Byte* bytes, size_t byte_num);
@@ -0,0 +1,33 @@
+#include <algorithm>
+#include <string>
+
+#include "sparse_map.h"
+
+SparseMap::SparseMap(const Bytes& raw_bytes, int part_byte_num, uint32_t part_num) : m_part_num(part_num) {
+    if (part_num > SPARSE_MAP_PART_ID_FLAG) throw invalid_image_codec_argument("invalid part_num '" + std::to_string(part_num) + "' for sparse map");
+    uint64_t map_part_capacity = static_cast<uint64_t>(part_byte_num) * 8;
+    for (uint32_t part_id = 0; part_id < part_num; ++part_id) {
+        auto begin = raw_bytes.begin() + static_cast<size_t>(part_id) * part_byte_num;
+        if (std::any_of(begin, begin + part_byte_num, [](Byte b){ return b != 0; })) {
+            m_part_ids.push_back(part_id);
+            continue;
+        }
+        uint32_t map_part_index = static_cast<uint32_t>(part_id / map_part_capacity);
+        if (m_map_parts.empty() || m_map_parts.back().first != (SPARSE_MAP_PART_ID_FLAG | map_part_index)) {
+            m_map_parts.emplace_back(SPARSE_MAP_PART_ID_FLAG | map_part_index, Bytes(part_byte_num, 0));
+        }
+        uint64_t bit_id = part_id % map_part_capacity;
+        m_map_parts.back().second[bit_id / 8] |= 0x1 << (bit_id % 8);
+    }
+}
+
+void get_sparse_map_zero_part_ids(uint32_t map_part_id, const Bytes& part_bytes, uint32_t part_num, std::vector<uint32_t>& part_ids) {
+    uint64_t first_part_id = static_cast<uint64_t>(map_part_id & ~SPARSE_MAP_PART_ID_FLAG) * part_bytes.size() * 8;
+    for (size_t i = 0; i < part_bytes.size(); ++i) {
+        if (!part_bytes[i]) continue;
+        for (int j = 0; j < 8; ++j) {
+            uint64_t part_id = first_part_id + i * 8 + j;
+            if ((part_bytes[i] >> j & 0x1) && part_id < part_num) part_ids.push_back(static_cast<uint32_t>(part_id));
+        }
+    }
+}
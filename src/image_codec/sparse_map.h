@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+
+#include "image_codec_api.h"
+#include "image_codec_types.h"
+#include "fountain_code.h"
+
+// sparse map parts carry this flag in their part id, the remaining bits are the index of the map part
+// map part i is a bitmap of the part_byte_num * 8 part ids starting from i * part_byte_num * 8, set bits mark parts which are all zero
+constexpr uint32_t SPARSE_MAP_PART_ID_FLAG = 0x40000000;
+
+inline bool is_sparse_map_part_id(uint32_t part_id) {
+    return (part_id & (FOUNTAIN_PART_ID_FLAG | SPARSE_MAP_PART_ID_FLAG)) == SPARSE_MAP_PART_ID_FLAG;
+}
+
+// all zero parts are never displayed, the receiver learns them from the map parts instead
+class SparseMap {
+public:
+    IMAGE_CODEC_API SparseMap(const Bytes& raw_bytes, int part_byte_num, uint32_t part_num);
+    // map parts listing no zero part are left out
+    IMAGE_CODEC_API const std::vector<std::pair<uint32_t, Bytes>>& MapParts() const { return m_map_parts; }
+    // ids of the parts which are not all zero
+    IMAGE_CODEC_API const std::vector<uint32_t>& PartIds() const { return m_part_ids; }
+    IMAGE_CODEC_API uint32_t ZeroPartNum() const { return m_part_num - static_cast<uint32_t>(m_part_ids.size()); }
+    // map parts followed by the parts which are not all zero
+    IMAGE_CODEC_API uint32_t DisplayedPartNum() const { return static_cast<uint32_t>(m_map_parts.size() + m_part_ids.size()); }
+
+private:
+    uint32_t m_part_num;
+    std::vector<std::pair<uint32_t, Bytes>> m_map_parts;
+    std::vector<uint32_t> m_part_ids;
+};
+
+// appends the ids of the zero parts listed by a map part, ids beyond part_num are dropped
+IMAGE_CODEC_API void get_sparse_map_zero_part_ids(uint32_t map_part_id, const Bytes& part_bytes, uint32_t part_num, std::vector<uint32_t>& part_ids);
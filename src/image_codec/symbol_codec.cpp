@@ -1,9 +1,11 @@
 #include <iomanip>
 #include <map>
-
-#include <boost/crc.hpp>
+#include <algorithm>
 
 #include "symbol_codec.h"
+#include "crc32.h"
+#include "reed_solomon.h"
+#include "symbol_packing.h"
 
 namespace {
 
@@ -11,12 +13,22 @@ std::map<std::string, SymbolType> symbol_type_str_to_symbol_type_mapping({
     {"symbol1", SymbolType::SYMBOL1},
     {"symbol2", SymbolType::SYMBOL2},
     {"symbol3", SymbolType::SYMBOL3},
+    {"symbol1_rs", SymbolType::SYMBOL1_RS},
+    {"symbol2_rs", SymbolType::SYMBOL2_RS},
+    {"symbol3_rs", SymbolType::SYMBOL3_RS},
+    {"symbol4", SymbolType::SYMBOL4},
+    {"symbol4_rs", SymbolType::SYMBOL4_RS},
 });
 
 std::map<SymbolType, std::string> symbol_type_to_symbol_type_str_mapping({
     {SymbolType::SYMBOL1, "symbol1"},
     {SymbolType::SYMBOL2, "symbol2"},
     {SymbolType::SYMBOL3, "symbol3"},
+    {SymbolType::SYMBOL1_RS, "symbol1_rs"},
+    {SymbolType::SYMBOL2_RS, "symbol2_rs"},
+    {SymbolType::SYMBOL3_RS, "symbol3_rs"},
+    {SymbolType::SYMBOL4, "symbol4"},
+    {SymbolType::SYMBOL4_RS, "symbol4_rs"},
 });
 
 }
@@ -35,221 +47,375 @@ std::string get_symbol_type_str(SymbolType symbol_type) {
     return symbol_type_to_symbol_type_str_mapping[symbol_type];
 }
 
+SymbolType get_base_symbol_type(SymbolType symbol_type) {
+    switch (symbol_type) {
+        case SymbolType::SYMBOL1_RS: return SymbolType::SYMBOL1;
+        case SymbolType::SYMBOL2_RS: return SymbolType::SYMBOL2;
+        case SymbolType::SYMBOL3_RS: return SymbolType::SYMBOL3;
+        case SymbolType::SYMBOL4_RS: return SymbolType::SYMBOL4;
+        default:                     return symbol_type;
+    }
+}
+
+bool is_fec_symbol_type(SymbolType symbol_type) {
+    return get_base_symbol_type(symbol_type) != symbol_type;
+}
+
 namespace {
 
-Bytes encrypt_bytes(const Bytes& bytes) {
-    Bytes encrypted_bytes(bytes.rbegin(), bytes.rend());
-    for (auto& e : encrypted_bytes) {
-        e ^= Byte(170);
+std::vector<PixelColor> get_identity_colors(int bit_num) {
+    std::vector<PixelColor> colors;
+    for (int i = 0; i < (1 << bit_num); ++i) {
+        colors.push_back(static_cast<PixelColor>(i));
     }
-    return encrypted_bytes;
+    return colors;
 }
 
-Bytes uint32_to_bytes(uint32_t v) {
-    return {
-        static_cast<Byte>((v >> 0) & 0xff),
-        static_cast<Byte>((v >> 8) & 0xff),
-        static_cast<Byte>((v >> 16) & 0xff),
-        static_cast<Byte>((v >> 24) & 0xff),
+// red and blue carry one bit each and the four green levels carry two gray coded bits, so mistaking a color for a neighboring one flips a single bit
+std::vector<PixelColor> get_symbol4_colors() {
+    const PixelColor green_level_colors[4][4] = {
+        {PixelColor::BLACK,   PixelColor::DARK_GREEN, PixelColor::MID_GREEN,  PixelColor::GREEN},
+        {PixelColor::BLUE,    PixelColor::ROYAL_BLUE, PixelColor::AZURE,      PixelColor::CYAN},
+        {PixelColor::RED,     PixelColor::VERMILION,  PixelColor::ORANGE,     PixelColor::YELLOW},
+        {PixelColor::MAGENTA, PixelColor::PINK,       PixelColor::LIGHT_PINK, PixelColor::WHITE},
     };
+    std::vector<PixelColor> colors(16);
+    for (int red_blue = 0; red_blue < 4; ++red_blue) {
+        for (int level = 0; level < 4; ++level) {
+            colors[(red_blue << 2) | get_gray_code(level)] = green_level_colors[red_blue][level];
+        }
+    }
+    return colors;
+}
+
+}
+
+const Constellation& get_constellation(SymbolType symbol_type) {
+    static const Constellation symbol1_constellation(1, get_identity_colors(1));
+    static const Constellation symbol2_constellation(2, get_identity_colors(2));
+    static const Constellation symbol3_constellation(3, get_identity_colors(3));
+    static const Constellation symbol4_constellation(4, get_symbol4_colors());
+    switch (get_base_symbol_type(symbol_type)) {
+        case SymbolType::SYMBOL1: return symbol1_constellation;
+        case SymbolType::SYMBOL2: return symbol2_constellation;
+        case SymbolType::SYMBOL3: return symbol3_constellation;
+        case SymbolType::SYMBOL4: return symbol4_constellation;
+        default: throw std::invalid_argument("invalid symbol type " + std::to_string(static_cast<int>(symbol_type)));
+    }
+}
+
+Symbol get_color_calibration_symbol(SymbolType symbol_type, int tile_x_id, int tile_y_id, int x, int y) {
+    const auto& constellation = get_constellation(symbol_type);
+    return constellation.BitsToSymbol((x + y + tile_x_id + tile_y_id) % constellation.ColorNum());
+}
+
+namespace {
+
+constexpr Byte ENCRYPTION_KEY = 170;
+constexpr size_t CHUNK_BYTE_NUM = 24;
+
+void uint32_to_bytes(uint32_t v, Byte* bytes) {
+    bytes[0] = static_cast<Byte>((v >> 0) & 0xff);
+    bytes[1] = static_cast<Byte>((v >> 8) & 0xff);
+    bytes[2] = static_cast<Byte>((v >> 16) & 0xff);
+    bytes[3] = static_cast<Byte>((v >> 24) & 0xff);
 }
 
-uint32_t bytes_to_uint32(const Bytes& bytes) {
+uint32_t bytes_to_uint32(const Byte* bytes) {
     return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (bytes[3] << 24);
 }
 
-uint32_t crc32(const Bytes& bytes) {
-    boost::crc_32_type crc_gen;
-    crc_gen.process_bytes(bytes.data(), bytes.size());
-    return crc_gen.checksum();
+const ReedSolomon& get_fec_reed_solomon() {
+    static const ReedSolomon reed_solomon(SymbolCodec::FEC_PARITY_BYTE_NUM);
+    return reed_solomon;
 }
 
-Bytes scramble_part_id_bytes(const Bytes& part_id_bytes, const Bytes& crc_bytes) {
-    Bytes scrambled_part_id_bytes = part_id_bytes;
-    for (size_t i = 0; i < scrambled_part_id_bytes.size(); ++i) {
-        scrambled_part_id_bytes[i] ^= crc_bytes[i];
-    }
-    return scrambled_part_id_bytes;
 }
 
+int SymbolCodec::FecParityByteNum(size_t frame_size) const {
+    if (!HasFec()) return 0;
+    return get_interleaved_codeword_num(frame_size * BitNumPerSymbol() / 8) * FEC_PARITY_BYTE_NUM;
 }
 
 Symbols SymbolCodec::Encode(uint32_t part_id, const Bytes& part_bytes, int frame_size) {
-    if (frame_size < ((META_BYTE_NUM + part_bytes.size()) * 8 + BitNumPerSymbol() - 1) / BitNumPerSymbol()) throw std::invalid_argument("invalid encode arguments");
-    Bytes part_id_bytes = uint32_to_bytes(part_id);
-    Bytes padded_part_bytes = part_bytes;
-    padded_part_bytes.resize(static_cast<size_t>(frame_size * BitNumPerSymbol() / 8 - META_BYTE_NUM), 0);
-    Bytes bytes_for_crc;
-    bytes_for_crc.insert(bytes_for_crc.end(), part_id_bytes.begin(), part_id_bytes.end());
-    bytes_for_crc.insert(bytes_for_crc.end(), padded_part_bytes.begin(), padded_part_bytes.end());
-    uint32_t crc = crc32(bytes_for_crc);
-    Bytes crc_bytes = uint32_to_bytes(crc);
-    Bytes scrambled_part_id_bytes = scramble_part_id_bytes(part_id_bytes, crc_bytes);
-    Bytes bytes;
-    bytes.insert(bytes.end(), crc_bytes.begin(), crc_bytes.end());
-    bytes.insert(bytes.end(), scrambled_part_id_bytes.begin(), scrambled_part_id_bytes.end());
-    bytes.insert(bytes.end(), padded_part_bytes.begin(), padded_part_bytes.end());
-    Symbols symbols = BytesToSymbols(encrypt_bytes(bytes));
-    symbols.resize(frame_size, 0);
+    Symbols symbols(frame_size > 0 ? frame_size : 0);
+    Encode(part_id, part_bytes.data(), part_bytes.size(), symbols.data(), symbols.size());
+    return symbols;
+}
+
+void SymbolCodec::Encode(uint32_t part_id, const Byte* part_bytes, size_t part_byte_num, Symbol* symbols, size_t frame_size) {
+    int bit_num_per_symbol = BitNumPerSymbol();
+    int padded_part_byte_num = PaddedPartByteNum(frame_size);
+    if (padded_part_byte_num < 0 || static_cast<size_t>(padded_part_byte_num) < part_byte_num) throw std::invalid_argument("invalid encode arguments");
+    size_t byte_num = frame_size * bit_num_per_symbol / 8;
+    Byte meta_bytes[META_BYTE_NUM];
+    Byte* part_id_bytes = meta_bytes + CRC_BYTE_NUM;
+    uint32_to_bytes(part_id, part_id_bytes);
+    uint32_t crc = crc32(part_id_bytes, PART_ID_BYTE_NUM);
+    crc = crc32_update(crc, part_bytes, part_byte_num);
+    crc = crc32_update_zeros(crc, padded_part_byte_num - part_byte_num);
+    uint32_to_bytes(crc, meta_bytes);
+    for (int i = 0; i < PART_ID_BYTE_NUM; ++i) {
+        part_id_bytes[i] ^= meta_bytes[i];
+    }
+    const Byte* fec_bytes = nullptr;
+    if (HasFec()) {
+        thread_local Bytes fec_buf;
+        fec_buf.resize(byte_num);
+        std::copy_n(meta_bytes, META_BYTE_NUM, fec_buf.data());
+        std::copy_n(part_bytes, part_byte_num, fec_buf.data() + META_BYTE_NUM);
+        std::fill(fec_buf.begin() + META_BYTE_NUM + part_byte_num, fec_buf.end(), 0);
+        encode_interleaved(get_fec_reed_solomon(), fec_buf.data(), byte_num);
+        fec_bytes = fec_buf.data();
+    }
+    // the frame carries meta bytes, padded part bytes and fec parity, reversed and xored
+    Byte chunk[CHUNK_BYTE_NUM];
+    Symbol* chunk_symbols = symbols;
+    for (size_t k0 = 0; k0 < byte_num; k0 += CHUNK_BYTE_NUM) {
+        size_t chunk_byte_num = std::min(CHUNK_BYTE_NUM, byte_num - k0);
+        for (size_t k = 0; k < chunk_byte_num; ++k) {
+            size_t i = byte_num - 1 - (k0 + k);
+            Byte byte = 0;
+            if (fec_bytes) {
+                byte = fec_bytes[i];
+            } else if (i < META_BYTE_NUM) {
+                byte = meta_bytes[i];
+            } else if (i - META_BYTE_NUM < part_byte_num) {
+                byte = part_bytes[i - META_BYTE_NUM];
+            }
+            chunk[k] = byte ^ ENCRYPTION_KEY;
+        }
+        BytesToSymbols(chunk, chunk_byte_num, chunk_symbols);
+        chunk_symbols += CHUNK_BYTE_NUM * 8 / bit_num_per_symbol;
+    }
+    size_t symbol_num = (byte_num * 8 + bit_num_per_symbol - 1) / bit_num_per_symbol;
+    std::fill(symbols + symbol_num, symbols + frame_size, 0);
     if (0) {
         std::cout << "encode\n";
         std::cout << "frame_size: " << std::dec << frame_size << "\n";
         std::cout << "part_id: " << std::hex << part_id << "\n";
-        std::cout << "part_id_bytes: " << part_id_bytes << "\n";
-        std::cout << "part_bytes: " << part_bytes << "\n";
-        std::cout << "padded_part_bytes: " << padded_part_bytes << "\n";
-        std::cout << "bytes_for_crc: " << bytes_for_crc << "\n";
         std::cout << "crc: " << std::hex << crc << "\n";
-        std::cout << "crc_bytes: " << crc_bytes << "\n";
-        std::cout << "bytes: " << bytes << "\n";
-        std::cout << "symbols: " << symbols << "\n";
     }
-    return symbols;
 }
 
 DecodeResult SymbolCodec::Decode(const Symbols& symbols) {
-    if (static_cast<int>(symbols.size()) < ((META_BYTE_NUM + 1) * 8 + BitNumPerSymbol() - 1) / BitNumPerSymbol()) throw std::invalid_argument("invalid encode arguments");
-    Symbols truncated_symbols(symbols.begin(), symbols.begin() + (symbols.size() * BitNumPerSymbol() / 8 * 8 + BitNumPerSymbol() - 1) / BitNumPerSymbol());
-    Bytes bytes = encrypt_bytes(SymbolsToBytes(truncated_symbols));
-    Bytes crc_bytes(bytes.begin(), bytes.begin() + CRC_BYTE_NUM);
-    uint32_t crc = bytes_to_uint32(crc_bytes);
-    Bytes scrambled_part_id_bytes(bytes.begin() + CRC_BYTE_NUM, bytes.begin() + META_BYTE_NUM);
-    Bytes part_id_bytes = scramble_part_id_bytes(scrambled_part_id_bytes, crc_bytes);
-    uint32_t part_id = bytes_to_uint32(part_id_bytes);
-    Bytes padded_part_bytes(bytes.begin() + META_BYTE_NUM, bytes.end());
-    Bytes bytes_for_crc;
-    bytes_for_crc.insert(bytes_for_crc.end(), part_id_bytes.begin(), part_id_bytes.end());
-    bytes_for_crc.insert(bytes_for_crc.end(), padded_part_bytes.begin(), padded_part_bytes.end());
-    uint32_t crc_computed = crc32(bytes_for_crc);
-    bool success = crc_computed == crc;
+    DecodeResult result;
+    Decode(symbols, result);
+    return result;
+}
+
+void SymbolCodec::Decode(const Symbols& symbols, DecodeResult& result) {
+    auto& [success, part_id, part_bytes] = result;
+    int padded_part_byte_num = PaddedPartByteNum(symbols.size());
+    part_bytes.resize(padded_part_byte_num > 0 ? padded_part_byte_num : 0);
+    success = Decode(symbols.data(), symbols.size(), part_id, part_bytes.data());
+}
+
+bool SymbolCodec::Decode(const Symbol* symbols, size_t frame_size, uint32_t& part_id, Byte* part_bytes) {
+    return DecodeSyndrome(symbols, frame_size, part_id, part_bytes) == 0;
+}
+
+uint32_t SymbolCodec::DecodeSyndrome(const Symbol* symbols, size_t frame_size, uint32_t& part_id, Byte* part_bytes) {
+    int bit_num_per_symbol = BitNumPerSymbol();
+    int padded_part_byte_num = PaddedPartByteNum(frame_size);
+    if (padded_part_byte_num < 1) throw std::invalid_argument("invalid decode arguments");
+    size_t byte_num = frame_size * bit_num_per_symbol / 8;
+    Byte meta_bytes[META_BYTE_NUM];
+    Byte* fec_bytes = nullptr;
+    if (HasFec()) {
+        thread_local Bytes fec_buf;
+        fec_buf.resize(byte_num);
+        fec_bytes = fec_buf.data();
+    }
+    Byte chunk[CHUNK_BYTE_NUM];
+    const Symbol* chunk_symbols = symbols;
+    for (size_t k0 = 0; k0 < byte_num; k0 += CHUNK_BYTE_NUM) {
+        size_t chunk_byte_num = std::min(CHUNK_BYTE_NUM, byte_num - k0);
+        SymbolsToBytes(chunk_symbols, chunk_byte_num, chunk);
+        for (size_t k = 0; k < chunk_byte_num; ++k) {
+            size_t i = byte_num - 1 - (k0 + k);
+            Byte byte = chunk[k] ^ ENCRYPTION_KEY;
+            if (fec_bytes) {
+                fec_bytes[i] = byte;
+            } else if (i < META_BYTE_NUM) {
+                meta_bytes[i] = byte;
+            } else {
+                part_bytes[i - META_BYTE_NUM] = byte;
+            }
+        }
+        chunk_symbols += CHUNK_BYTE_NUM * 8 / bit_num_per_symbol;
+    }
+    if (fec_bytes) {
+        decode_interleaved(get_fec_reed_solomon(), fec_bytes, byte_num);
+        std::copy_n(fec_bytes, META_BYTE_NUM, meta_bytes);
+        std::copy_n(fec_bytes + META_BYTE_NUM, padded_part_byte_num, part_bytes);
+    }
+    uint32_t crc = bytes_to_uint32(meta_bytes);
+    Byte* part_id_bytes = meta_bytes + CRC_BYTE_NUM;
+    for (int i = 0; i < PART_ID_BYTE_NUM; ++i) {
+        part_id_bytes[i] ^= meta_bytes[i];
+    }
+    part_id = bytes_to_uint32(part_id_bytes);
+    uint32_t crc_computed = crc32_update(crc32(part_id_bytes, PART_ID_BYTE_NUM), part_bytes, padded_part_byte_num);
     if (0) {
         std::cout << "decode\n";
-        std::cout << "symbols: " << symbols << "\n";
-        std::cout << "truncated_symbols: " << truncated_symbols << "\n";
-        std::cout << "bytes: " << bytes << "\n";
-        std::cout << "crc_bytes: " << crc_bytes << "\n";
         std::cout << "crc: " << std::hex << crc << "\n";
-        std::cout << "part_id_bytes: " << part_id_bytes << "\n";
         std::cout << "part_id: " << std::hex << part_id << "\n";
-        std::cout << "padded_part_bytes: " << padded_part_bytes << "\n";
-        std::cout << "bytes_for_crc: " << bytes_for_crc << "\n";
         std::cout << "crc_computed: " << crc_computed << "\n";
     }
-    return {success, part_id, padded_part_bytes};
-}
-
-Symbols Symbol1Codec::BytesToSymbols(const Bytes& bytes) {
-    Symbols symbols;
-    for (auto byte : bytes) {
-        symbols.push_back((byte >> 7) & 0x1);
-        symbols.push_back((byte >> 6) & 0x1);
-        symbols.push_back((byte >> 5) & 0x1);
-        symbols.push_back((byte >> 4) & 0x1);
-        symbols.push_back((byte >> 3) & 0x1);
-        symbols.push_back((byte >> 2) & 0x1);
-        symbols.push_back((byte >> 1) & 0x1);
-        symbols.push_back((byte >> 0) & 0x1);
-    }
-    return symbols;
+    return crc ^ crc_computed;
 }
 
-Bytes Symbol1Codec::SymbolsToBytes(const Symbols& symbols) {
-    Bytes bytes;
-    for (size_t i = 0; i < symbols.size(); i += 8) {
-        Byte byte = 0;
-        byte |= (symbols[i+0] & 0x1) << 7;
-        byte |= (symbols[i+1] & 0x1) << 6;
-        byte |= (symbols[i+2] & 0x1) << 5;
-        byte |= (symbols[i+3] & 0x1) << 4;
-        byte |= (symbols[i+4] & 0x1) << 3;
-        byte |= (symbols[i+5] & 0x1) << 2;
-        byte |= (symbols[i+6] & 0x1) << 1;
-        byte |= (symbols[i+7] & 0x1) << 0;
-        bytes.push_back(byte);
-    }
-    return bytes;
+void SymbolCodec::DecodeWithRetry(const Symbols& symbols, const SymbolSoftInfos& soft_infos, const ChaseConfig& chase_config, DecodeResult& result) {
+    auto& [success, part_id, part_bytes] = result;
+    int padded_part_byte_num = PaddedPartByteNum(symbols.size());
+    part_bytes.resize(padded_part_byte_num > 0 ? padded_part_byte_num : 0);
+    success = DecodeWithRetry(symbols.data(), soft_infos.data(), symbols.size(), chase_config, part_id, part_bytes.data());
 }
 
-Symbols Symbol2Codec::BytesToSymbols(const Bytes& bytes) {
-    Symbols symbols;
-    for (auto byte : bytes) {
-        symbols.push_back((byte >> 6) & 0x3);
-        symbols.push_back((byte >> 4) & 0x3);
-        symbols.push_back((byte >> 2) & 0x3);
-        symbols.push_back((byte >> 0) & 0x3);
-    }
-    return symbols;
+namespace {
+
+struct ChaseCandidate {
+    uint32_t syndrome_delta = 0;
+    uint32_t part_id_delta = 0;
+    // up to two frame bytes are touched by one symbol
+    int part_byte_positions[2] = {-1, -1};
+    Byte part_byte_deltas[2] = {0, 0};
+};
+
 }
 
-Bytes Symbol2Codec::SymbolsToBytes(const Symbols& symbols) {
-    Bytes bytes;
-    for (size_t i = 0; i < symbols.size(); i += 4) {
-        Byte byte = 0;
-        byte |= (symbols[i+0] & 0x3) << 6;
-        byte |= (symbols[i+1] & 0x3) << 4;
-        byte |= (symbols[i+2] & 0x3) << 2;
-        byte |= (symbols[i+3] & 0x3) << 0;
-        bytes.push_back(byte);
-    }
-    return bytes;
-}
-
-Symbols Symbol3Codec::BytesToSymbols(const Bytes& bytes) {
-    Symbols symbols;
-    Byte left = 0;
-    for (size_t i = 0; i < bytes.size(); ++i) {
-        Byte byte = bytes[i];
-        if (i % 3 == 0) {
-            symbols.push_back((byte >> 5) & 0x7);
-            symbols.push_back((byte >> 2) & 0x7);
-            left = byte & 0x3;
-        } else if (i % 3 == 1) {
-            symbols.push_back((left << 1) | ((byte >> 7) & 0x1));
-            symbols.push_back((byte >> 4) & 0x7);
-            symbols.push_back((byte >> 1) & 0x7);
-            left = byte & 0x1;
-        } else if (i % 3 == 2) {
-            symbols.push_back((left << 2)  | ((byte >> 6) & 0x3));
-            symbols.push_back((byte >> 3) & 0x7);
-            symbols.push_back(byte & 0x7);
-            left = 0;
+bool SymbolCodec::DecodeWithRetry(const Symbol* symbols, const SymbolSoftInfo* soft_infos, size_t frame_size, const ChaseConfig& chase_config, uint32_t& part_id, Byte* part_bytes) {
+    uint32_t syndrome = DecodeSyndrome(symbols, frame_size, part_id, part_bytes);
+    if (syndrome == 0) return true;
+    int candidate_num = std::min(chase_config.candidate_symbol_num, ChaseConfig::MAX_CANDIDATE_SYMBOL_NUM);
+    if (candidate_num <= 0 || HasFec()) return false;
+
+    int bit_num_per_symbol = BitNumPerSymbol();
+    size_t byte_num = frame_size * bit_num_per_symbol / 8;
+    size_t bit_num = byte_num * 8;
+    size_t symbol_num = std::min(frame_size, (bit_num + bit_num_per_symbol - 1) / bit_num_per_symbol);
+    int padded_part_byte_num = PaddedPartByteNum(frame_size);
+    size_t message_byte_num = PART_ID_BYTE_NUM + padded_part_byte_num;
+    const Constellation& constellation = get_constellation(GetSymbolType());
+
+    thread_local std::vector<uint32_t> symbol_ids;
+    symbol_ids.clear();
+    for (size_t i = 0; i < symbol_num; ++i) {
+        if (soft_infos[i].runner_up != symbols[i] && constellation.HasSymbol(soft_infos[i].runner_up) && constellation.HasSymbol(symbols[i])) {
+            symbol_ids.push_back(static_cast<uint32_t>(i));
         }
     }
-    if (bytes.size() % 3 != 0) {
-        symbols.push_back(left << (bytes.size() % 3));
+    candidate_num = std::min(candidate_num, static_cast<int>(symbol_ids.size()));
+    if (candidate_num == 0) return false;
+    auto less_confident = [soft_infos](uint32_t a, uint32_t b) { return soft_infos[a].confidence < soft_infos[b].confidence; };
+    std::partial_sort(symbol_ids.begin(), symbol_ids.begin() + candidate_num, symbol_ids.end(), less_confident);
+
+    // the crc is linear, so each flip changes the syndrome by a fixed delta
+    ChaseCandidate candidates[ChaseConfig::MAX_CANDIDATE_SYMBOL_NUM];
+    for (int c = 0; c < candidate_num; ++c) {
+        uint32_t symbol_id = symbol_ids[c];
+        int symbol_delta = constellation.SymbolToBits(symbols[symbol_id]) ^ constellation.SymbolToBits(soft_infos[symbol_id].runner_up);
+        auto& candidate = candidates[c];
+        int touched_byte_num = 0;
+        size_t touched_byte_ids[2] = {0, 0};
+        Byte touched_byte_deltas[2] = {0, 0};
+        for (int t = 0; t < bit_num_per_symbol; ++t) {
+            if (!((symbol_delta >> (bit_num_per_symbol - 1 - t)) & 1)) continue;
+            size_t bit_pos = static_cast<size_t>(symbol_id) * bit_num_per_symbol + t;
+            if (bit_pos >= bit_num) continue;
+            // frame bytes are stored reversed
+            size_t i = byte_num - 1 - bit_pos / 8;
+            Byte bit_mask = static_cast<Byte>(0x80 >> (bit_pos % 8));
+            if (touched_byte_num > 0 && touched_byte_ids[touched_byte_num - 1] == i) {
+                touched_byte_deltas[touched_byte_num - 1] ^= bit_mask;
+            } else {
+                touched_byte_ids[touched_byte_num] = i;
+                touched_byte_deltas[touched_byte_num] = bit_mask;
+                ++touched_byte_num;
+            }
+        }
+        for (int k = 0; k < touched_byte_num; ++k) {
+            size_t i = touched_byte_ids[k];
+            Byte e = touched_byte_deltas[k];
+            if (i < CRC_BYTE_NUM) {
+                // the stored crc also descrambles the part id
+                candidate.syndrome_delta ^= (static_cast<uint32_t>(e) << (8 * i)) ^ crc32_byte_delta(e, i, message_byte_num);
+                candidate.part_id_delta ^= static_cast<uint32_t>(e) << (8 * i);
+            } else if (i < META_BYTE_NUM) {
+                candidate.syndrome_delta ^= crc32_byte_delta(e, i - CRC_BYTE_NUM, message_byte_num);
+                candidate.part_id_delta ^= static_cast<uint32_t>(e) << (8 * (i - CRC_BYTE_NUM));
+            } else {
+                candidate.syndrome_delta ^= crc32_byte_delta(e, i - CRC_BYTE_NUM, message_byte_num);
+                candidate.part_byte_positions[k] = static_cast<int>(i - META_BYTE_NUM);
+                candidate.part_byte_deltas[k] = e;
+            }
+        }
     }
-    return symbols;
-}
 
-Bytes Symbol3Codec::SymbolsToBytes(const Symbols& symbols) {
-    Bytes bytes;
-    Byte byte = 0;
-    for (size_t i = 0; i < symbols.size(); ++i) {
-        Symbol symbol = symbols[i];
-        if (i % 8 == 0) {
-            byte = symbol << 5;
-        } else if (i % 8 == 1) {
-            byte = byte | symbol << 2;
-        } else if (i % 8 == 2) {
-            byte = byte | symbol >> 1;
-            bytes.push_back(byte);
-            byte = (symbol & 0x1) << 7;
-        } else if (i % 8 == 3) {
-            byte = byte | symbol << 4;
-        } else if (i % 8 == 4) {
-            byte = byte | symbol << 1;
-        } else if (i % 8 == 5) {
-            byte = byte | symbol >> 2;
-            bytes.push_back(byte);
-            byte = (symbol & 0x3) << 6;
-        } else if (i % 8 == 6) {
-            byte = byte | symbol << 3;
-        } else if (i % 8 == 7) {
-            byte = byte | symbol;
-            bytes.push_back(byte);
+    int max_flip_num = std::min({chase_config.max_flip_symbol_num, ChaseConfig::MAX_FLIP_SYMBOL_NUM, candidate_num});
+    for (int flip_num = 1; flip_num <= max_flip_num; ++flip_num) {
+        // visits the subsets of flip_num candidates in gosper's order
+        uint32_t mask = (1u << flip_num) - 1;
+        while (mask < (1u << candidate_num)) {
+            uint32_t syndrome1 = syndrome;
+            for (int c = 0; c < candidate_num; ++c) {
+                if ((mask >> c) & 1) syndrome1 ^= candidates[c].syndrome_delta;
+            }
+            if (syndrome1 == 0) {
+                for (int c = 0; c < candidate_num; ++c) {
+                    if (!((mask >> c) & 1)) continue;
+                    const auto& candidate = candidates[c];
+                    part_id ^= candidate.part_id_delta;
+                    for (int k = 0; k < 2; ++k) {
+                        if (candidate.part_byte_positions[k] >= 0) part_bytes[candidate.part_byte_positions[k]] ^= candidate.part_byte_deltas[k];
+                    }
+                }
+                return true;
+            }
+            uint32_t lowest = mask & (~mask + 1);
+            uint32_t ripple = mask + lowest;
+            mask = (((ripple ^ mask) >> 2) / lowest) | ripple;
         }
     }
-    return bytes;
+    return false;
+}
+
+void Symbol1Codec::BytesToSymbols(const Byte* bytes, size_t byte_num, Symbol* symbols) {
+    unpack_symbols<1>(bytes, byte_num, symbols);
+}
+
+void Symbol1Codec::SymbolsToBytes(const Symbol* symbols, size_t byte_num, Byte* bytes) {
+    pack_symbols<1>(symbols, byte_num, bytes);
+}
+
+void Symbol2Codec::BytesToSymbols(const Byte* bytes, size_t byte_num, Symbol* symbols) {
+    unpack_symbols<2>(bytes, byte_num, symbols);
+}
+
+void Symbol2Codec::SymbolsToBytes(const Symbol* symbols, size_t byte_num, Byte* bytes) {
+    pack_symbols<2>(symbols, byte_num, bytes);
+}
+
+void Symbol3Codec::BytesToSymbols(const Byte* bytes, size_t byte_num, Symbol* symbols) {
+    unpack_symbols<3>(bytes, byte_num, symbols);
+}
+
+void Symbol3Codec::SymbolsToBytes(const Symbol* symbols, size_t byte_num, Byte* bytes) {
+    pack_symbols<3>(symbols, byte_num, bytes);
+}
+
+void Symbol4Codec::BytesToSymbols(const Byte* bytes, size_t byte_num, Symbol* symbols) {
+    unpack_symbols<4>(bytes, byte_num, symbols);
+    get_constellation(SymbolType::SYMBOL4).BitsToSymbols(symbols, get_packed_symbol_num<4>(byte_num));
+}
+
+void Symbol4Codec::SymbolsToBytes(const Symbol* symbols, size_t byte_num, Byte* bytes) {
+    thread_local Symbols bits;
+    size_t symbol_num = get_packed_symbol_num<4>(byte_num);
+    bits.resize(symbol_num);
+    get_constellation(SymbolType::SYMBOL4).SymbolsToBits(symbols, symbol_num, bits.data());
+    pack_symbols<4>(bits.data(), byte_num, bytes);
 }
 
 std::unique_ptr<SymbolCodec> create_symbol_codec(SymbolType symbol_type) {
@@ -260,6 +426,16 @@ std::unique_ptr<SymbolCodec> create_symbol_codec(SymbolType symbol_type) {
         symbol_codec = std::make_unique<Symbol2Codec>();
     } else if (symbol_type == SymbolType::SYMBOL3) {
         symbol_codec = std::make_unique<Symbol3Codec>();
+    } else if (symbol_type == SymbolType::SYMBOL1_RS) {
+        symbol_codec = std::make_unique<Symbol1RsCodec>();
+    } else if (symbol_type == SymbolType::SYMBOL2_RS) {
+        symbol_codec = std::make_unique<Symbol2RsCodec>();
+    } else if (symbol_type == SymbolType::SYMBOL3_RS) {
+        symbol_codec = std::make_unique<Symbol3RsCodec>();
+    } else if (symbol_type == SymbolType::SYMBOL4) {
+        symbol_codec = std::make_unique<Symbol4Codec>();
+    } else if (symbol_type == SymbolType::SYMBOL4_RS) {
+        symbol_codec = std::make_unique<Symbol4RsCodec>();
     } else {
         throw std::invalid_argument("invalid symbol type '" + std::to_string(static_cast<int>(symbol_type)) + "'");
     }
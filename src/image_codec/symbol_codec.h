@@ -1,61 +1,138 @@
 #pragma once
 
 #include <string>
+#include <memory>
+#include <tuple>
 
 #include "image_codec_api.h"
 #include "image_codec_types.h"
+#include "constellation.h"
 
 enum class SymbolType {
     SYMBOL1 = 0,
     SYMBOL2 = 1,
     SYMBOL3 = 2,
+    SYMBOL1_RS = 3,
+    SYMBOL2_RS = 4,
+    SYMBOL3_RS = 5,
+    SYMBOL4 = 6,
+    SYMBOL4_RS = 7,
 };
 
 IMAGE_CODEC_API SymbolType parse_symbol_type(const std::string& symbol_type_str);
 IMAGE_CODEC_API std::string get_symbol_type_str(SymbolType symbol_type);
+IMAGE_CODEC_API SymbolType get_base_symbol_type(SymbolType symbol_type);
+IMAGE_CODEC_API bool is_fec_symbol_type(SymbolType symbol_type);
+IMAGE_CODEC_API const Constellation& get_constellation(SymbolType symbol_type);
+// color calibration pattern, cycles through the colors of the constellation along the diagonals
+IMAGE_CODEC_API Symbol get_color_calibration_symbol(SymbolType symbol_type, int tile_x_id, int tile_y_id, int x, int y);
 
 using DecodeResult = std::tuple<bool, uint32_t, Bytes>;
+using DecodeResults = std::vector<DecodeResult>;
+
+struct SymbolSoftInfo {
+    // vote margin in the high byte and distance of the most marginal sample to the pixelization threshold in the low byte
+    uint16_t confidence = 0xffff;
+    Symbol runner_up = 0;
+};
+
+using SymbolSoftInfos = std::vector<SymbolSoftInfo>;
+
+// every subset tried is a chance for a wrong frame to match the 32 bit crc, so the tries are bounded:
+// at most sum of C(MAX_CANDIDATE_SYMBOL_NUM, k) for k <= MAX_FLIP_SYMBOL_NUM = 696 tries per failed frame,
+// a false accept rate of at most 696 / 2^32, about 1.6e-7 per retried frame
+struct ChaseConfig {
+    static constexpr int MAX_CANDIDATE_SYMBOL_NUM = 16;
+    static constexpr int MAX_FLIP_SYMBOL_NUM = 3;
+
+    // number of least confident symbols tried with their runner up, 0 disables the retry, clamped to MAX_CANDIDATE_SYMBOL_NUM
+    int candidate_symbol_num = 0;
+    // clamped to MAX_FLIP_SYMBOL_NUM
+    int max_flip_symbol_num = 3;
+};
 
 class SymbolCodec {
 public:
     static constexpr int CRC_BYTE_NUM = 4;
     static constexpr int PART_ID_BYTE_NUM = 4;
     static constexpr int META_BYTE_NUM = CRC_BYTE_NUM + PART_ID_BYTE_NUM;
+    static constexpr int FEC_PARITY_BYTE_NUM = 32;
 
     IMAGE_CODEC_API virtual ~SymbolCodec() {}
     IMAGE_CODEC_API virtual SymbolType GetSymbolType() const = 0;
     IMAGE_CODEC_API virtual int BitNumPerSymbol() const = 0;
     IMAGE_CODEC_API int SymbolValueNum() const { return 1 << BitNumPerSymbol(); }
+    IMAGE_CODEC_API bool HasFec() const { return is_fec_symbol_type(GetSymbolType()); }
+    IMAGE_CODEC_API int FecParityByteNum(size_t frame_size) const;
+    IMAGE_CODEC_API int PaddedPartByteNum(size_t frame_size) const { return static_cast<int>(frame_size * BitNumPerSymbol() / 8) - META_BYTE_NUM - FecParityByteNum(frame_size); }
     IMAGE_CODEC_API Symbols Encode(uint32_t part_id, const Bytes& part_bytes, int frame_size);
+    IMAGE_CODEC_API void Encode(uint32_t part_id, const Byte* part_bytes, size_t part_byte_num, Symbol* symbols, size_t frame_size);
     IMAGE_CODEC_API DecodeResult Decode(const Symbols& symbols);
+    IMAGE_CODEC_API void Decode(const Symbols& symbols, DecodeResult& result);
+    IMAGE_CODEC_API bool Decode(const Symbol* symbols, size_t frame_size, uint32_t& part_id, Byte* part_bytes);
+    // chase decoding, flips subsets of the least confident symbols to their runner up until the crc matches
+    IMAGE_CODEC_API bool DecodeWithRetry(const Symbol* symbols, const SymbolSoftInfo* soft_infos, size_t frame_size, const ChaseConfig& chase_config, uint32_t& part_id, Byte* part_bytes);
+    IMAGE_CODEC_API void DecodeWithRetry(const Symbols& symbols, const SymbolSoftInfos& soft_infos, const ChaseConfig& chase_config, DecodeResult& result);
 
 protected:
-    IMAGE_CODEC_API virtual Symbols BytesToSymbols(const Bytes& bytes) = 0;
-    IMAGE_CODEC_API virtual Bytes SymbolsToBytes(const Symbols& symbols) = 0;
+    IMAGE_CODEC_API virtual void BytesToSymbols(const Byte* bytes, size_t byte_num, Symbol* symbols) = 0;
+    IMAGE_CODEC_API virtual void SymbolsToBytes(const Symbol* symbols, size_t byte_num, Byte* bytes) = 0;
+
+private:
+    // returns the stored crc xored with the computed crc
+    uint32_t DecodeSyndrome(const Symbol* symbols, size_t frame_size, uint32_t& part_id, Byte* part_bytes);
 };
 
 class Symbol1Codec : public SymbolCodec {
 protected:
     IMAGE_CODEC_API SymbolType GetSymbolType() const override { return SymbolType::SYMBOL1; }
     IMAGE_CODEC_API int BitNumPerSymbol() const override { return 1; }
-    IMAGE_CODEC_API Symbols BytesToSymbols(const Bytes& bytes) override;
-    IMAGE_CODEC_API Bytes SymbolsToBytes(const Symbols& symbols) override;
+    IMAGE_CODEC_API void BytesToSymbols(const Byte* bytes, size_t byte_num, Symbol* symbols) override;
+    IMAGE_CODEC_API void SymbolsToBytes(const Symbol* symbols, size_t byte_num, Byte* bytes) override;
 };
 
 class Symbol2Codec : public SymbolCodec {
 protected:
     IMAGE_CODEC_API SymbolType GetSymbolType() const override { return SymbolType::SYMBOL2; }
     IMAGE_CODEC_API int BitNumPerSymbol() const override { return 2; }
-    IMAGE_CODEC_API Symbols BytesToSymbols(const Bytes& bytes) override;
-    IMAGE_CODEC_API Bytes SymbolsToBytes(const Symbols& symbols) override;
+    IMAGE_CODEC_API void BytesToSymbols(const Byte* bytes, size_t byte_num, Symbol* symbols) override;
+    IMAGE_CODEC_API void SymbolsToBytes(const Symbol* symbols, size_t byte_num, Byte* bytes) override;
 };
 
 class Symbol3Codec : public SymbolCodec {
 protected:
     IMAGE_CODEC_API SymbolType GetSymbolType() const override { return SymbolType::SYMBOL3; }
     IMAGE_CODEC_API int BitNumPerSymbol() const override { return 3; }
-    IMAGE_CODEC_API Symbols BytesToSymbols(const Bytes& bytes) override;
-    IMAGE_CODEC_API Bytes SymbolsToBytes(const Symbols& symbols) override;
+    IMAGE_CODEC_API void BytesToSymbols(const Byte* bytes, size_t byte_num, Symbol* symbols) override;
+    IMAGE_CODEC_API void SymbolsToBytes(const Symbol* symbols, size_t byte_num, Byte* bytes) override;
+};
+
+class Symbol4Codec : public SymbolCodec {
+protected:
+    IMAGE_CODEC_API SymbolType GetSymbolType() const override { return SymbolType::SYMBOL4; }
+    IMAGE_CODEC_API int BitNumPerSymbol() const override { return 4; }
+    IMAGE_CODEC_API void BytesToSymbols(const Byte* bytes, size_t byte_num, Symbol* symbols) override;
+    IMAGE_CODEC_API void SymbolsToBytes(const Symbol* symbols, size_t byte_num, Byte* bytes) override;
+};
+
+class Symbol1RsCodec : public Symbol1Codec {
+protected:
+    IMAGE_CODEC_API SymbolType GetSymbolType() const override { return SymbolType::SYMBOL1_RS; }
+};
+
+class Symbol2RsCodec : public Symbol2Codec {
+protected:
+    IMAGE_CODEC_API SymbolType GetSymbolType() const override { return SymbolType::SYMBOL2_RS; }
+};
+
+class Symbol3RsCodec : public Symbol3Codec {
+protected:
+    IMAGE_CODEC_API SymbolType GetSymbolType() const override { return SymbolType::SYMBOL3_RS; }
+};
+
+class Symbol4RsCodec : public Symbol4Codec {
+protected:
+    IMAGE_CODEC_API SymbolType GetSymbolType() const override { return SymbolType::SYMBOL4_RS; }
 };
 
 IMAGE_CODEC_API std::unique_ptr<SymbolCodec> create_symbol_codec(SymbolType symbol_type);
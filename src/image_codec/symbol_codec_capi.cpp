@@ -1,5 +1,3 @@
-#include <algorithm>
-
 #include "image_codec_api.h"
 #include "image_codec_types.h"
 #include "symbol_codec.h"
@@ -7,16 +5,7 @@
 extern "C" {
 
 IMAGE_CODEC_API void* create_symbol_codec_c(const char* symbol_type_str) {
-    SymbolType symbol_type = parse_symbol_type(symbol_type_str);
-    if (symbol_type == SymbolType::SYMBOL1) {
-        return new Symbol1Codec;
-    } else if (symbol_type == SymbolType::SYMBOL2) {
-        return new Symbol2Codec;
-    } else if (symbol_type == SymbolType::SYMBOL3) {
-        return new Symbol3Codec;
-    } else {
-        return nullptr;
-    }
+    return create_symbol_codec(parse_symbol_type(symbol_type_str)).release();
 }
 
 IMAGE_CODEC_API int symbol_codec_meta_byte_num_c() {
@@ -27,18 +16,33 @@ IMAGE_CODEC_API int symbol_codec_bit_num_per_symbol_c(void* symbol_codec) {
     return reinterpret_cast<SymbolCodec*>(symbol_codec)->BitNumPerSymbol();
 }
 
+IMAGE_CODEC_API int symbol_codec_padded_part_byte_num_c(void* symbol_codec, size_t frame_size) {
+    return reinterpret_cast<SymbolCodec*>(symbol_codec)->PaddedPartByteNum(frame_size);
+}
+
 IMAGE_CODEC_API void symbol_codec_encode_c(void* symbol_codec, Byte* symbol_byte_p, uint32_t part_id, const Byte* part_byte_p, int part_byte_num, int frame_size) {
-    Bytes part_bytes(part_byte_p, part_byte_p+part_byte_num);
-    Symbols symbols = reinterpret_cast<SymbolCodec*>(symbol_codec)->Encode(part_id, part_bytes, frame_size);
-    std::copy_n(symbols.data(), frame_size, symbol_byte_p);
+    reinterpret_cast<SymbolCodec*>(symbol_codec)->Encode(part_id, part_byte_p, part_byte_num, symbol_byte_p, frame_size);
 }
 
 IMAGE_CODEC_API void symbol_codec_decode_c(void* symbol_codec, bool* success_p, uint32_t* part_id_p, Byte* part_byte_p, const Byte* symbol_byte_p, size_t frame_size) {
-    Symbols symbols(symbol_byte_p, symbol_byte_p+frame_size);
-    auto [success, part_id, part_bytes] = reinterpret_cast<SymbolCodec*>(symbol_codec)->Decode(symbols);
-    *success_p = success;
-    *part_id_p = part_id;
-    std::copy(part_bytes.begin(), part_bytes.end(), part_byte_p);
+    *success_p = reinterpret_cast<SymbolCodec*>(symbol_codec)->Decode(symbol_byte_p, frame_size, *part_id_p, part_byte_p);
+}
+
+// parts are read from part_byte_p at a stride of part_byte_num and frames are written to symbol_byte_p at a stride of frame_size
+IMAGE_CODEC_API void symbol_codec_encode_batch_c(void* symbol_codec, Byte* symbol_byte_p, const uint32_t* part_id_p, const Byte* part_byte_p, int part_byte_num, int frame_size, size_t part_num) {
+    auto codec = reinterpret_cast<SymbolCodec*>(symbol_codec);
+    for (size_t i = 0; i < part_num; ++i) {
+        codec->Encode(part_id_p[i], part_byte_p + i * part_byte_num, part_byte_num, symbol_byte_p + i * frame_size, frame_size);
+    }
+}
+
+// frames are read from symbol_byte_p at a stride of frame_size and parts are written to part_byte_p at a stride of the padded part byte num
+IMAGE_CODEC_API void symbol_codec_decode_batch_c(void* symbol_codec, bool* success_p, uint32_t* part_id_p, Byte* part_byte_p, const Byte* symbol_byte_p, size_t frame_size, size_t part_num) {
+    auto codec = reinterpret_cast<SymbolCodec*>(symbol_codec);
+    size_t padded_part_byte_num = codec->PaddedPartByteNum(frame_size);
+    for (size_t i = 0; i < part_num; ++i) {
+        success_p[i] = codec->Decode(symbol_byte_p + i * frame_size, frame_size, part_id_p[i], part_byte_p + i * padded_part_byte_num);
+    }
 }
 
 IMAGE_CODEC_API void destroy_symbol_codec_c(void* symbol_codec) {
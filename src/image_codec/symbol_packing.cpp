@@ -0,0 +1,142 @@
+#include "symbol_packing.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SYMBOL_PACKING_BMI2 1
+#define SYMBOL_PACKING_BMI2_TARGET __attribute__((target("bmi2")))
+#include <immintrin.h>
+#include <cpuid.h>
+#elif defined(_M_X64) && defined(_MSC_VER)
+#define SYMBOL_PACKING_BMI2 1
+#define SYMBOL_PACKING_BMI2_TARGET
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+namespace {
+
+#if SYMBOL_PACKING_BMI2
+
+void get_cpuid(unsigned leaf, unsigned info[4]) {
+#if defined(_MSC_VER)
+    int info1[4];
+    __cpuidex(info1, static_cast<int>(leaf), 0);
+    std::memcpy(info, info1, sizeof(info1));
+#else
+    __cpuid_count(leaf, 0, info[0], info[1], info[2], info[3]);
+#endif
+}
+
+// zen1 and zen2, and hygon dhyana derived from them, implement pdep and pext in microcode,
+// slower than the scalar path, so only their cpuid bit isn't trusted
+bool has_slow_bmi2() {
+    unsigned info[4];
+    get_cpuid(0, info);
+    char vendor[13] = {};
+    std::memcpy(vendor, &info[1], 4);
+    std::memcpy(vendor + 4, &info[3], 4);
+    std::memcpy(vendor + 8, &info[2], 4);
+    get_cpuid(1, info);
+    unsigned family = (info[0] >> 8) & 0xf;
+    if (family == 0xf) family += (info[0] >> 20) & 0xff;
+    return (std::strcmp(vendor, "AuthenticAMD") == 0 && family == 0x17) || (std::strcmp(vendor, "HygonGenuine") == 0 && family == 0x18);
+}
+
+bool has_bmi2() {
+    unsigned info[4];
+    get_cpuid(0, info);
+    if (info[0] < 7) return false;
+    get_cpuid(7, info);
+    return (info[1] & (1 << 8)) != 0 && !has_slow_bmi2();
+}
+
+uint64_t bswap64(uint64_t v) {
+#if defined(_MSC_VER)
+    return _byteswap_uint64(v);
+#else
+    return __builtin_bswap64(v);
+#endif
+}
+
+template <int BIT_NUM>
+constexpr uint64_t get_symbol_lane_mask() {
+    return 0x0101010101010101ull * ((1 << BIT_NUM) - 1);
+}
+
+template <int BIT_NUM>
+SYMBOL_PACKING_BMI2_TARGET void unpack_symbols_bmi2(const Byte* bytes, size_t byte_num, Symbol* symbols) {
+    size_t group_num = byte_num / BIT_NUM;
+    for (size_t i = 0; i < group_num; ++i) {
+        const Byte* group_bytes = bytes + i * BIT_NUM;
+        uint64_t v = 0;
+        for (int k = 0; k < BIT_NUM; ++k) {
+            v = (v << 8) | group_bytes[k];
+        }
+        uint64_t lanes = bswap64(_pdep_u64(v, get_symbol_lane_mask<BIT_NUM>()));
+        std::memcpy(symbols + i * 8, &lanes, 8);
+    }
+    if (byte_num % BIT_NUM) {
+        unpack_symbol_tail<BIT_NUM>(bytes + group_num * BIT_NUM, byte_num % BIT_NUM, symbols + group_num * 8);
+    }
+}
+
+template <int BIT_NUM>
+SYMBOL_PACKING_BMI2_TARGET void pack_symbols_bmi2(const Symbol* symbols, size_t byte_num, Byte* bytes) {
+    size_t group_num = byte_num / BIT_NUM;
+    for (size_t i = 0; i < group_num; ++i) {
+        uint64_t lanes;
+        std::memcpy(&lanes, symbols + i * 8, 8);
+        uint64_t v = _pext_u64(bswap64(lanes), get_symbol_lane_mask<BIT_NUM>());
+        Byte* group_bytes = bytes + i * BIT_NUM;
+        for (int k = 0; k < BIT_NUM; ++k) {
+            group_bytes[k] = static_cast<Byte>(v >> ((BIT_NUM - 1 - k) * 8));
+        }
+    }
+    if (byte_num % BIT_NUM) {
+        pack_symbol_tail<BIT_NUM>(symbols + group_num * 8, byte_num % BIT_NUM, bytes + group_num * BIT_NUM);
+    }
+}
+
+const bool g_bmi2 = has_bmi2();
+
+#else
+
+const bool g_bmi2 = false;
+
+#endif
+
+}
+
+bool is_symbol_packing_accelerated() {
+    return g_bmi2;
+}
+
+template <int BIT_NUM>
+void unpack_symbols(const Byte* bytes, size_t byte_num, Symbol* symbols) {
+#if SYMBOL_PACKING_BMI2
+    if (g_bmi2) {
+        unpack_symbols_bmi2<BIT_NUM>(bytes, byte_num, symbols);
+        return;
+    }
+#endif
+    unpack_symbols_scalar<BIT_NUM>(bytes, byte_num, symbols);
+}
+
+template <int BIT_NUM>
+void pack_symbols(const Symbol* symbols, size_t byte_num, Byte* bytes) {
+#if SYMBOL_PACKING_BMI2
+    if (g_bmi2) {
+        pack_symbols_bmi2<BIT_NUM>(symbols, byte_num, bytes);
+        return;
+    }
+#endif
+    pack_symbols_scalar<BIT_NUM>(symbols, byte_num, bytes);
+}
+
+template IMAGE_CODEC_API void unpack_symbols<1>(const Byte* bytes, size_t byte_num, Symbol* symbols);
+template IMAGE_CODEC_API void unpack_symbols<2>(const Byte* bytes, size_t byte_num, Symbol* symbols);
+template IMAGE_CODEC_API void unpack_symbols<3>(const Byte* bytes, size_t byte_num, Symbol* symbols);
+template IMAGE_CODEC_API void unpack_symbols<4>(const Byte* bytes, size_t byte_num, Symbol* symbols);
+template IMAGE_CODEC_API void pack_symbols<1>(const Symbol* symbols, size_t byte_num, Byte* bytes);
+template IMAGE_CODEC_API void pack_symbols<2>(const Symbol* symbols, size_t byte_num, Byte* bytes);
+template IMAGE_CODEC_API void pack_symbols<3>(const Symbol* symbols, size_t byte_num, Byte* bytes);
+template IMAGE_CODEC_API void pack_symbols<4>(const Symbol* symbols, size_t byte_num, Byte* bytes);
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstring>
+#include <utility>
+
+#include "image_codec_api.h"
+#include "image_codec_types.h"
+
+// every group of BIT_NUM bytes holds 8 symbols, the first symbol in the most significant bits
+template <int BIT_NUM>
+constexpr size_t get_packed_symbol_num(size_t byte_num) {
+    return (byte_num * 8 + BIT_NUM - 1) / BIT_NUM;
+}
+
+template <int BIT_NUM, size_t... BYTE_IDS, size_t... SYMBOL_IDS>
+inline void unpack_symbol_group(const Byte* bytes, Symbol* symbols, std::index_sequence<BYTE_IDS...>, std::index_sequence<SYMBOL_IDS...>) {
+    uint32_t v = ((static_cast<uint32_t>(bytes[BYTE_IDS]) << ((BIT_NUM - 1 - BYTE_IDS) * 8)) | ...);
+    ((symbols[SYMBOL_IDS] = static_cast<Symbol>((v >> ((7 - SYMBOL_IDS) * BIT_NUM)) & ((1 << BIT_NUM) - 1))), ...);
+}
+
+template <int BIT_NUM>
+inline void unpack_symbol_group(const Byte* bytes, Symbol* symbols) {
+    unpack_symbol_group<BIT_NUM>(bytes, symbols, std::make_index_sequence<BIT_NUM>(), std::make_index_sequence<8>());
+}
+
+template <int BIT_NUM, size_t... BYTE_IDS, size_t... SYMBOL_IDS>
+inline void pack_symbol_group(const Symbol* symbols, Byte* bytes, std::index_sequence<BYTE_IDS...>, std::index_sequence<SYMBOL_IDS...>) {
+    uint32_t v = ((static_cast<uint32_t>(symbols[SYMBOL_IDS] & ((1 << BIT_NUM) - 1)) << ((7 - SYMBOL_IDS) * BIT_NUM)) | ...);
+    ((bytes[BYTE_IDS] = static_cast<Byte>(v >> ((BIT_NUM - 1 - BYTE_IDS) * 8))), ...);
+}
+
+template <int BIT_NUM>
+inline void pack_symbol_group(const Symbol* symbols, Byte* bytes) {
+    pack_symbol_group<BIT_NUM>(symbols, bytes, std::make_index_sequence<BIT_NUM>(), std::make_index_sequence<8>());
+}
+
+template <int BIT_NUM>
+inline void unpack_symbol_tail(const Byte* bytes, size_t byte_num, Symbol* symbols) {
+    Byte group_bytes[BIT_NUM] = {};
+    Symbol group_symbols[8];
+    std::memcpy(group_bytes, bytes, byte_num);
+    unpack_symbol_group<BIT_NUM>(group_bytes, group_symbols);
+    std::memcpy(symbols, group_symbols, get_packed_symbol_num<BIT_NUM>(byte_num));
+}
+
+template <int BIT_NUM>
+inline void pack_symbol_tail(const Symbol* symbols, size_t byte_num, Byte* bytes) {
+    Symbol group_symbols[8] = {};
+    Byte group_bytes[BIT_NUM];
+    std::memcpy(group_symbols, symbols, get_packed_symbol_num<BIT_NUM>(byte_num));
+    pack_symbol_group<BIT_NUM>(group_symbols, group_bytes);
+    std::memcpy(bytes, group_bytes, byte_num);
+}
+
+template <int BIT_NUM>
+void unpack_symbols_scalar(const Byte* bytes, size_t byte_num, Symbol* symbols) {
+    size_t group_num = byte_num / BIT_NUM;
+    for (size_t i = 0; i < group_num; ++i) {
+        unpack_symbol_group<BIT_NUM>(bytes + i * BIT_NUM, symbols + i * 8);
+    }
+    if (byte_num % BIT_NUM) {
+        unpack_symbol_tail<BIT_NUM>(bytes + group_num * BIT_NUM, byte_num % BIT_NUM, symbols + group_num * 8);
+    }
+}
+
+template <int BIT_NUM>
+void pack_symbols_scalar(const Symbol* symbols, size_t byte_num, Byte* bytes) {
+    size_t group_num = byte_num / BIT_NUM;
+    for (size_t i = 0; i < group_num; ++i) {
+        pack_symbol_group<BIT_NUM>(symbols + i * 8, bytes + i * BIT_NUM);
+    }
+    if (byte_num % BIT_NUM) {
+        pack_symbol_tail<BIT_NUM>(symbols + group_num * 8, byte_num % BIT_NUM, bytes + group_num * BIT_NUM);
+    }
+}
+
+IMAGE_CODEC_API bool is_symbol_packing_accelerated();
+
+// symbols and bytes are laid out as in the scalar kernels, dispatched to pdep/pext when available
+template <int BIT_NUM>
+IMAGE_CODEC_API void unpack_symbols(const Byte* bytes, size_t byte_num, Symbol* symbols);
+template <int BIT_NUM>
+IMAGE_CODEC_API void pack_symbols(const Symbol* symbols, size_t byte_num, Byte* bytes);
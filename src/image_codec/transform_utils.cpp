@@ -3,6 +3,7 @@
 #include <exception>
 
 #include "transform_utils.h"
+#include "pixel_classifier.h"
 
 void Transform::Load(const std::string& path) {
     std::ifstream f(path, std::ios_base::binary);
@@ -102,15 +103,11 @@ std::string get_sphere_str(const Transform::Sphere& sphere) {
     return array_to_string(sphere);
 }
 
-cv::Mat do_sphere(const cv::Mat& img, const Transform::Sphere& sphere) {
-    auto cols0 = img.cols / 2;
-    auto rows0 = img.rows / 2;
-    auto cols1 = img.cols - cols0;
-    auto rows1 = img.rows - rows0;
-    cv::Mat img_nw = img(cv::Rect(0, 0, cols0, rows0));
-    cv::Mat img_sw = img(cv::Rect(0, rows0, cols0, rows1));
-    cv::Mat img_se = img(cv::Rect(cols0, rows0, cols1, rows1));
-    cv::Mat img_ne = img(cv::Rect(cols0, 0, cols1, rows0));
+std::array<std::pair<cv::Rect, cv::Mat>, 4> get_sphere_warps(int cols, int rows, const Transform::Sphere& sphere) {
+    auto cols0 = cols / 2;
+    auto rows0 = rows / 2;
+    auto cols1 = cols - cols0;
+    auto rows1 = rows - rows0;
     std::array<cv::Point2f, 4> src_corners_nw{
         cv::Point2f{0.f, 0.f},
         cv::Point2f{-sphere[0] * cols0, static_cast<float>(rows0)},
@@ -159,23 +156,21 @@ cv::Mat do_sphere(const cv::Mat& img, const Transform::Sphere& sphere) {
         cv::Point2f{static_cast<float>(cols1), static_cast<float>(rows0)},
         cv::Point2f{static_cast<float>(cols1), 0.f},
     };
-    cv::Mat mat_nw = cv::getPerspectiveTransform(src_corners_nw, dst_corners_nw);
-    cv::Mat mat_sw = cv::getPerspectiveTransform(src_corners_sw, dst_corners_sw);
-    cv::Mat mat_se = cv::getPerspectiveTransform(src_corners_se, dst_corners_se);
-    cv::Mat mat_ne = cv::getPerspectiveTransform(src_corners_ne, dst_corners_ne);
-    cv::Mat img_nw1;
-    cv::Mat img_sw1;
-    cv::Mat img_se1;
-    cv::Mat img_ne1;
-    cv::warpPerspective(img_nw, img_nw1, mat_nw, img_nw.size(), cv::INTER_NEAREST, cv::BORDER_CONSTANT, cv::Scalar(255, 255, 255));
-    cv::warpPerspective(img_sw, img_sw1, mat_sw, img_sw.size(), cv::INTER_NEAREST, cv::BORDER_CONSTANT, cv::Scalar(255, 255, 255));
-    cv::warpPerspective(img_se, img_se1, mat_se, img_se.size(), cv::INTER_NEAREST, cv::BORDER_CONSTANT, cv::Scalar(255, 255, 255));
-    cv::warpPerspective(img_ne, img_ne1, mat_ne, img_ne.size(), cv::INTER_NEAREST, cv::BORDER_CONSTANT, cv::Scalar(255, 255, 255));
+    return {
+        std::make_pair(cv::Rect(0, 0, cols0, rows0), cv::getPerspectiveTransform(src_corners_nw, dst_corners_nw)),
+        std::make_pair(cv::Rect(0, rows0, cols0, rows1), cv::getPerspectiveTransform(src_corners_sw, dst_corners_sw)),
+        std::make_pair(cv::Rect(cols0, rows0, cols1, rows1), cv::getPerspectiveTransform(src_corners_se, dst_corners_se)),
+        std::make_pair(cv::Rect(cols0, 0, cols1, rows0), cv::getPerspectiveTransform(src_corners_ne, dst_corners_ne)),
+    };
+}
+
+cv::Mat do_sphere(const cv::Mat& img, const Transform::Sphere& sphere) {
     cv::Mat img1(img.rows, img.cols, img.type());
-    img_nw1.copyTo(img1(cv::Rect(0, 0, cols0, rows0)));
-    img_sw1.copyTo(img1(cv::Rect(0, rows0, cols0, rows1)));
-    img_se1.copyTo(img1(cv::Rect(cols0, rows0, cols1, rows1)));
-    img_ne1.copyTo(img1(cv::Rect(cols0, 0, cols1, rows0)));
+    for (const auto& [rect, mat] : get_sphere_warps(img.cols, img.rows, sphere)) {
+        cv::Mat img_q;
+        cv::warpPerspective(img(rect), img_q, mat, rect.size(), cv::INTER_NEAREST, cv::BORDER_CONSTANT, cv::Scalar(255, 255, 255));
+        img_q.copyTo(img1(rect));
+    }
     return img1;
 }
 
@@ -365,6 +360,15 @@ cv::Mat do_filter(const cv::Mat& img, int filter_level) {
     return img1;
 }
 
+int get_filter_radius(int filter_level) {
+    int radius = 0;
+    if (filter_level >= 4) radius += 4;
+    if (filter_level >= 3) radius += 3;
+    if (filter_level >= 2) radius += 2;
+    if (filter_level >= 1) radius += 1;
+    return radius;
+}
+
 int parse_binarization_threshold(const std::string& binarization_threshold_str) {
     int binarization_threshold = 0;
     bool fail = false;
@@ -414,43 +418,13 @@ std::string get_pixelization_threshold_str(const Transform::PixelizationThreshol
 }
 
 cv::Mat do_pixelize(const cv::Mat& img, SymbolType symbol_type, Transform::PixelizationThreshold threshold) {
-    cv::Mat img_channels[3];
-    cv::split(img, img_channels);
-    cv::threshold(img_channels[0], img_channels[0], static_cast<double>(threshold[0]), 255, cv::THRESH_BINARY);
-    cv::threshold(img_channels[1], img_channels[1], static_cast<double>(threshold[1]), 255, cv::THRESH_BINARY);
-    cv::threshold(img_channels[2], img_channels[2], static_cast<double>(threshold[2]), 255, cv::THRESH_BINARY);
-    cv::Mat img1;
-    cv::merge(img_channels, 3, img1);
-    if (symbol_type == SymbolType::SYMBOL2) {
-        for (int y = 0; y < img1.rows; ++y) {
-            for (int x = 0; x < img1.cols; ++x) {
-                auto& c1 = img1.at<cv::Vec3b>(y, x);
-                if (c1[0] == 255 && c1[1] == 0 && c1[2] == 255) {
-                    const auto& c = img.at<cv::Vec3b>(y, x);
-                    if (c[0] > c[2]) {
-                        c1[0] = 255;
-                        c1[2] = 0;
-                    } else {
-                        c1[0] = 0;
-                        c1[2] = 255;
-                    }
-                }
-            }
-        }
-    } else if (symbol_type == SymbolType::SYMBOL1) {
-        for (int y = 0; y < img1.rows; ++y) {
-            for (int x = 0; x < img1.cols; ++x) {
-                auto& c1 = img1.at<cv::Vec3b>(y, x);
-                if (static_cast<int>(c1[0]) + static_cast<int>(c1[1]) + static_cast<int>(c1[2]) <= 255) {
-                    c1[0] = 0;
-                    c1[1] = 0;
-                    c1[2] = 0;
-                } else {
-                    c1[0] = 255;
-                    c1[1] = 255;
-                    c1[2] = 255;
-                }
-            }
+    PixelClassifier pixel_classifier(symbol_type, threshold);
+    cv::Mat img1(img.rows, img.cols, CV_8UC3);
+    for (int y = 0; y < img.rows; ++y) {
+        const uchar* src = img.ptr<uchar>(y);
+        cv::Vec3b* dst = img1.ptr<cv::Vec3b>(y);
+        for (int x = 0; x < img.cols; ++x) {
+            dst[x] = get_pixel_color_bgr(pixel_classifier.Classify(src + x * 3));
         }
     }
     return img1;
@@ -491,3 +465,37 @@ cv::Mat transform_image(const cv::Mat& img, const Transform& transform) {
     img1 = do_filter(img1, transform.filter_level);
     return img1;
 }
+
+bool TransformCache::IsUpToDate(const cv::Mat& img, const Transform& transform) const {
+    return !map.empty() && frame_size == img.size() && bbox == transform.bbox && sphere == transform.sphere;
+}
+
+void TransformCache::Update(const cv::Mat& img, const Transform& transform) {
+    if (IsUpToDate(img, transform)) return;
+    frame_size = img.size();
+    bbox = transform.bbox;
+    sphere = transform.sphere;
+    auto [crop_x0, crop_y0, crop_x1, crop_y1] = get_bbox(img, bbox);
+    int cols = crop_x1 - crop_x0;
+    int rows = crop_y1 - crop_y0;
+    cv::Mat coords(rows, cols, CV_32FC2);
+    for (int y = 0; y < rows; ++y) {
+        auto p = coords.ptr<cv::Vec2f>(y);
+        for (int x = 0; x < cols; ++x) {
+            p[x] = cv::Vec2f(static_cast<float>(crop_x0 + x), static_cast<float>(crop_y0 + y));
+        }
+    }
+    cv::Mat map1(rows, cols, CV_32FC2);
+    for (const auto& [rect, mat] : get_sphere_warps(cols, rows, sphere)) {
+        cv::Mat map_q;
+        cv::warpPerspective(coords(rect), map_q, mat, rect.size(), cv::INTER_NEAREST, cv::BORDER_CONSTANT, cv::Scalar(-1, -1));
+        map_q.copyTo(map1(rect));
+    }
+    map1.convertTo(map, CV_16SC2);
+}
+
+cv::Mat transform_image(const cv::Mat& img, const Transform& transform, TransformCache& transform_cache) {
+    transform_cache.Update(img, transform);
+    cv::remap(img, transform_cache.output, transform_cache.map, cv::Mat(), cv::INTER_NEAREST, cv::BORDER_CONSTANT, cv::Scalar(255, 255, 255));
+    return do_filter(transform_cache.output, transform.filter_level);
+}
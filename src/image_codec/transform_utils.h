@@ -27,6 +27,17 @@ struct Transform {
 
 IMAGE_CODEC_API std::ostream& operator<<(std::ostream& os, const Transform& transform);
 
+struct TransformCache {
+    cv::Size frame_size;
+    Transform::Bbox bbox{0, 0, 0, 0};
+    Transform::Sphere sphere{0, 0, 0, 0};
+    cv::Mat map;
+    cv::Mat output;
+
+    IMAGE_CODEC_API bool IsUpToDate(const cv::Mat& img, const Transform& transform) const;
+    IMAGE_CODEC_API void Update(const cv::Mat& img, const Transform& transform);
+};
+
 inline bool is_white(const cv::Mat& img, int x, int y) {
     return (img.channels() == 1 && img.at<uchar>(y, x) == 255) || (img.channels() == 3 && img.at<cv::Vec3b>(y, x) == cv::Vec3b(255, 255, 255));
 }
@@ -74,6 +85,7 @@ IMAGE_CODEC_API std::array<int, 4> get_bbox(const cv::Mat& img, const Transform:
 IMAGE_CODEC_API cv::Mat do_crop(const cv::Mat& img, const std::array<int, 4>& bbox);
 IMAGE_CODEC_API Transform::Sphere parse_sphere(const std::string& sphere_str);
 IMAGE_CODEC_API std::string get_sphere_str(const Transform::Sphere& sphere);
+IMAGE_CODEC_API std::array<std::pair<cv::Rect, cv::Mat>, 4> get_sphere_warps(int cols, int rows, const Transform::Sphere& sphere);
 IMAGE_CODEC_API cv::Mat do_sphere(const cv::Mat& img, const Transform::Sphere& sphere);
 IMAGE_CODEC_API Transform::Quad parse_quad(const std::string& quad_str);
 IMAGE_CODEC_API std::string get_quad_str(const Transform::Quad& quad);
@@ -82,6 +94,7 @@ IMAGE_CODEC_API cv::Mat do_auto_quad(const cv::Mat& img, int binarization_thresh
 IMAGE_CODEC_API int parse_filter_level(const std::string& filter_level_str);
 IMAGE_CODEC_API std::string get_filter_level_str(int filter_level);
 IMAGE_CODEC_API cv::Mat do_filter(const cv::Mat& img, int filter_level);
+IMAGE_CODEC_API int get_filter_radius(int filter_level);
 IMAGE_CODEC_API int parse_binarization_threshold(const std::string& binarization_threshold_str);
 IMAGE_CODEC_API std::string get_binarization_threshold_str(int binarization_threshold);
 IMAGE_CODEC_API cv::Mat do_binarize(const cv::Mat& img, int threshold);
@@ -92,3 +105,5 @@ IMAGE_CODEC_API cv::Mat do_pixelize(const cv::Mat& img, SymbolType symbol_type,
 IMAGE_CODEC_API void add_transform_options(boost::program_options::options_description_easy_init& desc_handler);
 IMAGE_CODEC_API Transform get_transform(const boost::program_options::variables_map& vm);
 IMAGE_CODEC_API cv::Mat transform_image(const cv::Mat& img, const Transform& transform);
+// the returned image shares transform_cache.output and is overwritten by the next call
+IMAGE_CODEC_API cv::Mat transform_image(const cv::Mat& img, const Transform& transform, TransformCache& transform_cache);
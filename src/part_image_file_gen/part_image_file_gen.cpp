@@ -14,6 +14,8 @@ int main(int argc, char** argv) {
         std::string dim_str;
         int pixel_size = 0;
         int space_size = 0;
+        int frame_part_num = 1;
+        std::string compression_type_str = "none";
         boost::program_options::options_description desc("usage");
         auto desc_handler = desc.add_options();
         desc_handler("help", "help message");
@@ -23,6 +25,9 @@ int main(int argc, char** argv) {
         desc_handler("dim", boost::program_options::value<std::string>(&dim_str), "dim as tile_x_num,tile_y_num,tile_x_size,tile_y_size");
         desc_handler("pixel_size", boost::program_options::value<int>(&pixel_size), "pixel size");
         desc_handler("space_size", boost::program_options::value<int>(&space_size), "space size");
+        desc_handler("frame_part_num", boost::program_options::value<int>(&frame_part_num), "independently coded parts per frame");
+        desc_handler("compression_type", boost::program_options::value<std::string>(&compression_type_str), "compression type, none or zlib");
+        desc_handler("sparse", "skip all-zero parts, a sparse map lists them instead");
         boost::program_options::positional_options_description p_desc;
         p_desc.add("save_image_dir_path", 1);
         p_desc.add("target_file", 1);
@@ -53,15 +58,22 @@ int main(int argc, char** argv) {
 
         auto symbol_type = parse_symbol_type(symbol_type_str);
         auto dim = parse_dim(dim_str);
-        auto [symbol_codec, part_byte_num, raw_bytes, part_num] = prepare_part_images(target_file, symbol_type, dim);
-        auto gen_image_fn = generate_part_images(dim, pixel_size, space_size, symbol_codec.get(), part_byte_num, raw_bytes, part_num);
-        std::cerr << "\rpart " << 0 << "/" << (part_num - 1);
+        auto compression_type = parse_compression_type(compression_type_str);
+        auto [symbol_codec, part_byte_num, raw_bytes, part_num] = prepare_part_images(target_file, symbol_type, dim, frame_part_num, compression_type);
+        std::unique_ptr<SparseMap> sparse_map;
+        if (vm.count("sparse")) {
+            sparse_map = std::make_unique<SparseMap>(raw_bytes, part_byte_num, part_num);
+            std::cout << sparse_map->ZeroPartNum() << " zero parts skipped\n";
+        }
+        auto gen_image_fn = generate_part_images(dim, pixel_size, space_size, symbol_codec.get(), part_byte_num, raw_bytes, part_num, frame_part_num, sparse_map.get());
+        uint32_t displayed_part_num = sparse_map ? sparse_map->DisplayedPartNum() : part_num;
+        std::cerr << "\rpart " << 0 << "/" << (displayed_part_num - 1);
         while (true) {
             auto data = gen_image_fn();
             if (!data) break;
             auto& [part_id, img] = data.value();
-            std::cerr << "\rpart " << part_id << "/" << (part_num - 1);
-            auto img_file_name = get_part_image_file_name(part_num, part_id);
+            std::cerr << "\rpart " << part_id << "/" << (displayed_part_num - 1);
+            auto img_file_name = get_part_image_file_name(displayed_part_num, part_id);
             cv::imwrite((std::filesystem::path(save_image_dir_path)/img_file_name).string(), img);
         }
         std::cerr << "\n";
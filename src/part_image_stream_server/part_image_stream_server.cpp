@@ -26,6 +26,8 @@ int main(int argc, char** argv) {
         std::string dim_str;
         int pixel_size = 0;
         int space_size = 0;
+        int frame_part_num = 1;
+        std::string compression_type_str = "none";
         int port = 0;
         boost::program_options::options_description desc("usage");
         auto desc_handler = desc.add_options();
@@ -35,6 +37,9 @@ int main(int argc, char** argv) {
         desc_handler("dim", boost::program_options::value<std::string>(&dim_str), "dim as tile_x_num,tile_y_num,tile_x_size,tile_y_size");
         desc_handler("pixel_size", boost::program_options::value<int>(&pixel_size), "pixel size");
         desc_handler("space_size", boost::program_options::value<int>(&space_size), "space size");
+        desc_handler("frame_part_num", boost::program_options::value<int>(&frame_part_num), "independently coded parts per frame");
+        desc_handler("compression_type", boost::program_options::value<std::string>(&compression_type_str), "compression type, none or zlib");
+        desc_handler("sparse", "skip all-zero parts, a sparse map lists them instead");
         desc_handler("port", boost::program_options::value<int>(&port), "port");
         boost::program_options::positional_options_description p_desc;
         p_desc.add("target_file", 1);
@@ -57,9 +62,15 @@ int main(int argc, char** argv) {
 
         auto symbol_type = parse_symbol_type(symbol_type_str);
         auto dim = parse_dim(dim_str);
-        auto [symbol_codec, part_byte_num, raw_bytes, part_num] = prepare_part_images(target_file, symbol_type, dim);
-        auto gen_image_fn1 = generate_part_images(dim, pixel_size, space_size, symbol_codec.get(), part_byte_num, raw_bytes, part_num);
-        auto gen_image_fn2 = gen_images(gen_image_fn1, part_num);
+        auto compression_type = parse_compression_type(compression_type_str);
+        auto [symbol_codec, part_byte_num, raw_bytes, part_num] = prepare_part_images(target_file, symbol_type, dim, frame_part_num, compression_type);
+        std::unique_ptr<SparseMap> sparse_map;
+        if (vm.count("sparse")) {
+            sparse_map = std::make_unique<SparseMap>(raw_bytes, part_byte_num, part_num);
+            std::cout << sparse_map->ZeroPartNum() << " zero parts skipped\n";
+        }
+        auto gen_image_fn1 = generate_part_images(dim, pixel_size, space_size, symbol_codec.get(), part_byte_num, raw_bytes, part_num, frame_part_num, sparse_map.get());
+        auto gen_image_fn2 = gen_images(gen_image_fn1, sparse_map ? sparse_map->DisplayedPartNum() : part_num);
         start_image_stream_server(gen_image_fn2, port);
     }
     catch (std::exception& e) {
@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "image_codec.h"
+#include "test_utils.h"
+
+bool is_supported(BlobStorageType blob_storage_type, const std::string& blob_path) {
+    std::ofstream(blob_path, std::ios_base::binary);
+    try {
+        create_blob_storage(blob_storage_type, blob_path, 1, 1);
+        return true;
+    }
+    catch (const std::exception& e) {
+        std::cout << get_blob_storage_type_str(blob_storage_type) << " skipped, " << e.what() << "\n";
+        return false;
+    }
+}
+
+// parts are read back before and after flush, in an order that leaves both gaps and runs of consecutive ids
+bool test_read_write(std::mt19937& rng, BlobStorageType blob_storage_type, int part_byte_num, uint32_t part_num, size_t write_behind_byte_budget) {
+    std::string name = std::string(write_behind_byte_budget ? "write behind " : "") + get_blob_storage_type_str(blob_storage_type) + " read write part_byte_num " + std::to_string(part_byte_num) + " part_num " + std::to_string(part_num);
+    auto dir = std::filesystem::temp_directory_path() / "test_blob_storage";
+    std::filesystem::create_directories(dir);
+    auto blob_path = (dir / "blob").string();
+    std::ofstream(blob_path, std::ios_base::binary);
+    std::filesystem::resize_file(blob_path, static_cast<uint64_t>(part_byte_num) * part_num);
+
+    Bytes blob_bytes(static_cast<size_t>(part_byte_num) * part_num, 0);
+    std::vector<uint32_t> part_ids(part_num);
+    for (uint32_t part_id = 0; part_id < part_num; ++part_id) part_ids[part_id] = part_id;
+    std::shuffle(part_ids.begin(), part_ids.begin() + part_num / 2, rng);
+    bool pass = true;
+    {
+        auto blob_storage = create_blob_storage(blob_storage_type, blob_path, part_byte_num, part_num);
+        if (write_behind_byte_budget) blob_storage = std::make_unique<WriteBehindBlobStorage>(std::move(blob_storage), write_behind_byte_budget, std::chrono::milliseconds(10));
+        Bytes part_bytes(part_byte_num);
+        Bytes part_bytes1(part_byte_num);
+        for (size_t i = 0; i < part_ids.size(); ++i) {
+            uint32_t part_id = part_ids[i];
+            for (auto& b : part_bytes) b = static_cast<Byte>(rng());
+            std::copy(part_bytes.begin(), part_bytes.end(), blob_bytes.begin() + static_cast<size_t>(part_id) * part_byte_num);
+            blob_storage->WritePart(part_id, part_bytes);
+            if (i % 97 == 0) {
+                uint32_t part_id1 = part_ids[rng() % (i + 1)];
+                blob_storage->ReadPart(part_id1, part_bytes1.data());
+                pass = pass && std::equal(part_bytes1.begin(), part_bytes1.end(), blob_bytes.begin() + static_cast<size_t>(part_id1) * part_byte_num);
+            }
+        }
+        blob_storage->Flush();
+        for (uint32_t part_id = 0; part_id < part_num; part_id += 13) {
+            blob_storage->ReadPart(part_id, part_bytes1.data());
+            pass = pass && std::equal(part_bytes1.begin(), part_bytes1.end(), blob_bytes.begin() + static_cast<size_t>(part_id) * part_byte_num);
+        }
+        blob_storage->Sync();
+    }
+    Bytes file_bytes(blob_bytes.size());
+    std::ifstream(blob_path, std::ios_base::binary).read(reinterpret_cast<char*>(file_bytes.data()), file_bytes.size());
+    pass = pass && file_bytes == blob_bytes;
+    std::filesystem::remove_all(dir);
+    std::cout << name << (pass ? " pass\n" : " fail\n");
+    return pass;
+}
+
+// the fountain decoder reads back parts that may still be buffered by the storage
+bool test_fountain_transfer(std::mt19937& rng, BlobStorageType blob_storage_type, uint32_t file_size, size_t write_behind_byte_budget) {
+    std::string name = std::string(write_behind_byte_budget ? "write behind " : "") + get_blob_storage_type_str(blob_storage_type) + " fountain transfer file_size " + std::to_string(file_size);
+    TestTransfer transfer("test_blob_storage", get_random_bytes(rng, file_size));
+    auto symbol_type = SymbolType::SYMBOL1;
+    auto dim = get_test_dim(64);
+    int part_byte_num = get_part_byte_num(symbol_type, dim);
+    transfer.LoadTaskBytes(part_byte_num);
+    const Bytes& raw_bytes = transfer.RawBytes();
+    uint32_t part_num = transfer.PartNum();
+    FountainCode fountain_code(part_num);
+
+    Task task(transfer.OutputFile(), blob_storage_type);
+    task.SetWriteBehind(write_behind_byte_budget);
+    transfer.InitTask(task, symbol_type, dim);
+    uint32_t seq = 0;
+    Bytes part_bytes(part_byte_num);
+    for (uint32_t part_id = 0; part_id < part_num && !task.IsDone(); ++part_id) {
+        if (rng() % 4 == 0) {
+            fountain_code.Encode(seq, raw_bytes.data(), part_byte_num, part_bytes.data());
+            task.UpdatePart(FOUNTAIN_PART_ID_FLAG | seq++, part_bytes);
+        } else {
+            task.UpdatePart(part_id, transfer.GetPart(part_id));
+        }
+    }
+    while (!task.IsDone() && seq < 20 * part_num) {
+        fountain_code.Encode(seq, raw_bytes.data(), part_byte_num, part_bytes.data());
+        task.UpdatePart(FOUNTAIN_PART_ID_FLAG | seq++, part_bytes);
+    }
+    bool pass = transfer.FinalizeAndCompare(task);
+    std::cout << name << (pass ? " pass\n" : " fail\n");
+    return pass;
+}
+
+// the status written by the io thread must only record parts already in the blob
+bool test_write_behind_resume(std::mt19937& rng, BlobStorageType blob_storage_type) {
+    std::string name = "write behind " + get_blob_storage_type_str(blob_storage_type) + " resume";
+    auto dir = std::filesystem::temp_directory_path() / "test_blob_storage";
+    std::filesystem::create_directories(dir);
+    auto output_file = (dir / "output").string();
+    int part_byte_num = 64;
+    uint32_t part_num = 20000;
+    auto dim = get_test_dim(part_byte_num);
+    Bytes raw_bytes(static_cast<size_t>(part_byte_num) * part_num);
+    for (auto& e : raw_bytes) e = static_cast<Byte>(rng());
+    uint32_t done_part_num = 0;
+    {
+        Task task(output_file, blob_storage_type);
+        task.SetWriteBehind(1 << 16);
+        task.Init(SymbolType::SYMBOL1, dim, part_num);
+        task.AllocateBlob();
+        for (uint32_t part_id = 0; part_id < part_num; part_id += 2) {
+            task.UpdatePart(part_id, Bytes(raw_bytes.begin() + static_cast<size_t>(part_id) * part_byte_num, raw_bytes.begin() + static_cast<size_t>(part_id + 1) * part_byte_num));
+        }
+        task.Flush();
+        done_part_num = task.DonePartNum();
+    }
+    Task task(output_file, blob_storage_type);
+    task.Load();
+    bool pass = task.DonePartNum() == done_part_num;
+    Bytes blob_bytes(raw_bytes.size());
+    std::ifstream(task.BlobPath(), std::ios_base::binary).read(reinterpret_cast<char*>(blob_bytes.data()), blob_bytes.size());
+    for (uint32_t part_id = 0; part_id < part_num; ++part_id) {
+        bool done = task.IsPartDone(part_id);
+        pass = pass && done == (part_id % 2 == 0);
+        if (done) pass = pass && std::equal(blob_bytes.begin() + static_cast<size_t>(part_id) * part_byte_num, blob_bytes.begin() + static_cast<size_t>(part_id + 1) * part_byte_num, raw_bytes.begin() + static_cast<size_t>(part_id) * part_byte_num);
+    }
+    std::filesystem::remove_all(dir);
+    std::cout << name << (pass ? " pass\n" : " fail\n");
+    return pass;
+}
+
+// fails every write after the first fail_part_num parts, like a full disk
+class FailingBlobStorage : public BlobStorage {
+public:
+    FailingBlobStorage(size_t fail_part_num) : m_fail_part_num(fail_part_num) {}
+    void WritePart(uint32_t, const Bytes&) override {
+        if (m_part_num++ >= m_fail_part_num) throw std::runtime_error("no space left on device");
+    }
+    void ReadPart(uint32_t, Byte*) override {}
+    void Flush() override {}
+    void Sync() override {}
+
+private:
+    size_t m_fail_part_num;
+    size_t m_part_num = 0;
+};
+
+// counts the parts written and the parts written before the last sync
+class SyncCountingBlobStorage : public BlobStorage {
+public:
+    void WritePart(uint32_t, const Bytes&) override { ++m_written_part_num; }
+    void ReadPart(uint32_t, Byte*) override {}
+    void Flush() override {}
+    void Sync() override { m_synced_part_num = m_written_part_num; }
+    size_t WrittenPartNum() const { return m_written_part_num; }
+    size_t SyncedPartNum() const { return m_synced_part_num; }
+
+private:
+    size_t m_written_part_num = 0;
+    size_t m_synced_part_num = 0;
+};
+
+// the flush callbacks write the task status, so every part before them must be synced
+bool test_write_behind_sync() {
+    std::string name = "write behind sync";
+    auto sync_counting_blob_storage = std::make_unique<SyncCountingBlobStorage>();
+    auto& counter = *sync_counting_blob_storage;
+    bool pass = true;
+    {
+        WriteBehindBlobStorage blob_storage(std::move(sync_counting_blob_storage), 1 << 16, std::chrono::milliseconds(10));
+        Bytes part_bytes(16, 1);
+        for (int round = 0; round < 10; ++round) {
+            for (uint32_t part_id = 0; part_id < 100; ++part_id) blob_storage.WritePart(round * 100 + part_id, part_bytes);
+            size_t part_num = (round + 1) * 100;
+            blob_storage.FlushAsync([&counter, &pass, part_num] {
+                pass = pass && counter.SyncedPartNum() >= part_num && counter.SyncedPartNum() == counter.WrittenPartNum();
+            });
+        }
+        blob_storage.Close();
+    }
+    std::cout << name << (pass ? " pass\n" : " fail\n");
+    return pass;
+}
+
+// the error of the io thread reaches the writer instead of being dropped
+bool test_write_behind_error() {
+    std::string name = "write behind error";
+    bool pass = true;
+    {
+        WriteBehindBlobStorage blob_storage(std::make_unique<FailingBlobStorage>(10), 1 << 16, std::chrono::milliseconds(10));
+        Bytes part_bytes(16, 1);
+        for (uint32_t part_id = 0; part_id < 100; ++part_id) blob_storage.WritePart(part_id, part_bytes);
+        bool thrown = false;
+        try {
+            blob_storage.Close();
+        }
+        catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        pass = pass && thrown;
+        thrown = false;
+        try {
+            blob_storage.WritePart(0, part_bytes);
+        }
+        catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        pass = pass && thrown;
+    }
+    std::cout << name << (pass ? " pass\n" : " fail\n");
+    return pass;
+}
+
+int main() {
+    std::mt19937 rng(0);
+    bool pass = true;
+    auto probe_path = (std::filesystem::temp_directory_path() / "test_blob_storage.probe").string();
+    for (auto blob_storage_type : {BlobStorageType::STREAM, BlobStorageType::MMAP, BlobStorageType::PWRITEV, BlobStorageType::IO_URING}) {
+        if (!is_supported(blob_storage_type, probe_path)) continue;
+        for (size_t write_behind_byte_budget : {0, 4096}) {
+            pass = pass && test_read_write(rng, blob_storage_type, 40, 3000, write_behind_byte_budget);
+            pass = pass && test_read_write(rng, blob_storage_type, 1, 5000, write_behind_byte_budget);
+            pass = pass && test_fountain_transfer(rng, blob_storage_type, 100000, write_behind_byte_budget);
+        }
+        pass = pass && test_write_behind_resume(rng, blob_storage_type);
+    }
+    std::filesystem::remove(probe_path);
+    pass = pass && test_write_behind_sync();
+    pass = pass && test_write_behind_error();
+    if (pass) {
+        std::cout << "pass\n";
+        return 0;
+    } else {
+        std::cout << "fail\n";
+        return 1;
+    }
+}
@@ -0,0 +1,202 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <array>
+#include <set>
+#include <queue>
+#include <chrono>
+#include <cmath>
+
+#include "image_codec.h"
+
+std::array<int, 2> detect_non_white_corner_nw_ref(const cv::Mat& img) {
+    int row_num = img.rows;
+    int col_num = img.cols;
+    int i0 = 0;
+    int j0 = 0;
+    while (true) {
+        int i = i0;
+        int j = j0;
+        while (true) {
+            if (is_non_white(img, j, i)) return {j, i};
+            if (i > 0) --i;
+            else break;
+            if (j < col_num - 1) ++j;
+            else break;
+        }
+        if (i0 < row_num - 1) ++i0;
+        else if (j0 < col_num - 1) ++j0;
+        else break;
+    }
+    return {0, 0};
+}
+
+std::tuple<int, int, int, int> get_non_white_region_bbox_ref(const cv::Mat& img, int x, int y) {
+    int x0 = x;
+    int y0 = y;
+    int x1 = x;
+    int y1 = y;
+    std::set<std::array<int, 2>> visited;
+    std::queue<std::array<int, 2>> q;
+    q.push({x, y});
+    while (!q.empty()) {
+        auto [px, py] = q.front();
+        q.pop();
+        if (px - 1 >= 0 && visited.insert({px - 1, py}).second && is_non_white(img, px - 1, py)) {
+            x0 = std::min(x0, px - 1);
+            q.push({px - 1, py});
+        }
+        if (px + 1 < img.cols && visited.insert({px + 1, py}).second && is_non_white(img, px + 1, py)) {
+            x1 = std::max(x1, px + 1);
+            q.push({px + 1, py});
+        }
+        if (py - 1 >= 0 && visited.insert({px, py - 1}).second && is_non_white(img, px, py - 1)) {
+            y0 = std::min(y0, py - 1);
+            q.push({px, py - 1});
+        }
+        if (py + 1 < img.rows && visited.insert({px, py + 1}).second && is_non_white(img, px, py + 1)) {
+            y1 = std::max(y1, py + 1);
+            q.push({px, py + 1});
+        }
+    }
+    return {x0, y0, x1 + 1, y1 + 1};
+}
+
+std::pair<bool, std::vector<std::array<float, 2>>> calibrate_ref(const cv::Mat& img, const Transform& transform, const Dim& dim) {
+    auto [tile_x_num, tile_y_num, tile_x_size, tile_y_size] = dim;
+    cv::Mat img1 = transform_image(img, transform);
+    cv::Mat img1_b = do_binarize(img1, transform.binarization_threshold);
+    std::vector<std::array<float, 2>> centers;
+    int start_x = 0;
+    std::vector<int> start_y(tile_x_num * tile_x_size, 0);
+    for (int y = 0; y < tile_y_num * tile_y_size; ++y) {
+        for (int x = 0; x < tile_x_num * tile_x_size; ++x) {
+            if (start_x >= img1_b.cols || start_y[x] >= img1_b.rows) {
+                return std::make_pair(false, std::move(centers));
+            }
+            cv::Mat img2_b = do_crop(img1_b, {start_x, start_y[x], img1.cols, img1.rows});
+            auto [corner_x, corner_y] = detect_non_white_corner_nw_ref(img2_b);
+            auto [x0, y0, x1, y1] = get_non_white_region_bbox_ref(img2_b, corner_x, corner_y);
+            float cx = static_cast<float>(x0 + x1) / 2 + start_x;
+            float cy = static_cast<float>(y0 + y1) / 2 + start_y[x];
+            centers.push_back({cx, cy});
+            start_x += x1;
+            start_y[x] += y1;
+        }
+        start_x = 0;
+    }
+    std::vector<std::array<float, 2>> decode_centers(centers.size());
+    for (int tile_y_id = 0; tile_y_id < tile_y_num; ++tile_y_id) {
+        for (int tile_x_id = 0; tile_x_id < tile_x_num; ++tile_x_id) {
+            for (int y = 0; y < tile_y_size; ++y) {
+                for (int x = 0; x < tile_x_size; ++x) {
+                    int index = ((tile_y_id * tile_y_size + y) * tile_x_num + tile_x_id) * tile_x_size + x;
+                    int decode_index = ((tile_y_id * tile_x_num + tile_x_id) * tile_y_size + y) * tile_x_size + x;
+                    decode_centers[decode_index] = centers[index];
+                }
+            }
+        }
+    }
+    return std::make_pair(true, std::move(decode_centers));
+}
+
+std::pair<cv::Mat, std::vector<std::array<float, 2>>> get_calibration_image(const Dim& dim, int pixel_size, int calibration_pixel_size, int space_size, float angle) {
+    auto [tile_x_num, tile_y_num, tile_x_size, tile_y_size] = dim;
+    int margin = 2 * pixel_size;
+    int width = (tile_x_num * (tile_x_size + 2) + (tile_x_num - 1) * space_size) * pixel_size + 2 * margin;
+    int height = (tile_y_num * (tile_y_size + 2) + (tile_y_num - 1) * space_size) * pixel_size + 2 * margin;
+    cv::Mat img(height, width, CV_8UC3, cv::Scalar(255, 255, 255));
+    cv::Mat rotation = cv::getRotationMatrix2D(cv::Point2f(static_cast<float>(width) / 2, static_cast<float>(height) / 2), angle, 1.0);
+    std::vector<std::array<float, 2>> centers;
+    for (int tile_y_id = 0; tile_y_id < tile_y_num; ++tile_y_id) {
+        int tile_y = margin + tile_y_id * (tile_y_size + 2 + space_size) * pixel_size;
+        for (int tile_x_id = 0; tile_x_id < tile_x_num; ++tile_x_id) {
+            int tile_x = margin + tile_x_id * (tile_x_size + 2 + space_size) * pixel_size;
+            for (int y = 1; y <= tile_y_size; ++y) {
+                for (int x = 1; x <= tile_x_size; ++x) {
+                    int x0 = tile_x + x * pixel_size + (pixel_size - calibration_pixel_size) / 2;
+                    int y0 = tile_y + y * pixel_size + (pixel_size - calibration_pixel_size) / 2;
+                    cv::rectangle(img, cv::Rect(x0, y0, calibration_pixel_size, calibration_pixel_size), cv::Scalar(0, 0, 0), cv::FILLED);
+                    double cx = x0 + static_cast<double>(calibration_pixel_size) / 2;
+                    double cy = y0 + static_cast<double>(calibration_pixel_size) / 2;
+                    centers.push_back({
+                        static_cast<float>(rotation.at<double>(0, 0) * cx + rotation.at<double>(0, 1) * cy + rotation.at<double>(0, 2)),
+                        static_cast<float>(rotation.at<double>(1, 0) * cx + rotation.at<double>(1, 1) * cy + rotation.at<double>(1, 2)),
+                    });
+                }
+            }
+        }
+    }
+    if (angle != 0) {
+        cv::warpAffine(img, img, rotation, img.size(), cv::INTER_NEAREST, cv::BORDER_CONSTANT, cv::Scalar(255, 255, 255));
+    }
+    return std::make_pair(std::move(img), std::move(centers));
+}
+
+bool test_calibration_grid(const std::string& dim_str, int pixel_size, int calibration_pixel_size, int space_size, float angle) {
+    auto dim = parse_dim(dim_str);
+    auto [img, expected_centers] = get_calibration_image(dim, pixel_size, calibration_pixel_size, space_size, angle);
+    Transform transform;
+    ImageDecoder image_decoder(SymbolType::SYMBOL1, dim);
+    std::string name = dim_str + " pixel_size=" + std::to_string(pixel_size) + " angle=" + std::to_string(angle);
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    auto [img1, calibration, result_imgs] = image_decoder.Calibrate(img, transform);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    if (!calibration.valid || calibration.CenterNum() != expected_centers.size()) {
+        std::cout << name << " calibration grid fail\n";
+        return false;
+    }
+    const float tolerance = angle == 0 ? 0.f : 1.f;
+    for (size_t i = 0; i < expected_centers.size(); ++i) {
+        float cx = calibration.CenterXs()[i];
+        float cy = calibration.CenterYs()[i];
+        if (std::abs(cx - expected_centers[i][0]) > tolerance || std::abs(cy - expected_centers[i][1]) > tolerance) {
+            std::cout << name << " calibration grid fail\n";
+            std::cout << "index=" << i << " center=" << cx << "," << cy << " expected_center=" << expected_centers[i][0] << "," << expected_centers[i][1] << "\n";
+            return false;
+        }
+    }
+    auto delta_t = std::chrono::duration_cast<std::chrono::duration<float, std::milli>>(t1 - t0).count();
+    std::cout << name << " calibrate " << delta_t << "ms";
+
+    if (angle == 0) {
+        auto t2 = std::chrono::high_resolution_clock::now();
+        auto [ref_success, ref_centers] = calibrate_ref(img, transform, dim);
+        auto t3 = std::chrono::high_resolution_clock::now();
+        if (!ref_success) {
+            std::cout << "\n" << name << " calibration grid ref fail\n";
+            return false;
+        }
+        for (size_t i = 0; i < ref_centers.size(); ++i) {
+            if (calibration.CenterXs()[i] != ref_centers[i][0] || calibration.CenterYs()[i] != ref_centers[i][1]) {
+                std::cout << "\n" << name << " calibration grid mismatch with ref\n";
+                std::cout << "index=" << i << " center=" << calibration.CenterXs()[i] << "," << calibration.CenterYs()[i] << " ref_center=" << ref_centers[i][0] << "," << ref_centers[i][1] << "\n";
+                return false;
+            }
+        }
+        auto ref_delta_t = std::chrono::duration_cast<std::chrono::duration<float, std::milli>>(t3 - t2).count();
+        std::cout << " ref " << ref_delta_t << "ms";
+    }
+    std::cout << "\n" << name << " calibration grid pass\n";
+    return true;
+}
+
+int main() {
+    bool pass = true;
+    pass = pass && test_calibration_grid("1,1,10,10", 8, 4, 2, 0);
+    pass = pass && test_calibration_grid("2,2,12,9", 8, 4, 2, 0);
+    pass = pass && test_calibration_grid("2,1,60,60", 6, 3, 2, 0);
+    pass = pass && test_calibration_grid("2,2,12,9", 8, 4, 2, 0.5f);
+    pass = pass && test_calibration_grid("2,1,60,60", 6, 3, 2, -0.3f);
+    pass = pass && test_calibration_grid("2,1,60,60", 6, 3, 2, 2.0f);
+    pass = pass && test_calibration_grid("2,1,60,60", 6, 3, 2, -3.0f);
+    pass = pass && test_calibration_grid("2,2,12,9", 8, 4, 2, 5.0f);
+    if (pass) {
+        std::cout << "pass\n";
+        return 0;
+    } else {
+        std::cout << "fail\n";
+        return 1;
+    }
+}
@@ -0,0 +1,83 @@
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "image_codec.h"
+#include "test_utils.h"
+
+// a compressible file of text lines mixed with some random bytes
+Bytes get_test_file_bytes(std::mt19937& rng, size_t file_size) {
+    Bytes file_bytes;
+    while (file_bytes.size() < file_size) {
+        std::string line = "2026-01-01 00:00:" + std::to_string(rng() % 60) + " INFO part " + std::to_string(rng() % 1000) + " saved\n";
+        file_bytes.insert(file_bytes.end(), line.begin(), line.end());
+        if (rng() % 16 == 0) file_bytes.push_back(static_cast<Byte>(rng()));
+    }
+    file_bytes.resize(file_size);
+    return file_bytes;
+}
+
+bool test_compressed_transfer(std::mt19937& rng, size_t file_size, SymbolType symbol_type, const Dim& dim, CompressionType compression_type) {
+    std::string name = get_compression_type_str(compression_type) + " file_size " + std::to_string(file_size);
+    TestTransfer transfer("test_compression", get_test_file_bytes(rng, file_size));
+    int part_byte_num = get_part_byte_num(symbol_type, dim);
+    auto [raw_bytes1, part_num1] = get_task_bytes(transfer.TargetFile(), part_byte_num);
+    transfer.LoadTaskBytes(part_byte_num, compression_type);
+    uint32_t part_num = transfer.PartNum();
+
+    Task task(transfer.OutputFile());
+    transfer.InitTask(task, symbol_type, dim);
+    uint64_t start_block_num = 0;
+    uint64_t done_block_num = 0;
+    task.SetFinalizationCb(
+        [&start_block_num](const Task::FinalizationProgress& progress){ start_block_num = progress.block_num; },
+        [&done_block_num](const Task::FinalizationProgress& progress){ done_block_num = progress.done_block_num; },
+        nullptr);
+    // parts arrive in reverse order so that the trailer part is not the last one saved
+    for (uint32_t part_id = part_num; part_id-- > 0;) {
+        task.UpdatePart(part_id, transfer.GetPart(part_id));
+    }
+    bool pass = transfer.FinalizeAndCompare(task) && !std::filesystem::exists(transfer.OutputFile() + ".blob");
+    if (compression_type != CompressionType::NONE) {
+        // tiny files may grow by the compression stream header
+        pass = pass && start_block_num > 0 && done_block_num == start_block_num && (file_size < 1000 || part_num < part_num1);
+    }
+    std::cout << name << " part_num " << part_num << ", uncompressed part_num " << part_num1 << "\n";
+    std::cout << name << (pass ? " pass\n" : " fail\n");
+    return pass;
+}
+
+bool test_small_part_byte_num() {
+    const std::string content = "small";
+    TestTransfer transfer("test_compression", Bytes(content.begin(), content.end()));
+    bool pass = false;
+    try {
+        transfer.LoadTaskBytes(Task::MIN_COMPRESSED_PART_BYTE_NUM - 1, CompressionType::ZLIB);
+    }
+    catch (const invalid_image_codec_argument&) {
+        pass = true;
+    }
+    std::cout << "small part_byte_num " << (pass ? "pass\n" : "fail\n");
+    return pass;
+}
+
+int main() {
+    std::mt19937 rng(0);
+    SymbolType symbol_type = SymbolType::SYMBOL1;
+    Dim dim{1, 1, 96, 96};
+    bool pass = true;
+    pass = pass && test_compressed_transfer(rng, 0, symbol_type, dim, CompressionType::ZLIB);
+    pass = pass && test_compressed_transfer(rng, 1, symbol_type, dim, CompressionType::ZLIB);
+    pass = pass && test_compressed_transfer(rng, 100000, symbol_type, dim, CompressionType::NONE);
+    pass = pass && test_compressed_transfer(rng, 100000, symbol_type, dim, CompressionType::ZLIB);
+    pass = pass && test_compressed_transfer(rng, 5000000, symbol_type, dim, CompressionType::ZLIB);
+    pass = pass && test_small_part_byte_num();
+    if (pass) {
+        std::cout << "pass\n";
+        return 0;
+    } else {
+        std::cout << "fail\n";
+        return 1;
+    }
+}
@@ -0,0 +1,106 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include <boost/crc.hpp>
+
+#include "image_codec.h"
+
+uint32_t crc32_ref(const Byte* bytes, size_t byte_num) {
+    boost::crc_32_type crc_gen;
+    crc_gen.process_bytes(bytes, byte_num);
+    return crc_gen.checksum();
+}
+
+bool test_crc32(std::mt19937& rng) {
+    Bytes bytes(4096 + 16);
+    for (auto& e : bytes) e = static_cast<Byte>(rng());
+    for (size_t offset = 0; offset < 16; ++offset) {
+        for (size_t byte_num = 0; byte_num <= 4096; byte_num += (byte_num < 300 ? 1 : 37)) {
+            const Byte* p = bytes.data() + offset;
+            uint32_t crc_ref = crc32_ref(p, byte_num);
+            if (crc32(p, byte_num) != crc_ref || crc32_update_slicing8(0, p, byte_num) != crc_ref) {
+                std::cout << "crc32 " << offset << " " << byte_num << " fail\n";
+                return false;
+            }
+            size_t split = byte_num ? rng() % (byte_num + 1) : 0;
+            uint32_t crc1 = crc32(p, split);
+            uint32_t crc2 = crc32(p + split, byte_num - split);
+            if (crc32_update(crc1, p + split, byte_num - split) != crc_ref || crc32_combine(crc1, crc2, byte_num - split) != crc_ref) {
+                std::cout << "crc32 streaming " << offset << " " << byte_num << " fail\n";
+                return false;
+            }
+        }
+    }
+    std::cout << "crc32 pass\n";
+    return true;
+}
+
+bool test_crc32_zeros(std::mt19937& rng) {
+    for (size_t byte_num = 0; byte_num < 2048; byte_num += 13) {
+        Bytes bytes(byte_num + 32);
+        for (size_t i = 0; i < 32; ++i) bytes[i] = static_cast<Byte>(rng());
+        if (crc32_update_zeros(crc32(bytes.data(), 32), byte_num) != crc32_ref(bytes.data(), bytes.size())) {
+            std::cout << "crc32 zeros " << byte_num << " fail\n";
+            return false;
+        }
+    }
+    std::cout << "crc32 zeros pass\n";
+    return true;
+}
+
+bool test_crc32_byte_delta(std::mt19937& rng) {
+    for (size_t byte_num = 1; byte_num < 1024; byte_num += 7) {
+        Bytes bytes(byte_num);
+        for (auto& e : bytes) e = static_cast<Byte>(rng());
+        uint32_t crc = crc32(bytes.data(), byte_num);
+        for (int k = 0; k < 8; ++k) {
+            size_t byte_pos = rng() % byte_num;
+            Byte xor_byte = static_cast<Byte>(rng() | 1);
+            bytes[byte_pos] ^= xor_byte;
+            crc ^= crc32_byte_delta(xor_byte, byte_pos, byte_num);
+            if (crc != crc32_ref(bytes.data(), byte_num)) {
+                std::cout << "crc32 byte delta " << byte_num << " " << byte_pos << " fail\n";
+                return false;
+            }
+        }
+    }
+    std::cout << "crc32 byte delta pass\n";
+    return true;
+}
+
+void benchmark_crc32() {
+    constexpr int ITERATION_NUM = 200;
+    Bytes bytes(1 << 20, 0x5a);
+    uint32_t crc = 0;
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < ITERATION_NUM; ++i) crc ^= crc32_ref(bytes.data(), bytes.size());
+    auto t1 = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < ITERATION_NUM; ++i) crc ^= crc32_update_slicing8(0, bytes.data(), bytes.size());
+    auto t2 = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < ITERATION_NUM; ++i) crc ^= crc32(bytes.data(), bytes.size());
+    auto t3 = std::chrono::high_resolution_clock::now();
+    auto get_speed = [&](auto ta, auto tb) {
+        return bytes.size() * ITERATION_NUM / std::chrono::duration_cast<std::chrono::duration<double>>(tb - ta).count() / (1 << 20);
+    };
+    std::cout << std::fixed << std::setprecision(0);
+    std::cout << "boost " << get_speed(t0, t1) << " MB/s, slicing8 " << get_speed(t1, t2) << " MB/s, crc32 " << get_speed(t2, t3) << " MB/s (accelerated " << is_crc32_accelerated() << ", " << crc << ")\n";
+}
+
+int main() {
+    std::mt19937 rng(0);
+    bool pass = true;
+    pass = pass && test_crc32(rng);
+    pass = pass && test_crc32_zeros(rng);
+    pass = pass && test_crc32_byte_delta(rng);
+    if (pass) {
+        benchmark_crc32();
+        std::cout << "pass\n";
+        return 0;
+    } else {
+        std::cout << "fail\n";
+        return 1;
+    }
+}
@@ -0,0 +1,92 @@
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "image_codec.h"
+
+std::atomic<size_t> g_allocation_num{0};
+
+void* operator new(size_t size) {
+    ++g_allocation_num;
+    void* p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+bool test_decode_allocation(SymbolType symbol_type, const Dim& dim, int frame_part_num, int pixel_size, int space_size) {
+    constexpr int FRAME_NUM = 4;
+    auto [tile_x_num, tile_y_num, tile_x_size, tile_y_size] = dim;
+    std::string name = get_symbol_type_str(symbol_type) + " " + std::to_string(tile_x_num) + "," + std::to_string(tile_y_num) + "," + std::to_string(tile_x_size) + "," + std::to_string(tile_y_size) + " frame_part_num=" + std::to_string(frame_part_num);
+    auto symbol_codec = create_symbol_codec(symbol_type);
+    int part_byte_num = get_part_byte_num(symbol_type, get_part_dim(dim, frame_part_num));
+    uint32_t part_num = FRAME_NUM * frame_part_num;
+    Bytes raw_bytes(static_cast<size_t>(part_byte_num) * part_num);
+    for (size_t i = 0; i < raw_bytes.size(); ++i) {
+        raw_bytes[i] = static_cast<uint8_t>(i * 131 + 7);
+    }
+    auto gen_part_image_fn = generate_part_images(dim, pixel_size, space_size, symbol_codec.get(), part_byte_num, raw_bytes, part_num, frame_part_num);
+    std::vector<cv::Mat> imgs;
+    std::vector<uint32_t> part_ids;
+    while (auto data = gen_part_image_fn()) {
+        part_ids.push_back(data.value().first);
+        imgs.push_back(data.value().second);
+    }
+    ImageDecoder image_decoder(symbol_type, dim, frame_part_num);
+    Calibration calibration = get_part_image_calibration(dim, pixel_size, space_size);
+    Transform transform;
+    DecodeScratch scratch;
+    std::vector<DecodeResults> results;
+    image_decoder.DecodeBatch(imgs, transform, calibration, scratch, results);
+    size_t allocation_num0 = g_allocation_num;
+    image_decoder.DecodeBatch(imgs, transform, calibration, scratch, results);
+    size_t allocation_num = g_allocation_num - allocation_num0;
+    std::cout << name << " allocations per batch of " << imgs.size() << " after warm-up: " << allocation_num << "\n";
+    if (allocation_num != 0) {
+        std::cout << name << " decode allocation fail\n";
+        return false;
+    }
+    for (size_t i = 0; i < imgs.size(); ++i) {
+        auto [success_ref, part_id_ref, part_bytes_ref, symbols_ref, img1_ref, result_imgs_ref] = image_decoder.Decode(imgs[i], transform, calibration, false);
+        DecodeResults results_ref;
+        image_decoder.DecodeParts(symbols_ref, results_ref);
+        if (!success_ref || results[i] != results_ref || results[i].size() != static_cast<size_t>(frame_part_num)) {
+            std::cout << name << " decode batch result " << i << " fail\n";
+            return false;
+        }
+        for (int j = 0; j < frame_part_num; ++j) {
+            const auto& [success, part_id, part_bytes] = results[i][j];
+            if (!success || part_id != part_ids[i] + j) {
+                std::cout << name << " decode batch result " << i << " part " << j << " fail\n";
+                return false;
+            }
+        }
+    }
+    std::cout << name << " decode allocation pass\n";
+    return true;
+}
+
+int main() {
+    bool pass = true;
+    pass = pass && test_decode_allocation(SymbolType::SYMBOL1, {2, 2, 24, 24}, 1, 8, 2);
+    pass = pass && test_decode_allocation(SymbolType::SYMBOL2, {2, 2, 24, 24}, 1, 8, 2);
+    pass = pass && test_decode_allocation(SymbolType::SYMBOL3, {1, 1, 32, 32}, 1, 8, 2);
+    pass = pass && test_decode_allocation(SymbolType::SYMBOL2, {3, 3, 24, 24}, 9, 8, 2);
+    if (pass) {
+        std::cout << "pass\n";
+        return 0;
+    } else {
+        std::cout << "fail\n";
+        return 1;
+    }
+}
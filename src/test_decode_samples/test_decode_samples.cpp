@@ -0,0 +1,79 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "image_codec.h"
+
+bool test_decode_samples(ImageDecoder& image_decoder, const cv::Mat& img, const Calibration& calibration, int filter_level, int& success_num) {
+    std::string name = std::string(calibration.valid ? "calibrated" : "uncalibrated") + " filter_level=" + std::to_string(filter_level);
+    Transform transform;
+    transform.filter_level = filter_level;
+    SampleMap sample_map;
+    SymbolSamples samples;
+    bool extraction_success = image_decoder.ExtractSamples(img, transform, calibration, sample_map, samples);
+    for (int t = 100; t <= 200; t += 10) {
+        Transform::PixelizationThreshold pixelization_threshold{t, t + 3, t - 3};
+        transform.pixelization_threshold = pixelization_threshold;
+        auto [success_ref, part_id_ref, part_bytes_ref, symbols_ref, img1_ref, result_imgs_ref] = image_decoder.Decode(img, transform, calibration, false);
+        bool success = false;
+        Symbols symbols;
+        if (extraction_success) {
+            auto [success1, part_id, part_bytes, symbols1, img1, result_imgs] = image_decoder.DecodeSamples(samples, pixelization_threshold);
+            success = success1;
+            symbols = std::move(symbols1);
+        }
+        if (success != success_ref || (!symbols_ref.empty() && symbols != symbols_ref)) {
+            std::cout << name << " decode samples " << get_pixelization_threshold_str(pixelization_threshold) << " fail\n";
+            return false;
+        }
+        if (calibration.valid) {
+            auto [success2, part_id2, part_bytes2, symbols2, img2, result_imgs2] = image_decoder.Decode(img, transform, calibration, sample_map);
+            if (success2 != success_ref || symbols2 != symbols_ref) {
+                std::cout << name << " decode sample map " << get_pixelization_threshold_str(pixelization_threshold) << " fail\n";
+                return false;
+            }
+        }
+        success_num += success;
+    }
+    std::cout << name << " decode samples pass\n";
+    return true;
+}
+
+bool test_decode_samples(SymbolType symbol_type, const Dim& dim, int pixel_size, int space_size, int& success_num) {
+    auto symbol_codec = create_symbol_codec(symbol_type);
+    int part_byte_num = get_part_byte_num(symbol_type, dim);
+    Bytes raw_bytes(part_byte_num);
+    for (size_t i = 0; i < raw_bytes.size(); ++i) {
+        raw_bytes[i] = static_cast<uint8_t>(i * 131 + 7);
+    }
+    auto gen_part_image_fn = generate_part_images(dim, pixel_size, space_size, symbol_codec.get(), part_byte_num, raw_bytes, 1);
+    cv::Mat img = gen_part_image_fn().value().second;
+    img.convertTo(img, -1, 0.6, 60);
+    cv::add(img, cv::Scalar(10, -5, 0), img);
+    ImageDecoder image_decoder(symbol_type, dim);
+    Calibration calibration = get_part_image_calibration(dim, pixel_size, space_size);
+    bool pass = true;
+    for (int filter_level = 0; filter_level <= 4; ++filter_level) {
+        pass = pass && test_decode_samples(image_decoder, img, calibration, filter_level, success_num);
+        pass = pass && test_decode_samples(image_decoder, img, Calibration(), filter_level, success_num);
+    }
+    return pass;
+}
+
+int main() {
+    bool pass = true;
+    int success_num = 0;
+    pass = pass && test_decode_samples(SymbolType::SYMBOL2, {2, 2, 24, 24}, 8, 2, success_num);
+    pass = pass && test_decode_samples(SymbolType::SYMBOL2, {1, 1, 10, 10}, 24, 2, success_num);
+    if (pass && success_num == 0) {
+        std::cout << "no threshold decodes\n";
+        pass = false;
+    }
+    if (pass) {
+        std::cout << "pass\n";
+        return 0;
+    } else {
+        std::cout << "fail\n";
+        return 1;
+    }
+}
@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "image_codec.h"
+#include "test_utils.h"
+
+bool test_neighbors() {
+    for (uint32_t part_num : {1u, 2u, 3u, 10u, 1000u, 100000u}) {
+        FountainCode fountain_code(part_num);
+        std::vector<uint32_t> neighbors;
+        std::vector<uint32_t> neighbors1;
+        uint64_t degree_sum = 0;
+        for (uint32_t seq = 0; seq < 2000; ++seq) {
+            fountain_code.GetNeighbors(seq, neighbors);
+            fountain_code.GetNeighbors(seq, neighbors1);
+            if (neighbors.empty() || neighbors != neighbors1 ||
+                !std::is_sorted(neighbors.begin(), neighbors.end()) ||
+                std::adjacent_find(neighbors.begin(), neighbors.end()) != neighbors.end() ||
+                neighbors.back() >= part_num) {
+                std::cout << "fountain neighbors " << part_num << " " << seq << " fail\n";
+                return false;
+            }
+            degree_sum += neighbors.size();
+        }
+        std::cout << "part_num " << part_num << " average degree " << degree_sum / 2000.0 << "\n";
+    }
+    std::cout << "fountain neighbors pass\n";
+    return true;
+}
+
+bool test_fountain_transfer(std::mt19937& rng, uint32_t file_size, double loss_rate, bool systematic) {
+    TestTransfer transfer("test_fountain_code", get_random_bytes(rng, file_size));
+    auto symbol_type = SymbolType::SYMBOL1;
+    auto dim = get_test_dim(64);
+    int part_byte_num = get_part_byte_num(symbol_type, dim);
+    transfer.LoadTaskBytes(part_byte_num);
+    const Bytes& raw_bytes = transfer.RawBytes();
+    uint32_t part_num = transfer.PartNum();
+    FountainCode fountain_code(part_num);
+
+    Task task(transfer.OutputFile());
+    transfer.InitTask(task, symbol_type, dim);
+    std::bernoulli_distribution loss_dist(loss_rate);
+    uint64_t frame_num = 0;
+    uint64_t received_num = 0;
+    uint32_t seq = rng() & ~FOUNTAIN_PART_ID_FLAG;
+    Bytes part_bytes(part_byte_num);
+    while (!task.IsDone() && frame_num < 20ull * part_num) {
+        uint32_t part_id = 0;
+        if (systematic && frame_num < part_num) {
+            part_id = static_cast<uint32_t>(frame_num);
+            std::copy_n(raw_bytes.begin() + static_cast<size_t>(part_id) * part_byte_num, part_byte_num, part_bytes.begin());
+        } else {
+            part_id = FOUNTAIN_PART_ID_FLAG | seq;
+            fountain_code.Encode(seq, raw_bytes.data(), part_byte_num, part_bytes.data());
+            seq = (seq + 1) & ~FOUNTAIN_PART_ID_FLAG;
+        }
+        ++frame_num;
+        if (loss_dist(rng)) continue;
+        ++received_num;
+        task.UpdatePart(part_id, part_bytes);
+    }
+    bool pass = transfer.FinalizeAndCompare(task) && !std::filesystem::exists(transfer.OutputFile() + ".fountain");
+
+    // a cyclic sender needs every part to survive at least once
+    double cyclic_frame_num = 0;
+    for (uint64_t round = 0; round < 1000; ++round) {
+        cyclic_frame_num += part_num * (1 - std::pow(1 - std::pow(loss_rate, round), part_num));
+    }
+    std::cout << (systematic ? "systematic " : "") << "fountain part_num " << part_num << " loss_rate " << loss_rate
+              << " frames " << frame_num << " received " << received_num << " (" << static_cast<double>(received_num) / part_num
+              << "x), cyclic sender expects " << cyclic_frame_num << " frames\n";
+    if (!pass) std::cout << "fountain transfer fail\n";
+    return pass;
+}
+
+int main() {
+    std::mt19937 rng(0);
+    bool pass = true;
+    pass = pass && test_neighbors();
+    pass = pass && test_fountain_transfer(rng, 1, 0, false);
+    pass = pass && test_fountain_transfer(rng, 1000, 0.1, false);
+    pass = pass && test_fountain_transfer(rng, 64 * 5000 + 13, 0.2, false);
+    pass = pass && test_fountain_transfer(rng, 64 * 5000 + 13, 0.2, true);
+    pass = pass && test_fountain_transfer(rng, 64 * 50000, 0.05, false);
+    if (pass) {
+        std::cout << "pass\n";
+        return 0;
+    } else {
+        std::cout << "fail\n";
+        return 1;
+    }
+}
@@ -1,6 +1,8 @@
 #include <iostream>
 #include <exception>
 #include <chrono>
+#include <thread>
+#include <vector>
 
 #include <boost/program_options.hpp>
 
@@ -18,7 +20,7 @@ int main(int argc, char** argv) {
         desc_handler("port", boost::program_options::value<int>(&port), "port");
         desc_handler("task_byte_num", boost::program_options::value<int>(&task_byte_num), "task byte num");
         boost::program_options::positional_options_description p_desc;
-        p_desc.add("server_client_type", 1);
+        p_desc.add("server_type", 1);
         p_desc.add("port", 1);
         p_desc.add("task_byte_num", 1);
         boost::program_options::variables_map vm;
@@ -34,26 +36,41 @@ int main(int argc, char** argv) {
 
         auto server_type = parse_server_type(server_type_str);
 
-        Bytes task_bytes1;
-        for (int i = 0; i < task_byte_num; ++i) {
-            task_bytes1.push_back(static_cast<uint8_t>(i & 0xff));
+        // task_byte_num status bytes of a task with every other byte done, and of a task nearly done
+        PartBitmap part_bitmap(task_byte_num * 8);
+        PartBitmap part_bitmap1(task_byte_num * 8);
+        for (uint32_t part_id = 0; part_id < part_bitmap.PartNum(); ++part_id) {
+            if (part_id / 8 % 2) part_bitmap.SetDone(part_id);
+            if (part_id % 1000) part_bitmap1.SetDone(part_id);
         }
+        Dim dim = {1, 1, 10, 10};
+        std::vector<Bytes> task_bytes_list = {to_task_bytes(SymbolType::SYMBOL1, dim, part_bitmap), to_task_bytes(SymbolType::SYMBOL1, dim, part_bitmap1)};
 
         auto task_status_server = create_task_status_server(server_type);
-        task_status_server->UpdateTaskStatus(task_bytes1);
         task_status_server->Start(port);
 
-        auto task_status_client = create_task_status_client(server_type, "127.0.0.1", port);
-        bool success = false;
-        for (int i = 0; i < 3; ++i) {
-            Bytes task_bytes2 = task_status_client->GetTaskStatus();
-            if (task_bytes1 == task_bytes2) {
-                success = true;
-                break;
-            } else {
-                std::this_thread::sleep_for(std::chrono::seconds(1));
+        bool success = true;
+        for (const auto& task_bytes1 : task_bytes_list) {
+            for (uint32_t server_version : {TASK_BYTES_VERSION1, TASK_BYTES_VERSION2}) {
+                task_status_server->UpdateTaskStatus(convert_task_bytes(task_bytes1, server_version));
+                for (uint32_t client_version : {TASK_BYTES_VERSION1, TASK_BYTES_VERSION2}) {
+                    auto task_status_client = create_task_status_client(server_type, "127.0.0.1", port, client_version);
+                    bool success1 = false;
+                    for (int i = 0; i < 3; ++i) {
+                        Bytes task_bytes2 = task_status_client->GetTaskStatus();
+                        if (!task_bytes2.empty() && get_task_bytes_version(task_bytes2) == client_version && convert_task_bytes(task_bytes2, TASK_BYTES_VERSION1) == task_bytes1) {
+                            success1 = true;
+                            break;
+                        } else {
+                            std::this_thread::sleep_for(std::chrono::seconds(1));
+                        }
+                    }
+                    success = success && success1;
+                }
             }
         }
+        // only the undone parts of the nearly done task are sent
+        success = success && to_task_bytes(SymbolType::SYMBOL1, dim, part_bitmap1, TASK_BYTES_VERSION2).size() * 10 < task_bytes_list[1].size();
 
         task_status_server->Stop();
 
@@ -0,0 +1,89 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "image_codec.h"
+
+// the bitmap queries are checked against a plain vector of done flags
+bool test_part_bitmap(std::mt19937& rng, uint32_t part_num, int done_percent, bool clustered) {
+    std::string name = "part_bitmap part_num " + std::to_string(part_num) + " done_percent " + std::to_string(done_percent) + (clustered ? " clustered" : "");
+    std::vector<bool> dones(part_num, false);
+    PartBitmap part_bitmap(part_num);
+    bool pass = part_bitmap.NextUndone(0) == (part_num ? 0 : part_num);
+    uint32_t part_id = 0;
+    while (part_id < part_num) {
+        // clustered runs fill whole blocks, like parts received in order
+        uint32_t run = clustered ? rng() % (3 * PartBitmap::BLOCK_PART_NUM) + 1 : 1;
+        bool done = static_cast<int>(rng() % 100) < done_percent;
+        for (uint32_t i = part_id; i < std::min(part_id + run, part_num); ++i) {
+            dones[i] = done;
+            if (done) pass = pass && part_bitmap.SetDone(i);
+        }
+        part_id += run;
+    }
+    uint32_t done_part_num = 0;
+    for (bool done : dones) done_part_num += done;
+    pass = pass && part_bitmap.DonePartNum() == done_part_num && part_bitmap.UndonePartNum() == part_num - done_part_num;
+    // done parts are only counted once
+    if (done_part_num) pass = pass && !part_bitmap.SetDone(part_bitmap.NextDone(0)) && part_bitmap.DonePartNum() == done_part_num;
+
+    std::vector<uint32_t> undone_part_ids;
+    for (uint32_t i = 0; i < part_num; ++i) {
+        if (!dones[i]) undone_part_ids.push_back(i);
+        pass = pass && part_bitmap.IsDone(i) == dones[i];
+    }
+    // next undone, next done and rank from every part id
+    size_t undone_index = 0;
+    uint32_t next_done = part_num;
+    for (uint32_t i = part_num; i-- > 0;) {
+        if (dones[i]) next_done = i;
+        pass = pass && part_bitmap.NextDone(i) == next_done;
+    }
+    for (uint32_t i = 0; i < part_num; ++i) {
+        while (undone_index < undone_part_ids.size() && undone_part_ids[undone_index] < i) ++undone_index;
+        uint32_t next_undone = undone_index < undone_part_ids.size() ? undone_part_ids[undone_index] : part_num;
+        pass = pass && part_bitmap.NextUndone(i) == next_undone && part_bitmap.UndoneRank(i) == undone_index;
+    }
+    pass = pass && part_bitmap.NextUndone(part_num) == part_num && part_bitmap.UndoneRank(part_num) == undone_part_ids.size();
+    for (size_t i = 0; i < undone_part_ids.size(); ++i) {
+        pass = pass && part_bitmap.SelectUndone(static_cast<uint32_t>(i)) == undone_part_ids[i];
+    }
+    // the ranges cover exactly the undone parts
+    std::vector<uint32_t> range_part_ids;
+    uint32_t prev_end_part_id = 0;
+    part_bitmap.ForEachUndoneRange([&](uint32_t first_part_id, uint32_t end_part_id) {
+        pass = pass && first_part_id < end_part_id && (range_part_ids.empty() || first_part_id > prev_end_part_id);
+        for (uint32_t i = first_part_id; i < end_part_id; ++i) range_part_ids.push_back(i);
+        prev_end_part_id = end_part_id;
+    });
+    pass = pass && range_part_ids == undone_part_ids;
+    // round trip through the task status layout
+    auto task_status_bytes = part_bitmap.ToBytes();
+    pass = pass && task_status_bytes.size() == (static_cast<size_t>(part_num) + 7) / 8;
+    for (uint32_t i = 0; i < part_num; ++i) {
+        pass = pass && is_part_done(task_status_bytes, i) == dones[i];
+    }
+    PartBitmap part_bitmap1(task_status_bytes, part_num);
+    pass = pass && part_bitmap1.DonePartNum() == done_part_num && part_bitmap1.ToBytes() == task_status_bytes;
+    std::cout << name << (pass ? " pass\n" : " fail\n");
+    return pass;
+}
+
+int main() {
+    std::mt19937 rng(0);
+    bool pass = true;
+    for (uint32_t part_num : {0u, 1u, 63u, 64u, 4096u, 4097u, 100000u, 300001u}) {
+        for (int done_percent : {0, 10, 50, 90, 100}) {
+            pass = pass && test_part_bitmap(rng, part_num, done_percent, false);
+            pass = pass && test_part_bitmap(rng, part_num, done_percent, true);
+        }
+    }
+    if (pass) {
+        std::cout << "pass\n";
+        return 0;
+    } else {
+        std::cout << "fail\n";
+        return 1;
+    }
+}
@@ -0,0 +1,112 @@
+#include <iostream>
+#include <string>
+
+#include "image_codec.h"
+
+cv::Mat do_pixelize_ref(const cv::Mat& img, SymbolType symbol_type, Transform::PixelizationThreshold threshold) {
+    cv::Mat img_channels[3];
+    cv::split(img, img_channels);
+    cv::threshold(img_channels[0], img_channels[0], static_cast<double>(threshold[0]), 255, cv::THRESH_BINARY);
+    cv::threshold(img_channels[1], img_channels[1], static_cast<double>(threshold[1]), 255, cv::THRESH_BINARY);
+    cv::threshold(img_channels[2], img_channels[2], static_cast<double>(threshold[2]), 255, cv::THRESH_BINARY);
+    cv::Mat img1;
+    cv::merge(img_channels, 3, img1);
+    if (symbol_type == SymbolType::SYMBOL2) {
+        for (int y = 0; y < img1.rows; ++y) {
+            for (int x = 0; x < img1.cols; ++x) {
+                auto& c1 = img1.at<cv::Vec3b>(y, x);
+                if (c1[0] == 255 && c1[1] == 0 && c1[2] == 255) {
+                    const auto& c = img.at<cv::Vec3b>(y, x);
+                    if (c[0] > c[2]) {
+                        c1[0] = 255;
+                        c1[2] = 0;
+                    } else {
+                        c1[0] = 0;
+                        c1[2] = 255;
+                    }
+                }
+            }
+        }
+    } else if (symbol_type == SymbolType::SYMBOL4) {
+        int green_threshold1 = threshold[1] / 3;
+        int green_threshold2 = threshold[1] + (255 - threshold[1]) * 2 / 3;
+        for (int y = 0; y < img1.rows; ++y) {
+            for (int x = 0; x < img1.cols; ++x) {
+                int g = img.at<cv::Vec3b>(y, x)[1];
+                int level = (g > green_threshold1) + (g > threshold[1]) + (g > green_threshold2);
+                img1.at<cv::Vec3b>(y, x)[1] = static_cast<uchar>(level * 85);
+            }
+        }
+    } else if (symbol_type == SymbolType::SYMBOL1) {
+        for (int y = 0; y < img1.rows; ++y) {
+            for (int x = 0; x < img1.cols; ++x) {
+                auto& c1 = img1.at<cv::Vec3b>(y, x);
+                if (static_cast<int>(c1[0]) + static_cast<int>(c1[1]) + static_cast<int>(c1[2]) <= 255) {
+                    c1[0] = 0;
+                    c1[1] = 0;
+                    c1[2] = 0;
+                } else {
+                    c1[0] = 255;
+                    c1[1] = 255;
+                    c1[2] = 255;
+                }
+            }
+        }
+    }
+    return img1;
+}
+
+cv::Mat get_all_color_image() {
+    cv::Mat img(4096, 4096, CV_8UC3);
+    for (int y = 0; y < img.rows; ++y) {
+        for (int x = 0; x < img.cols; ++x) {
+            int i = y * img.cols + x;
+            img.at<cv::Vec3b>(y, x) = cv::Vec3b(i & 0xff, (i >> 8) & 0xff, (i >> 16) & 0xff);
+        }
+    }
+    return img;
+}
+
+bool test_pixel_classifier(const cv::Mat& img, const std::string& symbol_type_str, const Transform::PixelizationThreshold& threshold) {
+    auto symbol_type = parse_symbol_type(symbol_type_str);
+    PixelClassifier pixel_classifier(symbol_type, threshold);
+    cv::Mat img_ref = do_pixelize_ref(img, symbol_type, threshold);
+    cv::Mat img1 = do_pixelize(img, symbol_type, threshold);
+    for (int y = 0; y < img.rows; ++y) {
+        for (int x = 0; x < img.cols; ++x) {
+            const auto& c = img.at<cv::Vec3b>(y, x);
+            const auto& c_ref = img_ref.at<cv::Vec3b>(y, x);
+            const auto& c1 = get_pixel_color_bgr(pixel_classifier.Classify(c));
+            int distance = 0;
+            PixelColor alternative;
+            PixelColor color2 = pixel_classifier.ClassifySoft(c, distance, alternative);
+            bool soft_pass = get_pixel_color_bgr(color2) == c_ref && (distance == 255 || alternative != color2);
+            if (c1 != c_ref || img1.at<cv::Vec3b>(y, x) != c_ref || !soft_pass) {
+                std::cout << symbol_type_str << " pixel classifier " << get_pixelization_threshold_str(threshold) << " fail\n";
+                std::cout << "bgr=" << static_cast<int>(c[0]) << "," << static_cast<int>(c[1]) << "," << static_cast<int>(c[2]) << "\n";
+                std::cout << "bgr_ref=" << static_cast<int>(c_ref[0]) << "," << static_cast<int>(c_ref[1]) << "," << static_cast<int>(c_ref[2]) << "\n";
+                std::cout << "bgr1=" << static_cast<int>(c1[0]) << "," << static_cast<int>(c1[1]) << "," << static_cast<int>(c1[2]) << "\n";
+                return false;
+            }
+        }
+    }
+    std::cout << symbol_type_str << " pixel classifier " << get_pixelization_threshold_str(threshold) << " pass\n";
+    return true;
+}
+
+int main() {
+    cv::Mat img = get_all_color_image();
+    bool pass = true;
+    for (const auto& symbol_type_str : {"symbol1", "symbol2", "symbol3", "symbol4"}) {
+        pass = pass && test_pixel_classifier(img, symbol_type_str, {128, 128, 128});
+        pass = pass && test_pixel_classifier(img, symbol_type_str, {150, 165, 172});
+        pass = pass && test_pixel_classifier(img, symbol_type_str, {0, 255, 97});
+    }
+    if (pass) {
+        std::cout << "pass\n";
+        return 0;
+    } else {
+        std::cout << "fail\n";
+        return 1;
+    }
+}
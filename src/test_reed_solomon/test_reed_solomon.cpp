@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "image_codec.h"
+
+bool test_reed_solomon(std::mt19937& rng) {
+    ReedSolomon rs(SymbolCodec::FEC_PARITY_BYTE_NUM);
+    int parity_byte_num = rs.ParityByteNum();
+    for (int codeword_byte_num = parity_byte_num + 1; codeword_byte_num <= ReedSolomon::MAX_CODEWORD_BYTE_NUM; codeword_byte_num += 7) {
+        int data_byte_num = codeword_byte_num - parity_byte_num;
+        for (int error_num = 0; error_num <= parity_byte_num / 2; error_num += 4) {
+            Bytes codeword(codeword_byte_num);
+            for (int i = 0; i < data_byte_num; ++i) codeword[i] = static_cast<Byte>(rng());
+            rs.Encode(codeword.data(), data_byte_num, codeword.data() + data_byte_num);
+            Bytes expected = codeword;
+            std::vector<int> positions(codeword_byte_num);
+            for (int i = 0; i < codeword_byte_num; ++i) positions[i] = i;
+            std::shuffle(positions.begin(), positions.end(), rng);
+            for (int i = 0; i < error_num; ++i) codeword[positions[i]] ^= static_cast<Byte>(rng() % 255 + 1);
+            if (rs.Decode(codeword.data(), codeword_byte_num) != error_num || codeword != expected) {
+                std::cout << "reed solomon " << codeword_byte_num << " " << error_num << " fail\n";
+                return false;
+            }
+        }
+    }
+    std::cout << "reed solomon pass\n";
+    return true;
+}
+
+bool test_interleaved_burst(std::mt19937& rng) {
+    ReedSolomon rs(SymbolCodec::FEC_PARITY_BYTE_NUM);
+    for (size_t byte_num : {100, 255, 256, 1000, 4096}) {
+        int codeword_num = get_interleaved_codeword_num(byte_num);
+        size_t data_byte_num = byte_num - codeword_num * rs.ParityByteNum();
+        Bytes bytes(byte_num);
+        for (size_t i = 0; i < data_byte_num; ++i) bytes[i] = static_cast<Byte>(rng());
+        encode_interleaved(rs, bytes.data(), byte_num);
+        Bytes expected = bytes;
+        // a burst of 16 bytes per codeword is correctable after interleaving
+        size_t burst_byte_num = static_cast<size_t>(codeword_num) * rs.ParityByteNum() / 2;
+        size_t start = rng() % (byte_num - burst_byte_num + 1);
+        for (size_t i = start; i < start + burst_byte_num; ++i) bytes[i] ^= 0xff;
+        if (decode_interleaved(rs, bytes.data(), byte_num) != static_cast<int>(burst_byte_num) || bytes != expected) {
+            std::cout << "interleaved burst " << byte_num << " fail\n";
+            return false;
+        }
+    }
+    std::cout << "interleaved burst pass\n";
+    return true;
+}
+
+void inject_symbol_errors(const SymbolCodec& codec, Symbols& symbols, double error_rate, std::mt19937& rng) {
+    std::bernoulli_distribution error_dist(error_rate);
+    int symbol_value_num = codec.SymbolValueNum();
+    for (auto& symbol : symbols) {
+        if (error_dist(rng)) symbol = static_cast<Symbol>((symbol + 1 + rng() % (symbol_value_num - 1)) % symbol_value_num);
+    }
+}
+
+bool test_fec_codec(std::mt19937& rng) {
+    for (auto symbol_type : {SymbolType::SYMBOL1_RS, SymbolType::SYMBOL2_RS, SymbolType::SYMBOL3_RS}) {
+        auto codec = create_symbol_codec(symbol_type);
+        for (int frame_size : {400, 1000, 5000, 20000}) {
+            int part_byte_num = codec->PaddedPartByteNum(frame_size);
+            Bytes part_bytes(part_byte_num);
+            for (auto& e : part_bytes) e = static_cast<Byte>(rng());
+            uint32_t part_id = rng();
+            Symbols symbols = codec->Encode(part_id, part_bytes, frame_size);
+            // one symbol error per 255 frame bytes touches at most 2 bytes of a codeword
+            Symbols corrupted_symbols = symbols;
+            int codeword_num = get_interleaved_codeword_num(frame_size * codec->BitNumPerSymbol() / 8);
+            for (int i = 0; i < codeword_num * 4; ++i) {
+                auto& symbol = corrupted_symbols[rng() % frame_size];
+                symbol = static_cast<Symbol>(symbol ^ 1);
+            }
+            auto [success, part_id1, part_bytes1] = codec->Decode(corrupted_symbols);
+            if (!success || part_id1 != part_id || part_bytes1 != part_bytes) {
+                std::cout << "fec codec " << get_symbol_type_str(symbol_type) << " " << frame_size << " fail\n";
+                return false;
+            }
+        }
+    }
+    std::cout << "fec codec pass\n";
+    return true;
+}
+
+void benchmark_fec_codec(std::mt19937& rng) {
+    constexpr int FRAME_SIZE = 160000;
+    constexpr int ITERATION_NUM = 50;
+    std::cout << std::fixed;
+    for (auto symbol_type : {SymbolType::SYMBOL2, SymbolType::SYMBOL2_RS}) {
+        auto codec = create_symbol_codec(symbol_type);
+        int part_byte_num = codec->PaddedPartByteNum(FRAME_SIZE);
+        Bytes part_bytes(part_byte_num);
+        for (auto& e : part_bytes) e = static_cast<Byte>(rng());
+        Symbols symbols(FRAME_SIZE);
+        DecodeResult result;
+        auto t0 = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < ITERATION_NUM; ++i) codec->Encode(i, part_bytes.data(), part_bytes.size(), symbols.data(), FRAME_SIZE);
+        auto t1 = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < ITERATION_NUM; ++i) codec->Decode(symbols, result);
+        auto t2 = std::chrono::high_resolution_clock::now();
+        auto get_us = [&](auto ta, auto tb) {
+            return std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(tb - ta).count() / ITERATION_NUM;
+        };
+        std::cout << std::setprecision(0) << get_symbol_type_str(symbol_type) << " frame_size " << FRAME_SIZE << " part_byte_num " << part_byte_num << " encode " << get_us(t0, t1) << " us, decode " << get_us(t1, t2) << " us\n";
+        // effective bytes per frame under injected symbol errors, the decode throughput is reported separately above
+        for (double error_rate : {0.0, 1e-5, 1e-4, 1e-3, 1e-2}) {
+            constexpr int FRAME_NUM = 40;
+            int ok_num = 0;
+            for (int i = 0; i < FRAME_NUM; ++i) {
+                Symbols corrupted_symbols = symbols;
+                inject_symbol_errors(*codec, corrupted_symbols, error_rate, rng);
+                codec->Decode(corrupted_symbols, result);
+                ok_num += std::get<0>(result);
+            }
+            std::cout << std::setprecision(5) << "  symbol error rate " << error_rate << std::setprecision(0) << ": effective " << static_cast<double>(part_byte_num) * ok_num / FRAME_NUM << " bytes/frame\n";
+        }
+    }
+}
+
+int main() {
+    std::mt19937 rng(0);
+    bool pass = true;
+    pass = pass && test_reed_solomon(rng);
+    pass = pass && test_interleaved_burst(rng);
+    pass = pass && test_fec_codec(rng);
+    if (pass) {
+        benchmark_fec_codec(rng);
+        std::cout << "pass\n";
+        return 0;
+    } else {
+        std::cout << "fail\n";
+        return 1;
+    }
+}
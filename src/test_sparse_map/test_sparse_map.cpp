@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "image_codec.h"
+#include "test_utils.h"
+
+// runs of random bytes separated by runs of zeros, like a disk image
+Bytes get_test_file_bytes(std::mt19937& rng, size_t file_size) {
+    Bytes file_bytes(file_size, 0);
+    size_t i = 0;
+    while (i < file_size) {
+        size_t run = rng() % 5000;
+        if (rng() % 2) {
+            for (size_t j = i; j < std::min(i + run, file_size); ++j) file_bytes[j] = static_cast<Byte>(rng());
+        }
+        i += run;
+    }
+    return file_bytes;
+}
+
+bool test_sparse_transfer(std::mt19937& rng, size_t file_size, int part_byte_num, bool fountain) {
+    std::string name = std::string(fountain ? "fountain " : "") + "sparse file_size " + std::to_string(file_size) + " part_byte_num " + std::to_string(part_byte_num);
+    TestTransfer transfer("test_sparse_map", get_test_file_bytes(rng, file_size));
+    auto symbol_type = SymbolType::SYMBOL1;
+    auto dim = get_test_dim(part_byte_num);
+    transfer.LoadTaskBytes(part_byte_num);
+    const Bytes& raw_bytes = transfer.RawBytes();
+    uint32_t part_num = transfer.PartNum();
+    SparseMap sparse_map(raw_bytes, part_byte_num, part_num);
+    uint32_t zero_part_num = 0;
+    for (uint32_t part_id = 0; part_id < part_num; ++part_id) {
+        zero_part_num += std::all_of(raw_bytes.begin() + static_cast<size_t>(part_id) * part_byte_num, raw_bytes.begin() + static_cast<size_t>(part_id + 1) * part_byte_num, [](Byte b){ return b == 0; });
+    }
+    bool pass = sparse_map.ZeroPartNum() == zero_part_num;
+
+    Task task(transfer.OutputFile());
+    transfer.InitTask(task, symbol_type, dim);
+    std::vector<std::pair<uint32_t, Bytes>> parts = sparse_map.MapParts();
+    for (auto part_id : sparse_map.PartIds()) {
+        parts.emplace_back(part_id, transfer.GetPart(part_id));
+    }
+    std::shuffle(parts.begin(), parts.end(), rng);
+    if (fountain) {
+        // a coded part makes the task route the zero parts through the fountain decoder
+        FountainCode fountain_code(part_num);
+        Bytes part_bytes(part_byte_num);
+        fountain_code.Encode(0, raw_bytes.data(), part_byte_num, part_bytes.data());
+        task.UpdatePart(FOUNTAIN_PART_ID_FLAG, part_bytes);
+    }
+    for (const auto& [part_id, part_bytes] : parts) {
+        task.UpdatePart(part_id, part_bytes);
+    }
+    pass = transfer.FinalizeAndCompare(task) && pass;
+    std::cout << name << " part_num " << part_num << ", " << zero_part_num << " zero parts, " << sparse_map.MapParts().size() << " map parts, " << sparse_map.DisplayedPartNum() << " displayed parts\n";
+    std::cout << name << (pass ? " pass\n" : " fail\n");
+    return pass;
+}
+
+bool test_map_part_range() {
+    // a map part of the last group may list ids beyond part_num
+    Bytes part_bytes(4, 0xff);
+    std::vector<uint32_t> part_ids;
+    get_sparse_map_zero_part_ids(SPARSE_MAP_PART_ID_FLAG | 2, part_bytes, 70, part_ids);
+    bool pass = part_ids.size() == 6 && part_ids.front() == 64 && part_ids.back() == 69;
+    pass = pass && is_sparse_map_part_id(SPARSE_MAP_PART_ID_FLAG | 5) && !is_sparse_map_part_id(FOUNTAIN_PART_ID_FLAG | SPARSE_MAP_PART_ID_FLAG | 5) && !is_sparse_map_part_id(5);
+    std::cout << "map part range " << (pass ? "pass\n" : "fail\n");
+    return pass;
+}
+
+int main() {
+    std::mt19937 rng(0);
+    bool pass = true;
+    pass = pass && test_map_part_range();
+    pass = pass && test_sparse_transfer(rng, 0, 64, false);
+    pass = pass && test_sparse_transfer(rng, 1000, 64, false);
+    pass = pass && test_sparse_transfer(rng, 1000000, 64, false);
+    pass = pass && test_sparse_transfer(rng, 1000000, 16, false);
+    pass = pass && test_sparse_transfer(rng, 1000000, 64, true);
+    if (pass) {
+        std::cout << "pass\n";
+        return 0;
+    } else {
+        std::cout << "fail\n";
+        return 1;
+    }
+}
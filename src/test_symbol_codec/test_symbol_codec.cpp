@@ -1,5 +1,7 @@
 #include <iostream>
 #include <string>
+#include <random>
+#include <algorithm>
 
 #include "image_codec.h"
 
@@ -39,11 +41,147 @@ bool test_symbol_codec(const std::string& symbol_type_str) {
     return true;
 }
 
+bool test_chase_decode(const std::string& symbol_type_str) {
+    auto symbol_type = parse_symbol_type(symbol_type_str);
+    auto symbol_codec = create_symbol_codec(symbol_type);
+    std::mt19937 rng(0);
+    int test_num = 0;
+    for (int frame_size : {100, 333, 1000, 20000}) {
+        int part_byte_num = symbol_codec->PaddedPartByteNum(frame_size);
+        // symbols beyond the last whole byte carry no data
+        size_t data_symbol_num = (static_cast<size_t>(frame_size) * symbol_codec->BitNumPerSymbol() / 8 * 8) / symbol_codec->BitNumPerSymbol();
+        for (int error_num = 1; error_num <= 3; ++error_num) {
+            for (int trial = 0; trial < 10; ++trial) {
+                Bytes part_bytes1(part_byte_num);
+                for (auto& e : part_bytes1) e = static_cast<Byte>(rng());
+                uint32_t part_id1 = rng();
+                Symbols symbols = symbol_codec->Encode(part_id1, part_bytes1, frame_size);
+                SymbolSoftInfos soft_infos(frame_size);
+                for (auto& e : soft_infos) {
+                    e.confidence = 1000 + rng() % 1000;
+                    e.runner_up = rng() % symbol_codec->SymbolValueNum();
+                }
+                std::vector<size_t> positions;
+                while (positions.size() < static_cast<size_t>(error_num + 3)) {
+                    size_t j = rng() % data_symbol_num;
+                    if (std::find(positions.begin(), positions.end(), j) == positions.end()) positions.push_back(j);
+                }
+                for (int k = 0; k < error_num; ++k) {
+                    size_t j = positions[k];
+                    soft_infos[j].runner_up = symbols[j];
+                    soft_infos[j].confidence = rng() % 100;
+                    symbols[j] = (symbols[j] + 1 + rng() % (symbol_codec->SymbolValueNum() - 1)) % symbol_codec->SymbolValueNum();
+                }
+                // low confidence symbols which are actually right
+                for (size_t k = error_num; k < positions.size(); ++k) {
+                    soft_infos[positions[k]].confidence = 100 + static_cast<uint16_t>(k);
+                }
+                DecodeResult result;
+                symbol_codec->Decode(symbols, result);
+                bool success0 = std::get<0>(result);
+                symbol_codec->DecodeWithRetry(symbols, soft_infos, ChaseConfig{8, 3}, result);
+                auto& [success, part_id2, part_bytes2] = result;
+                if (success0 || !success || part_id1 != part_id2 || part_bytes1 != part_bytes2) {
+                    std::cout << symbol_type_str << " chase decode " << frame_size << " " << error_num << " " << trial << " fail\n";
+                    std::cout << "success0=" << success0 << "\n";
+                    std::cout << "success=" << success << "\n";
+                    std::cout << "part_id1=" << part_id1 << "\n";
+                    std::cout << "part_id2=" << part_id2 << "\n";
+                    return false;
+                }
+                ++test_num;
+            }
+        }
+    }
+    std::cout << symbol_type_str << " chase decode " << test_num << " tests pass\n";
+    return true;
+}
+
+// frames needing more than MAX_FLIP_SYMBOL_NUM flips are given up even if the config asks for more
+bool test_chase_flip_limit(const std::string& symbol_type_str) {
+    auto symbol_type = parse_symbol_type(symbol_type_str);
+    auto symbol_codec = create_symbol_codec(symbol_type);
+    std::mt19937 rng(1);
+    int frame_size = 1000;
+    int part_byte_num = symbol_codec->PaddedPartByteNum(frame_size);
+    Bytes part_bytes1(part_byte_num);
+    for (auto& e : part_bytes1) e = static_cast<Byte>(rng());
+    Symbols symbols = symbol_codec->Encode(rng(), part_bytes1, frame_size);
+    SymbolSoftInfos soft_infos(frame_size);
+    for (size_t j = 0; j < soft_infos.size(); ++j) {
+        soft_infos[j].confidence = static_cast<uint16_t>(1000 + j % 1000);
+        soft_infos[j].runner_up = (symbols[j] + 1) % symbol_codec->SymbolValueNum();
+    }
+    int error_num = ChaseConfig::MAX_FLIP_SYMBOL_NUM + 1;
+    for (int k = 0; k < error_num; ++k) {
+        size_t j = k * 7;
+        soft_infos[j].runner_up = symbols[j];
+        soft_infos[j].confidence = static_cast<uint16_t>(k);
+        symbols[j] = (symbols[j] + 1) % symbol_codec->SymbolValueNum();
+    }
+    DecodeResult result;
+    symbol_codec->DecodeWithRetry(symbols, soft_infos, ChaseConfig{error_num, error_num}, result);
+    if (std::get<0>(result)) {
+        std::cout << symbol_type_str << " chase flip limit fail\n";
+        return false;
+    }
+    std::cout << symbol_type_str << " chase flip limit pass\n";
+    return true;
+}
+
+// two colors of the constellation are neighbors when they differ in one channel with no other color in between,
+// a gray coded constellation maps neighbors to bit patterns differing in one bit
+bool test_gray_constellation(const std::string& symbol_type_str) {
+    const auto& constellation = get_constellation(parse_symbol_type(symbol_type_str));
+    int neighbor_num = 0;
+    for (int bits1 = 0; bits1 < constellation.ColorNum(); ++bits1) {
+        const auto& bgr1 = get_pixel_color_bgr(static_cast<PixelColor>(constellation.BitsToSymbol(bits1)));
+        for (int bits2 = bits1 + 1; bits2 < constellation.ColorNum(); ++bits2) {
+            const auto& bgr2 = get_pixel_color_bgr(static_cast<PixelColor>(constellation.BitsToSymbol(bits2)));
+            int channel_num = 0;
+            int c = 0;
+            for (int c1 = 0; c1 < 3; ++c1) {
+                if (bgr1[c1] != bgr2[c1]) {
+                    ++channel_num;
+                    c = c1;
+                }
+            }
+            if (channel_num != 1) continue;
+            bool between = false;
+            for (int bits3 = 0; bits3 < constellation.ColorNum(); ++bits3) {
+                const auto& bgr3 = get_pixel_color_bgr(static_cast<PixelColor>(constellation.BitsToSymbol(bits3)));
+                bool same_others = true;
+                for (int c1 = 0; c1 < 3; ++c1) {
+                    if (c1 != c && bgr3[c1] != bgr1[c1]) same_others = false;
+                }
+                if (same_others && bgr3[c] > std::min(bgr1[c], bgr2[c]) && bgr3[c] < std::max(bgr1[c], bgr2[c])) between = true;
+            }
+            if (between) continue;
+            int diff = bits1 ^ bits2;
+            if (diff & (diff - 1)) {
+                std::cout << symbol_type_str << " gray constellation " << get_pixel_color(constellation.BitsToSymbol(bits1)) << " " << get_pixel_color(constellation.BitsToSymbol(bits2)) << " fail\n";
+                return false;
+            }
+            ++neighbor_num;
+        }
+    }
+    std::cout << symbol_type_str << " gray constellation " << neighbor_num << " neighbors pass\n";
+    return true;
+}
+
 int main() {
     bool pass = true;
     pass = pass && test_symbol_codec("symbol1");
     pass = pass && test_symbol_codec("symbol2");
     pass = pass && test_symbol_codec("symbol3");
+    pass = pass && test_symbol_codec("symbol4");
+    pass = pass && test_chase_decode("symbol1");
+    pass = pass && test_chase_decode("symbol2");
+    pass = pass && test_chase_decode("symbol3");
+    pass = pass && test_chase_decode("symbol4");
+    pass = pass && test_chase_flip_limit("symbol1");
+    pass = pass && test_chase_flip_limit("symbol3");
+    pass = pass && test_gray_constellation("symbol4");
     if (pass) {
         std::cout << "pass\n";
         return 0;
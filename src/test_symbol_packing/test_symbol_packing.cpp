@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "image_codec.h"
+
+Symbols bytes_to_symbols_ref(int bit_num, const Bytes& bytes) {
+    Symbols symbols;
+    if (bit_num == 1) {
+        for (auto byte : bytes) {
+            for (int k = 7; k >= 0; --k) {
+                symbols.push_back((byte >> k) & 0x1);
+            }
+        }
+    } else if (bit_num == 2) {
+        for (auto byte : bytes) {
+            for (int k = 6; k >= 0; k -= 2) {
+                symbols.push_back((byte >> k) & 0x3);
+            }
+        }
+    } else if (bit_num == 4) {
+        for (auto byte : bytes) {
+            symbols.push_back((byte >> 4) & 0xf);
+            symbols.push_back(byte & 0xf);
+        }
+    } else {
+        Byte left = 0;
+        for (size_t i = 0; i < bytes.size(); ++i) {
+            Byte byte = bytes[i];
+            if (i % 3 == 0) {
+                symbols.push_back((byte >> 5) & 0x7);
+                symbols.push_back((byte >> 2) & 0x7);
+                left = byte & 0x3;
+            } else if (i % 3 == 1) {
+                symbols.push_back((left << 1) | ((byte >> 7) & 0x1));
+                symbols.push_back((byte >> 4) & 0x7);
+                symbols.push_back((byte >> 1) & 0x7);
+                left = byte & 0x1;
+            } else if (i % 3 == 2) {
+                symbols.push_back((left << 2)  | ((byte >> 6) & 0x3));
+                symbols.push_back((byte >> 3) & 0x7);
+                symbols.push_back(byte & 0x7);
+                left = 0;
+            }
+        }
+        if (bytes.size() % 3 != 0) {
+            symbols.push_back(left << (bytes.size() % 3));
+        }
+    }
+    return symbols;
+}
+
+Bytes symbols_to_bytes_ref(int bit_num, const Symbols& symbols) {
+    Bytes bytes;
+    if (bit_num == 1 || bit_num == 2 || bit_num == 4) {
+        int symbol_num_per_byte = 8 / bit_num;
+        for (size_t i = 0; i + symbol_num_per_byte <= symbols.size(); i += symbol_num_per_byte) {
+            Byte byte = 0;
+            for (int k = 0; k < symbol_num_per_byte; ++k) {
+                byte = (byte << bit_num) | (symbols[i+k] & ((1 << bit_num) - 1));
+            }
+            bytes.push_back(byte);
+        }
+    } else {
+        Byte byte = 0;
+        for (size_t i = 0; i < symbols.size(); ++i) {
+            Symbol symbol = symbols[i];
+            if (i % 8 == 0) {
+                byte = symbol << 5;
+            } else if (i % 8 == 1) {
+                byte = byte | symbol << 2;
+            } else if (i % 8 == 2) {
+                byte = byte | symbol >> 1;
+                bytes.push_back(byte);
+                byte = (symbol & 0x1) << 7;
+            } else if (i % 8 == 3) {
+                byte = byte | symbol << 4;
+            } else if (i % 8 == 4) {
+                byte = byte | symbol << 1;
+            } else if (i % 8 == 5) {
+                byte = byte | symbol >> 2;
+                bytes.push_back(byte);
+                byte = (symbol & 0x3) << 6;
+            } else if (i % 8 == 6) {
+                byte = byte | symbol << 3;
+            } else if (i % 8 == 7) {
+                byte = byte | symbol;
+                bytes.push_back(byte);
+            }
+        }
+    }
+    return bytes;
+}
+
+template <int BIT_NUM>
+bool test_bytes(const Bytes& bytes, const std::string& name) {
+    Symbols symbols_ref = bytes_to_symbols_ref(BIT_NUM, bytes);
+    Symbols symbols1(symbols_ref.size());
+    Symbols symbols2(symbols_ref.size());
+    unpack_symbols_scalar<BIT_NUM>(bytes.data(), bytes.size(), symbols1.data());
+    unpack_symbols<BIT_NUM>(bytes.data(), bytes.size(), symbols2.data());
+    if (symbols1 != symbols_ref || symbols2 != symbols_ref) {
+        std::cout << "symbol" << BIT_NUM << " unpack " << name << " fail\n";
+        return false;
+    }
+    Bytes bytes1(bytes.size());
+    Bytes bytes2(bytes.size());
+    pack_symbols_scalar<BIT_NUM>(symbols_ref.data(), bytes.size(), bytes1.data());
+    pack_symbols<BIT_NUM>(symbols_ref.data(), bytes.size(), bytes2.data());
+    if (bytes1 != bytes || bytes2 != bytes) {
+        std::cout << "symbol" << BIT_NUM << " pack " << name << " fail\n";
+        return false;
+    }
+    return true;
+}
+
+template <int BIT_NUM>
+bool test_symbols(const Symbols& symbols, const std::string& name) {
+    size_t byte_num = symbols.size() * BIT_NUM / 8;
+    Bytes bytes_ref = symbols_to_bytes_ref(BIT_NUM, symbols);
+    Bytes bytes1(byte_num);
+    Bytes bytes2(byte_num);
+    pack_symbols_scalar<BIT_NUM>(symbols.data(), byte_num, bytes1.data());
+    pack_symbols<BIT_NUM>(symbols.data(), byte_num, bytes2.data());
+    if (bytes1 != bytes_ref || bytes2 != bytes_ref) {
+        std::cout << "symbol" << BIT_NUM << " pack " << name << " fail\n";
+        return false;
+    }
+    return true;
+}
+
+template <int BIT_NUM>
+bool test_symbol_packing() {
+    // groups of 4 bytes are too many to enumerate, only random bytes are tested for them
+    constexpr uint32_t GROUP_VALUE_NUM = BIT_NUM < 4 ? 1u << (BIT_NUM * 8) : 0;
+    constexpr uint32_t BLOCK_GROUP_NUM = 1u << 16;
+    for (uint32_t v0 = 0; v0 < GROUP_VALUE_NUM; v0 += BLOCK_GROUP_NUM) {
+        uint32_t group_num = std::min(BLOCK_GROUP_NUM, GROUP_VALUE_NUM - v0);
+        Bytes bytes;
+        Symbols symbols;
+        for (uint32_t v = v0; v < v0 + group_num; ++v) {
+            for (int i = BIT_NUM - 1; i >= 0; --i) {
+                bytes.push_back(static_cast<Byte>(v >> (i * 8)));
+            }
+            for (int j = 7; j >= 0; --j) {
+                symbols.push_back(static_cast<Symbol>((v >> (j * BIT_NUM)) & ((1 << BIT_NUM) - 1)));
+            }
+        }
+        if (!test_bytes<BIT_NUM>(bytes, "exhaustive") || !test_symbols<BIT_NUM>(symbols, "exhaustive")) return false;
+    }
+    std::mt19937 rng(BIT_NUM);
+    for (size_t byte_num = 0; byte_num < 256; ++byte_num) {
+        Bytes bytes(byte_num);
+        for (auto& e : bytes) e = static_cast<Byte>(rng());
+        if (!test_bytes<BIT_NUM>(bytes, std::to_string(byte_num) + " bytes")) return false;
+        Symbols symbols(byte_num * 8 / BIT_NUM);
+        for (auto& e : symbols) e = static_cast<Symbol>(rng() % (1 << BIT_NUM));
+        if (!test_symbols<BIT_NUM>(symbols, std::to_string(symbols.size()) + " symbols")) return false;
+    }
+    std::cout << "symbol" << BIT_NUM << " packing pass\n";
+    return true;
+}
+
+int main() {
+    std::cout << "symbol packing accelerated: " << is_symbol_packing_accelerated() << "\n";
+    bool pass = true;
+    pass = pass && test_symbol_packing<1>();
+    pass = pass && test_symbol_packing<2>();
+    pass = pass && test_symbol_packing<3>();
+    pass = pass && test_symbol_packing<4>();
+    if (pass) {
+        std::cout << "pass\n";
+        return 0;
+    } else {
+        std::cout << "fail\n";
+        return 1;
+    }
+}
@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "image_codec.h"
+#include "test_utils.h"
+
+bool is_same_status(const Task& task, const Task& task1) {
+    if (task.DonePartNum() != task1.DonePartNum() || task.GetPartNum() != task1.GetPartNum()) return false;
+    for (uint32_t part_id = 0; part_id < task.GetPartNum(); ++part_id) {
+        if (task.IsPartDone(part_id) != task1.IsPartDone(part_id)) return false;
+    }
+    return true;
+}
+
+// parts are flushed in small batches, the journal carries them between checkpoints and stays bounded
+bool test_journal_replay(std::mt19937& rng, uint32_t part_num, uint32_t flush_part_num) {
+    std::string name = "journal replay part_num " + std::to_string(part_num) + " flush_part_num " + std::to_string(flush_part_num);
+    auto dir = std::filesystem::temp_directory_path() / "test_task_journal";
+    std::filesystem::create_directories(dir);
+    auto output_file = (dir / "output").string();
+    int part_byte_num = 16;
+    Task task(output_file);
+    task.Init(SymbolType::SYMBOL1, get_test_dim(part_byte_num), part_num);
+    task.AllocateBlob();
+    std::vector<uint32_t> part_ids(part_num);
+    for (uint32_t part_id = 0; part_id < part_num; ++part_id) part_ids[part_id] = part_id;
+    std::shuffle(part_ids.begin(), part_ids.end(), rng);
+    part_ids.resize(part_num * 3 / 4);
+    Bytes part_bytes(part_byte_num, 1);
+    bool pass = true;
+    uintmax_t max_journal_byte_num = 0;
+    size_t checkpoint_byte_num = std::filesystem::file_size(task.BlobPath()) / part_byte_num / 8;
+    for (size_t i = 0; i < part_ids.size(); ++i) {
+        task.UpdatePart(part_ids[i], part_bytes);
+        if ((i + 1) % flush_part_num == 0) {
+            task.Flush();
+            if (std::filesystem::exists(task.JournalPath())) max_journal_byte_num = std::max(max_journal_byte_num, std::filesystem::file_size(task.JournalPath()));
+            if ((i + 1) % (flush_part_num * 7) == 0) {
+                Task task1(output_file);
+                task1.Load();
+                pass = pass && is_same_status(task, task1);
+            }
+        }
+    }
+    task.Flush();
+    Task task1(output_file);
+    task1.Load();
+    pass = pass && is_same_status(task, task1);
+    pass = pass && max_journal_byte_num < std::max<size_t>(checkpoint_byte_num, 1 << 16) + 8 + flush_part_num * 4;
+    std::filesystem::remove_all(dir);
+    std::cout << name << " max journal bytes " << max_journal_byte_num << "\n";
+    std::cout << name << (pass ? " pass\n" : " fail\n");
+    return pass;
+}
+
+// a record torn by a crash is dropped, the next flush replaces the journal by a checkpoint
+bool test_torn_journal() {
+    std::string name = "torn journal";
+    auto dir = std::filesystem::temp_directory_path() / "test_task_journal";
+    std::filesystem::create_directories(dir);
+    auto output_file = (dir / "output").string();
+    int part_byte_num = 16;
+    uint32_t part_num = 1000;
+    Bytes part_bytes(part_byte_num, 1);
+    {
+        Task task(output_file);
+        task.Init(SymbolType::SYMBOL1, get_test_dim(part_byte_num), part_num);
+        task.AllocateBlob();
+        task.Flush();
+        for (uint32_t part_id = 0; part_id < 30; ++part_id) {
+            task.UpdatePart(part_id, part_bytes);
+            if (part_id % 10 == 9) task.Flush();
+        }
+    }
+    Task task(output_file);
+    std::filesystem::resize_file(task.JournalPath(), std::filesystem::file_size(task.JournalPath()) - 2);
+    task.Load();
+    bool pass = task.DonePartNum() == 20 && task.IsPartDone(19) && !task.IsPartDone(20);
+    task.UpdatePart(500, part_bytes);
+    task.Flush();
+    pass = pass && !std::filesystem::exists(task.JournalPath());
+    Task task1(output_file);
+    task1.Load();
+    pass = pass && is_same_status(task, task1) && task1.DonePartNum() == 21;
+    std::filesystem::remove_all(dir);
+    std::cout << name << (pass ? " pass\n" : " fail\n");
+    return pass;
+}
+
+// a truncated checkpoint is rejected instead of being loaded as a status with parts missing
+bool test_truncated_checkpoint() {
+    std::string name = "truncated checkpoint";
+    auto dir = std::filesystem::temp_directory_path() / "test_task_journal";
+    std::filesystem::create_directories(dir);
+    auto output_file = (dir / "output").string();
+    int part_byte_num = 16;
+    uint32_t part_num = 1000;
+    {
+        Task task(output_file);
+        task.Init(SymbolType::SYMBOL1, get_test_dim(part_byte_num), part_num);
+        task.AllocateBlob();
+        task.UpdatePart(0, Bytes(part_byte_num, 1));
+        task.Flush();
+    }
+    Task task(output_file);
+    std::filesystem::resize_file(task.TaskPath(), std::filesystem::file_size(task.TaskPath()) - 1);
+    bool pass = false;
+    try {
+        task.Load();
+    }
+    catch (const std::runtime_error& e) {
+        pass = true;
+    }
+    pass = pass && !std::filesystem::exists(task.TaskPath() + ".tmp");
+    std::filesystem::remove_all(dir);
+    std::cout << name << (pass ? " pass\n" : " fail\n");
+    return pass;
+}
+
+int main() {
+    std::mt19937 rng(0);
+    bool pass = true;
+    pass = pass && test_journal_replay(rng, 1000, 10);
+    pass = pass && test_journal_replay(rng, 2000000, 5000);
+    pass = pass && test_torn_journal();
+    pass = pass && test_truncated_checkpoint();
+    if (pass) {
+        std::cout << "pass\n";
+        return 0;
+    } else {
+        std::cout << "fail\n";
+        return 1;
+    }
+}
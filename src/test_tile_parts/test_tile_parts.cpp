@@ -0,0 +1,100 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "image_codec.h"
+
+bool test_part_dim() {
+    struct Case {
+        Dim dim;
+        int frame_part_num;
+        bool valid;
+        Dim part_dim;
+    };
+    std::vector<Case> cases = {
+        {{3, 3, 20, 30}, 1, true, {3, 3, 20, 30}},
+        {{3, 3, 20, 30}, 3, true, {3, 1, 20, 30}},
+        {{3, 3, 20, 30}, 9, true, {1, 1, 20, 30}},
+        {{4, 2, 20, 30}, 2, true, {4, 1, 20, 30}},
+        {{4, 2, 20, 30}, 4, true, {2, 1, 20, 30}},
+        {{4, 2, 20, 30}, 8, true, {1, 1, 20, 30}},
+        {{3, 3, 20, 30}, 2, false, {}},
+        {{3, 3, 20, 30}, 0, false, {}},
+        {{6, 2, 20, 30}, 3, false, {}},
+    };
+    for (const auto& [dim, frame_part_num, valid, part_dim] : cases) {
+        bool valid1 = true;
+        Dim part_dim1;
+        try {
+            part_dim1 = get_part_dim(dim, frame_part_num);
+        }
+        catch (const invalid_image_codec_argument&) {
+            valid1 = false;
+        }
+        if (valid1 != valid || (valid && part_dim1 != part_dim)) {
+            std::cout << "part dim " << dim << " " << frame_part_num << " fail\n";
+            return false;
+        }
+    }
+    std::cout << "part dim pass\n";
+    return true;
+}
+
+// one tile of the frame is covered by noise, only the part owning it may be lost
+bool test_damaged_tile(SymbolType symbol_type, const Dim& dim, int frame_part_num, int damaged_tile_id) {
+    constexpr int pixel_size = 6;
+    constexpr int space_size = 2;
+    auto [tile_x_num, tile_y_num, tile_x_size, tile_y_size] = dim;
+    std::string name = get_symbol_type_str(symbol_type) + " frame_part_num=" + std::to_string(frame_part_num);
+    auto symbol_codec = create_symbol_codec(symbol_type);
+    int part_byte_num = get_part_byte_num(symbol_type, get_part_dim(dim, frame_part_num));
+    Bytes raw_bytes(static_cast<size_t>(part_byte_num) * frame_part_num);
+    for (size_t i = 0; i < raw_bytes.size(); ++i) {
+        raw_bytes[i] = static_cast<uint8_t>(i * 131 + 7);
+    }
+    auto gen_part_image_fn = generate_part_images(dim, pixel_size, space_size, symbol_codec.get(), part_byte_num, raw_bytes, frame_part_num, frame_part_num);
+    cv::Mat img = gen_part_image_fn().value().second;
+    int tile_x = ((damaged_tile_id % tile_x_num) * (tile_x_size + 2 + space_size) + 2) * pixel_size;
+    int tile_y = ((damaged_tile_id / tile_x_num) * (tile_y_size + 2 + space_size) + 2) * pixel_size;
+    cv::Mat roi = img(cv::Rect(tile_x, tile_y, tile_x_size * pixel_size, tile_y_size * pixel_size));
+    cv::randu(roi, cv::Scalar(0, 0, 0), cv::Scalar(256, 256, 256));
+
+    ImageDecoder image_decoder(symbol_type, dim, frame_part_num);
+    Calibration calibration = get_part_image_calibration(dim, pixel_size, space_size);
+    Transform transform;
+    DecodeScratch scratch;
+    DecodeResults results;
+    image_decoder.DecodeInto(img, transform, calibration, scratch, results);
+    int part_tile_num = tile_x_num * tile_y_num / frame_part_num;
+    int success_num = 0;
+    for (int i = 0; i < frame_part_num; ++i) {
+        const auto& [success, part_id, part_bytes] = results[i];
+        bool damaged = damaged_tile_id / part_tile_num == i;
+        Bytes part_bytes_ref(raw_bytes.begin() + static_cast<size_t>(i) * part_byte_num, raw_bytes.begin() + static_cast<size_t>(i + 1) * part_byte_num);
+        if (success == damaged || (success && (part_id != static_cast<uint32_t>(i) || part_bytes != part_bytes_ref))) {
+            std::cout << name << " damaged tile part " << i << " fail\n";
+            return false;
+        }
+        success_num += success;
+    }
+    std::cout << name << " damaged tile " << success_num << "/" << frame_part_num << " parts decoded, " << success_num * part_byte_num << " bytes\n";
+    std::cout << name << " damaged tile pass\n";
+    return true;
+}
+
+int main() {
+    bool pass = true;
+    pass = pass && test_part_dim();
+    for (auto symbol_type : {SymbolType::SYMBOL1, SymbolType::SYMBOL2, SymbolType::SYMBOL3, SymbolType::SYMBOL4}) {
+        pass = pass && test_damaged_tile(symbol_type, {3, 3, 24, 24}, 1, 4);
+        pass = pass && test_damaged_tile(symbol_type, {3, 3, 24, 24}, 3, 4);
+        pass = pass && test_damaged_tile(symbol_type, {3, 3, 24, 24}, 9, 4);
+    }
+    if (pass) {
+        std::cout << "pass\n";
+        return 0;
+    } else {
+        std::cout << "fail\n";
+        return 1;
+    }
+}
@@ -0,0 +1,72 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+
+#include "image_codec.h"
+
+cv::Mat get_random_image(int cols, int rows) {
+    cv::Mat img(rows, cols, CV_8UC3);
+    cv::randu(img, cv::Scalar(0, 0, 0), cv::Scalar(256, 256, 256));
+    return img;
+}
+
+bool test_transform_cache(const cv::Mat& img, const Transform& transform) {
+    constexpr int LOOP_NUM = 8;
+    std::string name = get_bbox_str(transform.bbox) + " " + get_sphere_str(transform.sphere) + " " + get_filter_level_str(transform.filter_level);
+    TransformCache transform_cache;
+    float delta_t_ref = 0;
+    float delta_t = 0;
+    for (int loop_id = 0; loop_id < LOOP_NUM; ++loop_id) {
+        auto t0 = std::chrono::high_resolution_clock::now();
+        cv::Mat img_ref = transform_image(img, transform);
+        auto t1 = std::chrono::high_resolution_clock::now();
+        cv::Mat img1 = transform_image(img, transform, transform_cache);
+        auto t2 = std::chrono::high_resolution_clock::now();
+        delta_t_ref += std::chrono::duration_cast<std::chrono::duration<float, std::milli>>(t1 - t0).count();
+        delta_t += std::chrono::duration_cast<std::chrono::duration<float, std::milli>>(t2 - t1).count();
+        if (img1.size() != img_ref.size() || img1.type() != img_ref.type()) {
+            std::cout << name << " transform cache size mismatch fail\n";
+            return false;
+        }
+        // warpPerspective and remap may round exact half-pixel ties differently across OpenCV versions
+        int diff_num = 0;
+        for (int y = 0; y < img_ref.rows; ++y) {
+            for (int x = 0; x < img_ref.cols; ++x) {
+                if (img1.at<cv::Vec3b>(y, x) != img_ref.at<cv::Vec3b>(y, x)) ++diff_num;
+            }
+        }
+        if (static_cast<double>(diff_num) > img_ref.total() * 1e-3) {
+            std::cout << name << " transform cache fail, diff_num=" << diff_num << "\n";
+            return false;
+        }
+        if (!transform_cache.IsUpToDate(img, transform)) {
+            std::cout << name << " transform cache not up to date fail\n";
+            return false;
+        }
+    }
+    std::cout << name << " ref " << delta_t_ref / LOOP_NUM << "ms cached " << delta_t / LOOP_NUM << "ms\n";
+    std::cout << name << " transform cache pass\n";
+    return true;
+}
+
+int main() {
+    cv::Mat img = get_random_image(1280, 720);
+    std::vector<Transform> transforms(4);
+    transforms[1].bbox = {0.1f, 0.05f, 0.9f, 0.95f};
+    transforms[2].bbox = {0.1f, 0.05f, 0.9f, 0.95f};
+    transforms[2].sphere = {0.03f, -0.02f, 0.05f, 0.01f};
+    transforms[3].bbox = {0.2f, 0.1f, 0.8f, 0.9f};
+    transforms[3].sphere = {-0.04f, 0.03f, -0.01f, 0.02f};
+    transforms[3].filter_level = 1;
+    bool pass = true;
+    for (const auto& transform : transforms) {
+        pass = pass && test_transform_cache(img, transform);
+    }
+    if (pass) {
+        std::cout << "pass\n";
+        return 0;
+    } else {
+        std::cout << "fail\n";
+        return 1;
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <tuple>
+
+#include "image_codec.h"
+
+// part_byte_num of symbol1 frames with dim {1, 1, (part_byte_num + 8) * 8, 1}
+inline Dim get_test_dim(int part_byte_num) {
+    return {1, 1, (part_byte_num + SymbolCodec::META_BYTE_NUM) * 8, 1};
+}
+
+inline Bytes get_random_bytes(std::mt19937& rng, size_t byte_num) {
+    Bytes bytes(byte_num);
+    for (auto& e : bytes) e = static_cast<Byte>(rng());
+    return bytes;
+}
+
+// a target file in a temp dir named after the test and the output file a task restores it to, the dir is removed on destruction
+class TestTransfer {
+public:
+    TestTransfer(const std::string& dir_name, const Bytes& file_bytes)
+        : m_dir(std::filesystem::temp_directory_path() / dir_name), m_file_bytes(file_bytes) {
+        std::filesystem::remove_all(m_dir);
+        std::filesystem::create_directories(m_dir);
+        m_target_file = (m_dir / "target").string();
+        m_output_file = (m_dir / "output").string();
+        std::ofstream(m_target_file, std::ios_base::binary).write(reinterpret_cast<const char*>(m_file_bytes.data()), m_file_bytes.size());
+    }
+
+    ~TestTransfer() {
+        std::filesystem::remove_all(m_dir);
+    }
+
+    TestTransfer(const TestTransfer&) = delete;
+    TestTransfer& operator=(const TestTransfer&) = delete;
+
+    const std::string& TargetFile() const { return m_target_file; }
+    const std::string& OutputFile() const { return m_output_file; }
+    const Bytes& RawBytes() const { return m_raw_bytes; }
+    uint32_t PartNum() const { return m_part_num; }
+
+    // splits the target file into parts as the display does
+    void LoadTaskBytes(int part_byte_num, CompressionType compression_type = CompressionType::NONE) {
+        m_part_byte_num = part_byte_num;
+        std::tie(m_raw_bytes, m_part_num) = get_task_bytes(m_target_file, part_byte_num, compression_type);
+    }
+
+    Bytes GetPart(uint32_t part_id) const {
+        return Bytes(m_raw_bytes.begin() + static_cast<size_t>(part_id) * m_part_byte_num, m_raw_bytes.begin() + static_cast<size_t>(part_id + 1) * m_part_byte_num);
+    }
+
+    void InitTask(Task& task, SymbolType symbol_type, const Dim& dim) const {
+        task.Init(symbol_type, dim, m_part_num);
+        task.AllocateBlob();
+    }
+
+    // finalizes the task if it is done, the output file should then match the target file
+    bool FinalizeAndCompare(Task& task) const {
+        if (!task.IsDone()) return false;
+        task.Finalize();
+        if (std::filesystem::file_size(m_output_file) != m_file_bytes.size()) return false;
+        Bytes output_bytes(m_file_bytes.size());
+        std::ifstream(m_output_file, std::ios_base::binary).read(reinterpret_cast<char*>(output_bytes.data()), output_bytes.size());
+        return output_bytes == m_file_bytes;
+    }
+
+private:
+    std::filesystem::path m_dir;
+    Bytes m_file_bytes;
+    std::string m_target_file;
+    std::string m_output_file;
+    int m_part_byte_num = 0;
+    Bytes m_raw_bytes;
+    uint32_t m_part_num = 0;
+};
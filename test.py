@@ -20,9 +20,54 @@ def test_test_symbol_codec_c():
 def test_test_symbol_codec_python_c():
     assert run(['python', 'test_symbol_codec_python_c.py'])
 
+def test_test_symbol_packing():
+    assert run(['test_symbol_packing'])
+
+def test_test_calibration_grid():
+    assert run(['test_calibration_grid'])
+
+def test_test_crc32():
+    assert run(['test_crc32'])
+
+def test_test_reed_solomon():
+    assert run(['test_reed_solomon'])
+
+def test_test_fountain_code():
+    assert run(['test_fountain_code'])
+
+def test_test_compression():
+    assert run(['test_compression'])
+
+def test_test_sparse_map():
+    assert run(['test_sparse_map'])
+
+def test_test_blob_storage():
+    assert run(['test_blob_storage'])
+
+def test_test_task_journal():
+    assert run(['test_task_journal'])
+
+def test_test_part_bitmap():
+    assert run(['test_part_bitmap'])
+
+def test_test_tile_parts():
+    assert run(['test_tile_parts'])
+
+def test_test_decode_allocation():
+    assert run(['test_decode_allocation'])
+
+def test_test_decode_samples():
+    assert run(['test_decode_samples'])
+
+def test_test_pixel_classifier():
+    assert run(['test_pixel_classifier'])
+
 def test_test_thread_safe_queue():
     assert run(['test_thread_safe_queue'])
 
+def test_test_transform_cache():
+    assert run(['test_transform_cache'])
+
 def test_test_image_decode_task_status_tcp_server_client_p():
     assert run(['python', 'test_image_decode_task_status_server_client.py', 'tcp', '80', '8192'])
 